@@ -0,0 +1,571 @@
+/*
+ * gocl-bench.c
+ *
+ * Gocl - GLib/GObject wrapper for OpenCL
+ * Copyright (C) 2012-2013 Igalia S.L.
+ *
+ * Authors:
+ *  Eduardo Lima Mitev <elima@igalia.com>
+ */
+
+/*
+ * Micro-benchmarks of Gocl overheads. Results are printed to stdout as one
+ * JSON object per line, with the benchmark name, its parameters, a value and
+ * its unit, so that runs can be collected and compared across releases.
+ * Progress and errors go to stderr.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <gocl.h>
+
+/* raw OpenCL handles are needed for the baselines */
+#include "gocl-private.h"
+
+#define NOOP_SOURCE                                             \
+  "__kernel void noop (__global int *data) { }\n"
+
+static gint enqueue_runs = 2000;
+static gint latency_runs = 200;
+static gint transfer_runs = 5;
+static gchar *filter = NULL;
+
+static GOptionEntry entries[] =
+  {
+    { "enqueue-runs", 'e', 0, G_OPTION_ARG_INT, &enqueue_runs,
+      "Kernels enqueued to measure enqueue cost", "N" },
+    { "latency-runs", 'l', 0, G_OPTION_ARG_INT, &latency_runs,
+      "Round trips to measure completion latency", "N" },
+    { "transfer-runs", 't', 0, G_OPTION_ARG_INT, &transfer_runs,
+      "Transfers per size, the best one is reported", "N" },
+    { "filter", 'f', 0, G_OPTION_ARG_STRING, &filter,
+      "Only run benchmarks whose name starts with PREFIX", "PREFIX" },
+    { NULL }
+  };
+
+typedef struct
+{
+  GoclContext *context;
+  GoclDevice *device;
+  GoclQueue *queue;
+  GoclKernel *noop;
+  GoclBuffer *noop_buffer;
+} Bench;
+
+static gboolean
+should_run (const gchar *name)
+{
+  return filter == NULL || g_str_has_prefix (name, filter);
+}
+
+static void
+report (const gchar *name,
+        const gchar *params,
+        gdouble      value,
+        const gchar *unit)
+{
+  g_print ("{\"benchmark\": \"%s\", %s%s\"value\": %.3f, \"unit\": \"%s\"}\n",
+           name,
+           params != NULL ? params : "",
+           params != NULL ? ", " : "",
+           value,
+           unit);
+}
+
+static void
+report_error (const gchar *name)
+{
+  GError *error;
+
+  error = gocl_error_get_last ();
+  g_printerr ("%s failed: %s\n",
+              name,
+              error != NULL ? error->message : "unknown error");
+  if (error != NULL)
+    g_error_free (error);
+}
+
+static gint
+compare_doubles (gconstpointer a, gconstpointer b)
+{
+  gdouble x = *(const gdouble *) a;
+  gdouble y = *(const gdouble *) b;
+
+  return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static gdouble
+median (gdouble *values, guint len)
+{
+  qsort (values, len, sizeof (gdouble), compare_doubles);
+
+  return values[len / 2];
+}
+
+static void
+drain_main_context (void)
+{
+  /* events returned by asynchronous calls are released from idle sources */
+  while (g_main_context_iteration (NULL, FALSE))
+    ;
+}
+
+/* enqueue overhead */
+
+static void
+bench_enqueue (Bench *bench)
+{
+  cl_command_queue queue;
+  cl_kernel kernel;
+  gsize global_size = 1;
+  gint64 start;
+  gint64 end;
+  gint i;
+
+  if (should_run ("enqueue.gocl_kernel_run_in_device"))
+    {
+      start = g_get_monotonic_time ();
+      for (i = 0; i < enqueue_runs; i++)
+        gocl_kernel_run_in_device (bench->noop, bench->device, NULL);
+      end = g_get_monotonic_time ();
+
+      gocl_queue_finish (bench->queue);
+      drain_main_context ();
+
+      report ("enqueue.gocl_kernel_run_in_device",
+              NULL,
+              (end - start) * 1000.0 / enqueue_runs,
+              "ns/op");
+    }
+
+  if (should_run ("enqueue.clEnqueueNDRangeKernel"))
+    {
+      queue = gocl_queue_get_queue (bench->queue);
+      kernel = gocl_kernel_get_kernel (bench->noop);
+
+      /* an event is requested too, like Gocl does for every command */
+      start = g_get_monotonic_time ();
+      for (i = 0; i < enqueue_runs; i++)
+        {
+          cl_event event;
+
+          clEnqueueNDRangeKernel (queue,
+                                  kernel,
+                                  1,
+                                  NULL,
+                                  &global_size,
+                                  NULL,
+                                  0,
+                                  NULL,
+                                  &event);
+          clReleaseEvent (event);
+        }
+      end = g_get_monotonic_time ();
+
+      clFinish (queue);
+
+      report ("enqueue.clEnqueueNDRangeKernel",
+              NULL,
+              (end - start) * 1000.0 / enqueue_runs,
+              "ns/op");
+    }
+}
+
+/* completion latency */
+
+static void
+on_event_complete (GoclEvent *event, GError *error, gpointer user_data)
+{
+  gint64 *completed_at = user_data;
+
+  *completed_at = g_get_monotonic_time ();
+}
+
+static void
+bench_latency (Bench *bench)
+{
+  gdouble *samples;
+  gint i;
+
+  samples = g_new (gdouble, latency_runs);
+
+  if (should_run ("latency.gocl_event_then"))
+    {
+      for (i = 0; i < latency_runs; i++)
+        {
+          GoclEvent *event;
+          gint64 start;
+          gint64 completed_at = 0;
+
+          start = g_get_monotonic_time ();
+          event = gocl_kernel_run_in_device (bench->noop, bench->device, NULL);
+          gocl_event_then (event, on_event_complete, &completed_at);
+          gocl_queue_flush (bench->queue);
+
+          while (completed_at == 0)
+            g_main_context_iteration (NULL, TRUE);
+
+          samples[i] = completed_at - start;
+        }
+      drain_main_context ();
+
+      report ("latency.gocl_event_then",
+              NULL,
+              median (samples, latency_runs),
+              "us");
+    }
+
+  if (should_run ("latency.clFinish"))
+    {
+      cl_command_queue queue;
+      cl_kernel kernel;
+      gsize global_size = 1;
+
+      queue = gocl_queue_get_queue (bench->queue);
+      kernel = gocl_kernel_get_kernel (bench->noop);
+
+      for (i = 0; i < latency_runs; i++)
+        {
+          gint64 start;
+
+          start = g_get_monotonic_time ();
+          clEnqueueNDRangeKernel (queue,
+                                  kernel,
+                                  1,
+                                  NULL,
+                                  &global_size,
+                                  NULL,
+                                  0,
+                                  NULL,
+                                  NULL);
+          clFinish (queue);
+
+          samples[i] = g_get_monotonic_time () - start;
+        }
+
+      report ("latency.clFinish",
+              NULL,
+              median (samples, latency_runs),
+              "us");
+    }
+
+  g_free (samples);
+}
+
+/* buffer bandwidth */
+
+static void
+bench_transfers (Bench *bench)
+{
+  static const struct
+  {
+    const gchar *name;
+    guint flags;
+  } flag_sets[] =
+    {
+      { "read_write", GOCL_BUFFER_FLAGS_READ_WRITE },
+      { "alloc_host_ptr", GOCL_BUFFER_FLAGS_READ_WRITE |
+                          GOCL_BUFFER_FLAGS_ALLOC_HOST_PTR }
+    };
+  gsize size;
+  guint f;
+
+  if (! should_run ("transfer."))
+    return;
+
+  for (f = 0; f < G_N_ELEMENTS (flag_sets); f++)
+    for (size = 4096; size <= 64 << 20; size *= 4)
+      {
+        GoclBuffer *buffer;
+        gpointer data;
+        gdouble best_write = 0.0;
+        gdouble best_read = 0.0;
+        gchar *params;
+        gint i;
+
+        buffer = gocl_buffer_new (bench->context,
+                                  flag_sets[f].flags,
+                                  size,
+                                  NULL);
+        if (buffer == NULL)
+          {
+            report_error ("transfer");
+            continue;
+          }
+
+        data = g_malloc0 (size);
+
+        for (i = 0; i < transfer_runs; i++)
+          {
+            gint64 start;
+            gdouble elapsed;
+
+            start = g_get_monotonic_time ();
+            gocl_buffer_write_sync (buffer, bench->queue, data, size, 0, NULL);
+            elapsed = MAX (g_get_monotonic_time () - start, 1);
+            best_write = MAX (best_write, size / elapsed);
+
+            start = g_get_monotonic_time ();
+            gocl_buffer_read_sync (buffer, bench->queue, data, size, 0, NULL);
+            elapsed = MAX (g_get_monotonic_time () - start, 1);
+            best_read = MAX (best_read, size / elapsed);
+          }
+
+        /* bytes per microsecond are megabytes per second */
+        params = g_strdup_printf ("\"flags\": \"%s\", \"size\": %" G_GSIZE_FORMAT,
+                                  flag_sets[f].name,
+                                  size);
+        if (should_run ("transfer.write"))
+          report ("transfer.write", params, best_write, "MB/s");
+        if (should_run ("transfer.read"))
+          report ("transfer.read", params, best_read, "MB/s");
+        g_free (params);
+
+        g_free (data);
+        g_object_unref (buffer);
+      }
+}
+
+/* image throughput */
+
+static void
+bench_images (Bench *bench)
+{
+  static const struct
+  {
+    const gchar *name;
+    GoclImageChannelOrder order;
+    GoclImageChannelType type;
+  } formats[] =
+    {
+      { "rgba_unorm_int8", GOCL_IMAGE_CHANNEL_ORDER_RGBA,
+        GOCL_IMAGE_CHANNEL_TYPE_UNORM_INT8 },
+      { "r_float", GOCL_IMAGE_CHANNEL_ORDER_R,
+        GOCL_IMAGE_CHANNEL_TYPE_FLOAT }
+    };
+  gsize side;
+  guint f;
+
+  if (! should_run ("image."))
+    return;
+
+  for (f = 0; f < G_N_ELEMENTS (formats); f++)
+    for (side = 512; side <= 4096; side *= 2)
+      {
+        GoclImage *image;
+        gsize origin[3] = { 0, 0, 0 };
+        gsize region[3] = { side, side, 1 };
+        gpointer data;
+        gsize size;
+        gdouble best_upload = 0.0;
+        gdouble best_download = 0.0;
+        gchar *params;
+        gint i;
+
+        if (! gocl_context_is_image_format_supported (bench->context,
+                                                      GOCL_BUFFER_FLAGS_READ_WRITE,
+                                                      GOCL_IMAGE_TYPE_2D,
+                                                      formats[f].order,
+                                                      formats[f].type))
+          {
+            g_printerr ("image format %s not supported, skipped\n",
+                        formats[f].name);
+            break;
+          }
+
+        image = gocl_image_new (bench->context,
+                                GOCL_BUFFER_FLAGS_READ_WRITE,
+                                NULL,
+                                GOCL_IMAGE_TYPE_2D,
+                                formats[f].order,
+                                formats[f].type,
+                                side,
+                                side,
+                                0);
+        if (image == NULL)
+          {
+            report_error ("image");
+            continue;
+          }
+
+        size = side * side * gocl_image_get_element_size (image);
+        data = g_malloc0 (size);
+
+        for (i = 0; i < transfer_runs; i++)
+          {
+            gint64 start;
+            gdouble elapsed;
+
+            start = g_get_monotonic_time ();
+            gocl_image_write_region_sync (image, bench->queue, data,
+                                          origin, region, 0, 0, NULL);
+            elapsed = MAX (g_get_monotonic_time () - start, 1);
+            best_upload = MAX (best_upload, size / elapsed);
+
+            start = g_get_monotonic_time ();
+            gocl_image_read_region_sync (image, bench->queue, data,
+                                         origin, region, 0, 0, NULL);
+            elapsed = MAX (g_get_monotonic_time () - start, 1);
+            best_download = MAX (best_download, size / elapsed);
+          }
+
+        params = g_strdup_printf ("\"format\": \"%s\", \"width\": %" G_GSIZE_FORMAT
+                                  ", \"height\": %" G_GSIZE_FORMAT,
+                                  formats[f].name,
+                                  side,
+                                  side);
+        if (should_run ("image.upload"))
+          report ("image.upload", params, best_upload, "MB/s");
+        if (should_run ("image.download"))
+          report ("image.download", params, best_download, "MB/s");
+        g_free (params);
+
+        g_free (data);
+        g_object_unref (image);
+      }
+}
+
+/* program build */
+
+static gdouble
+time_build (Bench *bench, const gchar *source)
+{
+  GoclProgram *program;
+  gint64 start;
+  gdouble elapsed = -1.0;
+
+  program = gocl_program_new (bench->context, &source, 1);
+  if (program == NULL)
+    return -1.0;
+
+  start = g_get_monotonic_time ();
+  if (gocl_program_build_sync (program, NULL))
+    elapsed = (g_get_monotonic_time () - start) / 1000.0;
+
+  g_object_unref (program);
+
+  return elapsed;
+}
+
+static void
+bench_build (Bench *bench)
+{
+  gchar *source;
+  gdouble cold;
+  gdouble cached;
+
+  if (! should_run ("build."))
+    return;
+
+  /* a unique comment makes a source the binary cache has never seen */
+  source = g_strdup_printf ("/* gocl-bench %" G_GINT64_FORMAT " */\n"
+                            "__kernel void scale (__global float *data,\n"
+                            "                     const float factor)\n"
+                            "{\n"
+                            "  size_t i = get_global_id (0);\n"
+                            "  data[i] = data[i] * factor + sin (data[i]);\n"
+                            "}\n",
+                            g_get_real_time ());
+
+  cold = time_build (bench, source);
+  cached = time_build (bench, source);
+
+  if (cold < 0.0 || cached < 0.0)
+    report_error ("build");
+  else
+    {
+      if (should_run ("build.cold"))
+        report ("build.cold", NULL, cold, "ms");
+      if (should_run ("build.cached"))
+        report ("build.cached", NULL, cached, "ms");
+    }
+
+  g_free (source);
+}
+
+static gboolean
+setup (Bench *bench)
+{
+  GoclProgram *program;
+  const gchar *source = NOOP_SOURCE;
+
+  bench->context = gocl_context_get_default_gpu_sync ();
+  if (bench->context == NULL)
+    bench->context = gocl_context_get_default_cpu_sync ();
+  if (bench->context == NULL)
+    return FALSE;
+
+  bench->device = gocl_context_get_device_by_index (bench->context, 0);
+  bench->queue = gocl_device_get_default_queue (bench->device);
+
+  g_printerr ("Running on %s (%s)\n",
+              gocl_device_get_name (bench->device),
+              gocl_device_get_vendor (bench->device));
+
+  program = gocl_program_new (bench->context, &source, 1);
+  if (program == NULL || ! gocl_program_build_sync (program, NULL))
+    return FALSE;
+
+  bench->noop = gocl_program_get_kernel (program, "noop");
+  g_object_unref (program);
+  if (bench->noop == NULL)
+    return FALSE;
+
+  bench->noop_buffer = gocl_buffer_new (bench->context,
+                                        GOCL_BUFFER_FLAGS_READ_WRITE,
+                                        sizeof (gint32),
+                                        NULL);
+  if (bench->noop_buffer == NULL)
+    return FALSE;
+
+  gocl_kernel_set_argument_buffer (bench->noop, 0, bench->noop_buffer);
+  gocl_kernel_set_global_work_size (bench->noop, 1, 0, 0);
+
+  return TRUE;
+}
+
+gint
+main (gint argc, gchar *argv[])
+{
+  GOptionContext *option_context;
+  GError *error = NULL;
+  Bench bench = { 0, };
+
+#ifndef GLIB_VERSION_2_36
+  g_type_init ();
+#endif
+
+  option_context = g_option_context_new ("- benchmark Gocl overheads");
+  g_option_context_add_main_entries (option_context, entries, NULL);
+  if (! g_option_context_parse (option_context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      g_error_free (error);
+      g_option_context_free (option_context);
+      return 1;
+    }
+  g_option_context_free (option_context);
+
+  enqueue_runs = MAX (enqueue_runs, 1);
+  latency_runs = MAX (latency_runs, 1);
+  transfer_runs = MAX (transfer_runs, 1);
+
+  if (! setup (&bench))
+    {
+      report_error ("setup");
+      return 1;
+    }
+
+  bench_enqueue (&bench);
+  bench_latency (&bench);
+  bench_transfers (&bench);
+  bench_images (&bench);
+  bench_build (&bench);
+
+  g_object_unref (bench.noop_buffer);
+  g_object_unref (bench.noop);
+  g_object_unref (bench.device);
+  g_object_unref (bench.context);
+
+  return 0;
+}
@@ -222,6 +222,8 @@ main (gint argc, gchar *argv[])
                                       GOCL_BUFFER_FLAGS_USE_HOST_PTR,
                                       tex_data,
                                       GOCL_IMAGE_TYPE_2D,
+                                      GOCL_IMAGE_CHANNEL_ORDER_RGBA,
+                                      GOCL_IMAGE_CHANNEL_TYPE_UNORM_INT8,
                                       cogl_texture_get_width (tex),
                                       cogl_texture_get_height (tex),
                                       0);
@@ -234,6 +236,8 @@ main (gint argc, gchar *argv[])
                                        GOCL_BUFFER_FLAGS_READ_WRITE,
                                        NULL,
                                        GOCL_IMAGE_TYPE_2D,
+                                       GOCL_IMAGE_CHANNEL_ORDER_RGBA,
+                                       GOCL_IMAGE_CHANNEL_TYPE_UNORM_INT8,
                                        width,
                                        height,
                                        0);
@@ -0,0 +1,560 @@
+/*
+ * gocl-buffer-pool.c
+ *
+ * Gocl - GLib/GObject wrapper for OpenCL
+ * Copyright (C) 2012-2013 Igalia S.L.
+ *
+ * Authors:
+ *  Eduardo Lima Mitev <elima@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License at http://www.gnu.org/licenses/lgpl-3.0.txt
+ * for more details.
+ */
+
+/**
+ * SECTION:gocl-buffer-pool
+ * @short_description: Object that recycles buffers of a context
+ * @stability: Unstable
+ *
+ * A #GoclBufferPool keeps the buffers that applications are done with,
+ * so that later requests of a similar size can reuse them instead of
+ * allocating new device memory.
+ *
+ * A pool is created with gocl_buffer_pool_new(). Buffers are obtained with
+ * gocl_buffer_pool_acquire() and given back with gocl_buffer_pool_release().
+ * Requested sizes are rounded up to the next power of two, and buffers are
+ * kept in a separate free list for each of these sizes.
+ *
+ * Small buffers are carved out of larger slabs as sub-buffers, at offsets
+ * aligned to the CL_DEVICE_MEM_BASE_ADDR_ALIGN of all the devices of the
+ * context. Buffers bigger than a quarter of the slab size are allocated on
+ * their own.
+ *
+ * Since released buffers are normally still in use by pending commands,
+ * gocl_buffer_pool_release() accepts the #GoclEvent of the last command
+ * using the buffer. The buffer returns to the pool only after that event
+ * completes. Notice that this relies on gocl_event_then(), so the
+ * thread-default main context at the time of the release must be running.
+ *
+ * Unused buffers are kept until gocl_buffer_pool_trim() is called or the
+ * pool is destroyed. The memory allocated by a pool is tagged "buffer-pool"
+ * in the reports of gocl_context_get_allocations().
+ **/
+
+/**
+ * GoclBufferPoolClass:
+ * @parent_class: The parent class
+ *
+ * The class for #GoclBufferPool objects.
+ **/
+
+#include "gocl-buffer-pool.h"
+
+#include "gocl-private.h"
+
+#define DEFAULT_SLAB_SIZE (4 * 1024 * 1024)
+#define NUM_BUCKETS       (sizeof (gsize) * 8)
+#define POOL_TAG          "buffer-pool"
+
+struct _GoclBufferPoolPrivate
+{
+  GoclContext *context;
+  guint flags;
+  gsize slab_size;
+  gsize alignment;
+
+  GMutex mutex;
+  GQueue free_lists[NUM_BUCKETS];
+
+  GoclBuffer *slab;
+  gsize slab_offset;
+};
+
+typedef struct
+{
+  GoclBufferPool *self;
+  GoclBuffer *buffer;
+} ReleaseClosure;
+
+/* properties */
+enum
+{
+  PROP_0,
+  PROP_CONTEXT,
+  PROP_FLAGS,
+  PROP_SLAB_SIZE
+};
+
+static GQuark pool_quark = 0;
+
+static void           gocl_buffer_pool_class_init        (GoclBufferPoolClass *class);
+static void           gocl_buffer_pool_init              (GoclBufferPool *self);
+static void           gocl_buffer_pool_constructed       (GObject *obj);
+static void           gocl_buffer_pool_finalize          (GObject *obj);
+
+static void           set_property                       (GObject      *obj,
+                                                          guint         prop_id,
+                                                          const GValue *value,
+                                                          GParamSpec   *pspec);
+static void           get_property                       (GObject    *obj,
+                                                          guint       prop_id,
+                                                          GValue     *value,
+                                                          GParamSpec *pspec);
+
+G_DEFINE_TYPE (GoclBufferPool, gocl_buffer_pool, G_TYPE_OBJECT)
+
+#define GOCL_BUFFER_POOL_GET_PRIVATE(obj)                       \
+  (G_TYPE_INSTANCE_GET_PRIVATE ((obj),                          \
+                                GOCL_TYPE_BUFFER_POOL,          \
+                                GoclBufferPoolPrivate))         \
+
+static void
+gocl_buffer_pool_class_init (GoclBufferPoolClass *class)
+{
+  GObjectClass *obj_class = G_OBJECT_CLASS (class);
+
+  obj_class->constructed = gocl_buffer_pool_constructed;
+  obj_class->finalize = gocl_buffer_pool_finalize;
+  obj_class->get_property = get_property;
+  obj_class->set_property = set_property;
+
+  g_object_class_install_property (obj_class, PROP_CONTEXT,
+                                   g_param_spec_object ("context",
+                                                        "Context",
+                                                        "The context where buffers are allocated",
+                                                        GOCL_TYPE_CONTEXT,
+                                                        G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
+                                                        G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (obj_class, PROP_FLAGS,
+                                   g_param_spec_uint ("flags",
+                                                      "Buffer flags",
+                                                      "The flags used when creating buffers",
+                                                      GOCL_BUFFER_FLAGS_READ_WRITE,
+                                                      GOCL_BUFFER_FLAGS_COPY_HOST_PTR,
+                                                      GOCL_BUFFER_FLAGS_READ_WRITE,
+                                                      G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
+                                                      G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (obj_class, PROP_SLAB_SIZE,
+                                   g_param_spec_uint64 ("slab-size",
+                                                        "Slab size",
+                                                        "The size of the slabs small buffers are carved from",
+                                                        0,
+                                                        G_MAXUINT64,
+                                                        DEFAULT_SLAB_SIZE,
+                                                        G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
+                                                        G_PARAM_STATIC_STRINGS));
+
+  g_type_class_add_private (class, sizeof (GoclBufferPoolPrivate));
+
+  pool_quark = g_quark_from_static_string ("gocl-buffer-pool");
+}
+
+static void
+gocl_buffer_pool_init (GoclBufferPool *self)
+{
+  GoclBufferPoolPrivate *priv;
+  guint i;
+
+  self->priv = priv = GOCL_BUFFER_POOL_GET_PRIVATE (self);
+
+  priv->context = NULL;
+  priv->alignment = 1;
+
+  g_mutex_init (&priv->mutex);
+  for (i = 0; i < NUM_BUCKETS; i++)
+    g_queue_init (&priv->free_lists[i]);
+
+  priv->slab = NULL;
+  priv->slab_offset = 0;
+}
+
+static void
+gocl_buffer_pool_constructed (GObject *obj)
+{
+  GoclBufferPool *self = GOCL_BUFFER_POOL (obj);
+  guint num_devices;
+  guint i;
+
+  /* sub-buffer origins must satisfy the strictest device of the context */
+  num_devices = gocl_context_get_num_devices (self->priv->context);
+  for (i = 0; i < num_devices; i++)
+    {
+      GoclDevice *device;
+      const GoclDeviceProps *props;
+
+      device = gocl_context_get_device_by_index (self->priv->context, i);
+      if (device == NULL)
+        continue;
+
+      props = gocl_context_get_device_props (self->priv->context,
+                                             gocl_device_get_id (device));
+      if (props != NULL)
+        self->priv->alignment = MAX (self->priv->alignment,
+                                     props->mem_base_addr_align / 8);
+
+      g_object_unref (device);
+    }
+
+  if (self->priv->slab_size == 0)
+    self->priv->slab_size = DEFAULT_SLAB_SIZE;
+
+  if (G_OBJECT_CLASS (gocl_buffer_pool_parent_class)->constructed != NULL)
+    G_OBJECT_CLASS (gocl_buffer_pool_parent_class)->constructed (obj);
+}
+
+static void
+gocl_buffer_pool_finalize (GObject *obj)
+{
+  GoclBufferPool *self = GOCL_BUFFER_POOL (obj);
+
+  gocl_buffer_pool_trim (self);
+
+  g_mutex_clear (&self->priv->mutex);
+
+  g_object_unref (self->priv->context);
+
+  G_OBJECT_CLASS (gocl_buffer_pool_parent_class)->finalize (obj);
+}
+
+static void
+set_property (GObject      *obj,
+              guint         prop_id,
+              const GValue *value,
+              GParamSpec   *pspec)
+{
+  GoclBufferPool *self;
+
+  self = GOCL_BUFFER_POOL (obj);
+
+  switch (prop_id)
+    {
+    case PROP_CONTEXT:
+      self->priv->context = g_value_dup_object (value);
+      break;
+
+    case PROP_FLAGS:
+      self->priv->flags = g_value_get_uint (value);
+      break;
+
+    case PROP_SLAB_SIZE:
+      self->priv->slab_size = g_value_get_uint64 (value);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
+      break;
+    }
+}
+
+static void
+get_property (GObject    *obj,
+              guint       prop_id,
+              GValue     *value,
+              GParamSpec *pspec)
+{
+  GoclBufferPool *self;
+
+  self = GOCL_BUFFER_POOL (obj);
+
+  switch (prop_id)
+    {
+    case PROP_CONTEXT:
+      g_value_set_object (value, self->priv->context);
+      break;
+
+    case PROP_FLAGS:
+      g_value_set_uint (value, self->priv->flags);
+      break;
+
+    case PROP_SLAB_SIZE:
+      g_value_set_uint64 (value, self->priv->slab_size);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
+      break;
+    }
+}
+
+static guint
+get_bucket (GoclBufferPool *self, gsize size, gsize *bucket_size)
+{
+  guint bucket = 0;
+  gsize min_size;
+
+  min_size = MAX (size, self->priv->alignment);
+  while (((gsize) 1 << bucket) < min_size && bucket < NUM_BUCKETS - 1)
+    bucket++;
+
+  if (bucket_size != NULL)
+    *bucket_size = (gsize) 1 << bucket;
+
+  return bucket;
+}
+
+static GoclBuffer *
+carve_from_slab (GoclBufferPool *self, gsize size)
+{
+  GoclBuffer *buffer;
+
+  if (self->priv->slab == NULL ||
+      self->priv->slab_offset + size > self->priv->slab_size)
+    {
+      /* sub-buffers carved from the previous slab keep it alive */
+      if (self->priv->slab != NULL)
+        g_object_unref (self->priv->slab);
+
+      self->priv->slab = gocl_buffer_new (self->priv->context,
+                                          self->priv->flags,
+                                          self->priv->slab_size,
+                                          NULL);
+      self->priv->slab_offset = 0;
+
+      if (self->priv->slab == NULL)
+        return NULL;
+
+      gocl_buffer_set_tag (self->priv->slab, POOL_TAG);
+    }
+
+  /* bucket sizes are powers of two not smaller than the alignment, so
+     consecutive offsets stay aligned */
+  buffer = gocl_buffer_new_sub_buffer (self->priv->slab,
+                                       self->priv->flags,
+                                       self->priv->slab_offset,
+                                       size);
+  if (buffer != NULL)
+    self->priv->slab_offset += size;
+
+  return buffer;
+}
+
+static void
+return_to_pool (GoclBufferPool *self, GoclBuffer *buffer)
+{
+  guint64 size;
+  guint bucket;
+
+  g_object_get (buffer, "size", &size, NULL);
+  bucket = get_bucket (self, size, NULL);
+
+  g_mutex_lock (&self->priv->mutex);
+  g_queue_push_head (&self->priv->free_lists[bucket], buffer);
+  g_mutex_unlock (&self->priv->mutex);
+}
+
+static void
+on_release_event_completed (GoclEvent *event,
+                            GError    *error,
+                            gpointer   user_data)
+{
+  ReleaseClosure *closure = user_data;
+
+  /* the command is over even if it failed, so the buffer is free anyway */
+  return_to_pool (closure->self, closure->buffer);
+
+  g_object_unref (closure->self);
+  g_slice_free (ReleaseClosure, closure);
+}
+
+/* public */
+
+/**
+ * gocl_buffer_pool_new:
+ * @context: The #GoclContext where buffers are allocated
+ * @flags: An OR'ed combination of values from #GoclBufferFlags, applied
+ * to all the buffers of the pool
+ * @slab_size: The size in bytes of the slabs small buffers are carved from,
+ * or 0 to use a default size
+ *
+ * Creates a new pool of buffers for @context. Since pooled buffers are
+ * recycled, @flags cannot contain %GOCL_BUFFER_FLAGS_USE_HOST_PTR nor
+ * %GOCL_BUFFER_FLAGS_COPY_HOST_PTR.
+ *
+ * Returns: (transfer full): A newly created #GoclBufferPool
+ **/
+GoclBufferPool *
+gocl_buffer_pool_new (GoclContext *context,
+                      guint        flags,
+                      gsize        slab_size)
+{
+  g_return_val_if_fail (GOCL_IS_CONTEXT (context), NULL);
+  g_return_val_if_fail ((flags & (GOCL_BUFFER_FLAGS_USE_HOST_PTR |
+                                  GOCL_BUFFER_FLAGS_COPY_HOST_PTR)) == 0, NULL);
+
+  return g_object_new (GOCL_TYPE_BUFFER_POOL,
+                       "context", context,
+                       "flags", flags,
+                       "slab-size", (guint64) slab_size,
+                       NULL);
+}
+
+/**
+ * gocl_buffer_pool_get_context:
+ * @self: The #GoclBufferPool
+ *
+ * Obtains the context where the buffers of the pool are allocated.
+ *
+ * Returns: (transfer none): The #GoclContext of the pool
+ **/
+GoclContext *
+gocl_buffer_pool_get_context (GoclBufferPool *self)
+{
+  g_return_val_if_fail (GOCL_IS_BUFFER_POOL (self), NULL);
+
+  return self->priv->context;
+}
+
+/**
+ * gocl_buffer_pool_get_alignment:
+ * @self: The #GoclBufferPool
+ *
+ * Obtains the alignment in bytes of the sub-buffers carved by the pool,
+ * which is the largest CL_DEVICE_MEM_BASE_ADDR_ALIGN of the devices of
+ * the context. It is also the smallest size of a pooled buffer.
+ *
+ * Returns: The alignment, in bytes
+ **/
+gsize
+gocl_buffer_pool_get_alignment (GoclBufferPool *self)
+{
+  g_return_val_if_fail (GOCL_IS_BUFFER_POOL (self), 0);
+
+  return self->priv->alignment;
+}
+
+/**
+ * gocl_buffer_pool_acquire:
+ * @self: The #GoclBufferPool
+ * @size: The minimum size of the buffer, in bytes
+ *
+ * Obtains a buffer of at least @size bytes from the pool, reusing a free
+ * one if available, or allocating a new one otherwise. The size of the
+ * returned buffer is @size rounded up to the next power of two.
+ *
+ * The buffer should be given back with gocl_buffer_pool_release() when it
+ * is no longer needed. Contents of recycled buffers are undefined.
+ *
+ * Returns: (transfer full): A #GoclBuffer, or %NULL on error
+ **/
+GoclBuffer *
+gocl_buffer_pool_acquire (GoclBufferPool *self, gsize size)
+{
+  GoclBuffer *buffer;
+  gsize bucket_size;
+  guint bucket;
+
+  g_return_val_if_fail (GOCL_IS_BUFFER_POOL (self), NULL);
+  g_return_val_if_fail (size > 0, NULL);
+
+  bucket = get_bucket (self, size, &bucket_size);
+
+  g_mutex_lock (&self->priv->mutex);
+
+  buffer = g_queue_pop_head (&self->priv->free_lists[bucket]);
+  if (buffer == NULL && bucket_size <= self->priv->slab_size / 4)
+    buffer = carve_from_slab (self, bucket_size);
+
+  g_mutex_unlock (&self->priv->mutex);
+
+  if (buffer == NULL && bucket_size > self->priv->slab_size / 4)
+    {
+      buffer = gocl_buffer_new (self->priv->context,
+                                self->priv->flags,
+                                bucket_size,
+                                NULL);
+      if (buffer != NULL)
+        gocl_buffer_set_tag (buffer, POOL_TAG);
+    }
+
+  if (buffer != NULL)
+    g_object_set_qdata (G_OBJECT (buffer), pool_quark, self);
+
+  return buffer;
+}
+
+/**
+ * gocl_buffer_pool_release:
+ * @self: The #GoclBufferPool
+ * @buffer: (transfer full): A #GoclBuffer obtained from @self
+ * @event: (allow-none): The #GoclEvent of the last command using @buffer,
+ * or %NULL
+ *
+ * Gives @buffer back to the pool. If @event is not %NULL, the buffer is
+ * returned to its free list only after @event completes, so that it is not
+ * handed out again while the device may still be using it. Otherwise it
+ * can be reused right away.
+ *
+ * The caller's reference on @buffer is taken by the pool.
+ **/
+void
+gocl_buffer_pool_release (GoclBufferPool *self,
+                          GoclBuffer     *buffer,
+                          GoclEvent      *event)
+{
+  ReleaseClosure *closure;
+
+  g_return_if_fail (GOCL_IS_BUFFER_POOL (self));
+  g_return_if_fail (GOCL_IS_BUFFER (buffer));
+  g_return_if_fail (g_object_get_qdata (G_OBJECT (buffer), pool_quark) == self);
+  g_return_if_fail (event == NULL || GOCL_IS_EVENT (event));
+
+  if (event == NULL)
+    {
+      return_to_pool (self, buffer);
+      return;
+    }
+
+  closure = g_slice_new (ReleaseClosure);
+  closure->self = g_object_ref (self);
+  closure->buffer = buffer;
+
+  gocl_event_then (event, on_release_event_completed, closure);
+}
+
+/**
+ * gocl_buffer_pool_trim:
+ * @self: The #GoclBufferPool
+ *
+ * Frees all the buffers currently in the free lists of the pool. Buffers
+ * that are acquired, or released but waiting for their event, are not
+ * affected.
+ *
+ * Device memory of a slab is returned only once none of the buffers carved
+ * from it is alive.
+ **/
+void
+gocl_buffer_pool_trim (GoclBufferPool *self)
+{
+  guint i;
+
+  g_return_if_fail (GOCL_IS_BUFFER_POOL (self));
+
+  g_mutex_lock (&self->priv->mutex);
+
+  for (i = 0; i < NUM_BUCKETS; i++)
+    {
+      GoclBuffer *buffer;
+
+      while ((buffer = g_queue_pop_head (&self->priv->free_lists[i])) != NULL)
+        g_object_unref (buffer);
+    }
+
+  if (self->priv->slab != NULL)
+    {
+      g_object_unref (self->priv->slab);
+      self->priv->slab = NULL;
+      self->priv->slab_offset = 0;
+    }
+
+  g_mutex_unlock (&self->priv->mutex);
+}
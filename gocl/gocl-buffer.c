@@ -35,6 +35,26 @@
  * Also, buffers can be initialized at any time by calling
  * gocl_buffer_write() or gocl_buffer_write_sync().
  *
+ * Data can be copied between buffers without going through host memory,
+ * using gocl_buffer_copy() and gocl_buffer_copy_rect(), and a buffer can
+ * be initialized with a repeated pattern using gocl_buffer_fill(). See
+ * also gocl_image_copy() and related functions for copies involving images.
+ *
+ * A region of an existing buffer can be exposed as a buffer of its own with
+ * gocl_buffer_new_sub_buffer(). Sub-buffers share memory with their parent.
+ * For applications that allocate and free many short-lived buffers, see also
+ * #GoclBufferPool.
+ *
+ * The device memory allocated by buffers is accounted by their context, see
+ * gocl_context_get_allocations(). A tag set with gocl_buffer_set_tag(), or
+ * the #GoclBuffer:tag property at construction, identifies the part of the
+ * application a buffer belongs to in these reports.
+ *
+ * A GL buffer object, like a vertex buffer, can be shared with OpenCL using
+ * gocl_buffer_new_from_gl_buffer(). Like images created from GL textures,
+ * such buffers must be acquired with gocl_device_acquire_gl_objects() before
+ * OpenCL commands use them, and released afterwards.
+ *
  * To read data from a buffer into host memory, gocl_buffer_read() and
  * gocl_buffer_read_sync() methods are provided. These are normally used after
  * the execution of a kernel that affected the contents of the buffer.
@@ -42,6 +62,26 @@
  * Both gocl_buffer_write_sync() and gocl_buffer_read_sync() block program
  * execution, while gocl_buffer_write() and gocl_buffer_read() are asynchronous
  * versions and safe to call from the application's main loop.
+ *
+ * Alternatively, a region of the buffer can be mapped into host address space
+ * with gocl_buffer_map() or gocl_buffer_map_sync(), and accessed directly
+ * from the host. This avoids an extra copy when the device shares memory with
+ * the host. A mapped region must be released with gocl_buffer_unmap() or
+ * gocl_buffer_unmap_sync() before the buffer is used again by a kernel.
+ *
+ * For language bindings, gocl_buffer_new_from_bytes(), gocl_buffer_write_bytes(),
+ * gocl_buffer_read_to_byte_array() and gocl_buffer_read_to_bytes_sync() take
+ * and return data as #GBytes or #GByteArray, keeping it alive for as long as
+ * OpenCL needs it, so that large payloads are not copied into temporary
+ * arrays on every call.
+ *
+ * Iterative algorithms that alternate host and device work can let Gocl do
+ * the transfers instead, using a managed buffer created with
+ * gocl_buffer_new_managed(). Such a buffer keeps a host copy of its contents
+ * and tracks which ranges changed on either side. Before a kernel using it
+ * runs, only the ranges changed on the host are sent to the device. Device
+ * changes are fetched only when the host asks for them with
+ * gocl_buffer_access_sync().
  **/
 
 /**
@@ -51,6 +91,8 @@
  *                 internal #cl_mem object
  * @read_all: Virtual method used by deriving classes to read all the
  *            content of the buffer into host memory
+ * @map: Virtual method used by deriving classes to map a region of the
+ *       buffer into host memory
  *
  * The class for #GoclBuffer objects.
  **/
@@ -72,8 +114,36 @@ struct _GoclBufferPrivate
   guint flags;
   gsize size;
   gpointer host_ptr;
+
+  GoclBuffer *parent;
+  goffset origin;
+
+  guint gl_buffer;
+
+  /* identifies the owner in the context's allocation reports */
+  gchar *tag;
+  gboolean accounted;
+
+  /* wrapped by buffers created with gocl_buffer_new_from_bytes() */
+  GBytes *bytes;
+
+  /* host shadow and validity tracking of managed buffers */
+  gboolean managed;
+  GMutex managed_mutex;
+  guint8 *shadow;
+  GArray *host_dirty;
+  GArray *device_dirty;
+  GArray *pending_uploads;
+  GArray *device_events;
 };
 
+/* a half-open byte range, kept sorted and disjoint within a range set */
+typedef struct
+{
+  gsize start;
+  gsize end;
+} Range;
+
 /* properties */
 enum
 {
@@ -81,7 +151,12 @@ enum
   PROP_CONTEXT,
   PROP_FLAGS,
   PROP_SIZE,
-  PROP_HOST_PTR
+  PROP_HOST_PTR,
+  PROP_PARENT,
+  PROP_ORIGIN,
+  PROP_GL_BUFFER,
+  PROP_MANAGED,
+  PROP_TAG
 };
 
 static void           gocl_buffer_class_init            (GoclBufferClass *class);
@@ -116,6 +191,24 @@ static cl_int         read_all                          (GoclBuffer          *se
                                                          cl_event            *event_wait_list,
                                                          guint                event_wait_list_len,
                                                          cl_event            *out_event);
+static gpointer       map                               (GoclBuffer          *self,
+                                                         cl_mem               buffer,
+                                                         cl_command_queue     queue,
+                                                         gboolean             blocking,
+                                                         guint                flags,
+                                                         goffset              offset,
+                                                         gsize                size,
+                                                         gsize               *row_pitch,
+                                                         gsize               *slice_pitch,
+                                                         cl_event            *event_wait_list,
+                                                         guint                event_wait_list_len,
+                                                         cl_event            *out_event,
+                                                         cl_int              *err_code);
+
+static void           range_set_add                     (GArray *set,
+                                                         gsize   start,
+                                                         gsize   end);
+static void           release_events                    (GArray *events);
 
 G_DEFINE_TYPE_WITH_CODE (GoclBuffer, gocl_buffer, G_TYPE_OBJECT,
                          G_IMPLEMENT_INTERFACE (G_TYPE_INITABLE,
@@ -137,6 +230,7 @@ gocl_buffer_class_init (GoclBufferClass *class)
 
   class->create_cl_mem = create_cl_mem;
   class->read_all = read_all;
+  class->map = map;
 
   g_object_class_install_property (obj_class, PROP_CONTEXT,
                                    g_param_spec_object ("context",
@@ -173,6 +267,50 @@ gocl_buffer_class_init (GoclBufferClass *class)
                                                          G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
                                                          G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (obj_class, PROP_PARENT,
+                                   g_param_spec_object ("parent",
+                                                        "Parent buffer",
+                                                        "The buffer this buffer is a region of, if any",
+                                                        GOCL_TYPE_BUFFER,
+                                                        G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
+                                                        G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (obj_class, PROP_ORIGIN,
+                                   g_param_spec_uint64 ("origin",
+                                                        "Origin",
+                                                        "The offset of this buffer within its parent",
+                                                        0,
+                                                        G_MAXUINT64,
+                                                        0,
+                                                        G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
+                                                        G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (obj_class, PROP_GL_BUFFER,
+                                   g_param_spec_uint ("gl-buffer",
+                                                      "GL buffer",
+                                                      "The GL buffer object shared with this buffer",
+                                                      0,
+                                                      G_MAXUINT,
+                                                      0,
+                                                      G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
+                                                      G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (obj_class, PROP_MANAGED,
+                                   g_param_spec_boolean ("managed",
+                                                         "Managed",
+                                                         "Whether the buffer keeps a host shadow synchronized lazily",
+                                                         FALSE,
+                                                         G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
+                                                         G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (obj_class, PROP_TAG,
+                                   g_param_spec_string ("tag",
+                                                        "Tag",
+                                                        "A tag identifying the owner in allocation reports",
+                                                        NULL,
+                                                        G_PARAM_READWRITE |
+                                                        G_PARAM_STATIC_STRINGS));
+
   g_type_class_add_private (class, sizeof (GoclBufferPrivate));
 }
 
@@ -193,13 +331,60 @@ gocl_buffer_initable_init (GInitable     *initable,
 
   ctx = gocl_context_get_context (self->priv->context);
 
+  if (self->priv->managed)
+    {
+      /* the host shadow takes the role of the host pointer */
+      self->priv->flags &= ~(GOCL_BUFFER_FLAGS_USE_HOST_PTR |
+                             GOCL_BUFFER_FLAGS_COPY_HOST_PTR);
+
+      self->priv->shadow = g_malloc0 (self->priv->size);
+      self->priv->host_dirty = g_array_new (FALSE, FALSE, sizeof (Range));
+      self->priv->device_dirty = g_array_new (FALSE, FALSE, sizeof (Range));
+      self->priv->pending_uploads = g_array_new (FALSE, FALSE, sizeof (cl_event));
+      self->priv->device_events = g_array_new (FALSE, FALSE, sizeof (cl_event));
+
+      /* initial contents are uploaded before the first kernel uses them */
+      if (self->priv->host_ptr != NULL)
+        {
+          memcpy (self->priv->shadow, self->priv->host_ptr, self->priv->size);
+          range_set_add (self->priv->host_dirty, 0, self->priv->size);
+        }
+      self->priv->host_ptr = NULL;
+    }
+
   err_code = GOCL_BUFFER_GET_CLASS (self)->create_cl_mem (self,
                                                           ctx,
                                                           &self->priv->buf,
                                                           self->priv->flags,
                                                           self->priv->size,
                                                           self->priv->host_ptr);
-  return ! gocl_error_check_opencl (err_code, error);
+  if (gocl_error_check_opencl (err_code, error))
+    return FALSE;
+
+  /* sub-buffers and GL objects do not allocate memory of their own */
+  if (self->priv->parent == NULL &&
+      self->priv->gl_buffer == 0 &&
+      ! (GOCL_IS_IMAGE (self) && gocl_image_is_gl_shared (GOCL_IMAGE (self))))
+    {
+      gsize size;
+
+      /* images may take more than their pixels, due to padding */
+      if (clGetMemObjectInfo (self->priv->buf,
+                              CL_MEM_SIZE,
+                              sizeof (gsize),
+                              &size,
+                              NULL) != CL_SUCCESS)
+        size = self->priv->size;
+
+      gocl_context_add_allocation (self->priv->context,
+                                   self,
+                                   self->priv->flags,
+                                   size,
+                                   self->priv->tag);
+      self->priv->accounted = TRUE;
+    }
+
+  return TRUE;
 }
 
 static void
@@ -210,6 +395,20 @@ gocl_buffer_init (GoclBuffer *self)
   self->priv = priv = GOCL_BUFFER_GET_PRIVATE (self);
 
   priv->host_ptr = NULL;
+
+  priv->parent = NULL;
+  priv->origin = 0;
+
+  priv->gl_buffer = 0;
+
+  priv->tag = NULL;
+  priv->accounted = FALSE;
+
+  priv->bytes = NULL;
+
+  priv->managed = FALSE;
+  g_mutex_init (&priv->managed_mutex);
+  priv->shadow = NULL;
 }
 
 static void
@@ -217,7 +416,31 @@ gocl_buffer_finalize (GObject *obj)
 {
   GoclBuffer *self = GOCL_BUFFER (obj);
 
-  clReleaseMemObject (self->priv->buf);
+  if (self->priv->accounted)
+    gocl_context_remove_allocation (self->priv->context, self);
+  g_free (self->priv->tag);
+
+  if (self->priv->buf != NULL)
+    clReleaseMemObject (self->priv->buf);
+
+  if (self->priv->bytes != NULL)
+    g_bytes_unref (self->priv->bytes);
+
+  if (self->priv->parent != NULL)
+    g_object_unref (self->priv->parent);
+
+  if (self->priv->managed)
+    {
+      release_events (self->priv->pending_uploads);
+      g_array_free (self->priv->pending_uploads, TRUE);
+      release_events (self->priv->device_events);
+      g_array_free (self->priv->device_events, TRUE);
+
+      g_array_free (self->priv->host_dirty, TRUE);
+      g_array_free (self->priv->device_dirty, TRUE);
+      g_free (self->priv->shadow);
+    }
+  g_mutex_clear (&self->priv->managed_mutex);
 
   G_OBJECT_CLASS (gocl_buffer_parent_class)->finalize (obj);
 }
@@ -250,6 +473,26 @@ set_property (GObject      *obj,
       self->priv->host_ptr = g_value_get_pointer (value);
       break;
 
+    case PROP_PARENT:
+      self->priv->parent = g_value_dup_object (value);
+      break;
+
+    case PROP_ORIGIN:
+      self->priv->origin = g_value_get_uint64 (value);
+      break;
+
+    case PROP_GL_BUFFER:
+      self->priv->gl_buffer = g_value_get_uint (value);
+      break;
+
+    case PROP_MANAGED:
+      self->priv->managed = g_value_get_boolean (value);
+      break;
+
+    case PROP_TAG:
+      gocl_buffer_set_tag (self, g_value_get_string (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
       break;
@@ -284,6 +527,26 @@ get_property (GObject    *obj,
       g_value_set_pointer (value, self->priv->host_ptr);
       break;
 
+    case PROP_PARENT:
+      g_value_set_object (value, self->priv->parent);
+      break;
+
+    case PROP_ORIGIN:
+      g_value_set_uint64 (value, self->priv->origin);
+      break;
+
+    case PROP_GL_BUFFER:
+      g_value_set_uint (value, self->priv->gl_buffer);
+      break;
+
+    case PROP_MANAGED:
+      g_value_set_boolean (value, self->priv->managed);
+      break;
+
+    case PROP_TAG:
+      g_value_set_string (value, self->priv->tag);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
       break;
@@ -300,6 +563,44 @@ create_cl_mem (GoclBuffer  *self,
 {
   cl_int err_code;
 
+  if (self->priv->parent != NULL)
+    {
+      cl_buffer_region region;
+
+      region.origin = self->priv->origin;
+      region.size = size;
+
+      /* host pointer flags are inherited from the parent */
+      *obj = clCreateSubBuffer (self->priv->parent->priv->buf,
+                                flags & (CL_MEM_READ_WRITE |
+                                         CL_MEM_WRITE_ONLY |
+                                         CL_MEM_READ_ONLY),
+                                CL_BUFFER_CREATE_TYPE_REGION,
+                                &region,
+                                &err_code);
+
+      return err_code;
+    }
+
+  if (self->priv->gl_buffer > 0)
+    {
+      /* the size is that of the GL buffer's data store */
+      *obj = clCreateFromGLBuffer (context,
+                                   flags & (CL_MEM_READ_WRITE |
+                                            CL_MEM_WRITE_ONLY |
+                                            CL_MEM_READ_ONLY),
+                                   self->priv->gl_buffer,
+                                   &err_code);
+      if (err_code == CL_SUCCESS)
+        err_code = clGetMemObjectInfo (*obj,
+                                       CL_MEM_SIZE,
+                                       sizeof (gsize),
+                                       &self->priv->size,
+                                       NULL);
+
+      return err_code;
+    }
+
   *obj = clCreateBuffer (context,
                          flags,
                          size,
@@ -334,109 +635,90 @@ read_all (GoclBuffer          *self,
                               out_event);
 }
 
-/* public */
-
-/**
- * gocl_buffer_new:
- * @context: A #GoclContext to attach the buffer to
- * @flags: An OR'ed combination of values from #GoclBufferFlags
- * @size: The size of the buffer, in bytes
- * @host_ptr: (allow-none) (type guint64): A pointer to memory in the host system, or %NULL
- *
- * Creates a new buffer on context's memory. Depending on flags, the @host_ptr pointer can be
- * used to initialize the contents of the buffer from a block of memory in the host.
- *
- * Returns: (transfer full): A newly created #GoclBuffer, or %NULL on error
- **/
-GoclBuffer *
-gocl_buffer_new (GoclContext  *context,
-                 guint         flags,
-                 gsize         size,
-                 gpointer      host_ptr)
+static gpointer
+map (GoclBuffer          *self,
+     cl_mem               buffer,
+     cl_command_queue     queue,
+     gboolean             blocking,
+     guint                flags,
+     goffset              offset,
+     gsize                size,
+     gsize               *row_pitch,
+     gsize               *slice_pitch,
+     cl_event            *event_wait_list,
+     guint                event_wait_list_len,
+     cl_event            *out_event,
+     cl_int              *err_code)
 {
-  GError **error;
-
-  g_return_val_if_fail (GOCL_IS_CONTEXT (context), NULL);
-
-  error = gocl_error_prepare ();
-
-  return g_initable_new (GOCL_TYPE_BUFFER,
-                         NULL,
-                         error,
-                         "context", context,
-                         "flags", flags,
-                         "size", size,
-                         "host-ptr", host_ptr,
-                         NULL);
+  /* plain buffers have no pitch */
+  if (row_pitch != NULL)
+    *row_pitch = 0;
+  if (slice_pitch != NULL)
+    *slice_pitch = 0;
+
+  if (size == 0)
+    size = self->priv->size - offset;
+
+  return clEnqueueMapBuffer (queue,
+                             buffer,
+                             blocking,
+                             flags,
+                             offset,
+                             size,
+                             event_wait_list_len,
+                             event_wait_list,
+                             out_event,
+                             err_code);
 }
 
-/**
- * gocl_buffer_get_buffer:
- * @self: The #GoclBuffer
- *
- * Retrieves the internal OpenCL #cl_mem object. This is not normally
- * called by applications. It is rather a low-level, internal API.
- *
- * Returns: (type guint64) (transfer none): The internal #cl_mem object
- **/
-cl_mem
-gocl_buffer_get_buffer (GoclBuffer *self)
+typedef struct
 {
-  g_return_val_if_fail (GOCL_IS_BUFFER (self), NULL);
+  gpointer data;
+  GDestroyNotify destroy;
+} Payload;
 
-  return self->priv->buf;
+static void
+payload_on_complete (cl_event  event,
+                     cl_int    event_command_exec_status,
+                     void     *user_data)
+{
+  Payload *payload = user_data;
+
+  payload->destroy (payload->data);
+  g_slice_free (Payload, payload);
 }
 
-/**
- * gocl_buffer_get_context:
- * @buffer: The #GoclBuffer
- *
- * Retrieves the #GoclContext the buffer belongs to.
- *
- * Returns: (transfer none): A #GoclContext object
- **/
-GoclContext *
-gocl_buffer_get_context (GoclBuffer *buffer)
+/* keeps @data alive until the command of @event completes, and then
+   destroys it from whatever thread OpenCL notifies on */
+static void
+hold_until_complete (cl_event       event,
+                     gpointer       data,
+                     GDestroyNotify destroy)
 {
-  g_return_val_if_fail (GOCL_IS_BUFFER (buffer), NULL);
+  Payload *payload;
 
-  return buffer->priv->context;
+  payload = g_slice_new (Payload);
+  payload->data = data;
+  payload->destroy = destroy;
+
+  if (clSetEventCallback (event,
+                          CL_COMPLETE,
+                          payload_on_complete,
+                          payload) != CL_SUCCESS)
+    {
+      clWaitForEvents (1, &event);
+      payload_on_complete (event, CL_COMPLETE, payload);
+    }
 }
 
-/**
- * gocl_buffer_read:
- * @self: The #GoclBuffer
- * @queue: A #GoclQueue where the operation will be enqueued
- * @target_ptr: (array length=size) (element-type guint8): The pointer to copy
- * the data to
- * @size: The size of the data to be read
- * @offset: The offset to start reading from
- * @event_wait_list: (element-type Gocl.Event) (allow-none): List or #GoclEvent
- * object to wait for, or %NULL
- *
- * Asynchronously reads a block of data of @size bytes from remote context
- * into host memory, starting at @offset. The operation is enqueued in
- * @queue, and the program execution continues without blocking. For a
- * synchronous version of this methid, see gocl_buffer_read_sync().
- *
- * A #GoclEvent is returned so that the application can get notified when the
- * operation finishes, by calling gocl_event_then(). Also, the returned event
- * can be added to the @event_wait_list argument of other operations, to
- * synchronize their execution with the completion of this operation.
- *
- * If @event_wait_list is provided, the read operation will start only when
- * all the #GoclEvent in the list have triggered.
- *
- * Returns: (transfer none): A #GoclEvent to get notified when the read
- * operation finishes
- **/
-GoclEvent *
-gocl_buffer_read (GoclBuffer *self,
-                  GoclQueue  *queue,
-                  gpointer    target_ptr,
-                  gsize       size,
-                  goffset     offset,
-                  GList      *event_wait_list)
+static GoclEvent *
+enqueue_read_or_write (GoclBuffer         *self,
+                       GoclQueue          *queue,
+                       gboolean            write,
+                       gpointer            ptr,
+                       gsize               size,
+                       goffset             offset,
+                       const GoclWaitList *wait_list)
 {
   GError *error = NULL;
   cl_int err_code;
@@ -446,25 +728,28 @@ gocl_buffer_read (GoclBuffer *self,
   GoclEvent *_event = NULL;
   GoclEventResolverFunc resolver_func;
 
-  cl_event *_event_wait_list = NULL;
-
-  g_return_val_if_fail (GOCL_IS_BUFFER (self), NULL);
-  g_return_val_if_fail (GOCL_IS_QUEUE (queue), NULL);
-
-  _event_wait_list = gocl_event_list_to_array (event_wait_list, NULL);
-
   _queue = gocl_queue_get_queue (queue);
 
-  err_code = clEnqueueReadBuffer (_queue,
-                                  self->priv->buf,
-                                  CL_FALSE,
-                                  offset,
-                                  size,
-                                  target_ptr,
-                                  g_list_length (event_wait_list),
-                                  _event_wait_list,
-                                  &event);
-  g_free (_event_wait_list);
+  if (write)
+    err_code = clEnqueueWriteBuffer (_queue,
+                                     self->priv->buf,
+                                     CL_FALSE,
+                                     offset,
+                                     size,
+                                     ptr,
+                                     wait_list->len,
+                                     wait_list->cl_events,
+                                     &event);
+  else
+    err_code = clEnqueueReadBuffer (_queue,
+                                    self->priv->buf,
+                                    CL_FALSE,
+                                    offset,
+                                    size,
+                                    ptr,
+                                    wait_list->len,
+                                    wait_list->cl_events,
+                                    &event);
 
   if (gocl_error_check_opencl (err_code, &error))
     {
@@ -480,8 +765,10 @@ gocl_buffer_read (GoclBuffer *self,
       _event = g_object_new (GOCL_TYPE_EVENT,
                              "queue", queue,
                              "event", event,
+                             "label", write ? "buffer-write" : "buffer-read",
+                             "bytes", (guint64) size,
                              NULL);
-      gocl_event_set_event_wait_list (_event, event_wait_list);
+      gocl_event_set_wait_list (_event, wait_list);
       gocl_event_steal_resolver_func (_event);
     }
 
@@ -490,304 +777,1882 @@ gocl_buffer_read (GoclBuffer *self,
   return _event;
 }
 
-/**
- * gocl_buffer_read_sync:
- * @self: The #GoclBuffer
- * @queue: A #GoclQueue where the operation will be enqueued
- * @target_ptr: (array length=size) (element-type guint8): The pointer to copy
- * the data to
- * @size: The size of the data to be read
- * @offset: The offset to start reading from
- * @event_wait_list: (element-type Gocl.Event) (allow-none): List or #GoclEvent
- * object to wait for, or %NULL
- *
- * Reads a block of data of @size bytes from remote context into host memory,
- * starting at @offset. The operation is actually enqueued in @queue, and
- * the program execution blocks until the read finishes. If @event_wait_list
- * is provided, the read operation will start only when all the #GoclEvent in
- * the list have triggered.
- *
- * Returns: %TRUE on success, %FALSE on error
- **/
-gboolean
-gocl_buffer_read_sync (GoclBuffer *self,
-                       GoclQueue  *queue,
-                       gpointer    target_ptr,
-                       gsize       size,
-                       goffset     offset,
-                       GList      *event_wait_list)
+static void
+range_set_add (GArray *set, gsize start, gsize end)
 {
-  cl_command_queue _queue;
-  cl_int err_code;
-  cl_event *_event_wait_list = NULL;
+  guint i = 0;
 
-  g_return_val_if_fail (GOCL_IS_BUFFER (self), FALSE);
-  g_return_val_if_fail (GOCL_IS_QUEUE (queue), FALSE);
+  if (start >= end)
+    return;
 
-  _event_wait_list = gocl_event_list_to_array (event_wait_list, NULL);
+  /* skip ranges entirely before, then absorb those touching the new one */
+  while (i < set->len && g_array_index (set, Range, i).end < start)
+    i++;
 
-  _queue = gocl_queue_get_queue (queue);
+  while (i < set->len && g_array_index (set, Range, i).start <= end)
+    {
+      Range *range = &g_array_index (set, Range, i);
 
-  err_code = clEnqueueReadBuffer (_queue,
-                                  self->priv->buf,
-                                  CL_TRUE,
-                                  offset,
-                                  size,
-                                  target_ptr,
-                                  g_list_length (event_wait_list),
-                                  _event_wait_list,
-                                  NULL);
+      start = MIN (start, range->start);
+      end = MAX (end, range->end);
+      g_array_remove_index (set, i);
+    }
 
-  g_free (_event_wait_list);
+  {
+    Range range = { start, end };
 
-  return ! gocl_error_check_opencl_internal (err_code);
+    g_array_insert_val (set, i, range);
+  }
 }
 
-/**
- * gocl_buffer_write:
- * @self: The #GoclBuffer
- * @queue: A #GoclQueue where the operation will be enqueued
- * @data: A pointer to write data from
- * @size: The size of the data to be written
- * @offset: The offset to start writing data to
- * @event_wait_list: (element-type Gocl.Event) (allow-none): List or #GoclEvent
- * object to wait for, or %NULL
- *
- * Asynchronously writes a block of data of @size bytes from host memory into
- * remote context, starting at @offset. The operation is enqueued in
- * @queue, and the program execution continues without blocking. For a
- * synchronous version of this methid, see gocl_buffer_write_sync().
- *
- * A #GoclEvent is returned so that the application can get notified when the
+static void
+range_set_remove (GArray *set, gsize start, gsize end)
+{
+  guint i = 0;
+
+  while (i < set->len)
+    {
+      Range range = g_array_index (set, Range, i);
+
+      if (range.end <= start || range.start >= end)
+        {
+          i++;
+          continue;
+        }
+
+      g_array_remove_index (set, i);
+
+      if (range.start < start)
+        {
+          Range left = { range.start, start };
+
+          g_array_insert_val (set, i, left);
+          i++;
+        }
+
+      if (range.end > end)
+        {
+          Range right = { end, range.end };
+
+          g_array_insert_val (set, i, right);
+          i++;
+        }
+    }
+}
+
+static void
+release_events (GArray *events)
+{
+  guint i;
+
+  for (i = 0; i < events->len; i++)
+    clReleaseEvent (g_array_index (events, cl_event, i));
+  g_array_set_size (events, 0);
+}
+
+/* forgets about device commands that already completed, so that the list of
+   events to wait for stays short across many kernel runs */
+static void
+prune_completed_events (GArray *events)
+{
+  guint i = 0;
+
+  while (i < events->len)
+    {
+      cl_event event = g_array_index (events, cl_event, i);
+      cl_int status = CL_QUEUED;
+
+      clGetEventInfo (event,
+                      CL_EVENT_COMMAND_EXECUTION_STATUS,
+                      sizeof (cl_int),
+                      &status,
+                      NULL);
+      if (status == CL_COMPLETE)
+        {
+          clReleaseEvent (event);
+          g_array_remove_index_fast (events, i);
+        }
+      else
+        {
+          i++;
+        }
+    }
+}
+
+/* OpenCL wants no array at all for an empty wait list, and pruning can
+   leave the array empty but allocated */
+static const cl_event *
+device_events_array (GoclBuffer *self)
+{
+  if (self->priv->device_events->len == 0)
+    return NULL;
+
+  return (const cl_event *) self->priv->device_events->data;
+}
+
+/* must be called with the managed mutex held */
+static cl_int
+upload_host_dirty (GoclBuffer       *self,
+                   cl_command_queue  queue,
+                   GArray           *out_events)
+{
+  cl_int err_code = CL_SUCCESS;
+
+  while (self->priv->host_dirty->len > 0)
+    {
+      Range range = g_array_index (self->priv->host_dirty, Range, 0);
+      cl_event event;
+
+      /* kernels still using the device copy must finish first */
+      err_code = clEnqueueWriteBuffer (queue,
+                                       self->priv->buf,
+                                       CL_FALSE,
+                                       range.start,
+                                       range.end - range.start,
+                                       self->priv->shadow + range.start,
+                                       self->priv->device_events->len,
+                                       device_events_array (self),
+                                       &event);
+      if (err_code != CL_SUCCESS)
+        break;
+
+      g_array_remove_index (self->priv->host_dirty, 0);
+
+      /* the shadow must not change until the write has read it */
+      g_array_append_val (self->priv->pending_uploads, event);
+      if (out_events != NULL)
+        {
+          clRetainEvent (event);
+          g_array_append_val (out_events, event);
+        }
+    }
+
+  return err_code;
+}
+
+/* must be called with the managed mutex held */
+static cl_int
+download_device_dirty (GoclBuffer       *self,
+                       cl_command_queue  queue,
+                       gsize             start,
+                       gsize             end)
+{
+  cl_int err_code = CL_SUCCESS;
+  guint i = 0;
+
+  while (i < self->priv->device_dirty->len)
+    {
+      Range range = g_array_index (self->priv->device_dirty, Range, i);
+      gsize from;
+      gsize to;
+
+      if (range.start >= end)
+        break;
+
+      if (range.end <= start)
+        {
+          i++;
+          continue;
+        }
+
+      from = MAX (range.start, start);
+      to = MIN (range.end, end);
+
+      err_code = clEnqueueReadBuffer (queue,
+                                      self->priv->buf,
+                                      CL_TRUE,
+                                      from,
+                                      to - from,
+                                      self->priv->shadow + from,
+                                      self->priv->device_events->len,
+                                      device_events_array (self),
+                                      NULL);
+      if (err_code != CL_SUCCESS)
+        break;
+
+      /* removal may split the range, leaving its tail at index i */
+      range_set_remove (self->priv->device_dirty, from, to);
+      if (range.start < from)
+        i++;
+    }
+
+  return err_code;
+}
+
+/* internal */
+
+cl_int
+gocl_buffer_upload_managed (GoclBuffer       *self,
+                            cl_command_queue  queue,
+                            GArray           *out_events)
+{
+  cl_int err_code;
+
+  g_mutex_lock (&self->priv->managed_mutex);
+  err_code = upload_host_dirty (self, queue, out_events);
+  g_mutex_unlock (&self->priv->managed_mutex);
+
+  return err_code;
+}
+
+void
+gocl_buffer_complete_managed (GoclBuffer     *self,
+                              const cl_event *events,
+                              guint           num_events,
+                              gboolean        written)
+{
+  guint i;
+
+  g_mutex_lock (&self->priv->managed_mutex);
+
+  prune_completed_events (self->priv->device_events);
+  for (i = 0; i < num_events; i++)
+    {
+      clRetainEvent (events[i]);
+      g_array_append_val (self->priv->device_events, events[i]);
+    }
+
+  /* which bytes a kernel writes is unknown, so all of them go stale */
+  if (written && ! (self->priv->flags & GOCL_BUFFER_FLAGS_READ_ONLY))
+    {
+      g_array_set_size (self->priv->device_dirty, 0);
+      range_set_add (self->priv->device_dirty, 0, self->priv->size);
+    }
+
+  g_mutex_unlock (&self->priv->managed_mutex);
+}
+
+/* public */
+
+/**
+ * gocl_buffer_new:
+ * @context: A #GoclContext to attach the buffer to
+ * @flags: An OR'ed combination of values from #GoclBufferFlags
+ * @size: The size of the buffer, in bytes
+ * @host_ptr: (allow-none) (type guint64): A pointer to memory in the host system, or %NULL
+ *
+ * Creates a new buffer on context's memory. Depending on flags, the @host_ptr pointer can be
+ * used to initialize the contents of the buffer from a block of memory in the host.
+ *
+ * Returns: (transfer full): A newly created #GoclBuffer, or %NULL on error
+ **/
+GoclBuffer *
+gocl_buffer_new (GoclContext  *context,
+                 guint         flags,
+                 gsize         size,
+                 gpointer      host_ptr)
+{
+  return gocl_buffer_new_full (context,
+                               flags,
+                               size,
+                               host_ptr,
+                               gocl_error_prepare ());
+}
+
+/**
+ * gocl_buffer_new_full:
+ * @context: A #GoclContext to create the buffer in
+ * @flags: An OR'ed combination of values from #GoclBufferFlags
+ * @size: The size of the buffer, in bytes
+ * @host_ptr: (allow-none) (type guint64): A pointer to memory in the host system, or %NULL
+ * @error: (allow-none): Return location for a #GError, or %NULL
+ *
+ * Like gocl_buffer_new(), but reports a failure in @error instead of the last
+ * error of the calling thread.
+ *
+ * Returns: (transfer full): A newly created #GoclBuffer, or %NULL on error
+ **/
+GoclBuffer *
+gocl_buffer_new_full (GoclContext  *context,
+                      guint         flags,
+                      gsize         size,
+                      gpointer      host_ptr,
+                      GError      **error)
+{
+  g_return_val_if_fail (GOCL_IS_CONTEXT (context), NULL);
+
+  return g_initable_new (GOCL_TYPE_BUFFER,
+                         NULL,
+                         error,
+                         "context", context,
+                         "flags", flags,
+                         "size", size,
+                         "host-ptr", host_ptr,
+                         NULL);
+}
+
+/**
+ * gocl_buffer_new_from_gl_buffer:
+ * @context: The #GoclContext to create the buffer in
+ * @flags: An OR'ed combination of access values from #GoclBufferFlags
+ * @gl_buffer: The GL buffer object handle
+ *
+ * Creates a new buffer sharing the data store of a GL buffer object, for
+ * instance a vertex buffer filled by a simulation kernel. The size of the
+ * buffer is that of the GL buffer. This only works if the OpenCL platform
+ * supports the <i>cl_khr_gl_sharing</i> extension, and the @context has been
+ * created for sharing with OpenGL, using gocl_context_gpu_new_sync().
+ *
+ * Returns: (transfer full): A newly created #GoclBuffer, or %NULL on error
+ **/
+GoclBuffer *
+gocl_buffer_new_from_gl_buffer (GoclContext *context,
+                                guint        flags,
+                                guint        gl_buffer)
+{
+  GError **error;
+
+  g_return_val_if_fail (GOCL_IS_CONTEXT (context), NULL);
+  g_return_val_if_fail (gl_buffer > 0, NULL);
+
+  error = gocl_error_prepare ();
+
+  return g_initable_new (GOCL_TYPE_BUFFER,
+                         NULL,
+                         error,
+                         "context", context,
+                         "flags", flags,
+                         "gl-buffer", gl_buffer,
+                         NULL);
+}
+
+/**
+ * gocl_buffer_new_managed:
+ * @context: The #GoclContext to create the buffer in
+ * @flags: An OR'ed combination of access values from #GoclBufferFlags
+ * @size: The size of the buffer, in bytes
+ * @data: (allow-none) (array length=size) (element-type guint8): Initial
+ * contents of the buffer, or %NULL
+ *
+ * Creates a new managed buffer. A managed buffer keeps a copy of its
+ * contents in host memory, and tracks which byte ranges are newer on the
+ * host or on the device. Host changes are transferred right before a kernel
+ * that has the buffer bound with gocl_kernel_set_argument_buffer() or
+ * gocl_launch_set_argument_buffer() runs, and only the ranges that changed
+ * are sent. Device changes are transferred back only when the host
+ * accesses them with gocl_buffer_access_sync().
+ *
+ * If @data is not %NULL, it is copied into the host copy and sent to the
+ * device before the first kernel uses the buffer. Otherwise, the contents are
+ * undefined until written. The host pointer flags in @flags are ignored.
+ *
+ * Returns: (transfer full): A newly created #GoclBuffer, or %NULL on error
+ **/
+GoclBuffer *
+gocl_buffer_new_managed (GoclContext   *context,
+                         guint          flags,
+                         gsize          size,
+                         gconstpointer  data)
+{
+  g_return_val_if_fail (GOCL_IS_CONTEXT (context), NULL);
+  g_return_val_if_fail (size > 0, NULL);
+
+  return g_initable_new (GOCL_TYPE_BUFFER,
+                         NULL,
+                         gocl_error_prepare (),
+                         "context", context,
+                         "flags", flags,
+                         "size", (guint64) size,
+                         "host-ptr", data,
+                         "managed", TRUE,
+                         NULL);
+}
+
+/**
+ * gocl_buffer_new_from_bytes:
+ * @context: The #GoclContext to create the buffer in
+ * @bytes: A #GBytes with the contents of the buffer
+ *
+ * Creates a new read-only buffer that uses the memory of @bytes directly,
+ * instead of copying it, and keeps a reference to @bytes for as long as the
+ * buffer exists. This is the cheapest way for language bindings to hand a
+ * large block of data to kernels. Since #GBytes are immutable, kernels must
+ * not write to the buffer, and it must not be mapped for writing.
+ *
+ * Returns: (transfer full): A newly created #GoclBuffer, or %NULL on error
+ **/
+GoclBuffer *
+gocl_buffer_new_from_bytes (GoclContext *context, GBytes *bytes)
+{
+  GoclBuffer *self;
+  gconstpointer data;
+  gsize size;
+
+  g_return_val_if_fail (GOCL_IS_CONTEXT (context), NULL);
+  g_return_val_if_fail (bytes != NULL, NULL);
+
+  data = g_bytes_get_data (bytes, &size);
+  g_return_val_if_fail (size > 0, NULL);
+
+  self = g_initable_new (GOCL_TYPE_BUFFER,
+                         NULL,
+                         gocl_error_prepare (),
+                         "context", context,
+                         "flags", GOCL_BUFFER_FLAGS_READ_ONLY |
+                                  GOCL_BUFFER_FLAGS_USE_HOST_PTR,
+                         "size", (guint64) size,
+                         "host-ptr", data,
+                         NULL);
+  if (self != NULL)
+    self->priv->bytes = g_bytes_ref (bytes);
+
+  return self;
+}
+
+/**
+ * gocl_buffer_new_sub_buffer:
+ * @parent: The #GoclBuffer to create the sub-buffer from
+ * @flags: An OR'ed combination of access values from #GoclBufferFlags
+ * @origin: The offset of the region within @parent, in bytes
+ * @size: The size of the region, in bytes
+ *
+ * Creates a new buffer representing the region of @size bytes of @parent
+ * starting at @origin. The new buffer shares memory with @parent, and keeps
+ * a reference to it. @origin must be aligned to the
+ * CL_DEVICE_MEM_BASE_ADDR_ALIGN value of the context devices.
+ *
+ * Returns: (transfer full): A newly created #GoclBuffer, or %NULL on error
+ **/
+GoclBuffer *
+gocl_buffer_new_sub_buffer (GoclBuffer *parent,
+                            guint       flags,
+                            goffset     origin,
+                            gsize       size)
+{
+  GError **error;
+
+  g_return_val_if_fail (GOCL_IS_BUFFER (parent), NULL);
+  g_return_val_if_fail (! parent->priv->managed, NULL);
+  g_return_val_if_fail (origin + size <= parent->priv->size, NULL);
+
+  error = gocl_error_prepare ();
+
+  return g_initable_new (GOCL_TYPE_BUFFER,
+                         NULL,
+                         error,
+                         "context", parent->priv->context,
+                         "flags", flags,
+                         "size", (guint64) size,
+                         "parent", parent,
+                         "origin", (guint64) origin,
+                         NULL);
+}
+
+/**
+ * gocl_buffer_get_buffer:
+ * @self: The #GoclBuffer
+ *
+ * Retrieves the internal OpenCL #cl_mem object. This is not normally
+ * called by applications. It is rather a low-level, internal API.
+ *
+ * Returns: (type guint64) (transfer none): The internal #cl_mem object
+ **/
+cl_mem
+gocl_buffer_get_buffer (GoclBuffer *self)
+{
+  g_return_val_if_fail (GOCL_IS_BUFFER (self), NULL);
+
+  return self->priv->buf;
+}
+
+/**
+ * gocl_buffer_get_context:
+ * @buffer: The #GoclBuffer
+ *
+ * Retrieves the #GoclContext the buffer belongs to.
+ *
+ * Returns: (transfer none): A #GoclContext object
+ **/
+GoclContext *
+gocl_buffer_get_context (GoclBuffer *buffer)
+{
+  g_return_val_if_fail (GOCL_IS_BUFFER (buffer), NULL);
+
+  return buffer->priv->context;
+}
+
+/**
+ * gocl_buffer_set_tag:
+ * @buffer: The #GoclBuffer
+ * @tag: (allow-none): A tag identifying the owner of the buffer, or %NULL
+ *
+ * Sets a tag that identifies the owner of @buffer, like a module or a
+ * cache of the application. The tag is reported along with the memory
+ * allocated by the buffer by gocl_context_get_allocations().
+ **/
+void
+gocl_buffer_set_tag (GoclBuffer *buffer, const gchar *tag)
+{
+  g_return_if_fail (GOCL_IS_BUFFER (buffer));
+
+  if (g_strcmp0 (buffer->priv->tag, tag) == 0)
+    return;
+
+  g_free (buffer->priv->tag);
+  buffer->priv->tag = g_strdup (tag);
+
+  if (buffer->priv->accounted)
+    gocl_context_set_allocation_tag (buffer->priv->context, buffer, tag);
+
+  g_object_notify (G_OBJECT (buffer), "tag");
+}
+
+/**
+ * gocl_buffer_get_tag:
+ * @buffer: The #GoclBuffer
+ *
+ * Obtains the tag set with gocl_buffer_set_tag().
+ *
+ * Returns: (transfer none): The tag of the buffer, or %NULL
+ **/
+const gchar *
+gocl_buffer_get_tag (GoclBuffer *buffer)
+{
+  g_return_val_if_fail (GOCL_IS_BUFFER (buffer), NULL);
+
+  return buffer->priv->tag;
+}
+
+/**
+ * gocl_buffer_is_managed:
+ * @self: The #GoclBuffer
+ *
+ * Tells whether @self was created with gocl_buffer_new_managed().
+ *
+ * Returns: %TRUE if the buffer is managed, %FALSE otherwise
+ **/
+gboolean
+gocl_buffer_is_managed (GoclBuffer *self)
+{
+  g_return_val_if_fail (GOCL_IS_BUFFER (self), FALSE);
+
+  return self->priv->managed;
+}
+
+/**
+ * gocl_buffer_access_sync:
+ * @self: The managed #GoclBuffer
+ * @queue: A #GoclQueue where transfers from the device are enqueued
+ * @flags: An OR'ed combination of values from #GoclBufferMapFlags
+ * @offset: The offset of the region to access, in bytes
+ * @size: The size of the region to access, in bytes, or 0 to access up to
+ * the end of the buffer
+ *
+ * Gives the host access to a region of the host copy of a managed buffer.
+ * Parts of the region that kernels may have changed since the last access
+ * are first transferred from the device, blocking until they arrive, unless
+ * @flags is %GOCL_BUFFER_MAP_FLAGS_WRITE_INVALIDATE_REGION. If @flags
+ * includes write access, the region is marked as changed on the host and is
+ * sent to the device before the next kernel using the buffer runs.
+ *
+ * The returned pointer stays valid for the lifetime of the buffer, but its
+ * contents are only guaranteed up to date until a kernel using the buffer is
+ * enqueued again. Kernel arguments declared <i>const</i> are assumed not to
+ * be written, which avoids transferring the buffer back after kernels that
+ * only read it.
+ *
+ * Returns: (transfer none): A pointer to the region in host memory, or %NULL
+ * on error
+ **/
+gpointer
+gocl_buffer_access_sync (GoclBuffer *self,
+                         GoclQueue  *queue,
+                         guint       flags,
+                         goffset     offset,
+                         gsize       size)
+{
+  cl_int err_code = CL_SUCCESS;
+  gsize end;
+
+  g_return_val_if_fail (GOCL_IS_BUFFER (self), NULL);
+  g_return_val_if_fail (self->priv->managed, NULL);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), NULL);
+  g_return_val_if_fail (offset >= 0 && (gsize) offset <= self->priv->size, NULL);
+
+  if (size == 0)
+    size = self->priv->size - offset;
+  end = offset + size;
+  g_return_val_if_fail (end <= self->priv->size, NULL);
+
+  g_mutex_lock (&self->priv->managed_mutex);
+
+  if (flags & GOCL_BUFFER_MAP_FLAGS_WRITE_INVALIDATE_REGION)
+    range_set_remove (self->priv->device_dirty, offset, end);
+  else
+    err_code = download_device_dirty (self,
+                                      gocl_queue_get_queue (queue),
+                                      offset,
+                                      end);
+
+  if (err_code == CL_SUCCESS &&
+      (flags & (GOCL_BUFFER_MAP_FLAGS_WRITE |
+                GOCL_BUFFER_MAP_FLAGS_WRITE_INVALIDATE_REGION)))
+    {
+      /* transfers still reading the host copy must be done before it changes */
+      if (self->priv->pending_uploads->len > 0)
+        err_code = clWaitForEvents (self->priv->pending_uploads->len,
+                                    (cl_event *) self->priv->pending_uploads->data);
+      release_events (self->priv->pending_uploads);
+
+      range_set_add (self->priv->host_dirty, offset, end);
+    }
+
+  g_mutex_unlock (&self->priv->managed_mutex);
+
+  if (gocl_error_check_opencl_internal (err_code))
+    return NULL;
+
+  return self->priv->shadow + offset;
+}
+
+/**
+ * gocl_buffer_flush_sync:
+ * @self: The managed #GoclBuffer
+ * @queue: A #GoclQueue where the transfers are enqueued
+ *
+ * Sends the regions of a managed buffer that changed on the host to the
+ * device right away, blocking until they are transferred. This is not
+ * needed before running kernels, which do it themselves, but it is before
+ * the device copy is accessed by other means, like gocl_buffer_copy().
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_buffer_flush_sync (GoclBuffer *self, GoclQueue *queue)
+{
+  cl_int err_code;
+
+  g_return_val_if_fail (GOCL_IS_BUFFER (self), FALSE);
+  g_return_val_if_fail (self->priv->managed, FALSE);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), FALSE);
+
+  g_mutex_lock (&self->priv->managed_mutex);
+
+  err_code = upload_host_dirty (self, gocl_queue_get_queue (queue), NULL);
+  if (err_code == CL_SUCCESS && self->priv->pending_uploads->len > 0)
+    err_code = clWaitForEvents (self->priv->pending_uploads->len,
+                                (cl_event *) self->priv->pending_uploads->data);
+  release_events (self->priv->pending_uploads);
+
+  g_mutex_unlock (&self->priv->managed_mutex);
+
+  return ! gocl_error_check_opencl_internal (err_code);
+}
+
+/**
+ * gocl_buffer_read:
+ * @self: The #GoclBuffer
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @target_ptr: (array length=size) (element-type guint8): The pointer to copy
+ * the data to
+ * @size: The size of the data to be read
+ * @offset: The offset to start reading from
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List or #GoclEvent
+ * object to wait for, or %NULL
+ *
+ * Asynchronously reads a block of data of @size bytes from remote context
+ * into host memory, starting at @offset. The operation is enqueued in
+ * @queue, and the program execution continues without blocking. For a
+ * synchronous version of this methid, see gocl_buffer_read_sync().
+ *
+ * A #GoclEvent is returned so that the application can get notified when the
  * operation finishes, by calling gocl_event_then(). Also, the returned event
  * can be added to the @event_wait_list argument of other operations, to
  * synchronize their execution with the completion of this operation.
  *
- * If @event_wait_list is provided, the write operation will start only when
- * all the #GoclEvent in the list have triggered.
+ * If @event_wait_list is provided, the read operation will start only when
+ * all the #GoclEvent in the list have triggered.
+ *
+ * Returns: (transfer none): A #GoclEvent to get notified when the read
+ * operation finishes
+ **/
+GoclEvent *
+gocl_buffer_read (GoclBuffer *self,
+                  GoclQueue  *queue,
+                  gpointer    target_ptr,
+                  gsize       size,
+                  goffset     offset,
+                  GList      *event_wait_list)
+{
+  GoclWaitList wait_list;
+  GoclEvent *event;
+
+  g_return_val_if_fail (GOCL_IS_BUFFER (self), NULL);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), NULL);
+
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
+  event = enqueue_read_or_write (self,
+                                 queue,
+                                 FALSE,
+                                 target_ptr,
+                                 size,
+                                 offset,
+                                 &wait_list);
+  gocl_wait_list_clear (&wait_list);
+
+  return event;
+}
+
+/**
+ * gocl_buffer_read_sync:
+ * @self: The #GoclBuffer
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @target_ptr: (array length=size) (element-type guint8): The pointer to copy
+ * the data to
+ * @size: The size of the data to be read
+ * @offset: The offset to start reading from
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List or #GoclEvent
+ * object to wait for, or %NULL
+ *
+ * Reads a block of data of @size bytes from remote context into host memory,
+ * starting at @offset. The operation is actually enqueued in @queue, and
+ * the program execution blocks until the read finishes. If @event_wait_list
+ * is provided, the read operation will start only when all the #GoclEvent in
+ * the list have triggered.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_buffer_read_sync (GoclBuffer *self,
+                       GoclQueue  *queue,
+                       gpointer    target_ptr,
+                       gsize       size,
+                       goffset     offset,
+                       GList      *event_wait_list)
+{
+  return gocl_buffer_read_sync_full (self,
+                                     queue,
+                                     target_ptr,
+                                     size,
+                                     offset,
+                                     event_wait_list,
+                                     gocl_error_prepare ());
+}
+
+/**
+ * gocl_buffer_read_sync_full:
+ * @self: The #GoclBuffer
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @target_ptr: (array length=size) (element-type guint8): The pointer to copy
+ * the data to
+ * @size: The size of the data to be read
+ * @offset: The offset to start reading from
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List or #GoclEvent
+ * object to wait for, or %NULL
+ * @error: (allow-none): Return location for a #GError, or %NULL
+ *
+ * Like gocl_buffer_read_sync(), but reports a failure in @error instead of
+ * the last error of the calling thread.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_buffer_read_sync_full (GoclBuffer *self,
+                            GoclQueue  *queue,
+                            gpointer    target_ptr,
+                            gsize       size,
+                            goffset     offset,
+                            GList      *event_wait_list,
+                            GError    **error)
+{
+  cl_command_queue _queue;
+  cl_int err_code;
+  GoclWaitList wait_list;
+
+  g_return_val_if_fail (GOCL_IS_BUFFER (self), FALSE);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), FALSE);
+
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
+
+  _queue = gocl_queue_get_queue (queue);
+
+  err_code = clEnqueueReadBuffer (_queue,
+                                  self->priv->buf,
+                                  CL_TRUE,
+                                  offset,
+                                  size,
+                                  target_ptr,
+                                  wait_list.len,
+                                  wait_list.cl_events,
+                                  NULL);
+
+  gocl_wait_list_clear (&wait_list);
+
+  return ! gocl_error_check_opencl (err_code, error);
+}
+
+/**
+ * gocl_buffer_write:
+ * @self: The #GoclBuffer
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @data: A pointer to write data from
+ * @size: The size of the data to be written
+ * @offset: The offset to start writing data to
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List or #GoclEvent
+ * object to wait for, or %NULL
+ *
+ * Asynchronously writes a block of data of @size bytes from host memory into
+ * remote context, starting at @offset. The operation is enqueued in
+ * @queue, and the program execution continues without blocking. For a
+ * synchronous version of this methid, see gocl_buffer_write_sync().
+ *
+ * A #GoclEvent is returned so that the application can get notified when the
+ * operation finishes, by calling gocl_event_then(). Also, the returned event
+ * can be added to the @event_wait_list argument of other operations, to
+ * synchronize their execution with the completion of this operation.
+ *
+ * If @event_wait_list is provided, the write operation will start only when
+ * all the #GoclEvent in the list have triggered.
+ *
+ * Returns: (transfer none): A #GoclEvent to get notified when the write
+ * operation finishes
+ **/
+GoclEvent *
+gocl_buffer_write (GoclBuffer     *self,
+                   GoclQueue      *queue,
+                   const gpointer  data,
+                   gsize           size,
+                   goffset         offset,
+                   GList          *event_wait_list)
+{
+  GoclWaitList wait_list;
+  GoclEvent *event;
+
+  g_return_val_if_fail (GOCL_IS_BUFFER (self), NULL);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), NULL);
+
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
+  event = enqueue_read_or_write (self,
+                                 queue,
+                                 TRUE,
+                                 data,
+                                 size,
+                                 offset,
+                                 &wait_list);
+  gocl_wait_list_clear (&wait_list);
+
+  return event;
+}
+
+/**
+ * gocl_buffer_read_with_events:
+ * @self: The #GoclBuffer
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @target_ptr: (array length=size) (element-type guint8): The pointer to copy
+ * the data to
+ * @size: The size of the data to be read
+ * @offset: The offset to start reading from
+ * @event_wait_list: (array length=event_wait_list_len) (allow-none): Array
+ * of #GoclEvent objects to wait for, or %NULL
+ * @event_wait_list_len: The number of events in @event_wait_list
+ *
+ * Like gocl_buffer_read(), but takes the events to wait for as a C array,
+ * such as the pdata member of a #GPtrArray. For up to four events, no
+ * memory is allocated for the wait list.
+ *
+ * Returns: (transfer none): A #GoclEvent to get notified when the read
+ * operation finishes
+ **/
+GoclEvent *
+gocl_buffer_read_with_events (GoclBuffer  *self,
+                              GoclQueue   *queue,
+                              gpointer     target_ptr,
+                              gsize        size,
+                              goffset      offset,
+                              GoclEvent  **event_wait_list,
+                              guint        event_wait_list_len)
+{
+  GoclWaitList wait_list;
+  GoclEvent *event;
+
+  g_return_val_if_fail (GOCL_IS_BUFFER (self), NULL);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), NULL);
+  g_return_val_if_fail (event_wait_list != NULL || event_wait_list_len == 0, NULL);
+
+  gocl_wait_list_init (&wait_list, event_wait_list, event_wait_list_len);
+  event = enqueue_read_or_write (self,
+                                 queue,
+                                 FALSE,
+                                 target_ptr,
+                                 size,
+                                 offset,
+                                 &wait_list);
+  gocl_wait_list_clear (&wait_list);
+
+  return event;
+}
+
+/**
+ * gocl_buffer_write_with_events:
+ * @self: The #GoclBuffer
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @data: A pointer to write data from
+ * @size: The size of the data to be written
+ * @offset: The offset to start writing data to
+ * @event_wait_list: (array length=event_wait_list_len) (allow-none): Array
+ * of #GoclEvent objects to wait for, or %NULL
+ * @event_wait_list_len: The number of events in @event_wait_list
+ *
+ * Like gocl_buffer_write(), but takes the events to wait for as a C array,
+ * such as the pdata member of a #GPtrArray. For up to four events, no
+ * memory is allocated for the wait list.
+ *
+ * Returns: (transfer none): A #GoclEvent to get notified when the write
+ * operation finishes
+ **/
+GoclEvent *
+gocl_buffer_write_with_events (GoclBuffer      *self,
+                               GoclQueue       *queue,
+                               const gpointer   data,
+                               gsize            size,
+                               goffset          offset,
+                               GoclEvent      **event_wait_list,
+                               guint            event_wait_list_len)
+{
+  GoclWaitList wait_list;
+  GoclEvent *event;
+
+  g_return_val_if_fail (GOCL_IS_BUFFER (self), NULL);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), NULL);
+  g_return_val_if_fail (event_wait_list != NULL || event_wait_list_len == 0, NULL);
+
+  gocl_wait_list_init (&wait_list, event_wait_list, event_wait_list_len);
+  event = enqueue_read_or_write (self,
+                                 queue,
+                                 TRUE,
+                                 data,
+                                 size,
+                                 offset,
+                                 &wait_list);
+  gocl_wait_list_clear (&wait_list);
+
+  return event;
+}
+
+/**
+ * gocl_buffer_write_sync:
+ * @self: The #GoclBuffer
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @data: A pointer to write data from
+ * @size: The size of the data to be written
+ * @offset: The offset to start writing data to
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List or #GoclEvent
+ * object to wait for, or %NULL
+ *
+ * Writes a block of data of @size bytes from host memory into remote context
+ * memory, starting at @offset. The operation is actually enqueued in @queue, and
+ * the program execution blocks until the read finishes. If @event_wait_list
+ * is provided, the read operation will start only when all the #GoclEvent in
+ * the list have triggered.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_buffer_write_sync (GoclBuffer     *self,
+                        GoclQueue      *queue,
+                        const gpointer  data,
+                        gsize           size,
+                        goffset         offset,
+                        GList          *event_wait_list)
+{
+  return gocl_buffer_write_sync_full (self,
+                                      queue,
+                                      data,
+                                      size,
+                                      offset,
+                                      event_wait_list,
+                                      gocl_error_prepare ());
+}
+
+/**
+ * gocl_buffer_write_sync_full:
+ * @self: The #GoclBuffer
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @data: A pointer to write data from
+ * @size: The size of the data to be written
+ * @offset: The offset to start writing data to
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List or #GoclEvent
+ * object to wait for, or %NULL
+ * @error: (allow-none): Return location for a #GError, or %NULL
+ *
+ * Like gocl_buffer_write_sync(), but reports a failure in @error instead of
+ * the last error of the calling thread.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_buffer_write_sync_full (GoclBuffer     *self,
+                             GoclQueue      *queue,
+                             const gpointer  data,
+                             gsize           size,
+                             goffset         offset,
+                             GList          *event_wait_list,
+                             GError        **error)
+{
+  cl_command_queue _queue;
+  cl_int err_code;
+  GoclWaitList wait_list;
+
+  g_return_val_if_fail (GOCL_IS_BUFFER (self), FALSE);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), FALSE);
+
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
+
+  _queue = gocl_queue_get_queue (queue);
+
+  err_code = clEnqueueWriteBuffer (_queue,
+                                   self->priv->buf,
+                                   CL_TRUE,
+                                   offset,
+                                   size,
+                                   data,
+                                   wait_list.len,
+                                   wait_list.cl_events,
+                                   NULL);
+
+  gocl_wait_list_clear (&wait_list);
+
+  return ! gocl_error_check_opencl (err_code, error);
+}
+
+/**
+ * gocl_buffer_list_to_array:
+ * @list: (element-type Gocl.Buffer) (allow-none): A #GList containing
+ * #GoclBuffer objects
+ * @len: (out) (allow-none): A pointer to a value to retrieve list length
+ *
+ * A convenient method to retrieve a #GList of #GoclBuffer's as an array of
+ * #cl_mem's corresponding to the internal objects of each #GoclBuffer in
+ * the #GList. This is a rather low-level method and should not normally be
+ * called by applications.
+ *
+ * Returns: (transfer container) (array length=len): An array of #cl_mem
+ *   objects. Free with g_free().
+ **/
+cl_mem *
+gocl_buffer_list_to_array (GList *list, guint *len)
+{
+  cl_mem *arr = NULL;
+  gint i;
+  guint _len;
+  GList *node;
+
+  _len = g_list_length (list);
+
+  if (len != NULL)
+    *len = _len;
+
+  if (_len == 0)
+    return arr;
+
+  arr = g_new (cl_mem, g_list_length (list));
+
+  node = list;
+  i = 0;
+  while (node != NULL)
+    {
+      g_return_val_if_fail (GOCL_IS_BUFFER (node->data), NULL);
+
+      arr[i] = gocl_buffer_get_buffer (GOCL_BUFFER (node->data));
+
+      i++;
+      node = g_list_next (node);
+    }
+
+  return arr;
+}
+
+/**
+ * gocl_buffer_read_all_sync:
+ * @self: The #GoclBuffer
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @target_ptr: (array length=size) (element-type guint8) (allow-none): The
+ * pointer to copy the data to
+ * @size: (out) (allow-none): A pointer to retrieve the size of the buffer,
+ * or %NULL
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List or #GoclEvent
+ * object to wait for, or %NULL
+ *
+ * Reads all the data in buffer from remote context into the host memory
+ * referenced by @target_ptr. The operation is enqueued in @queue, and the
+ * program execution blocks until the read finishes.
+ *
+ * If @size is not %NULL, it will store the total size read.
+ *
+ * If @event_wait_list is provided, the read operation will
+ * start only when all the #GoclEvent in the list have triggered.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_buffer_read_all_sync (GoclBuffer *self,
+                           GoclQueue  *queue,
+                           gpointer    target_ptr,
+                           gsize      *size,
+                           GList      *event_wait_list)
+{
+  GoclBufferClass *class;
+  cl_command_queue _queue;
+  cl_int err_code;
+  GoclWaitList wait_list;
+  cl_mem buffer;
+
+  g_return_val_if_fail (GOCL_IS_BUFFER (self), FALSE);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), FALSE);
+  g_return_val_if_fail (target_ptr != NULL, FALSE);
+
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
+
+  _queue = gocl_queue_get_queue (queue);
+
+  buffer = gocl_buffer_get_buffer (GOCL_BUFFER (self));
+
+  class = GOCL_BUFFER_GET_CLASS (self);
+  g_assert (class->read_all != NULL);
+
+  err_code = class->read_all (self,
+                              buffer,
+                              _queue,
+                              target_ptr,
+                              size,
+                              TRUE,
+                              wait_list.cl_events,
+                              wait_list.len,
+                              NULL);
+  gocl_wait_list_clear (&wait_list);
+
+  return ! gocl_error_check_opencl_internal (err_code);
+}
+
+/**
+ * gocl_buffer_read_all:
+ * @self: The #GoclBuffer
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @target_ptr: (array length=size) (element-type guint8): The pointer to copy
+ * the data to
+ * @size: (out) (allow-none): A pointer to retrieve the size of the buffer,
+ * or %NULL
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List or #GoclEvent
+ * object to wait for, or %NULL
+ *
+ * Asynchronously reads all the data in buffer from remote context into the
+ * host memory referenced by @target_ptr, which must be large enough to hold
+ * the whole buffer. The operation is enqueued in @queue, and the program
+ * execution continues without blocking. The memory pointed by @target_ptr
+ * must remain valid until the returned event resolves.
+ *
+ * If @size is not %NULL, it will store the total size to be read.
+ *
+ * If @event_wait_list is provided, the read operation will
+ * start only when all the #GoclEvent in the list have triggered.
+ *
+ * Returns: (transfer none): A #GoclEvent to get notified when the read
+ * operation finishes
+ **/
+GoclEvent *
+gocl_buffer_read_all (GoclBuffer *self,
+                      GoclQueue  *queue,
+                      gpointer    target_ptr,
+                      gsize      *size,
+                      GList      *event_wait_list)
+{
+  GoclBufferClass *class;
+  cl_int err_code;
+  cl_event event;
+  GoclWaitList wait_list;
+  gsize _size = 0;
+
+  g_return_val_if_fail (GOCL_IS_BUFFER (self), NULL);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), NULL);
+  g_return_val_if_fail (target_ptr != NULL, NULL);
+
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
+
+  class = GOCL_BUFFER_GET_CLASS (self);
+  g_assert (class->read_all != NULL);
+
+  err_code = class->read_all (self,
+                              self->priv->buf,
+                              gocl_queue_get_queue (queue),
+                              target_ptr,
+                              &_size,
+                              FALSE,
+                              wait_list.cl_events,
+                              wait_list.len,
+                              &event);
+  gocl_wait_list_clear (&wait_list);
+
+  if (size != NULL)
+    *size = _size;
+
+  return gocl_event_new_for_command (queue,
+                                     err_code,
+                                     event,
+                                     event_wait_list,
+                                     "buffer-read",
+                                     _size);
+}
+
+/**
+ * gocl_buffer_write_bytes:
+ * @self: The #GoclBuffer
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @bytes: A #GBytes with the data to write
+ * @offset: The offset to start writing data to
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List or #GoclEvent
+ * object to wait for, or %NULL
+ *
+ * Asynchronously writes the contents of @bytes into the buffer, starting at
+ * @offset. Unlike gocl_buffer_write(), the data is not copied and the caller
+ * need not keep it alive: a reference to @bytes is held until the write
+ * completes. This lets language bindings pass large payloads without
+ * marshalling them into temporary arrays. An empty @bytes enqueues nothing,
+ * and the returned event resolves right away.
+ *
+ * Returns: (transfer none): A #GoclEvent to get notified when the write
+ * operation finishes
+ **/
+GoclEvent *
+gocl_buffer_write_bytes (GoclBuffer *self,
+                         GoclQueue  *queue,
+                         GBytes     *bytes,
+                         goffset     offset,
+                         GList      *event_wait_list)
+{
+  GoclWaitList wait_list;
+  gconstpointer data;
+  gsize size;
+  cl_int err_code;
+  cl_event event;
+
+  g_return_val_if_fail (GOCL_IS_BUFFER (self), NULL);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), NULL);
+  g_return_val_if_fail (bytes != NULL, NULL);
+
+  data = g_bytes_get_data (bytes, &size);
+  g_return_val_if_fail (offset >= 0 && (gsize) offset <= self->priv->size, NULL);
+  g_return_val_if_fail (size <= self->priv->size - offset, NULL);
+
+  /* OpenCL rejects empty writes */
+  if (size == 0)
+    return gocl_event_new_for_command (queue,
+                                       CL_SUCCESS,
+                                       NULL,
+                                       event_wait_list,
+                                       "buffer-write",
+                                       0);
+
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
+  err_code = clEnqueueWriteBuffer (gocl_queue_get_queue (queue),
+                                   self->priv->buf,
+                                   CL_FALSE,
+                                   offset,
+                                   size,
+                                   data,
+                                   wait_list.len,
+                                   wait_list.cl_events,
+                                   &event);
+  gocl_wait_list_clear (&wait_list);
+
+  if (err_code == CL_SUCCESS)
+    hold_until_complete (event,
+                         g_bytes_ref (bytes),
+                         (GDestroyNotify) g_bytes_unref);
+
+  return gocl_event_new_for_command (queue,
+                                     err_code,
+                                     event,
+                                     event_wait_list,
+                                     "buffer-write",
+                                     size);
+}
+
+/**
+ * gocl_buffer_read_to_byte_array:
+ * @self: The #GoclBuffer
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @target: The #GByteArray to read the data into
+ * @offset: The offset to start reading data from
+ * @size: The number of bytes to read, or 0 to read up to the end of the
+ * buffer
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List or #GoclEvent
+ * object to wait for, or %NULL
+ *
+ * Asynchronously reads @size bytes of the buffer, starting at @offset, into
+ * @target, which is resized to hold them. A reference to @target is held
+ * until the read completes, so the caller may drop its own right away. The
+ * contents of @target are only valid once the returned event resolves. When
+ * @offset is the end of the buffer, nothing is enqueued, @target is emptied
+ * and the returned event resolves right away.
+ *
+ * Returns: (transfer none): A #GoclEvent to get notified when the read
+ * operation finishes
+ **/
+GoclEvent *
+gocl_buffer_read_to_byte_array (GoclBuffer *self,
+                                GoclQueue  *queue,
+                                GByteArray *target,
+                                goffset     offset,
+                                gsize       size,
+                                GList      *event_wait_list)
+{
+  GoclWaitList wait_list;
+  cl_int err_code;
+  cl_event event;
+
+  g_return_val_if_fail (GOCL_IS_BUFFER (self), NULL);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), NULL);
+  g_return_val_if_fail (target != NULL, NULL);
+  g_return_val_if_fail (offset >= 0 && (gsize) offset <= self->priv->size, NULL);
+
+  if (size == 0)
+    size = self->priv->size - offset;
+  g_return_val_if_fail (size <= self->priv->size - offset, NULL);
+  g_return_val_if_fail (size <= G_MAXUINT, NULL);
+
+  g_byte_array_set_size (target, size);
+
+  /* OpenCL rejects empty reads, which happen when @offset is the end */
+  if (size == 0)
+    return gocl_event_new_for_command (queue,
+                                       CL_SUCCESS,
+                                       NULL,
+                                       event_wait_list,
+                                       "buffer-read",
+                                       0);
+
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
+  err_code = clEnqueueReadBuffer (gocl_queue_get_queue (queue),
+                                  self->priv->buf,
+                                  CL_FALSE,
+                                  offset,
+                                  size,
+                                  target->data,
+                                  wait_list.len,
+                                  wait_list.cl_events,
+                                  &event);
+  gocl_wait_list_clear (&wait_list);
+
+  if (err_code == CL_SUCCESS)
+    hold_until_complete (event,
+                         g_byte_array_ref (target),
+                         (GDestroyNotify) g_byte_array_unref);
+
+  return gocl_event_new_for_command (queue,
+                                     err_code,
+                                     event,
+                                     event_wait_list,
+                                     "buffer-read",
+                                     size);
+}
+
+/**
+ * gocl_buffer_read_to_bytes_sync:
+ * @self: The #GoclBuffer
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @offset: The offset to start reading data from
+ * @size: The number of bytes to read, or 0 to read up to the end of the
+ * buffer
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List or #GoclEvent
+ * object to wait for, or %NULL
+ *
+ * Reads @size bytes of the buffer, starting at @offset, into a newly
+ * allocated #GBytes, blocking until the data arrives. The data is read
+ * directly into the memory owned by the returned #GBytes, without further
+ * copies.
  *
- * Returns: (transfer none): A #GoclEvent to get notified when the write
- * operation finishes
+ * Returns: (transfer full): A #GBytes with the data, or %NULL on error
  **/
-GoclEvent *
-gocl_buffer_write (GoclBuffer     *self,
-                   GoclQueue      *queue,
-                   const gpointer  data,
-                   gsize           size,
-                   goffset         offset,
-                   GList          *event_wait_list)
+GBytes *
+gocl_buffer_read_to_bytes_sync (GoclBuffer *self,
+                                GoclQueue  *queue,
+                                goffset     offset,
+                                gsize       size,
+                                GList      *event_wait_list)
 {
-  GError *error = NULL;
+  GoclWaitList wait_list;
+  gpointer data;
   cl_int err_code;
-  cl_event event;
-  cl_command_queue _queue;
-
-  GoclEvent *_event = NULL;
-  GoclEventResolverFunc resolver_func;
-
-  cl_event *_event_wait_list = NULL;
 
   g_return_val_if_fail (GOCL_IS_BUFFER (self), NULL);
   g_return_val_if_fail (GOCL_IS_QUEUE (queue), NULL);
+  g_return_val_if_fail (offset >= 0 && (gsize) offset <= self->priv->size, NULL);
 
-  _event_wait_list = gocl_event_list_to_array (event_wait_list, NULL);
-
-  _queue = gocl_queue_get_queue (queue);
-
-  err_code = clEnqueueWriteBuffer (_queue,
-                                   self->priv->buf,
-                                   CL_FALSE,
-                                   offset,
-                                   size,
-                                   data,
-                                   g_list_length (event_wait_list),
-                                   _event_wait_list,
-                                   &event);
-  g_free (_event_wait_list);
+  if (size == 0)
+    size = self->priv->size - offset;
+  g_return_val_if_fail (size <= self->priv->size - offset, NULL);
 
-  if (gocl_error_check_opencl (err_code, &error))
+  /* OpenCL rejects empty reads, which happen when @offset is the end */
+  if (size == 0)
     {
-      _event = g_object_new (GOCL_TYPE_EVENT,
-                             "queue", queue,
-                             NULL);
-      resolver_func = gocl_event_steal_resolver_func (_event);
-      resolver_func (_event, error);
-      g_error_free (error);
+      gocl_error_check_opencl_internal (CL_SUCCESS);
+      return g_bytes_new (NULL, 0);
     }
-  else
+
+  data = g_malloc (size);
+
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
+  err_code = clEnqueueReadBuffer (gocl_queue_get_queue (queue),
+                                  self->priv->buf,
+                                  CL_TRUE,
+                                  offset,
+                                  size,
+                                  data,
+                                  wait_list.len,
+                                  wait_list.cl_events,
+                                  NULL);
+  gocl_wait_list_clear (&wait_list);
+
+  if (gocl_error_check_opencl_internal (err_code))
     {
-      _event = g_object_new (GOCL_TYPE_EVENT,
-                             "queue", queue,
-                             "event", event,
-                             NULL);
-      gocl_event_set_event_wait_list (_event, event_wait_list);
-      gocl_event_steal_resolver_func (_event);
+      g_free (data);
+      return NULL;
     }
 
-  gocl_event_idle_unref (_event);
-
-  return _event;
+  return g_bytes_new_take (data, size);
 }
 
 /**
- * gocl_buffer_write_sync:
+ * gocl_buffer_map:
  * @self: The #GoclBuffer
  * @queue: A #GoclQueue where the operation will be enqueued
- * @data: A pointer to write data from
- * @size: The size of the data to be written
- * @offset: The offset to start writing data to
+ * @flags: An OR'ed combination of values from #GoclBufferMapFlags
+ * @offset: The offset of the region to map, in bytes
+ * @size: The size of the region to map in bytes, or zero to map up to the end
+ * of the buffer
+ * @mapped_ptr: (out): A pointer to retrieve the address of the mapped region
+ * @row_pitch: (out) (allow-none): A pointer to retrieve the row pitch of the
+ * mapped region, or %NULL
+ * @slice_pitch: (out) (allow-none): A pointer to retrieve the slice pitch of
+ * the mapped region, or %NULL
  * @event_wait_list: (element-type Gocl.Event) (allow-none): List or #GoclEvent
  * object to wait for, or %NULL
  *
- * Writes a block of data of @size bytes from host memory into remote context
- * memory, starting at @offset. The operation is actually enqueued in @queue, and
- * the program execution blocks until the read finishes. If @event_wait_list
- * is provided, the read operation will start only when all the #GoclEvent in
- * the list have triggered.
+ * Asynchronously maps a region of @size bytes of the buffer, starting at
+ * @offset, into host address space. The operation is enqueued in @queue, and
+ * the program execution continues without blocking. For a synchronous version
+ * of this method, see gocl_buffer_map_sync().
  *
- * Returns: %TRUE on success, %FALSE on error
+ * The address of the mapped region is stored in @mapped_ptr right away, but
+ * its contents must not be accessed until the returned #GoclEvent has
+ * triggered. The region must later be released with gocl_buffer_unmap().
+ *
+ * Row and slice pitches are only meaningful for images. For #GoclImage
+ * objects, @offset and @size are ignored and the whole image is mapped. For
+ * plain buffers, both pitches are set to zero.
+ *
+ * If @event_wait_list is provided, the map operation will start only when
+ * all the #GoclEvent in the list have triggered.
+ *
+ * Returns: (transfer none): A #GoclEvent to get notified when the map
+ * operation finishes
  **/
-gboolean
-gocl_buffer_write_sync (GoclBuffer     *self,
-                        GoclQueue      *queue,
-                        const gpointer  data,
-                        gsize           size,
-                        goffset         offset,
-                        GList          *event_wait_list)
+GoclEvent *
+gocl_buffer_map (GoclBuffer  *self,
+                 GoclQueue   *queue,
+                 guint        flags,
+                 goffset      offset,
+                 gsize        size,
+                 gpointer    *mapped_ptr,
+                 gsize       *row_pitch,
+                 gsize       *slice_pitch,
+                 GList       *event_wait_list)
 {
-  cl_command_queue _queue;
-  cl_int err_code;
-  cl_event *_event_wait_list = NULL;
-
-  g_return_val_if_fail (GOCL_IS_BUFFER (self), FALSE);
-  g_return_val_if_fail (GOCL_IS_QUEUE (queue), FALSE);
-
-  _event_wait_list = gocl_event_list_to_array (event_wait_list, NULL);
-
-  _queue = gocl_queue_get_queue (queue);
+  GoclBufferClass *class;
+  cl_int err_code = CL_SUCCESS;
+  cl_event event;
+  GoclWaitList wait_list;
+  gpointer ptr;
 
-  err_code = clEnqueueWriteBuffer (_queue,
-                                   self->priv->buf,
-                                   CL_TRUE,
-                                   offset,
-                                   size,
-                                   data,
-                                   g_list_length (event_wait_list),
-                                   _event_wait_list,
-                                   NULL);
+  g_return_val_if_fail (GOCL_IS_BUFFER (self), NULL);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), NULL);
+  g_return_val_if_fail (mapped_ptr != NULL, NULL);
 
-  g_free (_event_wait_list);
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
 
-  return ! gocl_error_check_opencl_internal (err_code);
+  class = GOCL_BUFFER_GET_CLASS (self);
+  g_assert (class->map != NULL);
+
+  ptr = class->map (self,
+                    self->priv->buf,
+                    gocl_queue_get_queue (queue),
+                    FALSE,
+                    flags,
+                    offset,
+                    size,
+                    row_pitch,
+                    slice_pitch,
+                    wait_list.cl_events,
+                    wait_list.len,
+                    &event,
+                    &err_code);
+  gocl_wait_list_clear (&wait_list);
+
+  *mapped_ptr = err_code == CL_SUCCESS ? ptr : NULL;
+
+  return gocl_event_new_for_command (queue,
+                                     err_code,
+                                     event,
+                                     event_wait_list,
+                                     "buffer-map",
+                                     0);
 }
 
 /**
- * gocl_buffer_list_to_array:
- * @list: (element-type Gocl.Buffer) (allow-none): A #GList containing
- * #GoclBuffer objects
- * @len: (out) (allow-none): A pointer to a value to retrieve list length
+ * gocl_buffer_map_sync:
+ * @self: The #GoclBuffer
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @flags: An OR'ed combination of values from #GoclBufferMapFlags
+ * @offset: The offset of the region to map, in bytes
+ * @size: The size of the region to map in bytes, or zero to map up to the end
+ * of the buffer
+ * @row_pitch: (out) (allow-none): A pointer to retrieve the row pitch of the
+ * mapped region, or %NULL
+ * @slice_pitch: (out) (allow-none): A pointer to retrieve the slice pitch of
+ * the mapped region, or %NULL
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List or #GoclEvent
+ * object to wait for, or %NULL
  *
- * A convenient method to retrieve a #GList of #GoclBuffer's as an array of
- * #cl_mem's corresponding to the internal objects of each #GoclBuffer in
- * the #GList. This is a rather low-level method and should not normally be
- * called by applications.
+ * Maps a region of @size bytes of the buffer, starting at @offset, into host
+ * address space. The operation is actually enqueued in @queue, and the program
+ * execution blocks until the region is accessible from the host. See
+ * gocl_buffer_map() for details on how images are mapped.
  *
- * Returns: (transfer container) (array length=len): An array of #cl_mem
- *   objects. Free with g_free().
+ * The region must later be released with gocl_buffer_unmap() or
+ * gocl_buffer_unmap_sync().
+ *
+ * Returns: (transfer none): The address of the mapped region, or %NULL on
+ * error
  **/
-cl_mem *
-gocl_buffer_list_to_array (GList *list, guint *len)
+gpointer
+gocl_buffer_map_sync (GoclBuffer  *self,
+                      GoclQueue   *queue,
+                      guint        flags,
+                      goffset      offset,
+                      gsize        size,
+                      gsize       *row_pitch,
+                      gsize       *slice_pitch,
+                      GList       *event_wait_list)
 {
-  cl_mem *arr = NULL;
-  gint i;
-  guint _len;
-  GList *node;
-
-  _len = g_list_length (list);
-
-  if (len != NULL)
-    *len = _len;
-
-  if (_len == 0)
-    return arr;
-
-  arr = g_new (cl_mem, g_list_length (list));
-
-  node = list;
-  i = 0;
-  while (node != NULL)
-    {
-      g_return_val_if_fail (GOCL_IS_BUFFER (node->data), NULL);
+  GoclBufferClass *class;
+  cl_int err_code = CL_SUCCESS;
+  GoclWaitList wait_list;
+  gpointer ptr;
 
-      arr[i] = gocl_buffer_get_buffer (GOCL_BUFFER (node->data));
+  g_return_val_if_fail (GOCL_IS_BUFFER (self), NULL);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), NULL);
 
-      i++;
-      node = g_list_next (node);
-    }
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
 
-  return arr;
+  class = GOCL_BUFFER_GET_CLASS (self);
+  g_assert (class->map != NULL);
+
+  ptr = class->map (self,
+                    self->priv->buf,
+                    gocl_queue_get_queue (queue),
+                    TRUE,
+                    flags,
+                    offset,
+                    size,
+                    row_pitch,
+                    slice_pitch,
+                    wait_list.cl_events,
+                    wait_list.len,
+                    NULL,
+                    &err_code);
+  gocl_wait_list_clear (&wait_list);
+
+  if (gocl_error_check_opencl_internal (err_code))
+    return NULL;
+
+  return ptr;
 }
 
 /**
- * gocl_buffer_read_all_sync:
+ * gocl_buffer_unmap:
  * @self: The #GoclBuffer
  * @queue: A #GoclQueue where the operation will be enqueued
- * @target_ptr: (array length=size) (element-type guint8) (allow-none): The
- * pointer to copy the data to
- * @size: (out) (allow-none): A pointer to retrieve the size of the buffer,
- * or %NULL
+ * @mapped_ptr: The address of a region previously mapped with
+ * gocl_buffer_map() or gocl_buffer_map_sync()
  * @event_wait_list: (element-type Gocl.Event) (allow-none): List or #GoclEvent
  * object to wait for, or %NULL
  *
- * Reads all the data in buffer from remote context into the host memory
- * referenced by @target_ptr. The operation is enqueued in @queue, and the
- * program execution blocks until the read finishes.
+ * Asynchronously releases a region of the buffer previously mapped into host
+ * address space. Any change done by the host to the region is visible to the
+ * device once the returned #GoclEvent has triggered. For a synchronous version
+ * of this method, see gocl_buffer_unmap_sync().
  *
- * If @size is not %NULL, it will store the total size read.
+ * If @event_wait_list is provided, the unmap operation will start only when
+ * all the #GoclEvent in the list have triggered.
  *
- * If @event_wait_list is provided, the read operation will
- * start only when all the #GoclEvent in the list have triggered.
+ * Returns: (transfer none): A #GoclEvent to get notified when the unmap
+ * operation finishes
+ **/
+GoclEvent *
+gocl_buffer_unmap (GoclBuffer  *self,
+                   GoclQueue   *queue,
+                   gpointer     mapped_ptr,
+                   GList       *event_wait_list)
+{
+  cl_int err_code;
+  cl_event event;
+  GoclWaitList wait_list;
+
+  g_return_val_if_fail (GOCL_IS_BUFFER (self), NULL);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), NULL);
+  g_return_val_if_fail (mapped_ptr != NULL, NULL);
+
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
+
+  err_code = clEnqueueUnmapMemObject (gocl_queue_get_queue (queue),
+                                      self->priv->buf,
+                                      mapped_ptr,
+                                      wait_list.len,
+                                      wait_list.cl_events,
+                                      &event);
+  gocl_wait_list_clear (&wait_list);
+
+  return gocl_event_new_for_command (queue,
+                                     err_code,
+                                     event,
+                                     event_wait_list,
+                                     "buffer-unmap",
+                                     0);
+}
+
+/**
+ * gocl_buffer_unmap_sync:
+ * @self: The #GoclBuffer
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @mapped_ptr: The address of a region previously mapped with
+ * gocl_buffer_map() or gocl_buffer_map_sync()
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List or #GoclEvent
+ * object to wait for, or %NULL
+ *
+ * Releases a region of the buffer previously mapped into host address space.
+ * The operation is actually enqueued in @queue, and the program execution
+ * blocks until the unmap finishes.
  *
  * Returns: %TRUE on success, %FALSE on error
  **/
 gboolean
-gocl_buffer_read_all_sync (GoclBuffer *self,
-                           GoclQueue  *queue,
-                           gpointer    target_ptr,
-                           gsize      *size,
-                           GList      *event_wait_list)
+gocl_buffer_unmap_sync (GoclBuffer  *self,
+                        GoclQueue   *queue,
+                        gpointer     mapped_ptr,
+                        GList       *event_wait_list)
 {
-  GoclBufferClass *class;
-  cl_command_queue _queue;
   cl_int err_code;
-  cl_event *_event_wait_list = NULL;
-  guint event_wait_list_len;
-  cl_mem buffer;
+  cl_event event;
+  GoclWaitList wait_list;
 
   g_return_val_if_fail (GOCL_IS_BUFFER (self), FALSE);
   g_return_val_if_fail (GOCL_IS_QUEUE (queue), FALSE);
-  g_return_val_if_fail (target_ptr != NULL, FALSE);
+  g_return_val_if_fail (mapped_ptr != NULL, FALSE);
 
-  _event_wait_list = gocl_event_list_to_array (event_wait_list,
-                                               &event_wait_list_len);
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
 
-  _queue = gocl_queue_get_queue (queue);
+  /* unmapping is never blocking in OpenCL, so wait for the event */
+  err_code = clEnqueueUnmapMemObject (gocl_queue_get_queue (queue),
+                                      self->priv->buf,
+                                      mapped_ptr,
+                                      wait_list.len,
+                                      wait_list.cl_events,
+                                      &event);
+  gocl_wait_list_clear (&wait_list);
 
-  buffer = gocl_buffer_get_buffer (GOCL_BUFFER (self));
+  if (err_code == CL_SUCCESS)
+    {
+      err_code = clWaitForEvents (1, &event);
+      clReleaseEvent (event);
+    }
 
-  class = GOCL_BUFFER_GET_CLASS (self);
-  g_assert (class->read_all != NULL);
+  return ! gocl_error_check_opencl_internal (err_code);
+}
 
-  err_code = class->read_all (self,
-                              buffer,
-                              _queue,
-                              target_ptr,
-                              size,
-                              TRUE,
-                              _event_wait_list,
-                              event_wait_list_len,
-                              NULL);
-  g_free (_event_wait_list);
+/**
+ * gocl_buffer_copy:
+ * @self: The #GoclBuffer to copy from
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @target: The #GoclBuffer to copy to
+ * @src_offset: The offset inside @self where to start copying, in bytes
+ * @dst_offset: The offset inside @target where to start writing, in bytes
+ * @size: The number of bytes to copy
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List of
+ * #GoclEvent objects to wait for, or %NULL
+ *
+ * Asynchronously copies @size bytes from @self into @target, without
+ * transferring the data through host memory. @self and @target can be the
+ * same buffer, as long as the source and destination ranges do not overlap.
+ *
+ * Returns: (transfer none): A #GoclEvent to get notified when the copy
+ * operation finishes
+ **/
+GoclEvent *
+gocl_buffer_copy (GoclBuffer *self,
+                  GoclQueue  *queue,
+                  GoclBuffer *target,
+                  goffset     src_offset,
+                  goffset     dst_offset,
+                  gsize       size,
+                  GList      *event_wait_list)
+{
+  cl_int err_code;
+  cl_event event;
+  GoclWaitList wait_list;
 
-  return ! gocl_error_check_opencl_internal (err_code);
+  g_return_val_if_fail (GOCL_IS_BUFFER (self), NULL);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), NULL);
+  g_return_val_if_fail (GOCL_IS_BUFFER (target), NULL);
+
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
+
+  err_code = clEnqueueCopyBuffer (gocl_queue_get_queue (queue),
+                                  self->priv->buf,
+                                  target->priv->buf,
+                                  src_offset,
+                                  dst_offset,
+                                  size,
+                                  wait_list.len,
+                                  wait_list.cl_events,
+                                  &event);
+  gocl_wait_list_clear (&wait_list);
+
+  return gocl_event_new_for_command (queue,
+                                     err_code,
+                                     event,
+                                     event_wait_list,
+                                     "buffer-copy",
+                                     size);
+}
+
+/**
+ * gocl_buffer_copy_rect:
+ * @self: The #GoclBuffer to copy from
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @target: The #GoclBuffer to copy to
+ * @src_origin: (array fixed-size=3): The (x, y, z) offset of the region in
+ * @self, with x in bytes and y, z in rows and slices
+ * @dst_origin: (array fixed-size=3): The (x, y, z) offset of the region in
+ * @target, with x in bytes and y, z in rows and slices
+ * @region: (array fixed-size=3): The (width, height, depth) of the region,
+ * with width in bytes and height, depth in rows and slices
+ * @src_row_pitch: The length in bytes of each row in @self, or 0
+ * @src_slice_pitch: The size in bytes of each 2D slice in @self, or 0
+ * @dst_row_pitch: The length in bytes of each row in @target, or 0
+ * @dst_slice_pitch: The size in bytes of each 2D slice in @target, or 0
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List of
+ * #GoclEvent objects to wait for, or %NULL
+ *
+ * Asynchronously copies a 2D or 3D rectangular region from @self into
+ * @target, treating both buffers as arrays of rows and slices. A pitch of 0
+ * means rows or slices are tightly packed. Unused dimensions must be 0 in
+ * the origins and 1 in @region.
+ *
+ * Returns: (transfer none): A #GoclEvent to get notified when the copy
+ * operation finishes
+ **/
+GoclEvent *
+gocl_buffer_copy_rect (GoclBuffer  *self,
+                       GoclQueue   *queue,
+                       GoclBuffer  *target,
+                       const gsize *src_origin,
+                       const gsize *dst_origin,
+                       const gsize *region,
+                       gsize        src_row_pitch,
+                       gsize        src_slice_pitch,
+                       gsize        dst_row_pitch,
+                       gsize        dst_slice_pitch,
+                       GList       *event_wait_list)
+{
+  cl_int err_code;
+  cl_event event;
+  GoclWaitList wait_list;
+
+  g_return_val_if_fail (GOCL_IS_BUFFER (self), NULL);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), NULL);
+  g_return_val_if_fail (GOCL_IS_BUFFER (target), NULL);
+  g_return_val_if_fail (src_origin != NULL && dst_origin != NULL, NULL);
+  g_return_val_if_fail (region != NULL, NULL);
+
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
+
+  err_code = clEnqueueCopyBufferRect (gocl_queue_get_queue (queue),
+                                      self->priv->buf,
+                                      target->priv->buf,
+                                      src_origin,
+                                      dst_origin,
+                                      region,
+                                      src_row_pitch,
+                                      src_slice_pitch,
+                                      dst_row_pitch,
+                                      dst_slice_pitch,
+                                      wait_list.len,
+                                      wait_list.cl_events,
+                                      &event);
+  gocl_wait_list_clear (&wait_list);
+
+  return gocl_event_new_for_command (queue,
+                                     err_code,
+                                     event,
+                                     event_wait_list,
+                                     "buffer-copy-rect",
+                                     (guint64) region[0] * region[1] * region[2]);
+}
+
+/**
+ * gocl_buffer_fill:
+ * @self: The #GoclBuffer
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @pattern: (array length=pattern_size) (element-type guint8): A pointer to
+ * the pattern to fill the buffer with
+ * @pattern_size: The size of the pattern, in bytes. Must be 1, 2, 4, 8, 16,
+ * 32, 64 or 128
+ * @offset: The offset inside the buffer where to start filling, in bytes
+ * @size: The number of bytes to fill, a multiple of @pattern_size
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List of
+ * #GoclEvent objects to wait for, or %NULL
+ *
+ * Asynchronously fills @size bytes of the buffer starting at @offset with
+ * repeated copies of @pattern. The pattern is copied before this function
+ * returns, so @pattern can be freed right away.
+ *
+ * Returns: (transfer none): A #GoclEvent to get notified when the fill
+ * operation finishes
+ **/
+GoclEvent *
+gocl_buffer_fill (GoclBuffer    *self,
+                  GoclQueue     *queue,
+                  gconstpointer  pattern,
+                  gsize          pattern_size,
+                  goffset        offset,
+                  gsize          size,
+                  GList         *event_wait_list)
+{
+  cl_int err_code;
+  cl_event event;
+  GoclWaitList wait_list;
+
+  g_return_val_if_fail (GOCL_IS_BUFFER (self), NULL);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), NULL);
+  g_return_val_if_fail (pattern != NULL && pattern_size > 0, NULL);
+
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
+
+  err_code = clEnqueueFillBuffer (gocl_queue_get_queue (queue),
+                                  self->priv->buf,
+                                  pattern,
+                                  pattern_size,
+                                  offset,
+                                  size,
+                                  wait_list.len,
+                                  wait_list.cl_events,
+                                  &event);
+  gocl_wait_list_clear (&wait_list);
+
+  return gocl_event_new_for_command (queue,
+                                     err_code,
+                                     event,
+                                     event_wait_list,
+                                     "buffer-fill",
+                                     size);
 }
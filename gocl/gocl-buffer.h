@@ -69,10 +69,37 @@ struct _GoclBufferClass
                             cl_event            *event_wait_list,
                             guint                event_wait_list_len,
                             cl_event            *out_event);
+  gpointer (* map)         (GoclBuffer          *self,
+                            cl_mem               buffer,
+                            cl_command_queue     queue,
+                            gboolean             blocking,
+                            guint                flags,
+                            goffset              offset,
+                            gsize                size,
+                            gsize               *row_pitch,
+                            gsize               *slice_pitch,
+                            cl_event            *event_wait_list,
+                            guint                event_wait_list_len,
+                            cl_event            *out_event,
+                            cl_int              *err_code);
 };
 
 GType                  gocl_buffer_get_type                   (void) G_GNUC_CONST;
 
+GoclBuffer *           gocl_buffer_new_sub_buffer             (GoclBuffer *parent,
+                                                               guint       flags,
+                                                               goffset     origin,
+                                                               gsize       size);
+
+gboolean               gocl_buffer_is_managed                 (GoclBuffer *self);
+gpointer               gocl_buffer_access_sync                (GoclBuffer *self,
+                                                               GoclQueue  *queue,
+                                                               guint       flags,
+                                                               goffset     offset,
+                                                               gsize       size);
+gboolean               gocl_buffer_flush_sync                 (GoclBuffer *self,
+                                                               GoclQueue  *queue);
+
 GoclEvent *            gocl_buffer_read                       (GoclBuffer *self,
                                                                GoclQueue  *queue,
                                                                gpointer    target_ptr,
@@ -85,6 +112,13 @@ gboolean               gocl_buffer_read_sync                  (GoclBuffer  *self
                                                                gsize        size,
                                                                goffset      offset,
                                                                GList       *event_wait_list);
+gboolean               gocl_buffer_read_sync_full             (GoclBuffer  *self,
+                                                               GoclQueue   *queue,
+                                                               gpointer     target_ptr,
+                                                               gsize        size,
+                                                               goffset      offset,
+                                                               GList       *event_wait_list,
+                                                               GError     **error);
 GoclEvent *            gocl_buffer_write                      (GoclBuffer     *self,
                                                                GoclQueue      *queue,
                                                                const gpointer  data,
@@ -97,12 +131,107 @@ gboolean               gocl_buffer_write_sync                 (GoclBuffer      *
                                                                gsize            size,
                                                                goffset          offset,
                                                                GList           *event_wait_list);
+gboolean               gocl_buffer_write_sync_full            (GoclBuffer      *self,
+                                                               GoclQueue       *queue,
+                                                               const gpointer   data,
+                                                               gsize            size,
+                                                               goffset          offset,
+                                                               GList           *event_wait_list,
+                                                               GError         **error);
+GoclEvent *            gocl_buffer_read_with_events           (GoclBuffer  *self,
+                                                               GoclQueue   *queue,
+                                                               gpointer     target_ptr,
+                                                               gsize        size,
+                                                               goffset      offset,
+                                                               GoclEvent  **event_wait_list,
+                                                               guint        event_wait_list_len);
+GoclEvent *            gocl_buffer_write_with_events          (GoclBuffer      *self,
+                                                               GoclQueue       *queue,
+                                                               const gpointer   data,
+                                                               gsize            size,
+                                                               goffset          offset,
+                                                               GoclEvent      **event_wait_list,
+                                                               guint            event_wait_list_len);
 
 gboolean               gocl_buffer_read_all_sync              (GoclBuffer  *self,
                                                                GoclQueue   *queue,
                                                                gpointer     target_ptr,
                                                                gsize       *size,
                                                                GList       *event_wait_list);
+GoclEvent *            gocl_buffer_read_all                   (GoclBuffer  *self,
+                                                               GoclQueue   *queue,
+                                                               gpointer     target_ptr,
+                                                               gsize       *size,
+                                                               GList       *event_wait_list);
+
+GoclEvent *            gocl_buffer_write_bytes                (GoclBuffer *self,
+                                                               GoclQueue  *queue,
+                                                               GBytes     *bytes,
+                                                               goffset     offset,
+                                                               GList      *event_wait_list);
+GoclEvent *            gocl_buffer_read_to_byte_array         (GoclBuffer *self,
+                                                               GoclQueue  *queue,
+                                                               GByteArray *target,
+                                                               goffset     offset,
+                                                               gsize       size,
+                                                               GList      *event_wait_list);
+GBytes *               gocl_buffer_read_to_bytes_sync         (GoclBuffer *self,
+                                                               GoclQueue  *queue,
+                                                               goffset     offset,
+                                                               gsize       size,
+                                                               GList      *event_wait_list);
+
+GoclEvent *            gocl_buffer_map                        (GoclBuffer  *self,
+                                                               GoclQueue   *queue,
+                                                               guint        flags,
+                                                               goffset      offset,
+                                                               gsize        size,
+                                                               gpointer    *mapped_ptr,
+                                                               gsize       *row_pitch,
+                                                               gsize       *slice_pitch,
+                                                               GList       *event_wait_list);
+gpointer               gocl_buffer_map_sync                   (GoclBuffer  *self,
+                                                               GoclQueue   *queue,
+                                                               guint        flags,
+                                                               goffset      offset,
+                                                               gsize        size,
+                                                               gsize       *row_pitch,
+                                                               gsize       *slice_pitch,
+                                                               GList       *event_wait_list);
+GoclEvent *            gocl_buffer_unmap                      (GoclBuffer  *self,
+                                                               GoclQueue   *queue,
+                                                               gpointer     mapped_ptr,
+                                                               GList       *event_wait_list);
+gboolean               gocl_buffer_unmap_sync                 (GoclBuffer  *self,
+                                                               GoclQueue   *queue,
+                                                               gpointer     mapped_ptr,
+                                                               GList       *event_wait_list);
+
+GoclEvent *            gocl_buffer_copy                       (GoclBuffer  *self,
+                                                               GoclQueue   *queue,
+                                                               GoclBuffer  *target,
+                                                               goffset      src_offset,
+                                                               goffset      dst_offset,
+                                                               gsize        size,
+                                                               GList       *event_wait_list);
+GoclEvent *            gocl_buffer_copy_rect                  (GoclBuffer  *self,
+                                                               GoclQueue   *queue,
+                                                               GoclBuffer  *target,
+                                                               const gsize *src_origin,
+                                                               const gsize *dst_origin,
+                                                               const gsize *region,
+                                                               gsize        src_row_pitch,
+                                                               gsize        src_slice_pitch,
+                                                               gsize        dst_row_pitch,
+                                                               gsize        dst_slice_pitch,
+                                                               GList       *event_wait_list);
+GoclEvent *            gocl_buffer_fill                       (GoclBuffer    *self,
+                                                               GoclQueue     *queue,
+                                                               gconstpointer  pattern,
+                                                               gsize          pattern_size,
+                                                               goffset        offset,
+                                                               gsize          size,
+                                                               GList         *event_wait_list);
 
 cl_mem *               gocl_buffer_list_to_array              (GList *list,
                                                                guint *len);
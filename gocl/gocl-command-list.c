@@ -0,0 +1,637 @@
+/*
+ * gocl-command-list.c
+ *
+ * Gocl - GLib/GObject wrapper for OpenCL
+ * Copyright (C) 2012-2013 Igalia S.L.
+ *
+ * Authors:
+ *  Eduardo Lima Mitev <elima@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License at http://www.gnu.org/licenses/lgpl-3.0.txt
+ * for more details.
+ */
+
+/**
+ * SECTION:gocl-command-list
+ * @short_description: Object that records a batch of commands
+ * @stability: Unstable
+ *
+ * A #GoclCommandList records a sequence of buffer writes, kernel executions
+ * and buffer reads, and later enqueues all of them in its #GoclQueue in a
+ * single call to gocl_command_list_submit() or
+ * gocl_command_list_submit_sync().
+ *
+ * Commands of a list execute in the order they were recorded, each one
+ * depending implicitly on the previous. Unlike enqueuing each command with
+ * gocl_buffer_write(), gocl_kernel_run_in_queue(), etc, submitting a list
+ * creates a single #GoclEvent, which resolves when the last command
+ * completes. On in-order queues no OpenCL event is created for the
+ * intermediate commands at all, and on out-of-order queues they are only
+ * used to chain each command to the next one.
+ *
+ * The data pointers passed to gocl_command_list_add_write() and
+ * gocl_command_list_add_read() are not copied, and must remain valid until
+ * the commands using them complete. Recorded commands are kept after
+ * submission, so the same list can be submitted repeatedly. Use
+ * gocl_command_list_clear() to start a new batch.
+ **/
+
+/**
+ * GoclCommandListClass:
+ * @parent_class: The parent class
+ *
+ * The class for #GoclCommandList objects.
+ **/
+
+#include "gocl-command-list.h"
+
+#include "gocl-private.h"
+
+typedef enum
+{
+  COMMAND_WRITE,
+  COMMAND_READ,
+  COMMAND_KERNEL
+} CommandType;
+
+typedef struct
+{
+  CommandType type;
+
+  GoclBuffer *buffer;
+  gpointer ptr;
+  gsize size;
+  goffset offset;
+
+  GoclLaunch *launch;
+} Command;
+
+struct _GoclCommandListPrivate
+{
+  GoclQueue *queue;
+
+  GArray *commands;
+  guint64 bytes;
+};
+
+/* properties */
+enum
+{
+  PROP_0,
+  PROP_QUEUE
+};
+
+static void           gocl_command_list_class_init       (GoclCommandListClass *class);
+static void           gocl_command_list_init             (GoclCommandList *self);
+static void           gocl_command_list_finalize         (GObject *obj);
+
+static void           set_property                       (GObject      *obj,
+                                                          guint         prop_id,
+                                                          const GValue *value,
+                                                          GParamSpec   *pspec);
+static void           get_property                       (GObject    *obj,
+                                                          guint       prop_id,
+                                                          GValue     *value,
+                                                          GParamSpec *pspec);
+
+G_DEFINE_TYPE (GoclCommandList, gocl_command_list, G_TYPE_OBJECT)
+
+#define GOCL_COMMAND_LIST_GET_PRIVATE(obj)                      \
+  (G_TYPE_INSTANCE_GET_PRIVATE ((obj),                          \
+                                GOCL_TYPE_COMMAND_LIST,         \
+                                GoclCommandListPrivate))        \
+
+static void
+gocl_command_list_class_init (GoclCommandListClass *class)
+{
+  GObjectClass *obj_class = G_OBJECT_CLASS (class);
+
+  obj_class->finalize = gocl_command_list_finalize;
+  obj_class->get_property = get_property;
+  obj_class->set_property = set_property;
+
+  g_object_class_install_property (obj_class, PROP_QUEUE,
+                                   g_param_spec_object ("queue",
+                                                        "Queue",
+                                                        "The command queue where commands are enqueued",
+                                                        GOCL_TYPE_QUEUE,
+                                                        G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
+                                                        G_PARAM_STATIC_STRINGS));
+
+  g_type_class_add_private (class, sizeof (GoclCommandListPrivate));
+}
+
+static void
+gocl_command_list_init (GoclCommandList *self)
+{
+  GoclCommandListPrivate *priv;
+
+  self->priv = priv = GOCL_COMMAND_LIST_GET_PRIVATE (self);
+
+  priv->commands = g_array_new (FALSE, TRUE, sizeof (Command));
+  priv->bytes = 0;
+}
+
+static void
+gocl_command_list_finalize (GObject *obj)
+{
+  GoclCommandList *self = GOCL_COMMAND_LIST (obj);
+
+  gocl_command_list_clear (self);
+  g_array_free (self->priv->commands, TRUE);
+
+  g_object_unref (self->priv->queue);
+
+  G_OBJECT_CLASS (gocl_command_list_parent_class)->finalize (obj);
+}
+
+static void
+set_property (GObject      *obj,
+              guint         prop_id,
+              const GValue *value,
+              GParamSpec   *pspec)
+{
+  GoclCommandList *self;
+
+  self = GOCL_COMMAND_LIST (obj);
+
+  switch (prop_id)
+    {
+    case PROP_QUEUE:
+      self->priv->queue = g_value_dup_object (value);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
+      break;
+    }
+}
+
+static void
+get_property (GObject    *obj,
+              guint       prop_id,
+              GValue     *value,
+              GParamSpec *pspec)
+{
+  GoclCommandList *self;
+
+  self = GOCL_COMMAND_LIST (obj);
+
+  switch (prop_id)
+    {
+    case PROP_QUEUE:
+      g_value_set_object (value, self->priv->queue);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
+      break;
+    }
+}
+
+static void
+add_transfer (GoclCommandList *self,
+              CommandType      type,
+              GoclBuffer      *buffer,
+              gpointer         ptr,
+              gsize            size,
+              goffset          offset)
+{
+  Command cmd = { 0, };
+
+  cmd.type = type;
+  cmd.buffer = g_object_ref (buffer);
+  cmd.ptr = ptr;
+  cmd.size = size;
+  cmd.offset = offset;
+
+  g_array_append_val (self->priv->commands, cmd);
+  self->priv->bytes += size;
+}
+
+static cl_int
+enqueue_command (GoclCommandList *self,
+                 Command         *cmd,
+                 cl_event        *event_wait_list,
+                 guint            event_wait_list_len,
+                 cl_event        *out_event)
+{
+  cl_command_queue queue;
+
+  queue = gocl_queue_get_queue (self->priv->queue);
+
+  switch (cmd->type)
+    {
+    case COMMAND_WRITE:
+      return clEnqueueWriteBuffer (queue,
+                                   gocl_buffer_get_buffer (cmd->buffer),
+                                   CL_FALSE,
+                                   cmd->offset,
+                                   cmd->size,
+                                   cmd->ptr,
+                                   event_wait_list_len,
+                                   event_wait_list,
+                                   out_event);
+
+    case COMMAND_READ:
+      return clEnqueueReadBuffer (queue,
+                                  gocl_buffer_get_buffer (cmd->buffer),
+                                  CL_FALSE,
+                                  cmd->offset,
+                                  cmd->size,
+                                  cmd->ptr,
+                                  event_wait_list_len,
+                                  event_wait_list,
+                                  out_event);
+
+    case COMMAND_KERNEL:
+      return gocl_launch_enqueue (cmd->launch,
+                                  event_wait_list,
+                                  event_wait_list_len,
+                                  out_event);
+    }
+
+  g_assert_not_reached ();
+  return CL_INVALID_OPERATION;
+}
+
+static cl_int
+enqueue_commands (GoclCommandList *self,
+                  cl_event        *event_wait_list,
+                  guint            event_wait_list_len,
+                  cl_event        *out_event)
+{
+  cl_event prev_event = NULL;
+  gboolean out_of_order;
+  guint len;
+  guint i;
+
+  len = self->priv->commands->len;
+  if (len == 0)
+    return clEnqueueMarkerWithWaitList (gocl_queue_get_queue (self->priv->queue),
+                                        event_wait_list_len,
+                                        event_wait_list,
+                                        out_event);
+
+  out_of_order = (gocl_queue_get_flags (self->priv->queue) &
+                  GOCL_QUEUE_FLAGS_OUT_OF_ORDER) != 0;
+
+  for (i = 0; i < len; i++)
+    {
+      Command *cmd;
+      cl_event event = NULL;
+      cl_event *wait_list;
+      guint wait_list_len;
+      cl_int err_code;
+
+      cmd = &g_array_index (self->priv->commands, Command, i);
+
+      /* only the first command waits for the external events; the rest
+         are ordered by the queue itself, or chained explicitly when the
+         queue is out-of-order */
+      if (i == 0)
+        {
+          wait_list = event_wait_list;
+          wait_list_len = event_wait_list_len;
+        }
+      else if (out_of_order)
+        {
+          wait_list = &prev_event;
+          wait_list_len = 1;
+        }
+      else
+        {
+          wait_list = NULL;
+          wait_list_len = 0;
+        }
+
+      err_code = enqueue_command (self,
+                                  cmd,
+                                  wait_list,
+                                  wait_list_len,
+                                  out_of_order || i == len - 1 ? &event : NULL);
+
+      if (prev_event != NULL)
+        clReleaseEvent (prev_event);
+      prev_event = event;
+
+      if (err_code != CL_SUCCESS)
+        {
+          if (prev_event != NULL)
+            clReleaseEvent (prev_event);
+          return err_code;
+        }
+    }
+
+  *out_event = prev_event;
+
+  return CL_SUCCESS;
+}
+
+/* public */
+
+/**
+ * gocl_command_list_new:
+ * @queue: The #GoclQueue where commands will be enqueued
+ *
+ * Creates a new, empty command list for @queue.
+ *
+ * Returns: (transfer full): A newly created #GoclCommandList
+ **/
+GoclCommandList *
+gocl_command_list_new (GoclQueue *queue)
+{
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), NULL);
+
+  return g_object_new (GOCL_TYPE_COMMAND_LIST,
+                       "queue", queue,
+                       NULL);
+}
+
+/**
+ * gocl_command_list_get_queue:
+ * @self: The #GoclCommandList
+ *
+ * Obtains the queue where the commands of the list are enqueued.
+ *
+ * Returns: (transfer none): The #GoclQueue
+ **/
+GoclQueue *
+gocl_command_list_get_queue (GoclCommandList *self)
+{
+  g_return_val_if_fail (GOCL_IS_COMMAND_LIST (self), NULL);
+
+  return self->priv->queue;
+}
+
+/**
+ * gocl_command_list_get_length:
+ * @self: The #GoclCommandList
+ *
+ * Obtains the number of commands recorded in the list.
+ *
+ * Returns: The number of commands
+ **/
+guint
+gocl_command_list_get_length (GoclCommandList *self)
+{
+  g_return_val_if_fail (GOCL_IS_COMMAND_LIST (self), 0);
+
+  return self->priv->commands->len;
+}
+
+/**
+ * gocl_command_list_add_write:
+ * @self: The #GoclCommandList
+ * @buffer: The #GoclBuffer to write to
+ * @data: (array length=size) (element-type guint8): A pointer to the data
+ * to write
+ * @size: The number of bytes to write
+ * @offset: The offset inside @buffer where to start writing
+ *
+ * Records a write of @size bytes from @data into @buffer. The memory
+ * pointed by @data is read when the command executes, not now.
+ **/
+void
+gocl_command_list_add_write (GoclCommandList *self,
+                             GoclBuffer      *buffer,
+                             gconstpointer    data,
+                             gsize            size,
+                             goffset          offset)
+{
+  g_return_if_fail (GOCL_IS_COMMAND_LIST (self));
+  g_return_if_fail (GOCL_IS_BUFFER (buffer));
+  g_return_if_fail (data != NULL);
+
+  add_transfer (self, COMMAND_WRITE, buffer, (gpointer) data, size, offset);
+}
+
+/**
+ * gocl_command_list_add_read:
+ * @self: The #GoclCommandList
+ * @buffer: The #GoclBuffer to read from
+ * @target_ptr: (array length=size) (element-type guint8): A pointer to the
+ * memory where data will be stored
+ * @size: The number of bytes to read
+ * @offset: The offset inside @buffer where to start reading
+ *
+ * Records a read of @size bytes from @buffer into @target_ptr. The data is
+ * available once the event returned by gocl_command_list_submit() resolves.
+ **/
+void
+gocl_command_list_add_read (GoclCommandList *self,
+                            GoclBuffer      *buffer,
+                            gpointer         target_ptr,
+                            gsize            size,
+                            goffset          offset)
+{
+  g_return_if_fail (GOCL_IS_COMMAND_LIST (self));
+  g_return_if_fail (GOCL_IS_BUFFER (buffer));
+  g_return_if_fail (target_ptr != NULL);
+
+  add_transfer (self, COMMAND_READ, buffer, target_ptr, size, offset);
+}
+
+/**
+ * gocl_command_list_add_kernel:
+ * @self: The #GoclCommandList
+ * @kernel: The #GoclKernel to execute
+ *
+ * Records an execution of @kernel. The current arguments and work sizes of
+ * @kernel are captured now, so the kernel can be set up differently for
+ * the next command right away.
+ **/
+void
+gocl_command_list_add_kernel (GoclCommandList *self, GoclKernel *kernel)
+{
+  GoclLaunch *launch;
+
+  g_return_if_fail (GOCL_IS_COMMAND_LIST (self));
+  g_return_if_fail (GOCL_IS_KERNEL (kernel));
+
+  launch = gocl_launch_new (kernel, self->priv->queue);
+  gocl_command_list_add_launch (self, launch);
+  g_object_unref (launch);
+}
+
+/**
+ * gocl_command_list_add_launch:
+ * @self: The #GoclCommandList
+ * @launch: The #GoclLaunch to execute
+ *
+ * Records an execution of @launch, which must use the same queue as the
+ * list. Unlike gocl_command_list_add_kernel(), the arguments and work sizes
+ * of @launch are read at submission time.
+ **/
+void
+gocl_command_list_add_launch (GoclCommandList *self, GoclLaunch *launch)
+{
+  Command cmd = { 0, };
+
+  g_return_if_fail (GOCL_IS_COMMAND_LIST (self));
+  g_return_if_fail (GOCL_IS_LAUNCH (launch));
+  g_return_if_fail (gocl_launch_get_queue (launch) == self->priv->queue);
+
+  cmd.type = COMMAND_KERNEL;
+  cmd.launch = g_object_ref (launch);
+
+  g_array_append_val (self->priv->commands, cmd);
+}
+
+/**
+ * gocl_command_list_clear:
+ * @self: The #GoclCommandList
+ *
+ * Removes all the commands recorded in the list. Commands already submitted
+ * are not affected.
+ **/
+void
+gocl_command_list_clear (GoclCommandList *self)
+{
+  guint i;
+
+  g_return_if_fail (GOCL_IS_COMMAND_LIST (self));
+
+  for (i = 0; i < self->priv->commands->len; i++)
+    {
+      Command *cmd;
+
+      cmd = &g_array_index (self->priv->commands, Command, i);
+
+      if (cmd->buffer != NULL)
+        g_object_unref (cmd->buffer);
+      if (cmd->launch != NULL)
+        g_object_unref (cmd->launch);
+    }
+
+  g_array_set_size (self->priv->commands, 0);
+  self->priv->bytes = 0;
+}
+
+/**
+ * gocl_command_list_submit_sync:
+ * @self: The #GoclCommandList
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List of
+ * #GoclEvent objects to wait for before the first command, or %NULL
+ *
+ * Enqueues all the recorded commands, and blocks until the last of them
+ * completes.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_command_list_submit_sync (GoclCommandList *self, GList *event_wait_list)
+{
+  return gocl_command_list_submit_sync_full (self,
+                                             event_wait_list,
+                                             gocl_error_prepare ());
+}
+
+/**
+ * gocl_command_list_submit_sync_full:
+ * @self: The #GoclCommandList
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List of
+ * #GoclEvent objects to wait for before the first command, or %NULL
+ * @error: (allow-none): Return location for a #GError, or %NULL
+ *
+ * Like gocl_command_list_submit_sync(), but reports a failure in @error
+ * instead of the last error of the calling thread.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_command_list_submit_sync_full (GoclCommandList  *self,
+                                    GList            *event_wait_list,
+                                    GError          **error)
+{
+  cl_int err_code;
+  cl_event event = NULL;
+
+  GoclWaitList wait_list;
+
+  g_return_val_if_fail (GOCL_IS_COMMAND_LIST (self), FALSE);
+
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
+
+  err_code = enqueue_commands (self,
+                               wait_list.cl_events,
+                               wait_list.len,
+                               &event);
+  gocl_wait_list_clear (&wait_list);
+
+  if (err_code == CL_SUCCESS)
+    {
+      err_code = clWaitForEvents (1, &event);
+      clReleaseEvent (event);
+    }
+
+  return ! gocl_error_check_opencl (err_code, error);
+}
+
+/**
+ * gocl_command_list_submit:
+ * @self: The #GoclCommandList
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List of
+ * #GoclEvent objects to wait for before the first command, or %NULL
+ *
+ * Enqueues all the recorded commands, without blocking. The returned
+ * event resolves when the last command completes.
+ *
+ * Returns: (transfer none): A #GoclEvent to get notified when all the
+ * commands of the list complete
+ **/
+GoclEvent *
+gocl_command_list_submit (GoclCommandList *self, GList *event_wait_list)
+{
+  GError *error = NULL;
+  cl_int err_code;
+  cl_event event = NULL;
+
+  GoclEvent *_event = NULL;
+  GoclEventResolverFunc resolver_func;
+
+  GoclWaitList wait_list;
+
+  g_return_val_if_fail (GOCL_IS_COMMAND_LIST (self), NULL);
+
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
+
+  err_code = enqueue_commands (self,
+                               wait_list.cl_events,
+                               wait_list.len,
+                               &event);
+  gocl_wait_list_clear (&wait_list);
+
+  if (gocl_error_check_opencl (err_code, &error))
+    {
+      _event = g_object_new (GOCL_TYPE_EVENT,
+                             "queue", self->priv->queue,
+                             NULL);
+      resolver_func = gocl_event_steal_resolver_func (_event);
+      resolver_func (_event, error);
+      g_error_free (error);
+    }
+  else
+    {
+      _event = g_object_new (GOCL_TYPE_EVENT,
+                             "queue", self->priv->queue,
+                             "event", event,
+                             "label", "command-list",
+                             "bytes", self->priv->bytes,
+                             NULL);
+      gocl_event_set_event_wait_list (_event, event_wait_list);
+      gocl_event_steal_resolver_func (_event);
+    }
+
+  gocl_event_idle_unref (_event);
+
+  return _event;
+}
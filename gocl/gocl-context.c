@@ -39,15 +39,46 @@
  * support, gocl_context_gpu_new_sync() is used, passing the pointers to the
  * corresponding GL context and display.
  *
+ * When several OpenCL platforms are installed, all of them are considered.
+ * Unless a platform is explicitly chosen, the context is created on the
+ * platform whose matching devices are estimated to be the fastest, based on
+ * their number of compute units and clock frequency, favouring GPUs with
+ * dedicated memory. Devices can be further filtered by vendor, number of
+ * compute units and global memory size using gocl_context_new_full_sync(),
+ * or picked explicitly with gocl_context_new_for_devices_sync(). Available
+ * platforms are listed with gocl_context_get_num_platforms() and
+ * gocl_context_get_platform_name().
+ *
+ * Device properties are queried once, when devices are discovered, and
+ * cached for the lifetime of the context.
+ *
  * Once a context is successfully created, devices can be obtained by calling
  * gocl_context_get_device_by_index(), where index must be a value between 0 and
  * the maximum number of devices in the context, minus one. Number of devices can
  * be obtained with gocl_context_get_num_devices().
+ *
+ * A context keeps track of the device memory allocated by its buffers and
+ * images. The number of bytes currently allocated and its peak are obtained
+ * with gocl_context_get_allocated_size() and
+ * gocl_context_get_peak_allocated_size(), and the live allocations, with
+ * their size, flags and tag (see gocl_buffer_set_tag()), with
+ * gocl_context_get_allocations(). Since OpenCL memory objects belong to the
+ * context and not to a particular device, every allocation counts against
+ * each device of the context. gocl_context_get_memory_limits() gives the
+ * smallest global memory size and maximum allocation size among them.
+ * Sub-buffers and objects shared with GL are not accounted, as they do not
+ * allocate memory of their own.
+ *
+ * To react before allocations start failing, a threshold can be set with
+ * gocl_context_set_high_water_mark(). The #GoclContext::high-water signal is
+ * emitted whenever an allocation takes the allocated size from below the
+ * threshold to or above it, giving the chance to release cached memory.
  **/
 
 /**
  * GoclContextClass:
  * @parent_class: The parent class
+ * @high_water: Class handler for the #GoclContext::high-water signal
  *
  * The class for #GoclContext objects.
  **/
@@ -59,27 +90,58 @@
 
 #include "gocl-private.h"
 #include "gocl-decls.h"
-
-#define MAX_PLATFORMS 8
-#define MAX_DEVICES   8
-
-#define DEFAULT_PLATFORM_INDEX 0
+#include "gocl-marshal.h"
 
 struct _GoclContextPrivate
 {
   cl_platform_id platform_id;
+  gint platform_index;
 
   cl_context context;
   GoclDeviceType device_type;
 
-  cl_device_id devices[MAX_DEVICES];
-  cl_uint num_devices;
+  /* selection criteria */
+  gchar *vendor;
+  guint min_compute_units;
+  guint64 min_global_mem_size;
+  GArray *device_indices;
+
+  /* array of GoclDeviceProps */
+  GArray *devices;
 
   gpointer gl_context;
   gpointer gl_display;
+
+  /* arrays of cl_image_format, by access flags and image type */
+  GMutex image_formats_mutex;
+  GHashTable *image_formats;
+
+  /* GoclAllocationInfo of the live allocations, by memory object owner */
+  GMutex allocations_mutex;
+  GHashTable *allocations;
+  guint64 allocated_size;
+  guint64 peak_allocated_size;
+  guint64 high_water_mark;
+
+  /* where #GoclContext::high-water is emitted */
+  GMainContext *main_context;
 };
 
-static cl_platform_id gocl_platforms[MAX_PLATFORMS];
+typedef struct
+{
+  GoclContext *self;
+  guint64 allocated_size;
+} HighWaterData;
+
+typedef struct
+{
+  gint index;
+  guint64 score;
+  GArray *devices;
+} PlatformCandidate;
+
+static GMutex platforms_mutex;
+static cl_platform_id *gocl_platforms = NULL;
 static cl_uint gocl_num_platforms = 0;
 
 static GoclContext *gocl_context_default_gpu = NULL;
@@ -91,9 +153,24 @@ enum
   PROP_0,
   PROP_DEVICE_TYPE,
   PROP_GL_CONTEXT,
-  PROP_GL_DISPLAY
+  PROP_GL_DISPLAY,
+  PROP_PLATFORM_INDEX,
+  PROP_VENDOR,
+  PROP_MIN_COMPUTE_UNITS,
+  PROP_MIN_GLOBAL_MEM_SIZE,
+  PROP_DEVICE_INDICES,
+  PROP_HIGH_WATER_MARK
 };
 
+/* signals */
+enum
+{
+  SIGNAL_HIGH_WATER,
+  LAST_SIGNAL
+};
+
+static guint context_signals[LAST_SIGNAL] = { 0 };
+
 static void           gocl_context_class_init            (GoclContextClass *class);
 static void           gocl_context_initable_iface_init   (GInitableIface *iface);
 static gboolean       gocl_context_initable_init         (GInitable     *initable,
@@ -111,6 +188,11 @@ static void           get_property                       (GObject    *obj,
                                                           GValue     *value,
                                                           GParamSpec *pspec);
 
+G_DEFINE_BOXED_TYPE (GoclAllocationInfo,
+                     gocl_allocation_info,
+                     gocl_allocation_info_copy,
+                     gocl_allocation_info_free)
+
 G_DEFINE_TYPE_WITH_CODE (GoclContext, gocl_context, G_TYPE_OBJECT,
                          G_IMPLEMENT_INTERFACE (G_TYPE_INITABLE,
                                                 gocl_context_initable_iface_init));
@@ -152,6 +234,88 @@ gocl_context_class_init (GoclContextClass *class)
                                                          G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
                                                          G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (obj_class, PROP_PLATFORM_INDEX,
+                                   g_param_spec_int ("platform-index",
+                                                     "Platform index",
+                                                     "The index of the platform of this context, or -1 to choose automatically",
+                                                     -1,
+                                                     G_MAXINT,
+                                                     -1,
+                                                     G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
+                                                     G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (obj_class, PROP_VENDOR,
+                                   g_param_spec_string ("vendor",
+                                                        "Vendor",
+                                                        "A case-insensitive substring devices' vendor must contain",
+                                                        NULL,
+                                                        G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
+                                                        G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (obj_class, PROP_MIN_COMPUTE_UNITS,
+                                   g_param_spec_uint ("min-compute-units",
+                                                      "Minimum compute units",
+                                                      "The minimum number of compute units of devices",
+                                                      0,
+                                                      G_MAXUINT,
+                                                      0,
+                                                      G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
+                                                      G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (obj_class, PROP_MIN_GLOBAL_MEM_SIZE,
+                                   g_param_spec_uint64 ("min-global-mem-size",
+                                                        "Minimum global memory size",
+                                                        "The minimum size in bytes of the global memory of devices",
+                                                        0,
+                                                        G_MAXUINT64,
+                                                        0,
+                                                        G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
+                                                        G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (obj_class, PROP_DEVICE_INDICES,
+                                   g_param_spec_boxed ("device-indices",
+                                                       "Device indices",
+                                                       "A GArray of guint with the indices of the devices to use, within the platform",
+                                                       G_TYPE_ARRAY,
+                                                       G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
+                                                       G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (obj_class, PROP_HIGH_WATER_MARK,
+                                   g_param_spec_uint64 ("high-water-mark",
+                                                        "High-water mark",
+                                                        "The allocated size in bytes that triggers the high-water signal, or 0 to disable it",
+                                                        0,
+                                                        G_MAXUINT64,
+                                                        0,
+                                                        G_PARAM_READWRITE |
+                                                        G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GoclContext::high-water:
+   * @context: The #GoclContext
+   * @allocated_size: The number of bytes allocated, including the new
+   *   allocation
+   *
+   * Emitted when an allocation takes the memory allocated in @context to or
+   * above the #GoclContext:high-water-mark. The signal is emitted again only
+   * after the allocated size drops below the mark.
+   *
+   * The signal is emitted from an idle source of the thread-default main
+   * context at the time @context was created, never from the thread that
+   * creates the buffer, so handlers are free to release memory or create
+   * buffers themselves.
+   **/
+  context_signals[SIGNAL_HIGH_WATER] =
+    g_signal_new ("high-water",
+                  G_TYPE_FROM_CLASS (obj_class),
+                  G_SIGNAL_RUN_LAST,
+                  G_STRUCT_OFFSET (GoclContextClass, high_water),
+                  NULL, NULL,
+                  gocl_marshal_VOID__UINT64,
+                  G_TYPE_NONE,
+                  1,
+                  G_TYPE_UINT64);
+
   g_type_class_add_private (class, sizeof (GoclContextPrivate));
 }
 
@@ -162,37 +326,209 @@ gocl_context_initable_iface_init (GInitableIface *iface)
 }
 
 static gboolean
-gocl_context_initable_init (GInitable     *initable,
-                            GCancellable  *cancellable,
-                            GError       **error)
+get_platforms (GError **error)
 {
-  GoclContext *self = GOCL_CONTEXT (initable);
-  cl_int err_code = 0;
-  cl_context_properties props[7] = {0, };
+  cl_int err_code = CL_SUCCESS;
+  cl_uint num_platforms = 0;
 
-  /* get platform ids */
-  if (gocl_num_platforms == 0)
+  g_mutex_lock (&platforms_mutex);
+
+  if (gocl_platforms == NULL)
     {
-      err_code = clGetPlatformIDs (MAX_PLATFORMS,
-                                   gocl_platforms,
-                                   &gocl_num_platforms);
-      if (gocl_error_check_opencl (err_code, error))
+      err_code = clGetPlatformIDs (0, NULL, &num_platforms);
+      if (err_code == CL_SUCCESS && num_platforms == 0)
+        err_code = CL_INVALID_PLATFORM;
+
+      if (err_code == CL_SUCCESS)
+        {
+          gocl_platforms = g_new0 (cl_platform_id, num_platforms);
+          err_code = clGetPlatformIDs (num_platforms,
+                                       gocl_platforms,
+                                       &gocl_num_platforms);
+          if (err_code != CL_SUCCESS)
+            {
+              g_free (gocl_platforms);
+              gocl_platforms = NULL;
+              gocl_num_platforms = 0;
+            }
+        }
+    }
+
+  g_mutex_unlock (&platforms_mutex);
+
+  return ! gocl_error_check_opencl (err_code, error);
+}
+
+static guint64
+get_device_score (const GoclDeviceProps *props)
+{
+  guint64 score;
+
+  score = (guint64) props->max_compute_units *
+    MAX (props->max_clock_frequency, 1);
+
+  /* a discrete GPU usually outperforms an integrated one with comparable
+     figures, since the latter shares memory bandwidth with the host */
+  if ((props->type & CL_DEVICE_TYPE_GPU) != 0 && ! props->host_unified_memory)
+    score *= 4;
+
+  return score;
+}
+
+static gboolean
+device_matches (GoclContext *self, const GoclDeviceProps *props)
+{
+  if (props->max_compute_units < self->priv->min_compute_units)
+    return FALSE;
+
+  if (props->global_mem_size < self->priv->min_global_mem_size)
+    return FALSE;
+
+  if (self->priv->vendor != NULL)
+    {
+      gchar *vendor;
+      gchar *wanted;
+      gboolean found;
+
+      vendor = g_ascii_strdown (props->vendor != NULL ? props->vendor : "", -1);
+      wanted = g_ascii_strdown (self->priv->vendor, -1);
+      found = strstr (vendor, wanted) != NULL;
+      g_free (wanted);
+      g_free (vendor);
+
+      if (! found)
         return FALSE;
     }
 
-  /* @TODO: currently using platform 0 only */
-  self->priv->platform_id = gocl_platforms[DEFAULT_PLATFORM_INDEX];
+  return TRUE;
+}
+
+static gint
+compare_devices (gconstpointer a, gconstpointer b)
+{
+  guint64 score_a = get_device_score (a);
+  guint64 score_b = get_device_score (b);
+
+  return score_a < score_b ? 1 : (score_a > score_b ? -1 : 0);
+}
+
+static void
+free_device_props_array (GArray *devices)
+{
+  guint i;
+
+  for (i = 0; i < devices->len; i++)
+    gocl_device_props_clear (&g_array_index (devices, GoclDeviceProps, i));
+  g_array_free (devices, TRUE);
+}
+
+static cl_int
+get_platform_devices (GoclContext     *self,
+                      cl_platform_id   platform_id,
+                      GArray         **devices)
+{
+  cl_int err_code;
+  cl_device_id *ids;
+  cl_uint num_ids = 0;
+  cl_device_type device_type;
+  guint i;
+
+  *devices = g_array_new (FALSE, TRUE, sizeof (GoclDeviceProps));
+
+  /* explicit indices refer to the whole list of devices of the platform */
+  device_type = self->priv->device_indices != NULL ?
+    CL_DEVICE_TYPE_ALL : self->priv->device_type;
+
+  err_code = clGetDeviceIDs (platform_id, device_type, 0, NULL, &num_ids);
+  if (err_code != CL_SUCCESS)
+    return err_code;
+
+  ids = g_new0 (cl_device_id, num_ids);
+  err_code = clGetDeviceIDs (platform_id, device_type, num_ids, ids, NULL);
+
+  if (self->priv->device_indices != NULL)
+    {
+      GArray *indices = self->priv->device_indices;
+
+      /* devices keep the order of the indices given */
+      for (i = 0; err_code == CL_SUCCESS && i < indices->len; i++)
+        {
+          GoclDeviceProps props;
+          guint index;
+          guint j;
+
+          index = g_array_index (indices, guint, i);
+          if (index >= num_ids)
+            {
+              err_code = CL_INVALID_DEVICE;
+              break;
+            }
+
+          for (j = 0; j < i; j++)
+            if (g_array_index (indices, guint, j) == index)
+              break;
+
+          if (j < i)
+            {
+              err_code = CL_INVALID_DEVICE;
+              break;
+            }
+
+          err_code = gocl_device_props_query (&props, ids[index]);
+          if (err_code == CL_SUCCESS)
+            g_array_append_val (*devices, props);
+        }
+    }
+  else
+    {
+      for (i = 0; err_code == CL_SUCCESS && i < num_ids; i++)
+        {
+          GoclDeviceProps props;
+
+          err_code = gocl_device_props_query (&props, ids[i]);
+          if (err_code != CL_SUCCESS)
+            break;
+
+          if (device_matches (self, &props))
+            g_array_append_val (*devices, props);
+          else
+            gocl_device_props_clear (&props);
+        }
+    }
+
+  g_free (ids);
 
-  /* get devices */
-  err_code = clGetDeviceIDs (self->priv->platform_id,
-                             self->priv->device_type,
-                             MAX_DEVICES,
-                             self->priv->devices,
-                             &self->priv->num_devices);
+  /* fastest devices first, unless they were explicitly chosen */
+  if (err_code == CL_SUCCESS && self->priv->device_indices == NULL)
+    g_array_sort (*devices, compare_devices);
+
+  return err_code;
+}
+
+static gint
+compare_candidates (gconstpointer a, gconstpointer b)
+{
+  const PlatformCandidate *ca = a;
+  const PlatformCandidate *cb = b;
+
+  if (ca->score != cb->score)
+    return ca->score < cb->score ? 1 : -1;
+
+  /* keep platform order for equal scores */
+  return ca->index - cb->index;
+}
+
+static cl_int
+create_context (GoclContext *self, cl_platform_id platform_id, GArray *devices)
+{
+  cl_int err_code = CL_SUCCESS;
+  cl_context_properties props[7] = {0, };
+  cl_device_id *ids;
+  guint i;
 
   /* setup context properties */
   props[0] = CL_CONTEXT_PLATFORM;
-  props[1] = (cl_context_properties) self->priv->platform_id;
+  props[1] = (cl_context_properties) platform_id;
 
   /* enable GL sharing, if a GL context and display are provided */
   if (self->priv->gl_context != NULL && self->priv->gl_display != NULL)
@@ -204,12 +540,109 @@ gocl_context_initable_init (GInitable     *initable,
       props[5] = (cl_context_properties) self->priv->gl_display;
     }
 
+  ids = g_new0 (cl_device_id, devices->len);
+  for (i = 0; i < devices->len; i++)
+    ids[i] = g_array_index (devices, GoclDeviceProps, i).id;
+
   /* create the context */
-  self->priv->context = clCreateContextFromType (props,
-                                                 self->priv->device_type,
-                                                 NULL,
-                                                 NULL,
-                                                 &err_code);
+  self->priv->context = clCreateContext (props,
+                                         devices->len,
+                                         ids,
+                                         NULL,
+                                         NULL,
+                                         &err_code);
+  g_free (ids);
+
+  return err_code;
+}
+
+static gboolean
+gocl_context_initable_init (GInitable     *initable,
+                            GCancellable  *cancellable,
+                            GError       **error)
+{
+  GoclContext *self = GOCL_CONTEXT (initable);
+  cl_int err_code = CL_DEVICE_NOT_FOUND;
+  GArray *candidates;
+  guint i;
+
+  /* get platform ids */
+  if (! get_platforms (error))
+    return FALSE;
+
+  if (self->priv->platform_index >= (gint) gocl_num_platforms)
+    {
+      gocl_error_check_opencl (CL_INVALID_PLATFORM, error);
+      return FALSE;
+    }
+
+  /* collect the matching devices of each eligible platform */
+  candidates = g_array_new (FALSE, TRUE, sizeof (PlatformCandidate));
+
+  for (i = 0; i < gocl_num_platforms; i++)
+    {
+      PlatformCandidate candidate = { 0, };
+      cl_int platform_err;
+      guint j;
+
+      if (self->priv->platform_index >= 0 &&
+          (guint) self->priv->platform_index != i)
+        {
+          continue;
+        }
+
+      candidate.index = i;
+      platform_err = get_platform_devices (self,
+                                           gocl_platforms[i],
+                                           &candidate.devices);
+
+      if (platform_err != CL_SUCCESS || candidate.devices->len == 0)
+        {
+          /* report the most specific reason if no platform is usable */
+          if (platform_err != CL_SUCCESS && platform_err != CL_DEVICE_NOT_FOUND)
+            err_code = platform_err;
+
+          free_device_props_array (candidate.devices);
+          continue;
+        }
+
+      for (j = 0; j < candidate.devices->len; j++)
+        candidate.score +=
+          get_device_score (&g_array_index (candidate.devices, GoclDeviceProps, j));
+
+      g_array_append_val (candidates, candidate);
+    }
+
+  g_array_sort (candidates, compare_candidates);
+
+  /* use the best platform where a context can actually be created, since
+     GL sharing for instance only works on the platform driving the display */
+  for (i = 0; i < candidates->len; i++)
+    {
+      PlatformCandidate *candidate;
+
+      candidate = &g_array_index (candidates, PlatformCandidate, i);
+
+      if (self->priv->context == NULL)
+        {
+          err_code = create_context (self,
+                                     gocl_platforms[candidate->index],
+                                     candidate->devices);
+
+          if (err_code == CL_SUCCESS)
+            {
+              self->priv->platform_id = gocl_platforms[candidate->index];
+              self->priv->platform_index = candidate->index;
+              self->priv->devices = candidate->devices;
+              continue;
+            }
+        }
+
+      free_device_props_array (candidate->devices);
+    }
+
+  g_array_free (candidates, TRUE);
+
   if (gocl_error_check_opencl (err_code, error))
     return FALSE;
 
@@ -224,6 +657,28 @@ gocl_context_init (GoclContext *self)
   self->priv = priv = GOCL_CONTEXT_GET_PRIVATE (self);
 
   priv->context = NULL;
+  priv->platform_index = -1;
+
+  priv->vendor = NULL;
+  priv->device_indices = NULL;
+  priv->devices = NULL;
+
+  g_mutex_init (&priv->image_formats_mutex);
+  priv->image_formats = g_hash_table_new_full (g_int64_hash,
+                                               g_int64_equal,
+                                               g_free,
+                                               (GDestroyNotify) g_array_unref);
+
+  g_mutex_init (&priv->allocations_mutex);
+  priv->allocations = g_hash_table_new_full (g_direct_hash,
+                                             g_direct_equal,
+                                             NULL,
+                                             (GDestroyNotify) gocl_allocation_info_free);
+  priv->allocated_size = 0;
+  priv->peak_allocated_size = 0;
+  priv->high_water_mark = 0;
+
+  priv->main_context = g_main_context_ref_thread_default ();
 }
 
 static void
@@ -234,12 +689,28 @@ gocl_context_finalize (GObject *obj)
   if (self->priv->context != NULL)
     clReleaseContext (self->priv->context);
 
+  if (self->priv->devices != NULL)
+    free_device_props_array (self->priv->devices);
+
+  if (self->priv->device_indices != NULL)
+    g_array_unref (self->priv->device_indices);
+
+  g_free (self->priv->vendor);
+
+  g_hash_table_unref (self->priv->image_formats);
+  g_mutex_clear (&self->priv->image_formats_mutex);
+
+  g_hash_table_unref (self->priv->allocations);
+  g_mutex_clear (&self->priv->allocations_mutex);
+
+  g_main_context_unref (self->priv->main_context);
+
   G_OBJECT_CLASS (gocl_context_parent_class)->finalize (obj);
 
   if (self == gocl_context_default_cpu)
     gocl_context_default_cpu = NULL;
   else if (self == gocl_context_default_gpu)
-    gocl_context_default_cpu = NULL;
+    gocl_context_default_gpu = NULL;
 }
 
 static void
@@ -266,6 +737,30 @@ set_property (GObject      *obj,
       self->priv->gl_display = g_value_get_pointer (value);
       break;
 
+    case PROP_PLATFORM_INDEX:
+      self->priv->platform_index = g_value_get_int (value);
+      break;
+
+    case PROP_VENDOR:
+      self->priv->vendor = g_value_dup_string (value);
+      break;
+
+    case PROP_MIN_COMPUTE_UNITS:
+      self->priv->min_compute_units = g_value_get_uint (value);
+      break;
+
+    case PROP_MIN_GLOBAL_MEM_SIZE:
+      self->priv->min_global_mem_size = g_value_get_uint64 (value);
+      break;
+
+    case PROP_DEVICE_INDICES:
+      self->priv->device_indices = g_value_dup_boxed (value);
+      break;
+
+    case PROP_HIGH_WATER_MARK:
+      gocl_context_set_high_water_mark (self, g_value_get_uint64 (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
       break;
@@ -296,12 +791,176 @@ get_property (GObject    *obj,
       g_value_set_pointer (value, self->priv->gl_display);
       break;
 
+    case PROP_PLATFORM_INDEX:
+      g_value_set_int (value, self->priv->platform_index);
+      break;
+
+    case PROP_VENDOR:
+      g_value_set_string (value, self->priv->vendor);
+      break;
+
+    case PROP_MIN_COMPUTE_UNITS:
+      g_value_set_uint (value, self->priv->min_compute_units);
+      break;
+
+    case PROP_MIN_GLOBAL_MEM_SIZE:
+      g_value_set_uint64 (value, self->priv->min_global_mem_size);
+      break;
+
+    case PROP_DEVICE_INDICES:
+      g_value_set_boxed (value, self->priv->device_indices);
+      break;
+
+    case PROP_HIGH_WATER_MARK:
+      g_value_set_uint64 (value, gocl_context_get_high_water_mark (self));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
       break;
     }
 }
 
+static gboolean
+emit_high_water_in_idle (gpointer user_data)
+{
+  HighWaterData *data = user_data;
+
+  g_signal_emit (data->self,
+                 context_signals[SIGNAL_HIGH_WATER],
+                 0,
+                 data->allocated_size);
+
+  return FALSE;
+}
+
+static void
+free_high_water_data (gpointer user_data)
+{
+  HighWaterData *data = user_data;
+
+  g_object_unref (data->self);
+  g_slice_free (HighWaterData, data);
+}
+
+/* internal */
+
+/**
+ * gocl_context_add_allocation:
+ * @self: The #GoclContext
+ * @owner: The object owning the allocation, usually a #GoclBuffer
+ * @flags: The flags the memory object was created with
+ * @size: The size of the allocation, in bytes
+ * @tag: (allow-none): A tag identifying the owner, or %NULL
+ *
+ * Accounts a new allocation of device memory, scheduling the emission of
+ * #GoclContext::high-water if it takes the allocated size past the mark.
+ * This is a Gocl private function, not exposed to applications.
+ **/
+void
+gocl_context_add_allocation (GoclContext *self,
+                             gpointer     owner,
+                             guint        flags,
+                             guint64      size,
+                             const gchar *tag)
+{
+  GoclAllocationInfo *info;
+  guint64 mark;
+  guint64 old_size;
+  guint64 new_size;
+
+  info = g_slice_new (GoclAllocationInfo);
+  info->tag = g_strdup (tag);
+  info->flags = flags;
+  info->size = size;
+
+  g_mutex_lock (&self->priv->allocations_mutex);
+
+  g_hash_table_insert (self->priv->allocations, owner, info);
+
+  old_size = self->priv->allocated_size;
+  new_size = old_size + size;
+  self->priv->allocated_size = new_size;
+  self->priv->peak_allocated_size = MAX (self->priv->peak_allocated_size,
+                                         new_size);
+  mark = self->priv->high_water_mark;
+
+  g_mutex_unlock (&self->priv->allocations_mutex);
+
+  if (mark > 0 && old_size < mark && new_size >= mark)
+    {
+      HighWaterData *data;
+      GSource *src;
+
+      /* callers may hold locks that handlers need, like the one of a
+         #GoclBufferPool carving a new slab */
+      data = g_slice_new (HighWaterData);
+      data->self = g_object_ref (self);
+      data->allocated_size = new_size;
+
+      src = g_idle_source_new ();
+      g_source_set_callback (src,
+                             emit_high_water_in_idle,
+                             data,
+                             free_high_water_data);
+      g_source_attach (src, self->priv->main_context);
+      g_source_unref (src);
+    }
+}
+
+/**
+ * gocl_context_remove_allocation:
+ * @self: The #GoclContext
+ * @owner: The object passed to gocl_context_add_allocation()
+ *
+ * Accounts the release of the allocation of @owner, if any.
+ * This is a Gocl private function, not exposed to applications.
+ **/
+void
+gocl_context_remove_allocation (GoclContext *self, gpointer owner)
+{
+  GoclAllocationInfo *info;
+
+  g_mutex_lock (&self->priv->allocations_mutex);
+
+  info = g_hash_table_lookup (self->priv->allocations, owner);
+  if (info != NULL)
+    {
+      self->priv->allocated_size -= info->size;
+      g_hash_table_remove (self->priv->allocations, owner);
+    }
+
+  g_mutex_unlock (&self->priv->allocations_mutex);
+}
+
+/**
+ * gocl_context_set_allocation_tag:
+ * @self: The #GoclContext
+ * @owner: The object passed to gocl_context_add_allocation()
+ * @tag: (allow-none): The new tag, or %NULL
+ *
+ * Changes the tag reported for the allocation of @owner, if any.
+ * This is a Gocl private function, not exposed to applications.
+ **/
+void
+gocl_context_set_allocation_tag (GoclContext *self,
+                                 gpointer     owner,
+                                 const gchar *tag)
+{
+  GoclAllocationInfo *info;
+
+  g_mutex_lock (&self->priv->allocations_mutex);
+
+  info = g_hash_table_lookup (self->priv->allocations, owner);
+  if (info != NULL)
+    {
+      g_free (info->tag);
+      info->tag = g_strdup (tag);
+    }
+
+  g_mutex_unlock (&self->priv->allocations_mutex);
+}
+
 /* public */
 
 /**
@@ -328,6 +987,148 @@ gocl_context_new_sync (GoclDeviceType device_type)
                          NULL);
 }
 
+/**
+ * gocl_context_new_full_sync:
+ * @device_type: A value from #GoclDeviceType
+ * @platform_index: The index of the platform to use, or -1 to choose the
+ * best one automatically
+ * @vendor: (allow-none): A case-insensitive substring that the vendor name
+ * of devices must contain, or %NULL
+ * @min_compute_units: The minimum number of compute units of devices, or 0
+ * @min_global_mem_size: The minimum size in bytes of the global memory of
+ * devices, or 0
+ *
+ * Attempts to create a #GoclContext with all the devices of type
+ * @device_type that match the given criteria. When @platform_index is -1,
+ * the platform whose matching devices are estimated to be the fastest is
+ * used. Devices of the context are sorted from fastest to slowest.
+ *
+ * Returns: (transfer full): A newly created #GoclContext, or %NULL on error
+ **/
+GoclContext *
+gocl_context_new_full_sync (GoclDeviceType  device_type,
+                            gint            platform_index,
+                            const gchar    *vendor,
+                            guint           min_compute_units,
+                            guint64         min_global_mem_size)
+{
+  GError **error;
+
+  error = gocl_error_prepare ();
+
+  return g_initable_new (GOCL_TYPE_CONTEXT,
+                         NULL,
+                         error,
+                         "device-type", device_type,
+                         "platform-index", platform_index,
+                         "vendor", vendor,
+                         "min-compute-units", min_compute_units,
+                         "min-global-mem-size", min_global_mem_size,
+                         NULL);
+}
+
+/**
+ * gocl_context_new_for_devices_sync:
+ * @platform_index: The index of the platform to use
+ * @device_indices: (array length=num_devices): The indices of the devices
+ * to use, within the list of all devices of the platform
+ * @num_devices: The number of elements in @device_indices
+ *
+ * Attempts to create a #GoclContext with exactly the devices specified by
+ * @device_indices, on the platform @platform_index. Devices keep the order
+ * given in @device_indices.
+ *
+ * Returns: (transfer full): A newly created #GoclContext, or %NULL on error
+ **/
+GoclContext *
+gocl_context_new_for_devices_sync (guint        platform_index,
+                                   const guint *device_indices,
+                                   guint        num_devices)
+{
+  GError **error;
+  GArray *indices;
+  GoclContext *context;
+
+  g_return_val_if_fail (device_indices != NULL && num_devices > 0, NULL);
+
+  indices = g_array_sized_new (FALSE, FALSE, sizeof (guint), num_devices);
+  g_array_append_vals (indices, device_indices, num_devices);
+
+  error = gocl_error_prepare ();
+
+  context = g_initable_new (GOCL_TYPE_CONTEXT,
+                            NULL,
+                            error,
+                            "device-type", GOCL_DEVICE_TYPE_ALL,
+                            "platform-index", (gint) platform_index,
+                            "device-indices", indices,
+                            NULL);
+  g_array_unref (indices);
+
+  return context;
+}
+
+/**
+ * gocl_context_get_num_platforms:
+ *
+ * Obtains the number of OpenCL platforms available in the system. Platforms
+ * are referred to by their index, between 0 and this number minus one.
+ *
+ * Returns: The number of platforms, or 0 on error
+ **/
+guint
+gocl_context_get_num_platforms (void)
+{
+  GError **error;
+
+  error = gocl_error_prepare ();
+  if (! get_platforms (error))
+    return 0;
+
+  return gocl_num_platforms;
+}
+
+/**
+ * gocl_context_get_platform_name:
+ * @platform_index: The index of the platform
+ *
+ * Obtains the human readable name of the @platform_index-th platform.
+ *
+ * Returns: (transfer full): A newly allocated string, or %NULL on error
+ **/
+gchar *
+gocl_context_get_platform_name (guint platform_index)
+{
+  cl_int err_code;
+  gsize size = 0;
+  gchar *name;
+
+  if (platform_index >= gocl_context_get_num_platforms ())
+    return NULL;
+
+  err_code = clGetPlatformInfo (gocl_platforms[platform_index],
+                                CL_PLATFORM_NAME,
+                                0,
+                                NULL,
+                                &size);
+  if (gocl_error_check_opencl_internal (err_code))
+    return NULL;
+
+  name = g_new0 (gchar, size + 1);
+  err_code = clGetPlatformInfo (gocl_platforms[platform_index],
+                                CL_PLATFORM_NAME,
+                                size,
+                                name,
+                                NULL);
+  if (gocl_error_check_opencl_internal (err_code))
+    {
+      g_free (name);
+      return NULL;
+    }
+
+  return name;
+}
+
 /**
  * gocl_context_gpu_new_sync:
  * @gl_context: (allow-none): A GL context, or %NULL
@@ -416,6 +1217,81 @@ gocl_context_get_context (GoclContext *self)
   return self->priv->context;
 }
 
+/**
+ * gocl_context_get_platform_index:
+ * @self: The #GoclContext
+ *
+ * Obtains the index of the platform the context was created on.
+ *
+ * Returns: The platform index
+ **/
+gint
+gocl_context_get_platform_index (GoclContext *self)
+{
+  g_return_val_if_fail (GOCL_IS_CONTEXT (self), -1);
+
+  return self->priv->platform_index;
+}
+
+/**
+ * gocl_context_get_device_props:
+ * @self: The #GoclContext
+ * @device_id: A device of the context
+ *
+ * Obtains the properties of @device_id cached when the context was created.
+ * This is a Gocl private function, not exposed to applications.
+ *
+ * Returns: The cached properties, or %NULL if @device_id is not a device of
+ *   the context
+ **/
+const GoclDeviceProps *
+gocl_context_get_device_props (GoclContext *self, cl_device_id device_id)
+{
+  guint i;
+
+  g_return_val_if_fail (GOCL_IS_CONTEXT (self), NULL);
+
+  for (i = 0; i < self->priv->devices->len; i++)
+    {
+      GoclDeviceProps *props;
+
+      props = &g_array_index (self->priv->devices, GoclDeviceProps, i);
+      if (props->id == device_id)
+        return props;
+    }
+
+  return NULL;
+}
+
+/**
+ * gocl_context_get_svm_capabilities:
+ * @self: The #GoclContext
+ *
+ * Obtains the shared virtual memory capabilities common to all the devices
+ * of the context, as a combination of CL_DEVICE_SVM_* flags. This is zero
+ * if any device lacks SVM support, as with OpenCL 1.2 devices.
+ * This is a Gocl private function, not exposed to applications.
+ *
+ * Returns: The SVM capabilities supported by every device
+ **/
+cl_bitfield
+gocl_context_get_svm_capabilities (GoclContext *self)
+{
+  cl_bitfield caps;
+  guint i;
+
+  g_return_val_if_fail (GOCL_IS_CONTEXT (self), 0);
+
+  if (self->priv->devices->len == 0)
+    return 0;
+
+  caps = G_MAXUINT64;
+  for (i = 0; i < self->priv->devices->len; i++)
+    caps &= g_array_index (self->priv->devices, GoclDeviceProps, i).svm_capabilities;
+
+  return caps;
+}
+
 /**
  * gocl_context_get_num_devices:
  * @self: The #GoclContext
@@ -431,7 +1307,7 @@ gocl_context_get_num_devices (GoclContext *self)
 {
   g_return_val_if_fail (GOCL_IS_CONTEXT (self), 0);
 
-  return (gint) self->priv->num_devices;
+  return self->priv->devices->len;
 }
 
 /**
@@ -453,12 +1329,326 @@ gocl_context_get_device_by_index (GoclContext *self, guint device_index)
   GoclDevice *device;
 
   g_return_val_if_fail (GOCL_IS_CONTEXT (self), NULL);
-  g_return_val_if_fail (device_index < self->priv->num_devices, NULL);
+  g_return_val_if_fail (device_index < self->priv->devices->len, NULL);
 
   device = g_object_new (GOCL_TYPE_DEVICE,
                          "context", self,
-                         "id", self->priv->devices[device_index],
+                         "id", g_array_index (self->priv->devices,
+                                              GoclDeviceProps,
+                                              device_index).id,
                          NULL);
 
   return device;
 }
+
+/**
+ * gocl_context_is_image_format_supported:
+ * @self: The #GoclContext
+ * @flags: An OR'ed combination of values from #GoclBufferFlags
+ * @type: Image type value from #GoclImageType
+ * @channel_order: The channel order, a #GoclImageChannelOrder value
+ * @channel_type: The channel data type, a #GoclImageChannelType value
+ *
+ * Checks whether images of @type with the given pixel format can be created
+ * in this context, and accessed as @flags specify. Only the access flags are
+ * relevant. The list of supported formats is queried from OpenCL once per
+ * combination of access flags and image type, and cached afterwards.
+ *
+ * Returns: %TRUE if the format is supported, %FALSE otherwise
+ **/
+gboolean
+gocl_context_is_image_format_supported (GoclContext           *self,
+                                        guint                  flags,
+                                        GoclImageType          type,
+                                        GoclImageChannelOrder  channel_order,
+                                        GoclImageChannelType   channel_type)
+{
+  GArray *formats;
+  gint64 key;
+  gboolean result = FALSE;
+  guint i;
+
+  g_return_val_if_fail (GOCL_IS_CONTEXT (self), FALSE);
+
+  flags &= CL_MEM_READ_WRITE | CL_MEM_WRITE_ONLY | CL_MEM_READ_ONLY;
+  if (flags == 0)
+    flags = CL_MEM_READ_WRITE;
+
+  key = ((gint64) flags << 32) | type;
+
+  g_mutex_lock (&self->priv->image_formats_mutex);
+
+  formats = g_hash_table_lookup (self->priv->image_formats, &key);
+  if (formats == NULL)
+    {
+      cl_uint num_formats = 0;
+
+      formats = g_array_new (FALSE, TRUE, sizeof (cl_image_format));
+
+      /* a failed query leaves an empty list, so nothing is supported */
+      if (clGetSupportedImageFormats (self->priv->context,
+                                      flags,
+                                      type,
+                                      0,
+                                      NULL,
+                                      &num_formats) == CL_SUCCESS &&
+          num_formats > 0)
+        {
+          g_array_set_size (formats, num_formats);
+          if (clGetSupportedImageFormats (self->priv->context,
+                                          flags,
+                                          type,
+                                          num_formats,
+                                          (cl_image_format *) formats->data,
+                                          NULL) != CL_SUCCESS)
+            {
+              g_array_set_size (formats, 0);
+            }
+        }
+
+      g_hash_table_insert (self->priv->image_formats,
+                           g_memdup (&key, sizeof (gint64)),
+                           formats);
+    }
+
+  for (i = 0; i < formats->len && ! result; i++)
+    {
+      cl_image_format *format;
+
+      format = &g_array_index (formats, cl_image_format, i);
+      result = format->image_channel_order == (cl_channel_order) channel_order &&
+        format->image_channel_data_type == (cl_channel_type) channel_type;
+    }
+
+  g_mutex_unlock (&self->priv->image_formats_mutex);
+
+  return result;
+}
+
+/**
+ * gocl_context_get_allocated_size:
+ * @self: The #GoclContext
+ *
+ * Obtains the number of bytes of device memory currently allocated by the
+ * buffers and images of @self. Since memory objects may reside in any
+ * device of the context, this is the usage to compare against the global
+ * memory size of each device. See gocl_context_get_memory_limits().
+ *
+ * Returns: The allocated size, in bytes
+ **/
+guint64
+gocl_context_get_allocated_size (GoclContext *self)
+{
+  guint64 size;
+
+  g_return_val_if_fail (GOCL_IS_CONTEXT (self), 0);
+
+  g_mutex_lock (&self->priv->allocations_mutex);
+  size = self->priv->allocated_size;
+  g_mutex_unlock (&self->priv->allocations_mutex);
+
+  return size;
+}
+
+/**
+ * gocl_context_get_peak_allocated_size:
+ * @self: The #GoclContext
+ *
+ * Obtains the largest number of bytes of device memory allocated at once by
+ * the buffers and images of @self, since the context was created or since
+ * the last call to gocl_context_reset_peak_allocated_size().
+ *
+ * Returns: The peak allocated size, in bytes
+ **/
+guint64
+gocl_context_get_peak_allocated_size (GoclContext *self)
+{
+  guint64 size;
+
+  g_return_val_if_fail (GOCL_IS_CONTEXT (self), 0);
+
+  g_mutex_lock (&self->priv->allocations_mutex);
+  size = self->priv->peak_allocated_size;
+  g_mutex_unlock (&self->priv->allocations_mutex);
+
+  return size;
+}
+
+/**
+ * gocl_context_reset_peak_allocated_size:
+ * @self: The #GoclContext
+ *
+ * Resets the peak reported by gocl_context_get_peak_allocated_size() to the
+ * size currently allocated.
+ **/
+void
+gocl_context_reset_peak_allocated_size (GoclContext *self)
+{
+  g_return_if_fail (GOCL_IS_CONTEXT (self));
+
+  g_mutex_lock (&self->priv->allocations_mutex);
+  self->priv->peak_allocated_size = self->priv->allocated_size;
+  g_mutex_unlock (&self->priv->allocations_mutex);
+}
+
+/**
+ * gocl_context_get_allocations:
+ * @self: The #GoclContext
+ *
+ * Retrieves a snapshot of the live allocations of device memory in @self,
+ * with one #GoclAllocationInfo per buffer or image. The tag of each
+ * allocation is the one set with gocl_buffer_set_tag(), which allows
+ * telling which part of the application holds the memory.
+ *
+ * Returns: (transfer full) (element-type Gocl.AllocationInfo): A #GList of
+ *   #GoclAllocationInfo. Free with g_list_free_full() and
+ *   gocl_allocation_info_free().
+ **/
+GList *
+gocl_context_get_allocations (GoclContext *self)
+{
+  GList *list = NULL;
+  GHashTableIter iter;
+  gpointer value;
+
+  g_return_val_if_fail (GOCL_IS_CONTEXT (self), NULL);
+
+  g_mutex_lock (&self->priv->allocations_mutex);
+
+  g_hash_table_iter_init (&iter, self->priv->allocations);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    list = g_list_prepend (list, gocl_allocation_info_copy (value));
+
+  g_mutex_unlock (&self->priv->allocations_mutex);
+
+  return list;
+}
+
+/**
+ * gocl_context_get_memory_limits:
+ * @self: The #GoclContext
+ * @global_mem_size: (out) (allow-none): Return location for the smallest
+ *   CL_DEVICE_GLOBAL_MEM_SIZE among the devices, or %NULL
+ * @max_alloc_size: (out) (allow-none): Return location for the smallest
+ *   CL_DEVICE_MAX_MEM_ALLOC_SIZE among the devices, or %NULL
+ *
+ * Obtains the memory limits that allocations in @self must fit in, whatever
+ * device they end up in. Limits of a particular device are obtained with
+ * gocl_device_get_global_mem_size() and
+ * gocl_device_get_max_mem_alloc_size().
+ **/
+void
+gocl_context_get_memory_limits (GoclContext *self,
+                                guint64     *global_mem_size,
+                                guint64     *max_alloc_size)
+{
+  guint64 global_size = 0;
+  guint64 alloc_size = 0;
+  guint i;
+
+  g_return_if_fail (GOCL_IS_CONTEXT (self));
+
+  for (i = 0; i < self->priv->devices->len; i++)
+    {
+      GoclDeviceProps *props;
+
+      props = &g_array_index (self->priv->devices, GoclDeviceProps, i);
+      if (i == 0 || props->global_mem_size < global_size)
+        global_size = props->global_mem_size;
+      if (i == 0 || props->max_mem_alloc_size < alloc_size)
+        alloc_size = props->max_mem_alloc_size;
+    }
+
+  if (global_mem_size != NULL)
+    *global_mem_size = global_size;
+  if (max_alloc_size != NULL)
+    *max_alloc_size = alloc_size;
+}
+
+/**
+ * gocl_context_set_high_water_mark:
+ * @self: The #GoclContext
+ * @size: The threshold, in bytes, or 0 to disable it
+ *
+ * Sets the allocated size that triggers the #GoclContext::high-water signal.
+ * A common choice is a fraction of the global memory size returned by
+ * gocl_context_get_memory_limits(). Setting a mark below the size already
+ * allocated does not emit the signal by itself; the next allocation does.
+ **/
+void
+gocl_context_set_high_water_mark (GoclContext *self, guint64 size)
+{
+  g_return_if_fail (GOCL_IS_CONTEXT (self));
+
+  g_mutex_lock (&self->priv->allocations_mutex);
+
+  if (self->priv->high_water_mark == size)
+    {
+      g_mutex_unlock (&self->priv->allocations_mutex);
+      return;
+    }
+  self->priv->high_water_mark = size;
+
+  g_mutex_unlock (&self->priv->allocations_mutex);
+
+  g_object_notify (G_OBJECT (self), "high-water-mark");
+}
+
+/**
+ * gocl_context_get_high_water_mark:
+ * @self: The #GoclContext
+ *
+ * Obtains the threshold set with gocl_context_set_high_water_mark().
+ *
+ * Returns: The high-water mark in bytes, or 0 if disabled
+ **/
+guint64
+gocl_context_get_high_water_mark (GoclContext *self)
+{
+  guint64 size;
+
+  g_return_val_if_fail (GOCL_IS_CONTEXT (self), 0);
+
+  g_mutex_lock (&self->priv->allocations_mutex);
+  size = self->priv->high_water_mark;
+  g_mutex_unlock (&self->priv->allocations_mutex);
+
+  return size;
+}
+
+/**
+ * gocl_allocation_info_copy:
+ * @info: A #GoclAllocationInfo
+ *
+ * Makes a copy of @info.
+ *
+ * Returns: (transfer full): A newly allocated #GoclAllocationInfo. Free with
+ *   gocl_allocation_info_free().
+ **/
+GoclAllocationInfo *
+gocl_allocation_info_copy (const GoclAllocationInfo *info)
+{
+  GoclAllocationInfo *copy;
+
+  g_return_val_if_fail (info != NULL, NULL);
+
+  copy = g_slice_dup (GoclAllocationInfo, info);
+  copy->tag = g_strdup (info->tag);
+
+  return copy;
+}
+
+/**
+ * gocl_allocation_info_free:
+ * @info: A #GoclAllocationInfo
+ *
+ * Frees a #GoclAllocationInfo.
+ **/
+void
+gocl_allocation_info_free (GoclAllocationInfo *info)
+{
+  g_return_if_fail (info != NULL);
+
+  g_free (info->tag);
+  g_slice_free (GoclAllocationInfo, info);
+}
@@ -32,6 +32,7 @@
 #include "gocl-device.h"
 #include "gocl-buffer.h"
 #include "gocl-image.h"
+#include "gocl-svm-buffer.h"
 
 G_BEGIN_DECLS
 
@@ -46,6 +47,10 @@ typedef struct _GoclContextClass GoclContextClass;
 typedef struct _GoclContext GoclContext;
 typedef struct _GoclContextPrivate GoclContextPrivate;
 
+#define GOCL_TYPE_ALLOCATION_INFO      (gocl_allocation_info_get_type ())
+
+typedef struct _GoclAllocationInfo GoclAllocationInfo;
+
 struct _GoclContext
 {
   GObject parent_instance;
@@ -56,14 +61,45 @@ struct _GoclContext
 struct _GoclContextClass
 {
   GObjectClass parent_class;
+
+  void (* high_water) (GoclContext *self,
+                       guint64      allocated_size);
+};
+
+/**
+ * GoclAllocationInfo:
+ * @tag: The tag of the buffer owning the allocation, or %NULL
+ * @flags: The #GoclBufferFlags the buffer was created with
+ * @size: The size of the allocation, in bytes
+ *
+ * Describes a live allocation of device memory by a #GoclBuffer or
+ * #GoclImage. See gocl_context_get_allocations().
+ **/
+struct _GoclAllocationInfo
+{
+  gchar *tag;
+  guint flags;
+  guint64 size;
 };
 
 GType                  gocl_context_get_type                   (void) G_GNUC_CONST;
 
 GoclContext *          gocl_context_new_sync                   (GoclDeviceType device_type);
+GoclContext *          gocl_context_new_full_sync              (GoclDeviceType  device_type,
+                                                                gint            platform_index,
+                                                                const gchar    *vendor,
+                                                                guint           min_compute_units,
+                                                                guint64         min_global_mem_size);
+GoclContext *          gocl_context_new_for_devices_sync       (guint        platform_index,
+                                                                const guint *device_indices,
+                                                                guint        num_devices);
 GoclContext *          gocl_context_gpu_new_sync               (gpointer gl_context,
                                                                 gpointer gl_display);
 
+guint                  gocl_context_get_num_platforms          (void);
+gchar *                gocl_context_get_platform_name          (guint platform_index);
+gint                   gocl_context_get_platform_index         (GoclContext *self);
+
 GoclContext *          gocl_context_get_default_cpu_sync       (void);
 GoclContext *          gocl_context_get_default_gpu_sync       (void);
 
@@ -72,6 +108,28 @@ guint                  gocl_context_get_num_devices            (GoclContext *sel
 GoclDevice *           gocl_context_get_device_by_index        (GoclContext *self,
                                                                 guint        device_index);
 
+gboolean               gocl_context_is_image_format_supported  (GoclContext           *self,
+                                                                guint                  flags,
+                                                                GoclImageType          type,
+                                                                GoclImageChannelOrder  channel_order,
+                                                                GoclImageChannelType   channel_type);
+
+guint64                gocl_context_get_allocated_size         (GoclContext *self);
+guint64                gocl_context_get_peak_allocated_size    (GoclContext *self);
+void                   gocl_context_reset_peak_allocated_size  (GoclContext *self);
+GList *                gocl_context_get_allocations            (GoclContext *self);
+void                   gocl_context_get_memory_limits          (GoclContext *self,
+                                                                guint64     *global_mem_size,
+                                                                guint64     *max_alloc_size);
+
+void                   gocl_context_set_high_water_mark        (GoclContext *self,
+                                                                guint64      size);
+guint64                gocl_context_get_high_water_mark        (GoclContext *self);
+
+GType                  gocl_allocation_info_get_type           (void) G_GNUC_CONST;
+GoclAllocationInfo *   gocl_allocation_info_copy               (const GoclAllocationInfo *info);
+void                   gocl_allocation_info_free               (GoclAllocationInfo *info);
+
 /* GoclDevice headers */
 GoclContext *          gocl_device_get_context                 (GoclDevice *device);
 
@@ -80,19 +138,48 @@ GoclBuffer *           gocl_buffer_new                         (GoclContext *con
                                                                 guint        flags,
                                                                 gsize        size,
                                                                 gpointer     host_ptr);
+GoclBuffer *           gocl_buffer_new_full                    (GoclContext  *context,
+                                                                guint         flags,
+                                                                gsize         size,
+                                                                gpointer      host_ptr,
+                                                                GError      **error);
+GoclBuffer *           gocl_buffer_new_from_gl_buffer          (GoclContext *context,
+                                                                guint        flags,
+                                                                guint        gl_buffer);
+GoclBuffer *           gocl_buffer_new_managed                 (GoclContext   *context,
+                                                                guint          flags,
+                                                                gsize          size,
+                                                                gconstpointer  data);
+GoclBuffer *           gocl_buffer_new_from_bytes              (GoclContext *context,
+                                                                GBytes      *bytes);
 GoclContext *          gocl_buffer_get_context                 (GoclBuffer *buffer);
+void                   gocl_buffer_set_tag                     (GoclBuffer  *buffer,
+                                                                const gchar *tag);
+const gchar *          gocl_buffer_get_tag                     (GoclBuffer *buffer);
+
+/* GoclSvmBuffer headers */
+GoclSvmBuffer *        gocl_svm_buffer_new                     (GoclContext *context,
+                                                                guint        flags,
+                                                                gsize        size);
 
 /* GoclImage headers */
-GoclImage *            gocl_image_new                          (GoclContext   *context,
-                                                                guint          flags,
-                                                                gpointer       host_ptr,
-                                                                GoclImageType  type,
-                                                                gsize          width,
-                                                                gsize          height,
-                                                                gsize          depth);
+GoclImage *            gocl_image_new                          (GoclContext           *context,
+                                                                guint                  flags,
+                                                                gpointer               host_ptr,
+                                                                GoclImageType          type,
+                                                                GoclImageChannelOrder  channel_order,
+                                                                GoclImageChannelType   channel_type,
+                                                                gsize                  width,
+                                                                gsize                  height,
+                                                                gsize                  depth);
 GoclImage *            gocl_image_new_from_gl_texture          (GoclContext *context,
                                                                 guint        flags,
                                                                 guint        texture);
+GoclImage *            gocl_image_new_from_gl_texture_full     (GoclContext *context,
+                                                                guint        flags,
+                                                                guint        target,
+                                                                gint         mip_level,
+                                                                guint        texture);
 #ifdef HAS_COGL
 GoclImage *            gocl_image_new_from_cogl_texture        (GoclContext *context,
                                                                 guint        flags,
@@ -83,6 +83,26 @@ typedef enum
   GOCL_BUFFER_FLAGS_COPY_HOST_PTR  = CL_MEM_COPY_HOST_PTR
 } GoclBufferFlags;
 
+/**
+ * GoclBufferMapFlags:
+ * @GOCL_BUFFER_MAP_FLAGS_READ:                    The mapped region will be
+ *                                                 read by the host.
+ * @GOCL_BUFFER_MAP_FLAGS_WRITE:                   The mapped region will be
+ *                                                 written by the host.
+ * @GOCL_BUFFER_MAP_FLAGS_WRITE_INVALIDATE_REGION: The mapped region will be
+ *                                                 entirely overwritten by the
+ *                                                 host, so its current
+ *                                                 contents need not be
+ *                                                 transferred. Requires
+ *                                                 OpenCL 1.2.
+ **/
+typedef enum
+{
+  GOCL_BUFFER_MAP_FLAGS_READ                    = CL_MAP_READ,
+  GOCL_BUFFER_MAP_FLAGS_WRITE                   = CL_MAP_WRITE,
+  GOCL_BUFFER_MAP_FLAGS_WRITE_INVALIDATE_REGION = CL_MAP_WRITE_INVALIDATE_REGION
+} GoclBufferMapFlags;
+
 /**
  * GoclQueueFlags:
  * @GOCL_QUEUE_FLAGS_OUT_OF_ORDER: Enables out-of-order execution of commands.
@@ -94,6 +114,52 @@ typedef enum
   GOCL_QUEUE_FLAGS_PROFILING    = CL_QUEUE_PROFILING_ENABLE
 } GoclQueueFlags;
 
+/**
+ * GoclCallbackDispatch:
+ * @GOCL_CALLBACK_DISPATCH_MAIN_CONTEXT:      Callbacks run from an idle source
+ *                                            on the thread-default main
+ *                                            context of the thread that
+ *                                            requested them. This is the
+ *                                            default.
+ * @GOCL_CALLBACK_DISPATCH_COMPLETION_THREAD: Callbacks run directly on the
+ *                                            thread that observes the
+ *                                            completion of the command,
+ *                                            without going through any main
+ *                                            loop.
+ * @GOCL_CALLBACK_DISPATCH_THREAD_POOL:       Callbacks are pushed to a
+ *                                            #GThreadPool supplied by the
+ *                                            application.
+ *
+ * How the callbacks requested with gocl_event_then() are invoked.
+ **/
+typedef enum
+{
+  GOCL_CALLBACK_DISPATCH_MAIN_CONTEXT = 0,
+  GOCL_CALLBACK_DISPATCH_COMPLETION_THREAD,
+  GOCL_CALLBACK_DISPATCH_THREAD_POOL
+} GoclCallbackDispatch;
+
+/**
+ * GoclEventStatus:
+ * @GOCL_EVENT_STATUS_ERROR:     The command failed, or the event was
+ *                               resolved with an error.
+ * @GOCL_EVENT_STATUS_COMPLETE:  The command completed successfully.
+ * @GOCL_EVENT_STATUS_RUNNING:   The command is executing in the device.
+ * @GOCL_EVENT_STATUS_SUBMITTED: The command was submitted to the device.
+ * @GOCL_EVENT_STATUS_QUEUED:    The command is in the queue.
+ *
+ * The execution status of the command represented by a #GoclEvent, as
+ * returned by gocl_event_get_status().
+ **/
+typedef enum
+{
+  GOCL_EVENT_STATUS_ERROR     = -1,
+  GOCL_EVENT_STATUS_COMPLETE  = CL_COMPLETE,
+  GOCL_EVENT_STATUS_RUNNING   = CL_RUNNING,
+  GOCL_EVENT_STATUS_SUBMITTED = CL_SUBMITTED,
+  GOCL_EVENT_STATUS_QUEUED    = CL_QUEUED
+} GoclEventStatus;
+
 /**
  * GoclImageType:
  * @GOCL_IMAGE_TYPE_1D:        Unidimensional image
@@ -113,6 +179,112 @@ typedef enum
   GOCL_IMAGE_TYPE_3D        = CL_MEM_OBJECT_IMAGE3D
 } GoclImageType;
 
+/**
+ * GoclImageChannelOrder:
+ * @GOCL_IMAGE_CHANNEL_ORDER_R:         A single red channel
+ * @GOCL_IMAGE_CHANNEL_ORDER_A:         A single alpha channel
+ * @GOCL_IMAGE_CHANNEL_ORDER_RG:        Red and green channels
+ * @GOCL_IMAGE_CHANNEL_ORDER_RA:        Red and alpha channels
+ * @GOCL_IMAGE_CHANNEL_ORDER_RGB:       Red, green and blue channels, only for
+ *                                      packed channel types
+ * @GOCL_IMAGE_CHANNEL_ORDER_RGBA:      Red, green, blue and alpha channels
+ * @GOCL_IMAGE_CHANNEL_ORDER_BGRA:      Blue, green, red and alpha channels
+ * @GOCL_IMAGE_CHANNEL_ORDER_ARGB:      Alpha, red, green and blue channels
+ * @GOCL_IMAGE_CHANNEL_ORDER_INTENSITY: A single intensity channel, replicated
+ *                                      into all components when read
+ * @GOCL_IMAGE_CHANNEL_ORDER_LUMINANCE: A single luminance channel, replicated
+ *                                      into the color components when read
+ *
+ * The channels of each pixel of an image, in memory order.
+ **/
+typedef enum
+{
+  GOCL_IMAGE_CHANNEL_ORDER_R         = CL_R,
+  GOCL_IMAGE_CHANNEL_ORDER_A         = CL_A,
+  GOCL_IMAGE_CHANNEL_ORDER_RG        = CL_RG,
+  GOCL_IMAGE_CHANNEL_ORDER_RA        = CL_RA,
+  GOCL_IMAGE_CHANNEL_ORDER_RGB       = CL_RGB,
+  GOCL_IMAGE_CHANNEL_ORDER_RGBA      = CL_RGBA,
+  GOCL_IMAGE_CHANNEL_ORDER_BGRA      = CL_BGRA,
+  GOCL_IMAGE_CHANNEL_ORDER_ARGB      = CL_ARGB,
+  GOCL_IMAGE_CHANNEL_ORDER_INTENSITY = CL_INTENSITY,
+  GOCL_IMAGE_CHANNEL_ORDER_LUMINANCE = CL_LUMINANCE
+} GoclImageChannelOrder;
+
+/**
+ * GoclImageChannelType:
+ * @GOCL_IMAGE_CHANNEL_TYPE_SNORM_INT8:     Signed 8-bit integer, normalized
+ *                                          to [-1.0, 1.0]
+ * @GOCL_IMAGE_CHANNEL_TYPE_SNORM_INT16:    Signed 16-bit integer, normalized
+ *                                          to [-1.0, 1.0]
+ * @GOCL_IMAGE_CHANNEL_TYPE_UNORM_INT8:     Unsigned 8-bit integer, normalized
+ *                                          to [0.0, 1.0]
+ * @GOCL_IMAGE_CHANNEL_TYPE_UNORM_INT16:    Unsigned 16-bit integer,
+ *                                          normalized to [0.0, 1.0]
+ * @GOCL_IMAGE_CHANNEL_TYPE_UNORM_SHORT_565: RGB packed in 16 bits, as 5-6-5
+ * @GOCL_IMAGE_CHANNEL_TYPE_UNORM_SHORT_555: RGB packed in 16 bits, as x-5-5-5
+ * @GOCL_IMAGE_CHANNEL_TYPE_UNORM_INT_101010: RGB packed in 32 bits, as
+ *                                          x-10-10-10
+ * @GOCL_IMAGE_CHANNEL_TYPE_SIGNED_INT8:    Signed 8-bit integer
+ * @GOCL_IMAGE_CHANNEL_TYPE_SIGNED_INT16:   Signed 16-bit integer
+ * @GOCL_IMAGE_CHANNEL_TYPE_SIGNED_INT32:   Signed 32-bit integer
+ * @GOCL_IMAGE_CHANNEL_TYPE_UNSIGNED_INT8:  Unsigned 8-bit integer
+ * @GOCL_IMAGE_CHANNEL_TYPE_UNSIGNED_INT16: Unsigned 16-bit integer
+ * @GOCL_IMAGE_CHANNEL_TYPE_UNSIGNED_INT32: Unsigned 32-bit integer
+ * @GOCL_IMAGE_CHANNEL_TYPE_HALF_FLOAT:     16-bit floating point
+ * @GOCL_IMAGE_CHANNEL_TYPE_FLOAT:          32-bit floating point
+ *
+ * The data type of each channel of an image.
+ **/
+typedef enum
+{
+  GOCL_IMAGE_CHANNEL_TYPE_SNORM_INT8       = CL_SNORM_INT8,
+  GOCL_IMAGE_CHANNEL_TYPE_SNORM_INT16      = CL_SNORM_INT16,
+  GOCL_IMAGE_CHANNEL_TYPE_UNORM_INT8       = CL_UNORM_INT8,
+  GOCL_IMAGE_CHANNEL_TYPE_UNORM_INT16      = CL_UNORM_INT16,
+  GOCL_IMAGE_CHANNEL_TYPE_UNORM_SHORT_565  = CL_UNORM_SHORT_565,
+  GOCL_IMAGE_CHANNEL_TYPE_UNORM_SHORT_555  = CL_UNORM_SHORT_555,
+  GOCL_IMAGE_CHANNEL_TYPE_UNORM_INT_101010 = CL_UNORM_INT_101010,
+  GOCL_IMAGE_CHANNEL_TYPE_SIGNED_INT8      = CL_SIGNED_INT8,
+  GOCL_IMAGE_CHANNEL_TYPE_SIGNED_INT16     = CL_SIGNED_INT16,
+  GOCL_IMAGE_CHANNEL_TYPE_SIGNED_INT32     = CL_SIGNED_INT32,
+  GOCL_IMAGE_CHANNEL_TYPE_UNSIGNED_INT8    = CL_UNSIGNED_INT8,
+  GOCL_IMAGE_CHANNEL_TYPE_UNSIGNED_INT16   = CL_UNSIGNED_INT16,
+  GOCL_IMAGE_CHANNEL_TYPE_UNSIGNED_INT32   = CL_UNSIGNED_INT32,
+  GOCL_IMAGE_CHANNEL_TYPE_HALF_FLOAT       = CL_HALF_FLOAT,
+  GOCL_IMAGE_CHANNEL_TYPE_FLOAT            = CL_FLOAT
+} GoclImageChannelType;
+
+/**
+ * GoclPrimitivesType:
+ * @GOCL_PRIMITIVES_TYPE_FLOAT:  32 bits floating point elements
+ * @GOCL_PRIMITIVES_TYPE_INT32:  32 bits signed integer elements
+ * @GOCL_PRIMITIVES_TYPE_UINT32: 32 bits unsigned integer elements
+ *
+ * The type of the elements of the buffers processed by a #GoclPrimitives.
+ **/
+typedef enum
+{
+  GOCL_PRIMITIVES_TYPE_FLOAT = 0,
+  GOCL_PRIMITIVES_TYPE_INT32,
+  GOCL_PRIMITIVES_TYPE_UINT32
+} GoclPrimitivesType;
+
+/**
+ * GoclPrimitivesOp:
+ * @GOCL_PRIMITIVES_OP_SUM: The sum of the elements
+ * @GOCL_PRIMITIVES_OP_MIN: The smallest element
+ * @GOCL_PRIMITIVES_OP_MAX: The largest element
+ *
+ * The operation combining elements in gocl_primitives_reduce().
+ **/
+typedef enum
+{
+  GOCL_PRIMITIVES_OP_SUM = 0,
+  GOCL_PRIMITIVES_OP_MIN,
+  GOCL_PRIMITIVES_OP_MAX
+} GoclPrimitivesOp;
+
 G_END_DECLS
 
 #endif /* __GOCL_DECLS_H__ */
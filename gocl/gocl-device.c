@@ -30,11 +30,20 @@
  *
  * To obtain the maximum work group size of a device,
  * gocl_device_get_max_work_group_size() is used. The number of compute units can be
- * retrieved with gocl_device_get_max_compute_units().
+ * retrieved with gocl_device_get_max_compute_units(). Other properties like name, vendor
+ * and memory sizes have their own getters as well. All these are queried once, when the
+ * context discovers its devices, so calling the getters is cheap.
  *
  * To enqueue operations on this device, a #GoclQueue provides a default command queue
  * which is obtained by calling gocl_device_get_default_queue(). More device queues can
- * be created by passing this object as 'device' property in the #GoclQueue constructor.
+ * be created with gocl_queue_new().
+ *
+ * A device also owns a pool of command queues, to allow for commands on different
+ * queues to execute concurrently. The default queue is always the first queue of the
+ * pool. More queues are added with gocl_device_add_queue(), and retrieved with
+ * gocl_device_get_queue_by_index(). Additionally, gocl_device_get_copy_queue()
+ * provides a dedicated queue for host-device transfers, so that these can overlap
+ * with kernels running on the other queues.
  **/
 
 /**
@@ -44,6 +53,7 @@
  * The class for #GoclDevice objects.
  **/
 
+#include <string.h>
 #include <gio/gio.h>
 
 #include "gocl-device.h"
@@ -58,9 +68,13 @@ struct _GoclDevicePrivate
   GoclContext *context;
   cl_device_id device_id;
 
-  gsize max_work_group_size;
+  /* points to the properties cached by the context, or to own_props */
+  const GoclDeviceProps *props;
+  GoclDeviceProps own_props;
 
-  GoclQueue *queue;
+  /* the default queue is always at index 0 */
+  GPtrArray *queues;
+  GoclQueue *copy_queue;
 
   gchar *extensions;
 };
@@ -129,8 +143,10 @@ gocl_device_init (GoclDevice *self)
 
   self->priv = priv = GOCL_DEVICE_GET_PRIVATE (self);
 
-  priv->max_work_group_size = 0;
-  priv->queue = NULL;
+  priv->props = NULL;
+
+  priv->queues = g_ptr_array_new_with_free_func (g_object_unref);
+  priv->copy_queue = NULL;
 
   priv->extensions = NULL;
 }
@@ -146,10 +162,16 @@ gocl_device_dispose (GObject *obj)
       self->priv->context = NULL;
     }
 
-  if (self->priv->queue != NULL)
+  if (self->priv->queues != NULL)
+    {
+      g_ptr_array_unref (self->priv->queues);
+      self->priv->queues = NULL;
+    }
+
+  if (self->priv->copy_queue != NULL)
     {
-      g_object_unref (self->priv->queue);
-      self->priv->queue = NULL;
+      g_object_unref (self->priv->copy_queue);
+      self->priv->copy_queue = NULL;
     }
 
   G_OBJECT_CLASS (gocl_device_parent_class)->dispose (obj);
@@ -162,6 +184,8 @@ gocl_device_finalize (GObject *obj)
 
   g_free (self->priv->extensions);
 
+  gocl_device_props_clear (&self->priv->own_props);
+
   G_OBJECT_CLASS (gocl_device_parent_class)->finalize (obj);
 }
 
@@ -217,19 +241,143 @@ get_property (GObject    *obj,
     }
 }
 
+static const GoclDeviceProps *
+get_props (GoclDevice *self)
+{
+  cl_int err_code;
+
+  if (self->priv->props != NULL)
+    return self->priv->props;
+
+  if (self->priv->context != NULL)
+    self->priv->props =
+      gocl_context_get_device_props (self->priv->context,
+                                     self->priv->device_id);
+
+  /* not a device discovered by the context, query it ourselves */
+  if (self->priv->props == NULL)
+    {
+      err_code = gocl_device_props_query (&self->priv->own_props,
+                                          self->priv->device_id);
+      gocl_error_check_opencl_internal (err_code);
+
+      self->priv->props = &self->priv->own_props;
+    }
+
+  return self->priv->props;
+}
+
+static gchar *
+get_info_string (cl_device_id device_id, cl_device_info param, cl_int *err_code)
+{
+  gsize size = 0;
+  gchar *value;
+
+  *err_code = clGetDeviceInfo (device_id, param, 0, NULL, &size);
+  if (*err_code != CL_SUCCESS)
+    return NULL;
+
+  value = g_new0 (gchar, size + 1);
+  *err_code = clGetDeviceInfo (device_id, param, size, value, NULL);
+  if (*err_code != CL_SUCCESS)
+    {
+      g_free (value);
+      return NULL;
+    }
+
+  return value;
+}
+
+static cl_int
+get_max_work_item_sizes (cl_device_id device_id, gsize *sizes)
+{
+  cl_uint dims = 0;
+  gsize *all_sizes;
+  cl_int err_code;
+
+  err_code = clGetDeviceInfo (device_id,
+                              CL_DEVICE_MAX_WORK_ITEM_DIMENSIONS,
+                              sizeof (cl_uint),
+                              &dims,
+                              NULL);
+  if (err_code != CL_SUCCESS)
+    return err_code;
+
+  /* devices may report more than the three dimensions we use */
+  all_sizes = g_new0 (gsize, MAX (dims, 3));
+  err_code = clGetDeviceInfo (device_id,
+                              CL_DEVICE_MAX_WORK_ITEM_SIZES,
+                              sizeof (gsize) * dims,
+                              all_sizes,
+                              NULL);
+  memcpy (sizes, all_sizes, sizeof (gsize) * 3);
+  g_free (all_sizes);
+
+  return err_code;
+}
+
+/* from cl_gl_ext.h, resolved at runtime since it is an extension */
+typedef cl_event (*CreateEventFromGLsyncFunc) (cl_context  context,
+                                               cl_GLsync   sync,
+                                               cl_int     *err_code);
+
+static cl_event
+create_event_from_gl_sync (GoclDevice *self,
+                           gpointer    gl_sync,
+                           cl_int     *err_code)
+{
+  cl_platform_id platform;
+  CreateEventFromGLsyncFunc func;
+
+  if (! gocl_device_has_extension (self, "cl_khr_gl_event"))
+    {
+      *err_code = CL_INVALID_OPERATION;
+      return NULL;
+    }
+
+  *err_code = clGetDeviceInfo (self->priv->device_id,
+                               CL_DEVICE_PLATFORM,
+                               sizeof (cl_platform_id),
+                               &platform,
+                               NULL);
+  if (*err_code != CL_SUCCESS)
+    return NULL;
+
+#ifdef CL_VERSION_1_2
+  func = (CreateEventFromGLsyncFunc)
+    clGetExtensionFunctionAddressForPlatform (platform,
+                                              "clCreateEventFromGLsyncKHR");
+#else
+  func = (CreateEventFromGLsyncFunc)
+    clGetExtensionFunctionAddress ("clCreateEventFromGLsyncKHR");
+#endif
+  if (func == NULL)
+    {
+      *err_code = CL_INVALID_OPERATION;
+      return NULL;
+    }
+
+  return func (gocl_context_get_context (self->priv->context),
+               (cl_GLsync) gl_sync,
+               err_code);
+}
+
 static gboolean
 acquire_or_release_gl_objects (GoclDevice  *self,
                                gboolean     acquire,
                                GList       *object_list,
                                GList       *event_wait_list,
+                               gpointer     gl_sync,
                                cl_event    *out_event)
 {
   cl_int err_code;
   GoclQueue *queue;
   cl_command_queue _queue;
 
-  cl_event *_event_wait_list = NULL;
-  guint event_wait_list_len;
+  GoclWaitList wait_list;
+  cl_event *events;
+  guint num_events;
+  cl_event gl_event = NULL;
 
   cl_mem *_object_list;
   guint object_list_len;
@@ -245,8 +393,26 @@ acquire_or_release_gl_objects (GoclDevice  *self,
 
   _queue = gocl_queue_get_queue (queue);
 
-  _event_wait_list = gocl_event_list_to_array (event_wait_list,
-                                               &event_wait_list_len);
+  /* a GL fence becomes one more event to wait for, so the device waits for
+     the GL commands before it, instead of the host doing a glFinish() */
+  if (gl_sync != NULL)
+    {
+      gl_event = create_event_from_gl_sync (self, gl_sync, &err_code);
+      if (gocl_error_check_opencl_internal (err_code))
+        return FALSE;
+    }
+
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
+  events = wait_list.cl_events;
+  num_events = wait_list.len;
+  if (gl_event != NULL)
+    {
+      events = g_new (cl_event, num_events + 1);
+      if (num_events > 0)
+        memcpy (events, wait_list.cl_events, sizeof (cl_event) * num_events);
+      events[num_events++] = gl_event;
+    }
+
   _object_list = gocl_buffer_list_to_array (object_list,
                                             &object_list_len);
 
@@ -254,18 +420,23 @@ acquire_or_release_gl_objects (GoclDevice  *self,
     err_code = clEnqueueAcquireGLObjects (_queue,
                                           object_list_len,
                                           _object_list,
-                                          event_wait_list_len,
-                                          _event_wait_list,
+                                          num_events,
+                                          events,
                                           out_event);
   else
     err_code = clEnqueueReleaseGLObjects (_queue,
                                           object_list_len,
                                           _object_list,
-                                          event_wait_list_len,
-                                          _event_wait_list,
+                                          num_events,
+                                          events,
                                           out_event);
 
-  g_free (_event_wait_list);
+  if (gl_event != NULL)
+    {
+      g_free (events);
+      clReleaseEvent (gl_event);
+    }
+  gocl_wait_list_clear (&wait_list);
   g_free (_object_list);
 
   if (gocl_error_check_opencl_internal (err_code))
@@ -274,6 +445,68 @@ acquire_or_release_gl_objects (GoclDevice  *self,
   return TRUE;
 }
 
+/* internal */
+
+cl_int
+gocl_device_props_query (GoclDeviceProps *props, cl_device_id device_id)
+{
+  cl_int err_code;
+
+  memset (props, 0, sizeof (GoclDeviceProps));
+  props->id = device_id;
+
+#define QUERY(param, field)                                     \
+  if (err_code == CL_SUCCESS)                                   \
+    err_code = clGetDeviceInfo (device_id,                      \
+                                param,                          \
+                                sizeof (props->field),          \
+                                &props->field,                  \
+                                NULL)
+
+  err_code = CL_SUCCESS;
+  QUERY (CL_DEVICE_TYPE, type);
+  QUERY (CL_DEVICE_MAX_COMPUTE_UNITS, max_compute_units);
+  QUERY (CL_DEVICE_MAX_CLOCK_FREQUENCY, max_clock_frequency);
+  QUERY (CL_DEVICE_MAX_WORK_GROUP_SIZE, max_work_group_size);
+  QUERY (CL_DEVICE_GLOBAL_MEM_SIZE, global_mem_size);
+  QUERY (CL_DEVICE_MAX_MEM_ALLOC_SIZE, max_mem_alloc_size);
+  QUERY (CL_DEVICE_LOCAL_MEM_SIZE, local_mem_size);
+  QUERY (CL_DEVICE_MEM_BASE_ADDR_ALIGN, mem_base_addr_align);
+  QUERY (CL_DEVICE_HOST_UNIFIED_MEMORY, host_unified_memory);
+
+#undef QUERY
+
+  if (err_code == CL_SUCCESS)
+    err_code = get_max_work_item_sizes (device_id, props->max_work_item_sizes);
+  if (err_code == CL_SUCCESS)
+    props->name = get_info_string (device_id, CL_DEVICE_NAME, &err_code);
+  if (err_code == CL_SUCCESS)
+    props->vendor = get_info_string (device_id, CL_DEVICE_VENDOR, &err_code);
+
+#ifdef CL_VERSION_2_0
+  /* devices older than OpenCL 2.0 fail this query, and simply have no SVM */
+  if (err_code == CL_SUCCESS &&
+      clGetDeviceInfo (device_id,
+                       CL_DEVICE_SVM_CAPABILITIES,
+                       sizeof (props->svm_capabilities),
+                       &props->svm_capabilities,
+                       NULL) != CL_SUCCESS)
+    props->svm_capabilities = 0;
+#endif
+
+  return err_code;
+}
+
+void
+gocl_device_props_clear (GoclDeviceProps *props)
+{
+  g_free (props->name);
+  props->name = NULL;
+
+  g_free (props->vendor);
+  props->vendor = NULL;
+}
+
 /* public */
 
 /**
@@ -324,22 +557,9 @@ gocl_device_get_context (GoclDevice *device)
 gsize
 gocl_device_get_max_work_group_size (GoclDevice *self)
 {
-  cl_int err_code;
-
   g_return_val_if_fail (GOCL_IS_DEVICE (self), 0);
 
-  if (self->priv->max_work_group_size > 0)
-    return self->priv->max_work_group_size;
-
-  err_code = clGetDeviceInfo (self->priv->device_id,
-                              CL_DEVICE_MAX_WORK_GROUP_SIZE,
-                              sizeof (gsize),
-                              &self->priv->max_work_group_size,
-                              NULL);
-  if (gocl_error_check_opencl_internal (err_code))
-    return 0;
-
-  return self->priv->max_work_group_size;
+  return get_props (self)->max_work_group_size;
 }
 
 /**
@@ -355,21 +575,117 @@ gocl_device_get_max_work_group_size (GoclDevice *self)
 GoclQueue *
 gocl_device_get_default_queue (GoclDevice *self)
 {
+  GoclQueue *queue;
+
   g_return_val_if_fail (GOCL_IS_DEVICE (self), NULL);
 
-  if (self->priv->queue == NULL)
+  if (self->priv->queues->len == 0)
     {
-      GError **error;
-
-      error = gocl_error_prepare ();
-      self->priv->queue = g_initable_new (GOCL_TYPE_QUEUE,
-                                          NULL,
-                                          error,
-                                          "device", self,
-                                          NULL);
+      queue = gocl_queue_new (self, 0);
+      if (queue == NULL)
+        return NULL;
+
+      g_ptr_array_add (self->priv->queues, queue);
     }
 
-  return self->priv->queue;
+  return g_ptr_array_index (self->priv->queues, 0);
+}
+
+/**
+ * gocl_device_add_queue:
+ * @self: The #GoclDevice
+ * @flags: An OR'ed combination of values from #GoclQueueFlags
+ *
+ * Creates a new command queue with properties specified in @flags, and adds it
+ * to the device's pool of queues. The default queue is created first if it
+ * didn't exist yet, so the new queue's index is always greater than zero.
+ *
+ * Returns: (transfer none): The newly created #GoclQueue, which is owned by
+ *   the device and should not be freed, or %NULL on error
+ **/
+GoclQueue *
+gocl_device_add_queue (GoclDevice *self, guint flags)
+{
+  GoclQueue *queue;
+
+  g_return_val_if_fail (GOCL_IS_DEVICE (self), NULL);
+
+  if (gocl_device_get_default_queue (self) == NULL)
+    return NULL;
+
+  queue = gocl_queue_new (self, flags);
+  if (queue == NULL)
+    return NULL;
+
+  g_ptr_array_add (self->priv->queues, queue);
+
+  return queue;
+}
+
+/**
+ * gocl_device_get_num_queues:
+ * @self: The #GoclDevice
+ *
+ * Obtains the number of queues currently in the device's pool of queues. This
+ * includes the default queue, if it has been created already, but not the
+ * queue returned by gocl_device_get_copy_queue().
+ *
+ * Returns: The number of queues in the pool
+ **/
+guint
+gocl_device_get_num_queues (GoclDevice *self)
+{
+  g_return_val_if_fail (GOCL_IS_DEVICE (self), 0);
+
+  return self->priv->queues->len;
+}
+
+/**
+ * gocl_device_get_queue_by_index:
+ * @self: The #GoclDevice
+ * @index: The index of the queue in the pool
+ *
+ * Obtains the queue at position @index in the device's pool of queues. Index
+ * zero is the default queue, which is created if needed.
+ *
+ * Returns: (transfer none): A #GoclQueue owned by the device, or %NULL if
+ *   @index is out of range
+ **/
+GoclQueue *
+gocl_device_get_queue_by_index (GoclDevice *self, guint index)
+{
+  g_return_val_if_fail (GOCL_IS_DEVICE (self), NULL);
+
+  if (index == 0)
+    return gocl_device_get_default_queue (self);
+
+  if (index >= self->priv->queues->len)
+    return NULL;
+
+  return g_ptr_array_index (self->priv->queues, index);
+}
+
+/**
+ * gocl_device_get_copy_queue:
+ * @self: The #GoclDevice
+ *
+ * Obtains a command queue dedicated to transfers between host and device, so
+ * that reads and writes enqueued on it can overlap with kernels running on the
+ * device's other queues. The queue is created on first use, and is not part of
+ * the pool of queues.
+ *
+ * Returns: (transfer none): A #GoclQueue owned by the device, or %NULL on
+ *   error
+ **/
+GoclQueue *
+gocl_device_get_copy_queue (GoclDevice *self)
+{
+  g_return_val_if_fail (GOCL_IS_DEVICE (self), NULL);
+
+  if (self->priv->copy_queue == NULL)
+    self->priv->copy_queue = gocl_queue_new (self, 0);
+
+  return self->priv->copy_queue;
 }
 
 /**
@@ -428,26 +744,108 @@ gocl_device_has_extension (GoclDevice *self, const gchar *extension_name)
 guint
 gocl_device_get_max_compute_units (GoclDevice *self)
 {
-  cl_int err_code;
-  cl_uint max_compute_units;
-  GError *error = NULL;
+  g_return_val_if_fail (GOCL_IS_DEVICE (self), 0);
 
-  g_return_val_if_fail (GOCL_IS_DEVICE (self), FALSE);
+  return get_props (self)->max_compute_units;
+}
 
-  err_code = clGetDeviceInfo (self->priv->device_id,
-                              CL_DEVICE_MAX_COMPUTE_UNITS,
-                              sizeof (guint),
-                              &max_compute_units,
-                              NULL);
-  if (gocl_error_check_opencl (err_code, &error))
-    {
-      g_warning ("Error getting device info for CL_DEVICE_MAX_COMPUTE_UNITS: %s",
-                 error->message);
-      g_error_free (error);
-      return 0;
-    }
+/**
+ * gocl_device_get_name:
+ * @self: The #GoclDevice
+ *
+ * Obtains the name of the device, as reported by CL_DEVICE_NAME.
+ *
+ * Returns: (transfer none): The name of the device, or %NULL on error
+ **/
+const gchar *
+gocl_device_get_name (GoclDevice *self)
+{
+  g_return_val_if_fail (GOCL_IS_DEVICE (self), NULL);
+
+  return get_props (self)->name;
+}
+
+/**
+ * gocl_device_get_vendor:
+ * @self: The #GoclDevice
+ *
+ * Obtains the vendor of the device, as reported by CL_DEVICE_VENDOR.
+ *
+ * Returns: (transfer none): The vendor of the device, or %NULL on error
+ **/
+const gchar *
+gocl_device_get_vendor (GoclDevice *self)
+{
+  g_return_val_if_fail (GOCL_IS_DEVICE (self), NULL);
+
+  return get_props (self)->vendor;
+}
+
+/**
+ * gocl_device_get_device_type:
+ * @self: The #GoclDevice
+ *
+ * Obtains the type of the device.
+ *
+ * Returns: An OR'ed combination of values from #GoclDeviceType
+ **/
+guint
+gocl_device_get_device_type (GoclDevice *self)
+{
+  g_return_val_if_fail (GOCL_IS_DEVICE (self), 0);
+
+  return (guint) get_props (self)->type;
+}
+
+/**
+ * gocl_device_get_global_mem_size:
+ * @self: The #GoclDevice
+ *
+ * Obtains the size of the global memory of the device, as reported by
+ * CL_DEVICE_GLOBAL_MEM_SIZE.
+ *
+ * Returns: The global memory size, in bytes
+ **/
+guint64
+gocl_device_get_global_mem_size (GoclDevice *self)
+{
+  g_return_val_if_fail (GOCL_IS_DEVICE (self), 0);
+
+  return get_props (self)->global_mem_size;
+}
+
+/**
+ * gocl_device_get_max_mem_alloc_size:
+ * @self: The #GoclDevice
+ *
+ * Obtains the maximum size of a single memory allocation on the device, as
+ * reported by CL_DEVICE_MAX_MEM_ALLOC_SIZE.
+ *
+ * Returns: The maximum allocation size, in bytes
+ **/
+guint64
+gocl_device_get_max_mem_alloc_size (GoclDevice *self)
+{
+  g_return_val_if_fail (GOCL_IS_DEVICE (self), 0);
 
-  return (guint) max_compute_units;
+  return get_props (self)->max_mem_alloc_size;
+}
+
+/**
+ * gocl_device_get_local_mem_size:
+ * @self: The #GoclDevice
+ *
+ * Obtains the size of the local memory of the device, as reported by
+ * CL_DEVICE_LOCAL_MEM_SIZE.
+ *
+ * Returns: The local memory size, in bytes
+ **/
+guint64
+gocl_device_get_local_mem_size (GoclDevice *self)
+{
+  g_return_val_if_fail (GOCL_IS_DEVICE (self), 0);
+
+  return get_props (self)->local_mem_size;
 }
 
 /**
@@ -463,7 +861,9 @@ gocl_device_get_max_compute_units (GoclDevice *self)
  * the program execution until the operation finishes.
  *
  * This method works only if the <i>cl_khr_gl_sharing</i> OpenCL extension is
- * supported.
+ * supported. Pending GL commands using the objects must be finished before,
+ * with glFinish(), unless the device supports the <i>cl_khr_gl_event</i>
+ * extension, see gocl_device_acquire_gl_objects_with_sync().
  *
  * Upon success, %TRUE is returned, otherwise %FALSE is returned.
  *
@@ -480,6 +880,7 @@ gocl_device_acquire_gl_objects_sync (GoclDevice  *self,
                                        TRUE,
                                        object_list,
                                        event_wait_list,
+                                       NULL,
                                        &event))
     {
       return FALSE;
@@ -505,7 +906,9 @@ gocl_device_acquire_gl_objects_sync (GoclDevice  *self,
  * gocl_device_acquire_gl_objects_sync().
  *
  * This method works only if the <i>cl_khr_gl_sharing</i> OpenCL extension is
- * supported.
+ * supported. Pending GL commands using the objects must be finished before,
+ * with glFinish(), unless the device supports the <i>cl_khr_gl_event</i>
+ * extension, see gocl_device_acquire_gl_objects_with_sync().
  *
  * Returns: (transfer none): A #GoclEvent to get notified when the operation
  * finishes
@@ -525,6 +928,7 @@ gocl_device_acquire_gl_objects (GoclDevice  *self,
                                        TRUE,
                                        object_list,
                                        event_wait_list,
+                                       NULL,
                                        &event))
     {
       GError *error;
@@ -552,6 +956,79 @@ gocl_device_acquire_gl_objects (GoclDevice  *self,
   return _event;
 }
 
+/**
+ * gocl_device_acquire_gl_objects_with_sync:
+ * @self: The #GoclDevice
+ * @object_list: (element-type Gocl.Buffer) (allow-none): A #GList of
+ * #GoclBuffer objects, or %NULL
+ * @gl_sync: (allow-none): A GLsync fence object, or %NULL
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List or #GoclEvent
+ * objects to wait for, or %NULL
+ *
+ * Like gocl_device_acquire_gl_objects(), but synchronized with OpenGL on the
+ * device instead of the host. The acquisition waits for the GL fence
+ * @gl_sync, as created by glFenceSync() after the GL commands using the
+ * objects, so there is no need to stall the host with glFinish(). The fence
+ * can be deleted right after this call. If @gl_sync is %NULL, the runtime
+ * synchronizes implicitly with the GL context current in the calling thread.
+ *
+ * This method requires the <i>cl_khr_gl_event</i> extension, which can be
+ * checked with gocl_device_has_extension(); the returned event fails with
+ * CL_INVALID_OPERATION otherwise.
+ *
+ * Returns: (transfer none): A #GoclEvent to get notified when the operation
+ * finishes
+ **/
+GoclEvent *
+gocl_device_acquire_gl_objects_with_sync (GoclDevice  *self,
+                                          GList       *object_list,
+                                          gpointer     gl_sync,
+                                          GList       *event_wait_list)
+{
+  GoclEvent *_event = NULL;
+  cl_event event;
+  GoclQueue *queue;
+
+  queue = gocl_device_get_default_queue (self);
+
+  if (gl_sync == NULL &&
+      ! gocl_device_has_extension (self, "cl_khr_gl_event"))
+    {
+      gocl_error_check_opencl_internal (CL_INVALID_OPERATION);
+    }
+  else if (acquire_or_release_gl_objects (self,
+                                          TRUE,
+                                          object_list,
+                                          event_wait_list,
+                                          gl_sync,
+                                          &event))
+    {
+      _event = g_object_new (GOCL_TYPE_EVENT,
+                             "queue", queue,
+                             "event", event,
+                             NULL);
+      gocl_event_set_event_wait_list (_event, event_wait_list);
+      gocl_event_steal_resolver_func (_event);
+    }
+
+  if (_event == NULL)
+    {
+      GError *error;
+      GoclEventResolverFunc resolver_func;
+
+      error = gocl_error_get_last ();
+
+      _event = g_object_new (GOCL_TYPE_EVENT,
+                             "queue", queue,
+                             NULL);
+      resolver_func = gocl_event_steal_resolver_func (_event);
+      resolver_func (_event, error);
+      g_error_free (error);
+    }
+
+  return _event;
+}
+
 /**
  * gocl_device_release_gl_objects_sync:
  * @self: The #GoclDevice
@@ -579,6 +1056,7 @@ gocl_device_release_gl_objects_sync (GoclDevice  *self,
                                        FALSE,
                                        object_list,
                                        event_wait_list,
+                                       NULL,
                                        &event))
     {
       return FALSE;
@@ -624,6 +1102,7 @@ gocl_device_release_gl_objects (GoclDevice  *self,
                                        FALSE,
                                        object_list,
                                        event_wait_list,
+                                       NULL,
                                        &event))
     {
       GError *error;
@@ -60,11 +60,23 @@ cl_device_id           gocl_device_get_id                     (GoclDevice *self)
 gsize                  gocl_device_get_max_work_group_size    (GoclDevice  *self);
 
 GoclQueue *            gocl_device_get_default_queue          (GoclDevice  *self);
+GoclQueue *            gocl_device_add_queue                  (GoclDevice  *self,
+                                                               guint        flags);
+guint                  gocl_device_get_num_queues             (GoclDevice  *self);
+GoclQueue *            gocl_device_get_queue_by_index         (GoclDevice  *self,
+                                                               guint        index);
+GoclQueue *            gocl_device_get_copy_queue             (GoclDevice  *self);
 
 gboolean               gocl_device_has_extension              (GoclDevice   *self,
                                                                const gchar  *extension_name);
 
 guint                  gocl_device_get_max_compute_units      (GoclDevice *self);
+const gchar *          gocl_device_get_name                   (GoclDevice *self);
+const gchar *          gocl_device_get_vendor                 (GoclDevice *self);
+guint                  gocl_device_get_device_type            (GoclDevice *self);
+guint64                gocl_device_get_global_mem_size        (GoclDevice *self);
+guint64                gocl_device_get_max_mem_alloc_size     (GoclDevice *self);
+guint64                gocl_device_get_local_mem_size         (GoclDevice *self);
 
 gboolean               gocl_device_acquire_gl_objects_sync    (GoclDevice  *self,
                                                                GList       *object_list,
@@ -72,6 +84,11 @@ gboolean               gocl_device_acquire_gl_objects_sync    (GoclDevice  *self
 GoclEvent *            gocl_device_acquire_gl_objects         (GoclDevice  *self,
                                                                GList       *object_list,
                                                                GList       *event_wait_list);
+GoclEvent *            gocl_device_acquire_gl_objects_with_sync
+                                                              (GoclDevice  *self,
+                                                               GList       *object_list,
+                                                               gpointer     gl_sync,
+                                                               GList       *event_wait_list);
 gboolean               gocl_device_release_gl_objects_sync    (GoclDevice  *self,
                                                                GList       *object_list,
                                                                GList       *event_wait_list);
@@ -80,6 +97,8 @@ GoclEvent *            gocl_device_release_gl_objects         (GoclDevice  *self
                                                                GList       *event_wait_list);
 
 /* GoclQueue headers */
+GoclQueue *            gocl_queue_new                         (GoclDevice *device,
+                                                               guint       flags);
 GoclDevice *           gocl_queue_get_device                  (GoclQueue *self);
 
 G_END_DECLS
@@ -26,12 +26,44 @@
  *
  * Internal functions related to error management. This API is private, not
  * supposed to be used in applications.
+ *
+ * The error of the last Gocl operation, as returned by gocl_error_get_last(),
+ * is kept per thread, so operations issued concurrently from different
+ * threads do not overwrite each other's errors. Functions with a @error
+ * argument, like gocl_buffer_read_sync_full(), report failures there
+ * instead and leave the last error of the thread untouched.
  **/
 
 #include "gocl-error.h"
 #include "gocl-private.h"
 
-static GError *last_error = NULL;
+static void free_last_error (gpointer data);
+
+static GPrivate last_error = G_PRIVATE_INIT (free_last_error);
+
+static void
+free_last_error (gpointer data)
+{
+  GError **slot = data;
+
+  g_clear_error (slot);
+  g_free (slot);
+}
+
+static GError **
+get_last_error (gboolean create)
+{
+  GError **slot;
+
+  slot = g_private_get (&last_error);
+  if (slot == NULL && create)
+    {
+      slot = g_new0 (GError *, 1);
+      g_private_set (&last_error, slot);
+    }
+
+  return slot;
+}
 
 static const gchar *
 get_error_code_description (cl_int err_code)
@@ -120,11 +152,16 @@ gocl_error_check_opencl (cl_int err_code, GError **error)
 gboolean
 gocl_error_check_opencl_internal (cl_int err_code)
 {
-  g_clear_error (&last_error);
+  GError **slot;
+
+  /* threads that never failed need no storage at all */
+  slot = get_last_error (err_code != CL_SUCCESS);
+  if (slot != NULL)
+    g_clear_error (slot);
 
   if (err_code != CL_SUCCESS)
     {
-      g_set_error_literal (&last_error,
+      g_set_error_literal (slot,
                            GOCL_OPENCL_ERROR,
                            err_code,
                            get_error_code_description (err_code));
@@ -139,8 +176,8 @@ gocl_error_check_opencl_internal (cl_int err_code)
 /**
  * gocl_error_prepare:
  *
- * Prepares the internal Gocl error for immediate use, by freeing it if
- * non-%NULL.
+ * Prepares the internal Gocl error of the calling thread for immediate use,
+ * by freeing it if non-%NULL.
  *
  * This is a Gocl private function, not exposed to applications.
  *
@@ -149,35 +186,49 @@ gocl_error_check_opencl_internal (cl_int err_code)
 GError **
 gocl_error_prepare (void)
 {
-  g_clear_error (&last_error);
+  GError **slot;
 
-  return &last_error;
+  slot = get_last_error (TRUE);
+  g_clear_error (slot);
+
+  return slot;
 }
 
 /**
  * gocl_error_get_last:
  *
- * Retrieves the error that ocurred in the last Gocl operation, if any, or
- * %NULL if the last operation was successful.
+ * Retrieves the error that ocurred in the last Gocl operation of the calling
+ * thread, if any, or %NULL if that operation was successful.
  *
  * Returns: (transfer full): A pointer to a newly created error, or %NULL
  **/
 GError *
 gocl_error_get_last (void)
 {
-  return g_error_copy (last_error);
+  GError **slot;
+
+  slot = get_last_error (FALSE);
+  if (slot == NULL || *slot == NULL)
+    return NULL;
+
+  return g_error_copy (*slot);
 }
 
 /**
  * gocl_error_free:
  *
- * Frees the internal Gocl error if it is not %NULL. Applications should
- * not normally need to ever call this function, except before the end of
- * execution of the program, to avoid leaking memory from a potential error
- * in the last Gocl operation.
+ * Frees the internal Gocl error of the calling thread if it is not %NULL.
+ * Applications should not normally need to ever call this function, since
+ * the error is freed when the thread exits. The main thread may call it
+ * before the end of execution of the program, to avoid leaking memory from
+ * a potential error in the last Gocl operation.
  **/
 void
 gocl_error_free (void)
 {
-  gocl_error_prepare ();
+  GError **slot;
+
+  slot = get_last_error (FALSE);
+  if (slot != NULL)
+    g_clear_error (slot);
 }
@@ -40,12 +40,32 @@
  * the completion of all #GoclEvent's in the list, before starting the
  * operation in question. This pattern greatly simplifies the application
  * logic and allows for complex algorithms to be splitted in smaller,
- * synchronized routines.
+ * synchronized routines. The most frequent operations also have a variant
+ * taking the wait list as a C array, which is convenient when events are
+ * collected in a #GPtrArray; see gocl_kernel_run_in_queue_with_events().
  *
  * A #GoclEvent is always associated with a #GoclQueue, which represents
  * the command queue where the operation represented by the event was
  * originally queued. The #GoclQueue can be retrieved using
  * gocl_event_get_queue().
+ *
+ * When the queue was created with %GOCL_QUEUE_FLAGS_PROFILING, the time at
+ * which the command was queued, submitted, started and finished can be
+ * obtained after completion with gocl_event_get_profiling_info().
+ *
+ * By default, callbacks are delivered through idle sources of the
+ * application's main loop. Queues can instead deliver them directly from the
+ * thread that notices the completion, or through a #GThreadPool; see
+ * gocl_queue_set_callback_dispatch(). Code that just needs to block until
+ * commands finish can use gocl_event_wait() and gocl_event_wait_all(), which
+ * need no main loop at all.
+ *
+ * The progress of a command can also be polled with gocl_event_get_status()
+ * and gocl_event_is_complete(), which only query the OpenCL runtime and
+ * never block. Schedulers running their own #GMainContext can instead
+ * attach the #GSource returned by gocl_event_source_new(), which wakes up
+ * the context once for all the events of a set that completed since the
+ * last iteration.
  **/
 
 /**
@@ -65,6 +85,20 @@
  * Prototype of the @callback argument of gocl_event_then().
  **/
 
+/**
+ * GoclEventSourceFunc:
+ * @events: (element-type Gocl.Event): The #GoclEvent objects that
+ * completed since the previous call
+ * @user_data: The data passed to g_source_set_callback()
+ *
+ * Prototype of the callback of the #GSource returned by
+ * gocl_event_source_new(). The list and its events are only valid during
+ * the call. Whether each of them succeeded can be checked with
+ * gocl_event_get_status().
+ *
+ * Returns: %FALSE if the source should be removed, %TRUE otherwise
+ **/
+
 /**
  * GoclEventResolverFunc:
  * @self: The #GoclEvent
@@ -100,14 +134,27 @@ struct _GoclEventPrivate
   gboolean waiting_event;
 
   GList *closure_list;
-  GThread *thread;
 
   gint complete_src_id;
   gint unref_src_id;
 
   gboolean is_user_event;
 
-  GList *event_wait_list;
+  /* set before the OpenCL status becomes CL_COMPLETE, so that
+     gocl_event_get_status() can read it without the mutex */
+  gint failed;
+
+  /* events this one waits for, kept alive until it completes */
+  GoclEvent **wait_events;
+  guint num_wait_events;
+  GoclEvent *inline_wait_events[GOCL_WAIT_LIST_INLINE_LEN];
+
+  gchar *label;
+  guint64 bytes;
+
+  /* snapshot of the queue's dispatch mode, taken at construction */
+  GoclCallbackDispatch dispatch;
+  GThreadPool *pool;
 };
 
 typedef struct
@@ -118,12 +165,28 @@ typedef struct
   GoclEvent *self;
 } Closure;
 
+typedef struct
+{
+  GSource source;
+
+  GMutex mutex;
+  GQueue completed;
+} EventSource;
+
+typedef struct
+{
+  EventSource *source;
+  GoclEvent *event;
+} EventSourceEntry;
+
 /* properties */
 enum
 {
   PROP_0,
   PROP_EVENT,
-  PROP_QUEUE
+  PROP_QUEUE,
+  PROP_LABEL,
+  PROP_BYTES
 };
 
 static void           gocl_event_class_init            (GoclEventClass *class);
@@ -156,6 +219,22 @@ static void           event_on_notify                  (cl_event event,
                                                         cl_int   event_command_exec_status,
                                                         gpointer user_data);
 
+static void           dispatcher_add_event             (cl_event event);
+
+static void           clear_wait_events                (GoclEvent *self);
+
+static void           complete                         (GoclEvent *self);
+
+/* a single, process-wide thread waits for all pending events instead of
+   spawning one thread per event */
+#define DISPATCHER_MIN_INTERVAL   50   /* microseconds */
+#define DISPATCHER_MAX_INTERVAL 1000
+
+static GMutex dispatcher_mutex;
+static GCond dispatcher_cond;
+static GThread *dispatcher_thread = NULL;
+static GQueue dispatcher_queue = G_QUEUE_INIT;
+
 G_DEFINE_TYPE (GoclEvent, gocl_event, G_TYPE_OBJECT);
 
 #define GOCL_EVENT_GET_PRIVATE(obj)                \
@@ -187,6 +266,22 @@ gocl_event_class_init (GoclEventClass *class)
                                                         GOCL_TYPE_QUEUE,
                                                         G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
                                                         G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (obj_class, PROP_LABEL,
+                                   g_param_spec_string ("label",
+                                                        "Label",
+                                                        "A label identifying the command, used by queue statistics",
+                                                        NULL,
+                                                        G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
+                                                        G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (obj_class, PROP_BYTES,
+                                   g_param_spec_uint64 ("bytes",
+                                                        "Bytes",
+                                                        "The number of bytes transferred by the command",
+                                                        0,
+                                                        G_MAXUINT64,
+                                                        0,
+                                                        G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
+                                                        G_PARAM_STATIC_STRINGS));
 
   g_type_class_add_private (class, sizeof (GoclEventPrivate));
 }
@@ -209,14 +304,21 @@ gocl_event_init (GoclEvent *self)
   priv->waiting_event = FALSE;
 
   priv->closure_list = NULL;
-  priv->thread = NULL;
 
   priv->complete_src_id = 0;
   priv->unref_src_id = 0;
 
-  priv->is_user_event = TRUE;
+  priv->is_user_event = FALSE;
+  priv->failed = FALSE;
+
+  priv->wait_events = priv->inline_wait_events;
+  priv->num_wait_events = 0;
+
+  priv->label = NULL;
+  priv->bytes = 0;
 
-  priv->event_wait_list = NULL;
+  priv->dispatch = GOCL_CALLBACK_DISPATCH_MAIN_CONTEXT;
+  priv->pool = NULL;
 }
 
 static void
@@ -230,11 +332,7 @@ gocl_event_dispose (GObject *obj)
       self->priv->queue = NULL;
     }
 
-  if (self->priv->event_wait_list != NULL)
-    {
-      g_list_free_full (self->priv->event_wait_list, g_object_unref);
-      self->priv->event_wait_list = NULL;
-    }
+  clear_wait_events (self);
 
   G_OBJECT_CLASS (gocl_event_parent_class)->dispose (obj);
 }
@@ -250,9 +348,6 @@ gocl_event_finalize (GObject *obj)
   if (self->priv->error != NULL)
     g_error_free (self->priv->error);
 
-  if (self->priv->thread != NULL)
-    g_thread_unref (self->priv->thread);
-
   if (self->priv->closure_list != NULL)
     {
       /* @TODO: should we call any awaiting closure? */
@@ -261,6 +356,8 @@ gocl_event_finalize (GObject *obj)
 
   g_mutex_clear (&self->priv->mutex);
 
+  g_free (self->priv->label);
+
   if (self->priv->complete_src_id != 0)
     {
       g_source_remove (self->priv->complete_src_id);
@@ -276,6 +373,17 @@ gocl_event_constructed (GObject *obj)
   GoclEvent *self = GOCL_EVENT (obj);
   cl_int err_code;
 
+  if (self->priv->queue != NULL)
+    {
+      self->priv->dispatch =
+        gocl_queue_get_callback_dispatch (self->priv->queue,
+                                          &self->priv->pool);
+
+      if (self->priv->dispatch == GOCL_CALLBACK_DISPATCH_THREAD_POOL &&
+          self->priv->pool == NULL)
+        self->priv->dispatch = GOCL_CALLBACK_DISPATCH_COMPLETION_THREAD;
+    }
+
   if (self->priv->event == NULL)
     {
       GoclDevice *device;
@@ -316,6 +424,14 @@ set_property (GObject      *obj,
       self->priv->queue = g_value_dup_object (value);
       break;
 
+    case PROP_LABEL:
+      self->priv->label = g_value_dup_string (value);
+      break;
+
+    case PROP_BYTES:
+      self->priv->bytes = g_value_get_uint64 (value);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
       break;
@@ -340,6 +456,14 @@ get_property (GObject    *obj,
       g_value_set_object (value, self->priv->queue);
       break;
 
+    case PROP_LABEL:
+      g_value_set_string (value, self->priv->label);
+      break;
+
+    case PROP_BYTES:
+      g_value_set_uint64 (value, self->priv->bytes);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
       break;
@@ -401,43 +525,73 @@ notify_event_completed_in_caller_context (gpointer user_data)
   return FALSE;
 }
 
-static gboolean
-event_completed (gpointer user_data)
+static void
+dispatch_closure (GoclEvent *self, Closure *closure)
 {
-  GoclEvent *self = GOCL_EVENT (user_data);
-
-  g_mutex_lock (&self->priv->mutex);
-
-  self->priv->complete_src_id = 0;
-
-  self->priv->already_resolved = TRUE;
-  self->priv->waiting_event = FALSE;
-
-  GList *node = self->priv->closure_list;
-  while (node != NULL)
+  switch (self->priv->dispatch)
     {
-      Closure *closure = node->data;
+    case GOCL_CALLBACK_DISPATCH_COMPLETION_THREAD:
+      notify_event_completed_in_caller_context (closure);
+      break;
+
+    case GOCL_CALLBACK_DISPATCH_THREAD_POOL:
+      g_thread_pool_push (self->priv->pool, closure, NULL);
+      break;
 
+    default:
       timeout_add (closure->context,
                    0,
                    G_PRIORITY_DEFAULT,
                    notify_event_completed_in_caller_context,
                    closure);
-
-      node = g_list_next (node);
+      break;
     }
+}
 
-  g_list_free (self->priv->closure_list);
-  self->priv->closure_list = NULL;
+/* must be called without the mutex held, since callbacks may run right away.
+   Completion can be signaled more than once for user events, so only the
+   first call does anything */
+static void
+complete (GoclEvent *self)
+{
+  GList *closure_list;
+  GList *node;
+
+  g_mutex_lock (&self->priv->mutex);
 
-  if (self->priv->event_wait_list != NULL)
+  if (self->priv->already_resolved)
     {
-      g_list_free_full (self->priv->event_wait_list, g_object_unref);
-      self->priv->event_wait_list = NULL;
+      g_mutex_unlock (&self->priv->mutex);
+      return;
     }
 
+  self->priv->already_resolved = TRUE;
+  self->priv->waiting_event = FALSE;
+
+  closure_list = self->priv->closure_list;
+  self->priv->closure_list = NULL;
+
+  clear_wait_events (self);
+
   g_mutex_unlock (&self->priv->mutex);
 
+  for (node = closure_list; node != NULL; node = g_list_next (node))
+    dispatch_closure (self, node->data);
+
+  g_list_free (closure_list);
+}
+
+static gboolean
+event_completed (gpointer user_data)
+{
+  GoclEvent *self = GOCL_EVENT (user_data);
+
+  g_mutex_lock (&self->priv->mutex);
+  self->priv->complete_src_id = 0;
+  g_mutex_unlock (&self->priv->mutex);
+
+  complete (self);
+
   return FALSE;
 }
 
@@ -452,14 +606,26 @@ event_on_notify (cl_event event,
   g_mutex_lock (&self->priv->mutex);
 
   if (gocl_error_check_opencl (event_command_exec_status, &error))
-    self->priv->error = error;
-
-  self->priv->complete_src_id = timeout_add (self->priv->context,
-                                             0,
-                                             G_PRIORITY_DEFAULT,
-                                             event_completed,
-                                             self);
+    {
+      self->priv->error = error;
+      g_atomic_int_set (&self->priv->failed, TRUE);
+    }
+  else if (! self->priv->is_user_event && self->priv->queue != NULL)
+    gocl_queue_record_command (self->priv->queue,
+                               event,
+                               self->priv->label,
+                               self->priv->bytes);
+
+  if (self->priv->dispatch == GOCL_CALLBACK_DISPATCH_MAIN_CONTEXT)
+    self->priv->complete_src_id = timeout_add (self->priv->context,
+                                               0,
+                                               G_PRIORITY_DEFAULT,
+                                               event_completed,
+                                               self);
   g_mutex_unlock (&self->priv->mutex);
+
+  if (self->priv->dispatch != GOCL_CALLBACK_DISPATCH_MAIN_CONTEXT)
+    complete (self);
 }
 
 static void
@@ -471,13 +637,17 @@ gocl_event_resolve (GoclEvent *self, GError *error)
   g_mutex_lock (&self->priv->mutex);
 
   if (error != NULL)
-    self->priv->error = g_error_copy (error);
+    {
+      self->priv->error = g_error_copy (error);
+      g_atomic_int_set (&self->priv->failed, TRUE);
+    }
 
-  self->priv->complete_src_id = timeout_add (self->priv->context,
-                                             0,
-                                             G_PRIORITY_DEFAULT,
-                                             event_completed,
-                                             self);
+  if (self->priv->dispatch == GOCL_CALLBACK_DISPATCH_MAIN_CONTEXT)
+    self->priv->complete_src_id = timeout_add (self->priv->context,
+                                               0,
+                                               G_PRIORITY_DEFAULT,
+                                               event_completed,
+                                               self);
 
   g_mutex_unlock (&self->priv->mutex);
 
@@ -489,26 +659,125 @@ gocl_event_resolve (GoclEvent *self, GError *error)
       err_code = clSetUserEventStatus (self->priv->event, CL_COMPLETE);
       if (gocl_error_check_opencl (err_code, &cl_error))
         {
-          g_warning ("Error resolving OpenCL user event: %s\n", error->message);
-          g_error_free (error);
+          g_warning ("Error resolving OpenCL user event: %s\n",
+                     cl_error->message);
+          g_error_free (cl_error);
         }
     }
+
+  /* the user event's own callback may also get here first, or not at all on
+     platforms that need someone waiting on the event */
+  if (self->priv->dispatch != GOCL_CALLBACK_DISPATCH_MAIN_CONTEXT)
+    complete (self);
 }
 
-/* calling clWaitForEvents from a thread is oddly necessary because otherwise
-   the event callback doesn't trigger in AMD APP SDK platform */
+/* someone has to keep waiting on events, since otherwise the event callback
+   doesn't trigger in AMD APP SDK platform. Blocking on one event at a time
+   would stall every event queued after it, possibly from other queues, so
+   the whole set is polled instead, backing off while nothing completes */
 static gpointer
-wait_event_thread_func (gpointer user_data)
+dispatcher_thread_func (gpointer user_data)
 {
-  GoclEvent *self = GOCL_EVENT (user_data);
+  GPtrArray *pending;
+  gint64 interval = DISPATCHER_MIN_INTERVAL;
+  guint i;
+
+  pending = g_ptr_array_new ();
+
+  while (TRUE)
+    {
+      gboolean progress = FALSE;
+
+      g_mutex_lock (&dispatcher_mutex);
 
-  g_assert (self->priv->event != NULL);
+      if (pending->len == 0)
+        {
+          while (g_queue_is_empty (&dispatcher_queue))
+            g_cond_wait (&dispatcher_cond, &dispatcher_mutex);
+        }
+      else if (g_queue_is_empty (&dispatcher_queue))
+        {
+          g_cond_wait_until (&dispatcher_cond,
+                             &dispatcher_mutex,
+                             g_get_monotonic_time () + interval);
+        }
+
+      if (! g_queue_is_empty (&dispatcher_queue))
+        progress = TRUE;
+
+      while (! g_queue_is_empty (&dispatcher_queue))
+        g_ptr_array_add (pending, g_queue_pop_head (&dispatcher_queue));
+
+      g_mutex_unlock (&dispatcher_mutex);
+
+      i = 0;
+      while (i < pending->len)
+        {
+          cl_event event = g_ptr_array_index (pending, i);
+          cl_int status;
+          cl_int err_code;
+
+          err_code = clGetEventInfo (event,
+                                     CL_EVENT_COMMAND_EXECUTION_STATUS,
+                                     sizeof (cl_int),
+                                     &status,
+                                     NULL);
+          if (err_code != CL_SUCCESS || status <= CL_COMPLETE)
+            {
+              clReleaseEvent (event);
+              g_ptr_array_remove_index_fast (pending, i);
+              progress = TRUE;
+            }
+          else
+            {
+              i++;
+            }
+        }
+
+      if (progress)
+        interval = DISPATCHER_MIN_INTERVAL;
+      else
+        interval = MIN (interval * 2, DISPATCHER_MAX_INTERVAL);
+    }
 
-  clWaitForEvents (1, &self->priv->event);
+  g_ptr_array_unref (pending);
 
   return NULL;
 }
 
+/* user events must not be added, their callback triggers as soon as their
+   status is set */
+static void
+dispatcher_add_event (cl_event event)
+{
+  cl_command_queue queue = NULL;
+
+  clRetainEvent (event);
+
+  /* the command must reach the device for polling to ever see it
+     complete, as clWaitForEvents() used to guarantee */
+  if (clGetEventInfo (event,
+                      CL_EVENT_COMMAND_QUEUE,
+                      sizeof (cl_command_queue),
+                      &queue,
+                      NULL) == CL_SUCCESS && queue != NULL)
+    {
+      clFlush (queue);
+    }
+
+  g_mutex_lock (&dispatcher_mutex);
+
+  if (dispatcher_thread == NULL)
+    dispatcher_thread = g_thread_new ("gocl-event-dispatcher",
+                                      dispatcher_thread_func,
+                                      NULL);
+
+  g_queue_push_tail (&dispatcher_queue, event);
+  g_cond_signal (&dispatcher_cond);
+
+  g_mutex_unlock (&dispatcher_mutex);
+}
+
 static gboolean
 unref_in_idle (gpointer user_data)
 {
@@ -519,6 +788,312 @@ unref_in_idle (gpointer user_data)
   return FALSE;
 }
 
+static gboolean
+event_source_dispatch (GSource     *source,
+                       GSourceFunc  callback,
+                       gpointer     user_data)
+{
+  EventSource *self = (EventSource *) source;
+  GList *events;
+  gboolean result;
+
+  g_mutex_lock (&self->mutex);
+
+  events = self->completed.head;
+  g_queue_init (&self->completed);
+  g_source_set_ready_time (source, -1);
+
+  g_mutex_unlock (&self->mutex);
+
+  if (callback == NULL)
+    {
+      g_warning ("GoclEvent source dispatched without callback. "
+                 "You must call g_source_set_callback().");
+      result = FALSE;
+    }
+  else
+    {
+      result = ((GoclEventSourceFunc) callback) (events, user_data);
+    }
+
+  g_list_free_full (events, g_object_unref);
+
+  return result;
+}
+
+static void
+event_source_finalize (GSource *source)
+{
+  EventSource *self = (EventSource *) source;
+  GoclEvent *event;
+
+  while ((event = g_queue_pop_head (&self->completed)) != NULL)
+    g_object_unref (event);
+
+  g_mutex_clear (&self->mutex);
+}
+
+static GSourceFuncs event_source_funcs =
+  {
+    NULL,
+    NULL,
+    event_source_dispatch,
+    event_source_finalize
+  };
+
+/* called with the source mutex held. Many completions before the next
+   iteration of the context cost a single wakeup */
+static void
+event_source_push_completed (EventSource *self, GoclEvent *event)
+{
+  g_queue_push_tail (&self->completed, event);
+  g_source_set_ready_time ((GSource *) self, 0);
+}
+
+static void
+event_source_on_notify (cl_event event,
+                        cl_int   event_command_exec_status,
+                        gpointer user_data)
+{
+  EventSourceEntry *entry = user_data;
+
+  g_mutex_lock (&entry->source->mutex);
+  event_source_push_completed (entry->source, entry->event);
+  g_mutex_unlock (&entry->source->mutex);
+
+  g_source_unref ((GSource *) entry->source);
+  g_slice_free (EventSourceEntry, entry);
+}
+
+static void
+clear_wait_events (GoclEvent *self)
+{
+  guint i;
+
+  for (i = 0; i < self->priv->num_wait_events; i++)
+    g_object_unref (self->priv->wait_events[i]);
+
+  if (self->priv->wait_events != self->priv->inline_wait_events)
+    g_free (self->priv->wait_events);
+
+  self->priv->wait_events = self->priv->inline_wait_events;
+  self->priv->num_wait_events = 0;
+}
+
+static void
+set_wait_events (GoclEvent  *self,
+                 GoclEvent **events,
+                 guint       len)
+{
+  guint i;
+
+  /* take the new references before dropping the old ones, since both may
+     hold the same events */
+  for (i = 0; i < len; i++)
+    g_object_ref (events[i]);
+
+  clear_wait_events (self);
+
+  if (len > GOCL_WAIT_LIST_INLINE_LEN)
+    self->priv->wait_events = g_new (GoclEvent *, len);
+
+  memcpy (self->priv->wait_events, events, sizeof (GoclEvent *) * len);
+  self->priv->num_wait_events = len;
+}
+
+static gboolean
+wait_for_events (const GoclWaitList *wait_list)
+{
+  cl_int err_code;
+  guint i;
+
+  if (wait_list->len == 0)
+    return ! gocl_error_check_opencl_internal (CL_SUCCESS);
+
+  err_code = clWaitForEvents (wait_list->len, wait_list->cl_events);
+
+  /* report the status of the command that actually failed */
+  if (err_code == CL_EXEC_STATUS_ERROR_FOR_EVENTS_IN_WAIT_LIST)
+    {
+      for (i = 0; i < wait_list->len; i++)
+        {
+          cl_int status;
+
+          if (clGetEventInfo (wait_list->cl_events[i],
+                              CL_EVENT_COMMAND_EXECUTION_STATUS,
+                              sizeof (cl_int),
+                              &status,
+                              NULL) == CL_SUCCESS && status < 0)
+            {
+              err_code = status;
+              break;
+            }
+        }
+    }
+
+  if (gocl_error_check_opencl_internal (err_code))
+    return FALSE;
+
+  /* user events always complete successfully at the OpenCL level, the
+     error they were resolved with is kept by the event itself */
+  for (i = 0; i < wait_list->len; i++)
+    {
+      GoclEvent *event = wait_list->events[i];
+      gboolean failed = FALSE;
+
+      if (! event->priv->is_user_event)
+        continue;
+
+      g_mutex_lock (&event->priv->mutex);
+      if (event->priv->error != NULL)
+        {
+          g_propagate_error (gocl_error_prepare (),
+                             g_error_copy (event->priv->error));
+          failed = TRUE;
+        }
+      g_mutex_unlock (&event->priv->mutex);
+
+      if (failed)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+wait_list_alloc (GoclWaitList *wait_list, guint len)
+{
+  wait_list->len = len;
+
+  /* OpenCL wants no array at all for an empty wait list */
+  if (len == 0)
+    {
+      wait_list->events = wait_list->inline_events;
+      wait_list->cl_events = NULL;
+    }
+  else if (len <= GOCL_WAIT_LIST_INLINE_LEN)
+    {
+      wait_list->events = wait_list->inline_events;
+      wait_list->cl_events = wait_list->inline_cl_events;
+    }
+  else
+    {
+      wait_list->events = g_new (GoclEvent *, len);
+      wait_list->cl_events = g_new (cl_event, len);
+    }
+}
+
+/* internal */
+
+void
+gocl_wait_list_init (GoclWaitList *wait_list,
+                     GoclEvent   **events,
+                     guint         len)
+{
+  guint i;
+
+  wait_list_alloc (wait_list, len);
+
+  for (i = 0; i < len; i++)
+    {
+      wait_list->events[i] = events[i];
+      wait_list->cl_events[i] = events[i]->priv->event;
+    }
+}
+
+void
+gocl_wait_list_init_from_list (GoclWaitList *wait_list, GList *event_list)
+{
+  GList *node;
+  guint i;
+
+  wait_list_alloc (wait_list, g_list_length (event_list));
+
+  for (node = event_list, i = 0; node != NULL; node = node->next, i++)
+    {
+      GoclEvent *event = node->data;
+
+      wait_list->events[i] = event;
+      wait_list->cl_events[i] = event->priv->event;
+    }
+}
+
+void
+gocl_wait_list_clear (GoclWaitList *wait_list)
+{
+  if (wait_list->events != wait_list->inline_events)
+    {
+      g_free (wait_list->events);
+      g_free (wait_list->cl_events);
+    }
+
+  wait_list->events = wait_list->inline_events;
+  wait_list->cl_events = NULL;
+  wait_list->len = 0;
+}
+
+void
+gocl_event_set_wait_list (GoclEvent *self, const GoclWaitList *wait_list)
+{
+  set_wait_events (self, wait_list->events, wait_list->len);
+}
+
+void
+gocl_event_dispatcher_add_event (cl_event event)
+{
+  dispatcher_add_event (event);
+}
+
+/* wraps a command just enqueued, adopting @event, or failed with @err_code.
+   With no @event and no error, nothing was enqueued and the returned event
+   is already resolved */
+GoclEvent *
+gocl_event_new_for_command (GoclQueue   *queue,
+                            cl_int       err_code,
+                            cl_event     event,
+                            GList       *event_wait_list,
+                            const gchar *label,
+                            guint64      bytes)
+{
+  GError *error = NULL;
+  GoclEvent *_event;
+  GoclEventResolverFunc resolver_func;
+
+  if (gocl_error_check_opencl (err_code, &error))
+    {
+      _event = g_object_new (GOCL_TYPE_EVENT,
+                             "queue", queue,
+                             NULL);
+      resolver_func = gocl_event_steal_resolver_func (_event);
+      resolver_func (_event, error);
+      g_error_free (error);
+    }
+  else if (event == NULL)
+    {
+      _event = g_object_new (GOCL_TYPE_EVENT,
+                             "queue", queue,
+                             "label", label,
+                             NULL);
+      resolver_func = gocl_event_steal_resolver_func (_event);
+      resolver_func (_event, NULL);
+    }
+  else
+    {
+      _event = g_object_new (GOCL_TYPE_EVENT,
+                             "queue", queue,
+                             "event", event,
+                             "label", label,
+                             "bytes", bytes,
+                             NULL);
+      gocl_event_set_event_wait_list (_event, event_wait_list);
+      gocl_event_steal_resolver_func (_event);
+    }
+
+  gocl_event_idle_unref (_event);
+
+  return _event;
+}
+
 /* public */
 
 /**
@@ -594,6 +1169,14 @@ gocl_event_steal_resolver_func (GoclEvent *self)
  *
  * If the event already triggered when this method is called, the notification
  * is immediately scheduled as an idle call.
+ *
+ * How @callback is invoked depends on the dispatch mode of the event's
+ * #GoclQueue at the time the event was created; see
+ * gocl_queue_set_callback_dispatch(). With
+ * %GOCL_CALLBACK_DISPATCH_COMPLETION_THREAD, @callback may run from an
+ * OpenCL runtime thread, and must not block nor call blocking functions like
+ * gocl_event_wait(). If the event already triggered, it is then called
+ * before this method returns.
  **/
 void
 gocl_event_then (GoclEvent         *self,
@@ -601,6 +1184,7 @@ gocl_event_then (GoclEvent         *self,
                  gpointer           user_data)
 {
   Closure *closure;
+  gboolean resolved;
 
   g_return_if_fail (GOCL_IS_EVENT (self));
   g_return_if_fail (callback != NULL);
@@ -613,15 +1197,8 @@ gocl_event_then (GoclEvent         *self,
 
   g_mutex_lock (&self->priv->mutex);
 
-  if (self->priv->already_resolved)
-    {
-      timeout_add (closure->context,
-                   0,
-                   G_PRIORITY_DEFAULT,
-                   notify_event_completed_in_caller_context,
-                   closure);
-    }
-  else
+  resolved = self->priv->already_resolved;
+  if (! resolved)
     {
       self->priv->closure_list = g_list_append (self->priv->closure_list,
                                                 closure);
@@ -629,13 +1206,15 @@ gocl_event_then (GoclEvent         *self,
       if (self->priv->event != NULL && ! self->priv->waiting_event)
         {
           self->priv->waiting_event = TRUE;
-          self->priv->thread = g_thread_new ("gocl-event-thread",
-                                             wait_event_thread_func,
-                                             self);
+          if (! self->priv->is_user_event)
+            dispatcher_add_event (self->priv->event);
         }
     }
 
   g_mutex_unlock (&self->priv->mutex);
+
+  if (resolved)
+    dispatch_closure (self, closure);
 }
 
 /**
@@ -644,9 +1223,9 @@ gocl_event_then (GoclEvent         *self,
  * @event_list: (element-type Gocl.Event) (allow-none): List of #GoclEvent
  * events that this event should wait for, or %NULL
  *
- * Stores a copy of the given #GList of #GoclEvent's to take ownership over the
- * list and guarantee that the events will remain alive until this event is
- * destroyed.
+ * Keeps a reference to each #GoclEvent in @event_list, to guarantee that the
+ * events will remain alive until this event is destroyed. The list itself is
+ * not retained, and lists of up to four events need no extra memory.
  *
  * This is a rather low-level method and should not normally be called by
  * applications.
@@ -654,24 +1233,13 @@ gocl_event_then (GoclEvent         *self,
 void
 gocl_event_set_event_wait_list (GoclEvent *self, GList *event_list)
 {
-  GList *new_list = NULL;
+  GoclWaitList wait_list;
 
   g_return_if_fail (GOCL_IS_EVENT (self));
 
-  if (self->priv->event_wait_list != NULL)
-    g_list_free_full (self->priv->event_wait_list, g_object_unref);
-
-  while (event_list != NULL)
-    {
-      g_return_if_fail (GOCL_IS_EVENT (event_list->data));
-
-      new_list = g_list_prepend (new_list,
-                                 g_object_ref (G_OBJECT (event_list->data)));
-
-      event_list = event_list->next;
-    }
-
-  self->priv->event_wait_list = new_list;
+  gocl_wait_list_init_from_list (&wait_list, event_list);
+  set_wait_events (self, wait_list.events, wait_list.len);
+  gocl_wait_list_clear (&wait_list);
 }
 
 /**
@@ -704,7 +1272,7 @@ gocl_event_list_to_array (GList *event_list, guint *len)
   if (_len == 0)
     return event_arr;
 
-  event_arr = g_new (cl_event, g_list_length (event_list));
+  event_arr = g_new (cl_event, _len);
 
   node = event_list;
   i = 0;
@@ -743,3 +1311,298 @@ gocl_event_idle_unref (GoclEvent *self)
                                           unref_in_idle,
                                           self);
 }
+
+/**
+ * gocl_event_wait:
+ * @self: The #GoclEvent
+ *
+ * Blocks the calling thread until the operation represented by this event
+ * completes. This does not depend on any main loop, so it can be used from
+ * worker threads. The callbacks added with gocl_event_then() are not
+ * necessarily invoked by the time this method returns.
+ *
+ * Returns: %TRUE if the operation completed successfully, %FALSE on error
+ **/
+gboolean
+gocl_event_wait (GoclEvent *self)
+{
+  GoclWaitList wait_list;
+  gboolean result;
+
+  g_return_val_if_fail (GOCL_IS_EVENT (self), FALSE);
+
+  gocl_wait_list_init (&wait_list, &self, 1);
+  result = wait_for_events (&wait_list);
+  gocl_wait_list_clear (&wait_list);
+
+  return result;
+}
+
+/**
+ * gocl_event_wait_all:
+ * @event_list: (element-type Gocl.Event) (allow-none): List of #GoclEvent
+ * events to wait for, or %NULL
+ *
+ * Blocks the calling thread until all the operations represented by the
+ * events in @event_list complete. All events are waited for in a single
+ * call to the OpenCL runtime, which is cheaper than calling
+ * gocl_event_wait() on each of them. See gocl_event_wait() for details.
+ *
+ * Returns: %TRUE if all operations completed successfully, %FALSE on error
+ **/
+gboolean
+gocl_event_wait_all (GList *event_list)
+{
+  GoclWaitList wait_list;
+  gboolean result;
+
+  gocl_wait_list_init_from_list (&wait_list, event_list);
+  result = wait_for_events (&wait_list);
+  gocl_wait_list_clear (&wait_list);
+
+  return result;
+}
+
+/**
+ * gocl_event_dispatch_func: (skip)
+ * @data: Data pushed to the pool by Gocl
+ * @user_data: The user data of the pool, ignored
+ *
+ * The #GFunc to create a #GThreadPool with, for use with
+ * %GOCL_CALLBACK_DISPATCH_THREAD_POOL. For example:
+ *
+ * |[
+ * pool = g_thread_pool_new (gocl_event_dispatch_func, NULL, 4, FALSE, NULL);
+ * gocl_queue_set_callback_dispatch (queue,
+ *                                   GOCL_CALLBACK_DISPATCH_THREAD_POOL,
+ *                                   pool);
+ * ]|
+ **/
+void
+gocl_event_dispatch_func (gpointer data, gpointer user_data)
+{
+  notify_event_completed_in_caller_context (data);
+}
+
+/**
+ * gocl_event_get_status:
+ * @self: The #GoclEvent
+ *
+ * Retrieves the current execution status of the command represented by
+ * this event. This only queries the OpenCL runtime and never blocks, so it
+ * is cheap enough to be called from a polling loop. A status of
+ * %GOCL_EVENT_STATUS_COMPLETE or %GOCL_EVENT_STATUS_ERROR may be observed
+ * before the callbacks added with gocl_event_then() are invoked.
+ *
+ * Returns: A value from #GoclEventStatus
+ **/
+GoclEventStatus
+gocl_event_get_status (GoclEvent *self)
+{
+  cl_int status;
+  cl_int err_code;
+
+  g_return_val_if_fail (GOCL_IS_EVENT (self), GOCL_EVENT_STATUS_ERROR);
+
+  /* the command failed to be created. Polling leaves the last error of the
+     thread alone, so that it still describes that failure */
+  if (self->priv->event == NULL)
+    return GOCL_EVENT_STATUS_ERROR;
+
+  err_code = clGetEventInfo (self->priv->event,
+                             CL_EVENT_COMMAND_EXECUTION_STATUS,
+                             sizeof (cl_int),
+                             &status,
+                             NULL);
+  if (err_code != CL_SUCCESS || status < 0)
+    return GOCL_EVENT_STATUS_ERROR;
+
+  /* user events complete successfully at the OpenCL level even when
+     resolved with an error */
+  if (status == CL_COMPLETE && g_atomic_int_get (&self->priv->failed))
+    return GOCL_EVENT_STATUS_ERROR;
+
+  return status;
+}
+
+/**
+ * gocl_event_is_complete:
+ * @self: The #GoclEvent
+ *
+ * Checks whether the command represented by this event has finished,
+ * either successfully or with an error. Use gocl_event_get_status() to tell
+ * both cases apart. This method never blocks.
+ *
+ * Returns: %TRUE if the command finished, %FALSE otherwise
+ **/
+gboolean
+gocl_event_is_complete (GoclEvent *self)
+{
+  GoclEventStatus status;
+
+  g_return_val_if_fail (GOCL_IS_EVENT (self), FALSE);
+
+  status = gocl_event_get_status (self);
+
+  return status == GOCL_EVENT_STATUS_COMPLETE ||
+    status == GOCL_EVENT_STATUS_ERROR;
+}
+
+/**
+ * gocl_event_source_new:
+ * @event_list: (element-type Gocl.Event) (allow-none): List of #GoclEvent
+ * objects to watch, or %NULL
+ *
+ * Creates a #GSource that dispatches when events of the set it watches
+ * complete. Its callback has the #GoclEventSourceFunc signature, and
+ * receives all the events that completed since the previous dispatch, so a
+ * burst of completions wakes up the #GMainContext only once. Each event is
+ * reported exactly once. More events can be added later with
+ * gocl_event_source_add_event().
+ *
+ * The source does not remove itself when all its events have completed;
+ * its callback should return %FALSE when it is no longer needed. Set the
+ * callback with g_source_set_callback(), casting it to #GSourceFunc, and
+ * attach the source with g_source_attach().
+ *
+ * Returns: (transfer full): A newly created #GSource. Free with
+ * g_source_unref().
+ **/
+GSource *
+gocl_event_source_new (GList *event_list)
+{
+  GSource *source;
+  EventSource *self;
+  GList *node;
+
+  source = g_source_new (&event_source_funcs, sizeof (EventSource));
+  g_source_set_name (source, "GoclEventSource");
+
+  self = (EventSource *) source;
+  g_mutex_init (&self->mutex);
+  g_queue_init (&self->completed);
+
+  for (node = event_list; node != NULL; node = g_list_next (node))
+    gocl_event_source_add_event (source, GOCL_EVENT (node->data));
+
+  return source;
+}
+
+/**
+ * gocl_event_source_add_event:
+ * @source: A #GSource created with gocl_event_source_new()
+ * @event: The #GoclEvent to watch
+ *
+ * Adds @event to the set watched by @source. If @event already completed,
+ * it is reported in the next dispatch of @source. This method can be called
+ * from any thread.
+ **/
+void
+gocl_event_source_add_event (GSource *source, GoclEvent *event)
+{
+  EventSource *self = (EventSource *) source;
+  EventSourceEntry *entry;
+  cl_int err_code;
+
+  g_return_if_fail (source != NULL);
+  g_return_if_fail (source->source_funcs == &event_source_funcs);
+  g_return_if_fail (GOCL_IS_EVENT (event));
+
+  if (event->priv->event == NULL)
+    {
+      g_mutex_lock (&self->mutex);
+      event_source_push_completed (self, g_object_ref (event));
+      g_mutex_unlock (&self->mutex);
+      return;
+    }
+
+  /* the entry keeps the source alive until the runtime calls back */
+  entry = g_slice_new (EventSourceEntry);
+  entry->source = (EventSource *) g_source_ref (source);
+  entry->event = g_object_ref (event);
+
+  err_code = clSetEventCallback (event->priv->event,
+                                 CL_COMPLETE,
+                                 event_source_on_notify,
+                                 entry);
+  if (gocl_error_check_opencl_internal (err_code))
+    {
+      g_mutex_lock (&self->mutex);
+      event_source_push_completed (self, entry->event);
+      g_mutex_unlock (&self->mutex);
+
+      g_source_unref (source);
+      g_slice_free (EventSourceEntry, entry);
+      return;
+    }
+
+  /* some platforms only call back while someone waits on the event */
+  if (! event->priv->is_user_event)
+    dispatcher_add_event (event->priv->event);
+}
+
+/**
+ * gocl_event_get_profiling_info:
+ * @self: The #GoclEvent
+ * @queued: (out) (allow-none): Return location for the time the command was
+ * enqueued, or %NULL
+ * @submit: (out) (allow-none): Return location for the time the command was
+ * submitted to the device, or %NULL
+ * @start: (out) (allow-none): Return location for the time the command started
+ * executing, or %NULL
+ * @end: (out) (allow-none): Return location for the time the command finished
+ * executing, or %NULL
+ *
+ * Retrieves the profiling timestamps of the command represented by this
+ * event, in nanoseconds of the device's clock. This is only available once
+ * the event has triggered, and if the command was enqueued in a #GoclQueue
+ * created with %GOCL_QUEUE_FLAGS_PROFILING. Otherwise, %FALSE is returned.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_event_get_profiling_info (GoclEvent *self,
+                               guint64   *queued,
+                               guint64   *submit,
+                               guint64   *start,
+                               guint64   *end)
+{
+  cl_profiling_info params[4] = {
+    CL_PROFILING_COMMAND_QUEUED,
+    CL_PROFILING_COMMAND_SUBMIT,
+    CL_PROFILING_COMMAND_START,
+    CL_PROFILING_COMMAND_END
+  };
+  guint64 *values[4];
+  cl_int err_code = CL_SUCCESS;
+  guint i;
+
+  g_return_val_if_fail (GOCL_IS_EVENT (self), FALSE);
+
+  /* user events are never profiled */
+  if (self->priv->is_user_event)
+    return ! gocl_error_check_opencl_internal (CL_PROFILING_INFO_NOT_AVAILABLE);
+
+  values[0] = queued;
+  values[1] = submit;
+  values[2] = start;
+  values[3] = end;
+
+  for (i = 0; i < 4 && err_code == CL_SUCCESS; i++)
+    {
+      cl_ulong value;
+
+      if (values[i] == NULL)
+        continue;
+
+      err_code = clGetEventProfilingInfo (self->priv->event,
+                                          params[i],
+                                          sizeof (cl_ulong),
+                                          &value,
+                                          NULL);
+      if (err_code == CL_SUCCESS)
+        *values[i] = value;
+    }
+
+  return ! gocl_error_check_opencl_internal (err_code);
+}
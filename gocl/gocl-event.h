@@ -46,6 +46,11 @@ typedef void (* GoclEventCallback)     (GoclEvent *self,
                                         GError    *error,
                                         gpointer   user_data);
 
+typedef void (* GoclHostFunc)          (gpointer user_data);
+
+typedef gboolean (* GoclEventSourceFunc) (GList    *events,
+                                          gpointer  user_data);
+
 struct _GoclEvent
 {
   GObject parent_instance;
@@ -68,6 +73,15 @@ void                   gocl_event_then                       (GoclEvent
                                                               GoclEventCallback  callback,
                                                               gpointer           user_data);
 
+GoclEventStatus        gocl_event_get_status                 (GoclEvent *self);
+gboolean               gocl_event_is_complete                (GoclEvent *self);
+
+gboolean               gocl_event_get_profiling_info         (GoclEvent *self,
+                                                              guint64   *queued,
+                                                              guint64   *submit,
+                                                              guint64   *start,
+                                                              guint64   *end);
+
 /* these methods should eventually be moved to a private header file,
    since they are not supposed to be called by applications */
 void                   gocl_event_set_event_wait_list        (GoclEvent *self,
@@ -77,6 +91,23 @@ cl_event *             gocl_event_list_to_array              (GList *event_list,
 
 void                   gocl_event_idle_unref                 (GoclEvent *self);
 
+gboolean               gocl_event_wait                       (GoclEvent *self);
+gboolean               gocl_event_wait_all                   (GList *event_list);
+
+void                   gocl_event_dispatch_func              (gpointer data,
+                                                              gpointer user_data);
+
+GSource *              gocl_event_source_new                 (GList *event_list);
+void                   gocl_event_source_add_event           (GSource   *source,
+                                                              GoclEvent *event);
+
+/* GoclQueue headers */
+GoclEvent *            gocl_queue_enqueue_host_func          (GoclQueue      *self,
+                                                              GoclHostFunc    func,
+                                                              gpointer        user_data,
+                                                              GDestroyNotify  destroy,
+                                                              GList          *event_wait_list);
+
 G_END_DECLS
 
 #endif /* __GOCL_EVENT_H__ */
@@ -0,0 +1,876 @@
+/*
+ * gocl-graph.c
+ *
+ * Gocl - GLib/GObject wrapper for OpenCL
+ * Copyright (C) 2012-2013 Igalia S.L.
+ *
+ * Authors:
+ *  Eduardo Lima Mitev <elima@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License at http://www.gnu.org/licenses/lgpl-3.0.txt
+ * for more details.
+ */
+
+/**
+ * SECTION:gocl-graph
+ * @short_description: Object that schedules a graph of dependent commands
+ * @stability: Unstable
+ *
+ * A #GoclGraph holds a set of commands, its nodes, and enqueues all of them
+ * with gocl_graph_submit() or gocl_graph_submit_sync(). Unlike a
+ * #GoclCommandList, whose commands run one after another in a single queue,
+ * nodes of a graph can be spread across several queues, even of different
+ * devices, and only wait for the nodes they actually depend on.
+ *
+ * Nodes are buffer writes, buffer reads and kernel executions, added with
+ * gocl_graph_add_write(), gocl_graph_add_read(), gocl_graph_add_kernel() and
+ * gocl_graph_add_launch(). Each function returns the index of the new node.
+ * Dependencies are not given explicitly, but derived from the buffers each
+ * node uses. Transfers use their buffer implicitly, and the buffers a kernel
+ * reads and writes are declared with gocl_graph_add_input() and
+ * gocl_graph_add_output(). A node then depends on the previous node that
+ * wrote each of its inputs, and a node writing a buffer also depends on the
+ * previous nodes that read or wrote it. The order in which nodes are added
+ * is thus the order in which their accesses to each buffer take effect.
+ * Sub-buffers are treated as their parent buffer.
+ *
+ * The first submission computes a schedule: which dependencies need an
+ * OpenCL event, and which are already implied by the order of an in-order
+ * queue. It is kept, so submitting the same graph again, for instance every
+ * frame, costs little more than enqueuing the commands. Adding nodes or
+ * declaring buffers discards the schedule. A graph must not be submitted
+ * from several threads at the same time.
+ *
+ * Like with #GoclCommandList, the data pointers of transfers are not
+ * copied, and must remain valid until the commands using them complete.
+ **/
+
+/**
+ * GoclGraphClass:
+ * @parent_class: The parent class
+ *
+ * The class for #GoclGraph objects.
+ **/
+
+#include <string.h>
+
+#include "gocl-graph.h"
+
+#include "gocl-private.h"
+
+typedef enum
+{
+  NODE_WRITE,
+  NODE_READ,
+  NODE_KERNEL
+} NodeType;
+
+typedef struct
+{
+  NodeType type;
+  GoclQueue *queue;
+
+  GoclBuffer *buffer;
+  gpointer ptr;
+  gsize size;
+  goffset offset;
+
+  GoclLaunch *launch;
+
+  /* buffers read and written by the node */
+  GPtrArray *inputs;
+  GPtrArray *outputs;
+
+  /* schedule: nodes whose events to wait for, and what else to wait */
+  GArray *deps;
+  gboolean needs_event;
+  gboolean waits_external;
+} Node;
+
+struct _GoclGraphPrivate
+{
+  GArray *nodes;
+  guint64 bytes;
+
+  gboolean scheduled;
+  GArray *final_nodes;
+  GoclQueue *event_queue;
+
+  /* reused by every submission */
+  cl_event *events;
+  GArray *wait_list;
+};
+
+static void           gocl_graph_class_init              (GoclGraphClass *class);
+static void           gocl_graph_init                    (GoclGraph *self);
+static void           gocl_graph_finalize                (GObject *obj);
+
+G_DEFINE_TYPE (GoclGraph, gocl_graph, G_TYPE_OBJECT)
+
+#define GOCL_GRAPH_GET_PRIVATE(obj)                     \
+  (G_TYPE_INSTANCE_GET_PRIVATE ((obj),                  \
+                                GOCL_TYPE_GRAPH,        \
+                                GoclGraphPrivate))      \
+
+static void
+gocl_graph_class_init (GoclGraphClass *class)
+{
+  GObjectClass *obj_class = G_OBJECT_CLASS (class);
+
+  obj_class->finalize = gocl_graph_finalize;
+
+  g_type_class_add_private (class, sizeof (GoclGraphPrivate));
+}
+
+static void
+gocl_graph_init (GoclGraph *self)
+{
+  GoclGraphPrivate *priv;
+
+  self->priv = priv = GOCL_GRAPH_GET_PRIVATE (self);
+
+  priv->nodes = g_array_new (FALSE, TRUE, sizeof (Node));
+  priv->bytes = 0;
+
+  priv->scheduled = FALSE;
+  priv->final_nodes = g_array_new (FALSE, FALSE, sizeof (guint));
+  priv->event_queue = NULL;
+
+  priv->events = NULL;
+  priv->wait_list = g_array_new (FALSE, FALSE, sizeof (cl_event));
+}
+
+static void
+gocl_graph_finalize (GObject *obj)
+{
+  GoclGraph *self = GOCL_GRAPH (obj);
+
+  gocl_graph_clear (self);
+  g_array_free (self->priv->nodes, TRUE);
+
+  g_array_free (self->priv->final_nodes, TRUE);
+  g_free (self->priv->events);
+  g_array_free (self->priv->wait_list, TRUE);
+
+  G_OBJECT_CLASS (gocl_graph_parent_class)->finalize (obj);
+}
+
+static gboolean
+is_in_order (GoclQueue *queue)
+{
+  return (gocl_queue_get_flags (queue) & GOCL_QUEUE_FLAGS_OUT_OF_ORDER) == 0;
+}
+
+/* sub-buffers alias their parent, so dependencies are tracked on the
+   outermost buffer */
+static GoclBuffer *
+get_root_buffer (GoclBuffer *buffer)
+{
+  GoclBuffer *parent = NULL;
+
+  g_object_get (buffer, "parent", &parent, NULL);
+  if (parent == NULL)
+    return buffer;
+
+  /* the sub-buffer keeps its parent alive */
+  g_object_unref (parent);
+
+  return get_root_buffer (parent);
+}
+
+static void
+add_buffer (GPtrArray *buffers, GoclBuffer *buffer)
+{
+  guint i;
+
+  buffer = get_root_buffer (buffer);
+
+  for (i = 0; i < buffers->len; i++)
+    if (g_ptr_array_index (buffers, i) == buffer)
+      return;
+
+  g_ptr_array_add (buffers, g_object_ref (buffer));
+}
+
+static guint
+add_node (GoclGraph *self, Node *node)
+{
+  node->inputs = g_ptr_array_new_with_free_func (g_object_unref);
+  node->outputs = g_ptr_array_new_with_free_func (g_object_unref);
+  node->deps = g_array_new (FALSE, FALSE, sizeof (guint));
+
+  g_array_append_vals (self->priv->nodes, node, 1);
+  self->priv->scheduled = FALSE;
+
+  return self->priv->nodes->len - 1;
+}
+
+static void
+add_raw_dependency (GArray *deps, guint index)
+{
+  guint i;
+
+  for (i = 0; i < deps->len; i++)
+    if (g_array_index (deps, guint, i) == index)
+      return;
+
+  g_array_append_val (deps, index);
+}
+
+/* keeps only the waits that the order of the queues does not imply */
+static void
+prune_dependencies (GoclGraph *self, Node *node, GArray *raw_deps)
+{
+  guint i, j;
+
+  g_array_set_size (node->deps, 0);
+
+  for (i = 0; i < raw_deps->len; i++)
+    {
+      guint index = g_array_index (raw_deps, guint, i);
+      Node *dep;
+      gboolean replaced = FALSE;
+
+      dep = &g_array_index (self->priv->nodes, Node, index);
+
+      if (dep->queue == node->queue && is_in_order (node->queue))
+        continue;
+
+      /* on an in-order queue, waiting for the latest node covers the rest */
+      if (is_in_order (dep->queue))
+        for (j = 0; j < node->deps->len && ! replaced; j++)
+          {
+            guint *other = &g_array_index (node->deps, guint, j);
+
+            if (g_array_index (self->priv->nodes, Node, *other).queue == dep->queue)
+              {
+                *other = MAX (*other, index);
+                replaced = TRUE;
+              }
+          }
+
+      if (! replaced)
+        g_array_append_val (node->deps, index);
+    }
+}
+
+static void
+schedule (GoclGraph *self)
+{
+  GHashTable *last_writer;
+  GHashTable *readers;
+  GHashTable *last_on_queue;
+  GArray *raw_deps;
+  gboolean *referenced;
+  GHashTableIter iter;
+  gpointer value;
+  guint len;
+  guint i, j;
+
+  len = self->priv->nodes->len;
+
+  last_writer = g_hash_table_new (NULL, NULL);
+  readers = g_hash_table_new_full (NULL,
+                                   NULL,
+                                   NULL,
+                                   (GDestroyNotify) g_array_unref);
+  last_on_queue = g_hash_table_new (NULL, NULL);
+  raw_deps = g_array_new (FALSE, FALSE, sizeof (guint));
+  referenced = g_new0 (gboolean, len);
+
+  for (i = 0; i < len; i++)
+    {
+      Node *node = &g_array_index (self->priv->nodes, Node, i);
+      GArray *buffer_readers;
+      gpointer writer;
+
+      g_array_set_size (raw_deps, 0);
+
+      /* read after write */
+      for (j = 0; j < node->inputs->len; j++)
+        {
+          writer = g_hash_table_lookup (last_writer,
+                                        g_ptr_array_index (node->inputs, j));
+          if (writer != NULL)
+            add_raw_dependency (raw_deps, GPOINTER_TO_UINT (writer) - 1);
+        }
+
+      /* write after write, and write after read */
+      for (j = 0; j < node->outputs->len; j++)
+        {
+          gpointer buffer = g_ptr_array_index (node->outputs, j);
+          guint k;
+
+          writer = g_hash_table_lookup (last_writer, buffer);
+          if (writer != NULL)
+            add_raw_dependency (raw_deps, GPOINTER_TO_UINT (writer) - 1);
+
+          buffer_readers = g_hash_table_lookup (readers, buffer);
+          for (k = 0; buffer_readers != NULL && k < buffer_readers->len; k++)
+            add_raw_dependency (raw_deps, g_array_index (buffer_readers, guint, k));
+        }
+
+      for (j = 0; j < node->inputs->len; j++)
+        {
+          gpointer buffer = g_ptr_array_index (node->inputs, j);
+
+          buffer_readers = g_hash_table_lookup (readers, buffer);
+          if (buffer_readers == NULL)
+            {
+              buffer_readers = g_array_new (FALSE, FALSE, sizeof (guint));
+              g_hash_table_insert (readers, buffer, buffer_readers);
+            }
+          g_array_append_val (buffer_readers, i);
+        }
+
+      for (j = 0; j < node->outputs->len; j++)
+        {
+          gpointer buffer = g_ptr_array_index (node->outputs, j);
+
+          g_hash_table_insert (last_writer, buffer, GUINT_TO_POINTER (i + 1));
+          g_hash_table_remove (readers, buffer);
+        }
+
+      prune_dependencies (self, node, raw_deps);
+      for (j = 0; j < node->deps->len; j++)
+        referenced[g_array_index (node->deps, guint, j)] = TRUE;
+
+      /* a node with no dependencies waits for the submission's wait list,
+         unless an earlier node of its in-order queue already did */
+      node->waits_external = raw_deps->len == 0 &&
+        (! is_in_order (node->queue) ||
+         ! g_hash_table_contains (last_on_queue, node->queue));
+
+      g_hash_table_insert (last_on_queue, node->queue, GUINT_TO_POINTER (i + 1));
+    }
+
+  /* the graph completes when the last node of each in-order queue, and all
+     the nodes nobody waits for on out-of-order queues, complete */
+  g_array_set_size (self->priv->final_nodes, 0);
+
+  g_hash_table_iter_init (&iter, last_on_queue);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+      guint index = GPOINTER_TO_UINT (value) - 1;
+
+      if (is_in_order (g_array_index (self->priv->nodes, Node, index).queue))
+        g_array_append_val (self->priv->final_nodes, index);
+    }
+
+  for (i = 0; i < len; i++)
+    {
+      Node *node = &g_array_index (self->priv->nodes, Node, i);
+
+      if (! is_in_order (node->queue) && ! referenced[i])
+        g_array_append_val (self->priv->final_nodes, i);
+
+      node->needs_event = referenced[i];
+    }
+
+  for (i = 0; i < self->priv->final_nodes->len; i++)
+    {
+      guint index = g_array_index (self->priv->final_nodes, guint, i);
+
+      g_array_index (self->priv->nodes, Node, index).needs_event = TRUE;
+    }
+
+  self->priv->event_queue =
+    g_array_index (self->priv->nodes,
+                   Node,
+                   g_array_index (self->priv->final_nodes, guint, 0)).queue;
+
+  self->priv->events = g_renew (cl_event, self->priv->events, len);
+  self->priv->scheduled = TRUE;
+
+  g_free (referenced);
+  g_array_free (raw_deps, TRUE);
+  g_hash_table_unref (last_on_queue);
+  g_hash_table_unref (readers);
+  g_hash_table_unref (last_writer);
+}
+
+static cl_int
+enqueue_node (Node     *node,
+              cl_event *event_wait_list,
+              guint     event_wait_list_len,
+              cl_event *out_event)
+{
+  cl_command_queue queue;
+
+  queue = gocl_queue_get_queue (node->queue);
+
+  switch (node->type)
+    {
+    case NODE_WRITE:
+      return clEnqueueWriteBuffer (queue,
+                                   gocl_buffer_get_buffer (node->buffer),
+                                   CL_FALSE,
+                                   node->offset,
+                                   node->size,
+                                   node->ptr,
+                                   event_wait_list_len,
+                                   event_wait_list,
+                                   out_event);
+
+    case NODE_READ:
+      return clEnqueueReadBuffer (queue,
+                                  gocl_buffer_get_buffer (node->buffer),
+                                  CL_FALSE,
+                                  node->offset,
+                                  node->size,
+                                  node->ptr,
+                                  event_wait_list_len,
+                                  event_wait_list,
+                                  out_event);
+
+    case NODE_KERNEL:
+      return gocl_launch_enqueue (node->launch,
+                                  event_wait_list,
+                                  event_wait_list_len,
+                                  out_event);
+    }
+
+  g_assert_not_reached ();
+  return CL_INVALID_OPERATION;
+}
+
+static cl_int
+enqueue_graph (GoclGraph *self,
+               cl_event  *event_wait_list,
+               guint      event_wait_list_len,
+               cl_event  *out_event)
+{
+  GArray *wait_list = self->priv->wait_list;
+  GArray *final_nodes;
+  cl_int err_code = CL_SUCCESS;
+  guint len;
+  guint i, j;
+
+  if (! self->priv->scheduled)
+    schedule (self);
+
+  len = self->priv->nodes->len;
+  final_nodes = self->priv->final_nodes;
+  memset (self->priv->events, 0, sizeof (cl_event) * len);
+
+  for (i = 0; i < len && err_code == CL_SUCCESS; i++)
+    {
+      Node *node = &g_array_index (self->priv->nodes, Node, i);
+
+      g_array_set_size (wait_list, 0);
+      if (node->waits_external)
+        g_array_append_vals (wait_list, event_wait_list, event_wait_list_len);
+      for (j = 0; j < node->deps->len; j++)
+        g_array_append_val (wait_list,
+                            self->priv->events[g_array_index (node->deps, guint, j)]);
+
+      err_code = enqueue_node (node,
+                               wait_list->len > 0 ?
+                                 (cl_event *) wait_list->data : NULL,
+                               wait_list->len,
+                               node->needs_event ? &self->priv->events[i] : NULL);
+    }
+
+  if (err_code == CL_SUCCESS)
+    {
+      if (final_nodes->len == 1)
+        {
+          guint index = g_array_index (final_nodes, guint, 0);
+
+          *out_event = self->priv->events[index];
+          self->priv->events[index] = NULL;
+        }
+      else
+        {
+          g_array_set_size (wait_list, 0);
+          for (i = 0; i < final_nodes->len; i++)
+            g_array_append_val (wait_list,
+                                self->priv->events[g_array_index (final_nodes, guint, i)]);
+
+          err_code = clEnqueueMarkerWithWaitList (gocl_queue_get_queue (self->priv->event_queue),
+                                                  wait_list->len,
+                                                  (cl_event *) wait_list->data,
+                                                  out_event);
+        }
+    }
+
+  /* nodes already enqueued still run, but their events are not needed */
+  for (i = 0; i < len; i++)
+    if (self->priv->events[i] != NULL)
+      clReleaseEvent (self->priv->events[i]);
+
+  return err_code;
+}
+
+/* public */
+
+/**
+ * gocl_graph_new:
+ *
+ * Creates a new, empty graph.
+ *
+ * Returns: (transfer full): A newly created #GoclGraph
+ **/
+GoclGraph *
+gocl_graph_new (void)
+{
+  return g_object_new (GOCL_TYPE_GRAPH, NULL);
+}
+
+/**
+ * gocl_graph_get_num_nodes:
+ * @self: The #GoclGraph
+ *
+ * Obtains the number of nodes in the graph.
+ *
+ * Returns: The number of nodes
+ **/
+guint
+gocl_graph_get_num_nodes (GoclGraph *self)
+{
+  g_return_val_if_fail (GOCL_IS_GRAPH (self), 0);
+
+  return self->priv->nodes->len;
+}
+
+/**
+ * gocl_graph_add_write:
+ * @self: The #GoclGraph
+ * @queue: The #GoclQueue to enqueue the write in
+ * @buffer: The #GoclBuffer to write to
+ * @data: (array length=size) (element-type guint8): A pointer to the data
+ * to write
+ * @size: The number of bytes to write
+ * @offset: The offset inside @buffer where to start writing
+ *
+ * Adds a node that writes @size bytes from @data into @buffer. The node is
+ * an output of @buffer, so later nodes reading it wait for the write. The
+ * memory pointed by @data is read when the node executes, not now.
+ *
+ * Returns: The index of the new node
+ **/
+guint
+gocl_graph_add_write (GoclGraph     *self,
+                      GoclQueue     *queue,
+                      GoclBuffer    *buffer,
+                      gconstpointer  data,
+                      gsize          size,
+                      goffset        offset)
+{
+  Node node = { 0, };
+  guint index;
+
+  g_return_val_if_fail (GOCL_IS_GRAPH (self), G_MAXUINT);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), G_MAXUINT);
+  g_return_val_if_fail (GOCL_IS_BUFFER (buffer), G_MAXUINT);
+  g_return_val_if_fail (data != NULL, G_MAXUINT);
+
+  node.type = NODE_WRITE;
+  node.queue = g_object_ref (queue);
+  node.buffer = g_object_ref (buffer);
+  node.ptr = (gpointer) data;
+  node.size = size;
+  node.offset = offset;
+
+  index = add_node (self, &node);
+  gocl_graph_add_output (self, index, buffer);
+  self->priv->bytes += size;
+
+  return index;
+}
+
+/**
+ * gocl_graph_add_read:
+ * @self: The #GoclGraph
+ * @queue: The #GoclQueue to enqueue the read in
+ * @buffer: The #GoclBuffer to read from
+ * @target_ptr: (array length=size) (element-type guint8): A pointer to the
+ * memory where data will be stored
+ * @size: The number of bytes to read
+ * @offset: The offset inside @buffer where to start reading
+ *
+ * Adds a node that reads @size bytes from @buffer into @target_ptr. The node
+ * is an input of @buffer, so it waits for the previous nodes writing it. The
+ * data is available once the event returned by gocl_graph_submit()
+ * resolves.
+ *
+ * Returns: The index of the new node
+ **/
+guint
+gocl_graph_add_read (GoclGraph  *self,
+                     GoclQueue  *queue,
+                     GoclBuffer *buffer,
+                     gpointer    target_ptr,
+                     gsize       size,
+                     goffset     offset)
+{
+  Node node = { 0, };
+  guint index;
+
+  g_return_val_if_fail (GOCL_IS_GRAPH (self), G_MAXUINT);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), G_MAXUINT);
+  g_return_val_if_fail (GOCL_IS_BUFFER (buffer), G_MAXUINT);
+  g_return_val_if_fail (target_ptr != NULL, G_MAXUINT);
+
+  node.type = NODE_READ;
+  node.queue = g_object_ref (queue);
+  node.buffer = g_object_ref (buffer);
+  node.ptr = target_ptr;
+  node.size = size;
+  node.offset = offset;
+
+  index = add_node (self, &node);
+  gocl_graph_add_input (self, index, buffer);
+  self->priv->bytes += size;
+
+  return index;
+}
+
+/**
+ * gocl_graph_add_kernel:
+ * @self: The #GoclGraph
+ * @kernel: The #GoclKernel to execute
+ * @queue: The #GoclQueue to enqueue the kernel in
+ *
+ * Adds a node that executes @kernel in @queue. The current arguments and
+ * work sizes of @kernel are captured now, like gocl_command_list_add_kernel()
+ * does. The buffers used by the kernel must be declared with
+ * gocl_graph_add_input() and gocl_graph_add_output().
+ *
+ * Returns: The index of the new node
+ **/
+guint
+gocl_graph_add_kernel (GoclGraph  *self,
+                       GoclKernel *kernel,
+                       GoclQueue  *queue)
+{
+  GoclLaunch *launch;
+  guint index;
+
+  g_return_val_if_fail (GOCL_IS_GRAPH (self), G_MAXUINT);
+  g_return_val_if_fail (GOCL_IS_KERNEL (kernel), G_MAXUINT);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), G_MAXUINT);
+
+  launch = gocl_launch_new (kernel, queue);
+  index = gocl_graph_add_launch (self, launch);
+  g_object_unref (launch);
+
+  return index;
+}
+
+/**
+ * gocl_graph_add_launch:
+ * @self: The #GoclGraph
+ * @launch: The #GoclLaunch to execute
+ *
+ * Adds a node that executes @launch, in the queue of the launch. The
+ * arguments and work sizes of @launch are read at submission time, so they
+ * can be changed between submissions of the graph. The buffers used by the
+ * kernel must be declared with gocl_graph_add_input() and
+ * gocl_graph_add_output().
+ *
+ * Returns: The index of the new node
+ **/
+guint
+gocl_graph_add_launch (GoclGraph *self, GoclLaunch *launch)
+{
+  Node node = { 0, };
+
+  g_return_val_if_fail (GOCL_IS_GRAPH (self), G_MAXUINT);
+  g_return_val_if_fail (GOCL_IS_LAUNCH (launch), G_MAXUINT);
+
+  node.type = NODE_KERNEL;
+  node.queue = g_object_ref (gocl_launch_get_queue (launch));
+  node.launch = g_object_ref (launch);
+
+  return add_node (self, &node);
+}
+
+/**
+ * gocl_graph_add_input:
+ * @self: The #GoclGraph
+ * @node: The index of a node of the graph
+ * @buffer: A #GoclBuffer read by the node
+ *
+ * Declares that @node reads @buffer, so that it waits for the nodes added
+ * before it that write @buffer.
+ **/
+void
+gocl_graph_add_input (GoclGraph  *self,
+                      guint       node,
+                      GoclBuffer *buffer)
+{
+  g_return_if_fail (GOCL_IS_GRAPH (self));
+  g_return_if_fail (node < self->priv->nodes->len);
+  g_return_if_fail (GOCL_IS_BUFFER (buffer));
+
+  add_buffer (g_array_index (self->priv->nodes, Node, node).inputs, buffer);
+  self->priv->scheduled = FALSE;
+}
+
+/**
+ * gocl_graph_add_output:
+ * @self: The #GoclGraph
+ * @node: The index of a node of the graph
+ * @buffer: A #GoclBuffer written by the node
+ *
+ * Declares that @node writes @buffer, so that it waits for the nodes added
+ * before it that read or write @buffer, and the nodes added after it that
+ * read @buffer wait for it.
+ **/
+void
+gocl_graph_add_output (GoclGraph  *self,
+                       guint       node,
+                       GoclBuffer *buffer)
+{
+  g_return_if_fail (GOCL_IS_GRAPH (self));
+  g_return_if_fail (node < self->priv->nodes->len);
+  g_return_if_fail (GOCL_IS_BUFFER (buffer));
+
+  add_buffer (g_array_index (self->priv->nodes, Node, node).outputs, buffer);
+  self->priv->scheduled = FALSE;
+}
+
+/**
+ * gocl_graph_clear:
+ * @self: The #GoclGraph
+ *
+ * Removes all the nodes of the graph. Submissions already made are not
+ * affected.
+ **/
+void
+gocl_graph_clear (GoclGraph *self)
+{
+  guint i;
+
+  g_return_if_fail (GOCL_IS_GRAPH (self));
+
+  for (i = 0; i < self->priv->nodes->len; i++)
+    {
+      Node *node = &g_array_index (self->priv->nodes, Node, i);
+
+      g_object_unref (node->queue);
+      if (node->buffer != NULL)
+        g_object_unref (node->buffer);
+      if (node->launch != NULL)
+        g_object_unref (node->launch);
+
+      g_ptr_array_unref (node->inputs);
+      g_ptr_array_unref (node->outputs);
+      g_array_free (node->deps, TRUE);
+    }
+
+  g_array_set_size (self->priv->nodes, 0);
+  self->priv->bytes = 0;
+  self->priv->scheduled = FALSE;
+}
+
+/**
+ * gocl_graph_submit_sync:
+ * @self: The #GoclGraph
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List of
+ * #GoclEvent objects to wait for before the nodes that depend on no other
+ * node, or %NULL
+ *
+ * Enqueues all the nodes of the graph, and blocks until all of them
+ * complete. The graph must have at least one node.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_graph_submit_sync (GoclGraph *self, GList *event_wait_list)
+{
+  cl_int err_code;
+  cl_event event = NULL;
+
+  GoclWaitList wait_list;
+
+  g_return_val_if_fail (GOCL_IS_GRAPH (self), FALSE);
+  g_return_val_if_fail (self->priv->nodes->len > 0, FALSE);
+
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
+
+  err_code = enqueue_graph (self,
+                            wait_list.cl_events,
+                            wait_list.len,
+                            &event);
+  gocl_wait_list_clear (&wait_list);
+
+  if (err_code == CL_SUCCESS)
+    {
+      err_code = clWaitForEvents (1, &event);
+      clReleaseEvent (event);
+    }
+
+  return ! gocl_error_check_opencl_internal (err_code);
+}
+
+/**
+ * gocl_graph_submit:
+ * @self: The #GoclGraph
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List of
+ * #GoclEvent objects to wait for before the nodes that depend on no other
+ * node, or %NULL
+ *
+ * Enqueues all the nodes of the graph, without blocking. The returned event
+ * resolves when all of them complete. The graph must have at least one node.
+ *
+ * Returns: (transfer none): A #GoclEvent to get notified when all the
+ * nodes of the graph complete
+ **/
+GoclEvent *
+gocl_graph_submit (GoclGraph *self, GList *event_wait_list)
+{
+  GError *error = NULL;
+  cl_int err_code;
+  cl_event event = NULL;
+
+  GoclEvent *_event = NULL;
+  GoclEventResolverFunc resolver_func;
+
+  GoclWaitList wait_list;
+
+  g_return_val_if_fail (GOCL_IS_GRAPH (self), NULL);
+  g_return_val_if_fail (self->priv->nodes->len > 0, NULL);
+
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
+
+  err_code = enqueue_graph (self,
+                            wait_list.cl_events,
+                            wait_list.len,
+                            &event);
+  gocl_wait_list_clear (&wait_list);
+
+  if (gocl_error_check_opencl (err_code, &error))
+    {
+      _event = g_object_new (GOCL_TYPE_EVENT,
+                             "queue", self->priv->event_queue,
+                             NULL);
+      resolver_func = gocl_event_steal_resolver_func (_event);
+      resolver_func (_event, error);
+      g_error_free (error);
+    }
+  else
+    {
+      _event = g_object_new (GOCL_TYPE_EVENT,
+                             "queue", self->priv->event_queue,
+                             "event", event,
+                             "label", "graph",
+                             "bytes", self->priv->bytes,
+                             NULL);
+      gocl_event_set_event_wait_list (_event, event_wait_list);
+      gocl_event_steal_resolver_func (_event);
+    }
+
+  gocl_event_idle_unref (_event);
+
+  return _event;
+}
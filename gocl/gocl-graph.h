@@ -0,0 +1,98 @@
+/*
+ * gocl-graph.h
+ *
+ * Gocl - GLib/GObject wrapper for OpenCL
+ * Copyright (C) 2012-2013 Igalia S.L.
+ *
+ * Authors:
+ *  Eduardo Lima Mitev <elima@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License at http://www.gnu.org/licenses/lgpl-3.0.txt
+ * for more details.
+ */
+
+#ifndef __GOCL_GRAPH_H__
+#define __GOCL_GRAPH_H__
+
+#include <glib-object.h>
+
+#include "gocl-queue.h"
+#include "gocl-buffer.h"
+#include "gocl-kernel.h"
+#include "gocl-launch.h"
+#include "gocl-event.h"
+
+G_BEGIN_DECLS
+
+#define GOCL_TYPE_GRAPH              (gocl_graph_get_type ())
+#define GOCL_GRAPH(obj)              (G_TYPE_CHECK_INSTANCE_CAST ((obj), GOCL_TYPE_GRAPH, GoclGraph))
+#define GOCL_GRAPH_CLASS(klass)      (G_TYPE_CHECK_CLASS_CAST ((klass), GOCL_TYPE_GRAPH, GoclGraphClass))
+#define GOCL_IS_GRAPH(obj)           (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GOCL_TYPE_GRAPH))
+#define GOCL_IS_GRAPH_CLASS(klass)   (G_TYPE_CHECK_CLASS_TYPE ((klass), GOCL_TYPE_GRAPH))
+#define GOCL_GRAPH_GET_CLASS(obj)    (G_TYPE_INSTANCE_GET_CLASS ((obj), GOCL_TYPE_GRAPH, GoclGraphClass))
+
+typedef struct _GoclGraphClass GoclGraphClass;
+typedef struct _GoclGraph GoclGraph;
+typedef struct _GoclGraphPrivate GoclGraphPrivate;
+
+struct _GoclGraph
+{
+  GObject parent_instance;
+
+  GoclGraphPrivate *priv;
+};
+
+struct _GoclGraphClass
+{
+  GObjectClass parent_class;
+};
+
+GType                  gocl_graph_get_type                    (void) G_GNUC_CONST;
+
+GoclGraph *            gocl_graph_new                         (void);
+
+guint                  gocl_graph_get_num_nodes               (GoclGraph *self);
+
+guint                  gocl_graph_add_write                   (GoclGraph     *self,
+                                                               GoclQueue     *queue,
+                                                               GoclBuffer    *buffer,
+                                                               gconstpointer  data,
+                                                               gsize          size,
+                                                               goffset        offset);
+guint                  gocl_graph_add_read                    (GoclGraph  *self,
+                                                               GoclQueue  *queue,
+                                                               GoclBuffer *buffer,
+                                                               gpointer    target_ptr,
+                                                               gsize       size,
+                                                               goffset     offset);
+guint                  gocl_graph_add_kernel                  (GoclGraph  *self,
+                                                               GoclKernel *kernel,
+                                                               GoclQueue  *queue);
+guint                  gocl_graph_add_launch                  (GoclGraph  *self,
+                                                               GoclLaunch *launch);
+
+void                   gocl_graph_add_input                   (GoclGraph  *self,
+                                                               guint       node,
+                                                               GoclBuffer *buffer);
+void                   gocl_graph_add_output                  (GoclGraph  *self,
+                                                               guint       node,
+                                                               GoclBuffer *buffer);
+
+void                   gocl_graph_clear                       (GoclGraph *self);
+
+gboolean               gocl_graph_submit_sync                 (GoclGraph *self,
+                                                               GList     *event_wait_list);
+GoclEvent *            gocl_graph_submit                      (GoclGraph *self,
+                                                               GList     *event_wait_list);
+
+G_END_DECLS
+
+#endif /* __GOCL_GRAPH_H__ */
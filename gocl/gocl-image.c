@@ -29,11 +29,32 @@
  * special type of buffer that holds pixel information in a convenient way.
  * As buffers, images are also directly accessible from OpenCL programs.
  *
- * Iamges are created using gocl_image_new() and
- * gocl_image_new_from_gl_texture().
+ * Iamges are created using gocl_image_new(), or shared with OpenGL using
+ * gocl_image_new_from_gl_texture() and gocl_image_new_from_gl_texture_full().
+ * The latter accepts any texture target, including 3D textures and texture
+ * arrays, and any mipmap level.
  *
  * Reading from and writing to images is done using the provided
- * #GoclBuffer APIs.
+ * #GoclBuffer APIs. When an image is mapped with gocl_buffer_map(), the whole
+ * image is mapped and the row and slice pitches of the mapped region are
+ * reported, since these are chosen by the OpenCL implementation.
+ *
+ * Images hold pixels in one of many formats, given by a #GoclImageChannelOrder
+ * and a #GoclImageChannelType, like single-channel floats or half-float RGBA.
+ * Host data is always transferred in the image's own format, with rows
+ * tightly packed unless a pitch is given. gocl_image_get_element_size()
+ * gives the size of a pixel.
+ *
+ * Rectangular parts of an image can be transferred with
+ * gocl_image_read_region() and gocl_image_write_region(), and their
+ * synchronous counterparts. The @origin and @region arguments are given in
+ * pixels, as arrays of three elements (x, y, z), where unused dimensions
+ * are 0 for @origin and 1 for @region. A row or slice pitch of 0 means the
+ * host memory is tightly packed.
+ *
+ * Pixels can also be copied between images, or between an image and a
+ * #GoclBuffer, without going through host memory, using gocl_image_copy(),
+ * gocl_image_copy_to_buffer() and gocl_image_copy_from_buffer().
  **/
 
 /**
@@ -51,11 +72,20 @@
 #include "gocl-private.h"
 #include "gocl-context.h"
 
+/* from gl.h, which is not required to build Gocl */
+#define GL_TEXTURE_2D 0x0DE1
+
 struct _GoclImagePrivate
 {
   cl_image_desc props;
+  cl_image_format format;
+
+  /* size of a pixel in bytes, known once the image is created */
+  gsize element_size;
 
   guint gl_texture;
+  guint gl_target;
+  gint gl_mip_level;
 };
 
 /* properties */
@@ -66,7 +96,11 @@ enum
   PROP_WIDTH,
   PROP_HEIGHT,
   PROP_DEPTH,
-  PROP_GL_TEXTURE
+  PROP_CHANNEL_ORDER,
+  PROP_CHANNEL_TYPE,
+  PROP_GL_TEXTURE,
+  PROP_GL_TARGET,
+  PROP_GL_MIP_LEVEL
 };
 
 static void           gocl_image_class_init               (GoclImageClass *class);
@@ -96,6 +130,19 @@ static cl_int         read_all                            (GoclBuffer          *
                                                            cl_event            *event_wait_list,
                                                            guint                event_wait_list_len,
                                                            cl_event            *out_event);
+static gpointer       map                                 (GoclBuffer          *buffer,
+                                                           cl_mem               image,
+                                                           cl_command_queue     queue,
+                                                           gboolean             blocking,
+                                                           guint                flags,
+                                                           goffset              offset,
+                                                           gsize                size,
+                                                           gsize               *row_pitch,
+                                                           gsize               *slice_pitch,
+                                                           cl_event            *event_wait_list,
+                                                           guint                event_wait_list_len,
+                                                           cl_event            *out_event,
+                                                           cl_int              *err_code);
 
 G_DEFINE_TYPE (GoclImage, gocl_image, GOCL_TYPE_BUFFER)
 
@@ -115,6 +162,7 @@ gocl_image_class_init (GoclImageClass *class)
 
   gocl_buf_class->create_cl_mem = create_cl_mem;
   gocl_buf_class->read_all = read_all;
+  gocl_buf_class->map = map;
 
   g_object_class_install_property (obj_class, PROP_TYPE,
                                    g_param_spec_uint ("type",
@@ -153,6 +201,25 @@ gocl_image_class_init (GoclImageClass *class)
                                                         G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
                                                         G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (obj_class, PROP_CHANNEL_ORDER,
+                                   g_param_spec_uint ("channel-order",
+                                                      "Channel order",
+                                                      "The channels of each pixel, from GoclImageChannelOrder",
+                                                      0,
+                                                      G_MAXUINT,
+                                                      GOCL_IMAGE_CHANNEL_ORDER_RGBA,
+                                                      G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
+                                                      G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (obj_class, PROP_CHANNEL_TYPE,
+                                   g_param_spec_uint ("channel-type",
+                                                      "Channel type",
+                                                      "The data type of each channel, from GoclImageChannelType",
+                                                      0,
+                                                      G_MAXUINT,
+                                                      GOCL_IMAGE_CHANNEL_TYPE_UNORM_INT8,
+                                                      G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
+                                                      G_PARAM_STATIC_STRINGS));
+
   g_object_class_install_property (obj_class, PROP_GL_TEXTURE,
                                    g_param_spec_uint ("gl-texture",
                                                       "GL Texture",
@@ -163,6 +230,25 @@ gocl_image_class_init (GoclImageClass *class)
                                                       G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
                                                       G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (obj_class, PROP_GL_TARGET,
+                                   g_param_spec_uint ("gl-target",
+                                                      "GL target",
+                                                      "The GL texture target, like GL_TEXTURE_2D",
+                                                      0,
+                                                      G_MAXUINT,
+                                                      GL_TEXTURE_2D,
+                                                      G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
+                                                      G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (obj_class, PROP_GL_MIP_LEVEL,
+                                   g_param_spec_int ("gl-mip-level",
+                                                     "GL mipmap level",
+                                                     "The mipmap level of the GL texture to use",
+                                                     0,
+                                                     G_MAXINT,
+                                                     0,
+                                                     G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
+                                                     G_PARAM_STATIC_STRINGS));
+
   g_type_class_add_private (class, sizeof (GoclImagePrivate));
 }
 
@@ -174,6 +260,14 @@ gocl_image_init (GoclImage *self)
   self->priv = priv = GOCL_IMAGE_GET_PRIVATE (self);
 
   memset (&priv->props, 0, sizeof (cl_image_desc));
+
+  priv->gl_texture = 0;
+  priv->gl_target = GL_TEXTURE_2D;
+  priv->gl_mip_level = 0;
+
+  priv->format.image_channel_order = GOCL_IMAGE_CHANNEL_ORDER_RGBA;
+  priv->format.image_channel_data_type = GOCL_IMAGE_CHANNEL_TYPE_UNORM_INT8;
+  priv->element_size = 0;
 }
 
 static void
@@ -204,10 +298,26 @@ set_property (GObject      *obj,
       self->priv->props.image_depth = g_value_get_uint64 (value);
       break;
 
+    case PROP_CHANNEL_ORDER:
+      self->priv->format.image_channel_order = g_value_get_uint (value);
+      break;
+
+    case PROP_CHANNEL_TYPE:
+      self->priv->format.image_channel_data_type = g_value_get_uint (value);
+      break;
+
     case PROP_GL_TEXTURE:
       self->priv->gl_texture = g_value_get_uint (value);
       break;
 
+    case PROP_GL_TARGET:
+      self->priv->gl_target = g_value_get_uint (value);
+      break;
+
+    case PROP_GL_MIP_LEVEL:
+      self->priv->gl_mip_level = g_value_get_int (value);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
       break;
@@ -242,10 +352,26 @@ get_property (GObject    *obj,
       g_value_set_uint64 (value, self->priv->props.image_depth);
       break;
 
+    case PROP_CHANNEL_ORDER:
+      g_value_set_uint (value, self->priv->format.image_channel_order);
+      break;
+
+    case PROP_CHANNEL_TYPE:
+      g_value_set_uint (value, self->priv->format.image_channel_data_type);
+      break;
+
     case PROP_GL_TEXTURE:
       g_value_set_uint (value, self->priv->gl_texture);
       break;
 
+    case PROP_GL_TARGET:
+      g_value_set_uint (value, self->priv->gl_target);
+      break;
+
+    case PROP_GL_MIP_LEVEL:
+      g_value_set_int (value, self->priv->gl_mip_level);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
       break;
@@ -285,6 +411,14 @@ get_image_info (GoclImage *self, cl_mem obj, cl_image_info param)
       self->priv->props.image_depth = value;
       break;
 
+    case CL_IMAGE_ARRAY_SIZE:
+      self->priv->props.image_array_size = value;
+      break;
+
+    case CL_IMAGE_ELEMENT_SIZE:
+      self->priv->element_size = value;
+      break;
+
     default:
       break;
     }
@@ -305,37 +439,84 @@ create_cl_mem (GoclBuffer  *buffer,
     {
       *obj = clCreateFromGLTexture (context,
                                     flags,  /* OR'ed from GoclBufferFlags */
-                                    0x0DE1, /* GL_TEXTURE_2D from gl.h */
-                                    0,      /* miplevel = 0 for now */
+                                    self->priv->gl_target,
+                                    self->priv->gl_mip_level,
                                     self->priv->gl_texture,
                                     &err_code);
 
       if (err_code == CL_SUCCESS)
         {
-          /* the only we currently support from GL */
-          self->priv->props.image_type = GOCL_IMAGE_TYPE_2D;
+          cl_mem_object_type type;
+
+          /* the image type follows from the texture target */
+          if (clGetMemObjectInfo (*obj,
+                                  CL_MEM_TYPE,
+                                  sizeof (cl_mem_object_type),
+                                  &type,
+                                  NULL) == CL_SUCCESS)
+            self->priv->props.image_type = type;
+          else
+            self->priv->props.image_type = GOCL_IMAGE_TYPE_2D;
 
           get_image_info (self, *obj, CL_IMAGE_WIDTH);
           get_image_info (self, *obj, CL_IMAGE_HEIGHT);
           get_image_info (self, *obj, CL_IMAGE_DEPTH);
+          get_image_info (self, *obj, CL_IMAGE_ARRAY_SIZE);
+
+          /* the format is chosen by the GL texture */
+          clGetImageInfo (*obj,
+                          CL_IMAGE_FORMAT,
+                          sizeof (cl_image_format),
+                          &self->priv->format,
+                          NULL);
         }
     }
   else
     {
-      /* by now, only RGBA as 8-bit unsigned integers is supported */
-      cl_image_format format = { CL_RGBA, CL_UNORM_INT8 };
-
       *obj = clCreateImage (context,
                             flags,
-                            &format,
+                            &self->priv->format,
                             &self->priv->props,
                             host_ptr,
                             &err_code);
     }
 
+  if (err_code == CL_SUCCESS)
+    get_image_info (self, *obj, CL_IMAGE_ELEMENT_SIZE);
+
   return err_code;
 }
 
+static void
+get_full_region (GoclImage *self, gsize *region)
+{
+  cl_image_desc *props = &self->priv->props;
+
+  /* unused dimensions of the image are 0, but 1 for a region; the layers
+     of an image array come right after its last dimension */
+  region[0] = props->image_width;
+  region[1] = MAX (props->image_height, 1);
+  region[2] = 1;
+
+  switch (props->image_type)
+    {
+    case GOCL_IMAGE_TYPE_1D_ARRAY:
+      region[1] = MAX (props->image_array_size, 1);
+      break;
+
+    case GOCL_IMAGE_TYPE_2D_ARRAY:
+      region[2] = MAX (props->image_array_size, 1);
+      break;
+
+    case GOCL_IMAGE_TYPE_3D:
+      region[2] = MAX (props->image_depth, 1);
+      break;
+
+    default:
+      break;
+    }
+}
+
 static cl_int
 read_all (GoclBuffer          *buffer,
           cl_mem               image,
@@ -352,13 +533,10 @@ read_all (GoclBuffer          *buffer,
   gsize origin[3] = {0, };
   gsize region[3];
 
-  region[0] = self->priv->props.image_width;
-  region[1] = self->priv->props.image_height;
-  region[2] = self->priv->props.image_type == GOCL_IMAGE_TYPE_2D ?
-    1 : self->priv->props.image_depth;
+  get_full_region (self, region);
 
   if (size != NULL)
-    *size = region[0] * region[1] * region[2] * 4 /* assuming RGBA */;
+    *size = region[0] * region[1] * region[2] * self->priv->element_size;
 
   return clEnqueueReadImage (queue,
                              image,
@@ -373,6 +551,138 @@ read_all (GoclBuffer          *buffer,
                              out_event);
 }
 
+static gpointer
+map (GoclBuffer          *buffer,
+     cl_mem               image,
+     cl_command_queue     queue,
+     gboolean             blocking,
+     guint                flags,
+     goffset              offset,
+     gsize                size,
+     gsize               *row_pitch,
+     gsize               *slice_pitch,
+     cl_event            *event_wait_list,
+     guint                event_wait_list_len,
+     cl_event            *out_event,
+     cl_int              *err_code)
+{
+  GoclImage *self = GOCL_IMAGE (buffer);
+  gpointer ptr;
+
+  gsize origin[3] = {0, };
+  gsize region[3];
+  gsize _row_pitch = 0;
+  gsize _slice_pitch = 0;
+
+  get_full_region (self, region);
+
+  /* row pitch is mandatory, and slice pitch is required for 3D images and
+     image arrays, so always query both */
+  ptr = clEnqueueMapImage (queue,
+                           image,
+                           blocking,
+                           flags,
+                           origin,
+                           region,
+                           &_row_pitch,
+                           &_slice_pitch,
+                           event_wait_list_len,
+                           event_wait_list,
+                           out_event,
+                           err_code);
+
+  if (row_pitch != NULL)
+    *row_pitch = _row_pitch;
+  if (slice_pitch != NULL)
+    *slice_pitch = _slice_pitch;
+
+  return ptr;
+}
+
+static gsize
+get_region_size (GoclImage   *self,
+                 const gsize *region,
+                 gsize        row_pitch,
+                 gsize        slice_pitch)
+{
+  if (row_pitch == 0)
+    row_pitch = region[0] * self->priv->element_size;
+  if (slice_pitch == 0)
+    slice_pitch = row_pitch * region[1];
+
+  return slice_pitch * region[2];
+}
+
+static cl_int
+enqueue_region (GoclImage    *self,
+                GoclQueue    *queue,
+                gboolean      write,
+                gboolean      blocking,
+                gpointer      ptr,
+                const gsize  *origin,
+                const gsize  *region,
+                gsize         row_pitch,
+                gsize         slice_pitch,
+                GList        *event_wait_list,
+                cl_event     *out_event)
+{
+  cl_int err_code;
+  cl_command_queue _queue;
+  cl_mem image;
+  GoclWaitList wait_list;
+
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
+
+  _queue = gocl_queue_get_queue (queue);
+  image = gocl_buffer_get_buffer (GOCL_BUFFER (self));
+
+  if (write)
+    err_code = clEnqueueWriteImage (_queue,
+                                    image,
+                                    blocking,
+                                    origin,
+                                    region,
+                                    row_pitch,
+                                    slice_pitch,
+                                    ptr,
+                                    wait_list.len,
+                                    wait_list.cl_events,
+                                    out_event);
+  else
+    err_code = clEnqueueReadImage (_queue,
+                                   image,
+                                   blocking,
+                                   origin,
+                                   region,
+                                   row_pitch,
+                                   slice_pitch,
+                                   ptr,
+                                   wait_list.len,
+                                   wait_list.cl_events,
+                                   out_event);
+
+  gocl_wait_list_clear (&wait_list);
+
+  return err_code;
+}
+
+/* internal */
+
+/**
+ * gocl_image_is_gl_shared:
+ * @self: The #GoclImage
+ *
+ * Tells whether @self was created from a GL texture, sharing its storage.
+ * This is a Gocl private function, not exposed to applications.
+ *
+ * Returns: %TRUE if the image shares a GL texture, %FALSE otherwise
+ **/
+gboolean
+gocl_image_is_gl_shared (GoclImage *self)
+{
+  return self->priv->gl_texture > 0;
+}
+
 /* public */
 
 /**
@@ -381,25 +691,33 @@ read_all (GoclBuffer          *buffer,
  * @flags: An OR'ed combination of values from #GoclBufferFlags
  * @host_ptr: (allow-none): Pointer to host memory, or %NULL
  * @type: Image type value from #GoclImageType
+ * @channel_order: The channels of each pixel, from #GoclImageChannelOrder
+ * @channel_type: The data type of each channel, from #GoclImageChannelType
  * @width: Image width in pixels
  * @height: Image height in pixels, zero if image type is 1D
  * @depth: Image depth in pixels, or zero if image is not 3D
  *
- * Creates a new image buffer. Currently only 8-bits unsigned integer format is
- * supported, with RGBA channels.
+ * Creates a new image buffer, with pixels stored in the format given by
+ * @channel_order and @channel_type. Data in @host_ptr, and data later
+ * transferred to and from the image, is in that same format, so no
+ * conversion takes place on the host. Use
+ * gocl_context_is_image_format_supported() to find out which formats the
+ * OpenCL implementation accepts.
  * Other image properties like row pitch, slice pitch, etc. are assumed to be
- * zero by now.
+ * zero by now, that is, @host_ptr must be tightly packed.
  *
  * Returns: (transfer full): A newly created #GoclImage, or %NULL on error
  **/
 GoclImage *
-gocl_image_new (GoclContext   *context,
-                guint          flags,
-                gpointer       host_ptr,
-                GoclImageType  type,
-                gsize          width,
-                gsize          height,
-                gsize          depth)
+gocl_image_new (GoclContext           *context,
+                guint                  flags,
+                gpointer               host_ptr,
+                GoclImageType          type,
+                GoclImageChannelOrder  channel_order,
+                GoclImageChannelType   channel_type,
+                gsize                  width,
+                gsize                  height,
+                gsize                  depth)
 {
   GError **error;
 
@@ -414,6 +732,8 @@ gocl_image_new (GoclContext   *context,
                          "flags", flags,
                          "host-ptr", host_ptr,
                          "type", type,
+                         "channel-order", channel_order,
+                         "channel-type", channel_type,
                          "width", width,
                          "height", height,
                          "depth", depth,
@@ -426,10 +746,11 @@ gocl_image_new (GoclContext   *context,
  * @flags: An OR'ed combination of values from #GoclBufferFlags
  * @texture: The GL texture handle
  *
- * Creates a new image buffer from a GL texture handle. This only works if the
- * OpenCL platform supports the <i>cl_khr_gl_sharing</i> extension, and the
- * @context has been created for sharing with OpenGL, using
- * gocl_context_gpu_new_sync().
+ * Creates a new image buffer from the base level of a GL_TEXTURE_2D texture.
+ * This only works if the OpenCL platform supports the
+ * <i>cl_khr_gl_sharing</i> extension, and the @context has been created for
+ * sharing with OpenGL, using gocl_context_gpu_new_sync(). For other texture
+ * targets and mipmap levels, see gocl_image_new_from_gl_texture_full().
  *
  * Returns: (transfer full): A newly created #GoclImage, or %NULL on error
  **/
@@ -437,11 +758,43 @@ GoclImage *
 gocl_image_new_from_gl_texture (GoclContext *context,
                                 guint        flags,
                                 guint        texture)
+{
+  return gocl_image_new_from_gl_texture_full (context,
+                                              flags,
+                                              GL_TEXTURE_2D,
+                                              0,
+                                              texture);
+}
+
+/**
+ * gocl_image_new_from_gl_texture_full:
+ * @context: The #GoclContext to create the image in
+ * @flags: An OR'ed combination of values from #GoclBufferFlags
+ * @target: The GL texture target, like GL_TEXTURE_3D or GL_TEXTURE_2D_ARRAY
+ * @mip_level: The mipmap level of the texture to share
+ * @texture: The GL texture handle
+ *
+ * Creates a new image buffer from a level of a GL texture. The type, size
+ * and format of the image are those of the texture level; a cube map face
+ * is selected by passing its own target. This only works if the OpenCL
+ * platform supports the <i>cl_khr_gl_sharing</i> extension, and the @context
+ * has been created for sharing with OpenGL, using gocl_context_gpu_new_sync().
+ * Targets other than GL_TEXTURE_2D and GL_TEXTURE_3D need OpenCL 1.2.
+ *
+ * Returns: (transfer full): A newly created #GoclImage, or %NULL on error
+ **/
+GoclImage *
+gocl_image_new_from_gl_texture_full (GoclContext *context,
+                                     guint        flags,
+                                     guint        target,
+                                     gint         mip_level,
+                                     guint        texture)
 {
   GError **error;
 
   g_return_val_if_fail (GOCL_IS_CONTEXT (context), NULL);
   g_return_val_if_fail (texture > 0, NULL);
+  g_return_val_if_fail (mip_level >= 0, NULL);
 
   error = gocl_error_prepare ();
 
@@ -451,6 +804,8 @@ gocl_image_new_from_gl_texture (GoclContext *context,
                          "context", context,
                          "flags", flags,
                          "gl-texture", texture,
+                         "gl-target", target,
+                         "gl-mip-level", mip_level,
                          NULL);
 }
 
@@ -475,13 +830,470 @@ gocl_image_new_from_cogl_texture (GoclContext *context,
                                   CoglTexture *texture)
 {
   guint gl_tex;
+  guint gl_target;
 
   g_return_val_if_fail (GOCL_IS_CONTEXT (context), NULL);
   g_return_val_if_fail (texture != NULL, NULL);
 
-  cogl_texture_get_gl_texture (texture, &gl_tex, NULL);
+  cogl_texture_get_gl_texture (texture, &gl_tex, &gl_target);
 
-  return gocl_image_new_from_gl_texture (context, flags, gl_tex);
+  return gocl_image_new_from_gl_texture_full (context,
+                                              flags,
+                                              gl_target,
+                                              0,
+                                              gl_tex);
 }
 
 #endif
+
+/**
+ * gocl_image_read_region_sync:
+ * @self: The #GoclImage
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @target_ptr: (element-type guint8): The pointer to copy the data to
+ * @origin: (array fixed-size=3): The (x, y, z) offset in pixels of the
+ * region to read
+ * @region: (array fixed-size=3): The (width, height, depth) in pixels of
+ * the region to read
+ * @row_pitch: The length in bytes of each row in @target_ptr, or 0
+ * @slice_pitch: The size in bytes of each 2D slice in @target_ptr, or 0
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List or
+ * #GoclEvent object to wait for, or %NULL
+ *
+ * Reads a rectangular region of the image into the host memory referenced
+ * by @target_ptr. The operation is enqueued in @queue, and the program
+ * execution blocks until the read finishes.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_image_read_region_sync (GoclImage   *self,
+                             GoclQueue   *queue,
+                             gpointer     target_ptr,
+                             const gsize *origin,
+                             const gsize *region,
+                             gsize        row_pitch,
+                             gsize        slice_pitch,
+                             GList       *event_wait_list)
+{
+  cl_int err_code;
+
+  g_return_val_if_fail (GOCL_IS_IMAGE (self), FALSE);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), FALSE);
+  g_return_val_if_fail (target_ptr != NULL, FALSE);
+  g_return_val_if_fail (origin != NULL && region != NULL, FALSE);
+
+  err_code = enqueue_region (self,
+                             queue,
+                             FALSE,
+                             TRUE,
+                             target_ptr,
+                             origin,
+                             region,
+                             row_pitch,
+                             slice_pitch,
+                             event_wait_list,
+                             NULL);
+
+  return ! gocl_error_check_opencl_internal (err_code);
+}
+
+/**
+ * gocl_image_read_region:
+ * @self: The #GoclImage
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @target_ptr: (element-type guint8): The pointer to copy the data to
+ * @origin: (array fixed-size=3): The (x, y, z) offset in pixels of the
+ * region to read
+ * @region: (array fixed-size=3): The (width, height, depth) in pixels of
+ * the region to read
+ * @row_pitch: The length in bytes of each row in @target_ptr, or 0
+ * @slice_pitch: The size in bytes of each 2D slice in @target_ptr, or 0
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List or
+ * #GoclEvent object to wait for, or %NULL
+ *
+ * Asynchronously reads a rectangular region of the image into the host
+ * memory referenced by @target_ptr. The operation is enqueued in @queue,
+ * and the program execution continues without blocking. The memory pointed
+ * by @target_ptr must remain valid until the returned event resolves.
+ *
+ * Returns: (transfer none): A #GoclEvent to get notified when the read
+ * operation finishes
+ **/
+GoclEvent *
+gocl_image_read_region (GoclImage   *self,
+                        GoclQueue   *queue,
+                        gpointer     target_ptr,
+                        const gsize *origin,
+                        const gsize *region,
+                        gsize        row_pitch,
+                        gsize        slice_pitch,
+                        GList       *event_wait_list)
+{
+  cl_int err_code;
+  cl_event event;
+
+  g_return_val_if_fail (GOCL_IS_IMAGE (self), NULL);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), NULL);
+  g_return_val_if_fail (target_ptr != NULL, NULL);
+  g_return_val_if_fail (origin != NULL && region != NULL, NULL);
+
+  err_code = enqueue_region (self,
+                             queue,
+                             FALSE,
+                             FALSE,
+                             target_ptr,
+                             origin,
+                             region,
+                             row_pitch,
+                             slice_pitch,
+                             event_wait_list,
+                             &event);
+
+  return gocl_event_new_for_command (queue,
+                                     err_code,
+                                     event,
+                                     event_wait_list,
+                                     "image-read",
+                                     get_region_size (self, region, row_pitch, slice_pitch));
+}
+
+/**
+ * gocl_image_write_region_sync:
+ * @self: The #GoclImage
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @data: (element-type guint8): A pointer to the data to write
+ * @origin: (array fixed-size=3): The (x, y, z) offset in pixels of the
+ * region to write
+ * @region: (array fixed-size=3): The (width, height, depth) in pixels of
+ * the region to write
+ * @row_pitch: The length in bytes of each row in @data, or 0
+ * @slice_pitch: The size in bytes of each 2D slice in @data, or 0
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List or
+ * #GoclEvent object to wait for, or %NULL
+ *
+ * Writes the host memory referenced by @data into a rectangular region of
+ * the image. The operation is enqueued in @queue, and the program execution
+ * blocks until the write finishes.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_image_write_region_sync (GoclImage     *self,
+                              GoclQueue     *queue,
+                              gconstpointer  data,
+                              const gsize   *origin,
+                              const gsize   *region,
+                              gsize          row_pitch,
+                              gsize          slice_pitch,
+                              GList         *event_wait_list)
+{
+  cl_int err_code;
+
+  g_return_val_if_fail (GOCL_IS_IMAGE (self), FALSE);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), FALSE);
+  g_return_val_if_fail (data != NULL, FALSE);
+  g_return_val_if_fail (origin != NULL && region != NULL, FALSE);
+
+  err_code = enqueue_region (self,
+                             queue,
+                             TRUE,
+                             TRUE,
+                             (gpointer) data,
+                             origin,
+                             region,
+                             row_pitch,
+                             slice_pitch,
+                             event_wait_list,
+                             NULL);
+
+  return ! gocl_error_check_opencl_internal (err_code);
+}
+
+/**
+ * gocl_image_write_region:
+ * @self: The #GoclImage
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @data: (element-type guint8): A pointer to the data to write
+ * @origin: (array fixed-size=3): The (x, y, z) offset in pixels of the
+ * region to write
+ * @region: (array fixed-size=3): The (width, height, depth) in pixels of
+ * the region to write
+ * @row_pitch: The length in bytes of each row in @data, or 0
+ * @slice_pitch: The size in bytes of each 2D slice in @data, or 0
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List or
+ * #GoclEvent object to wait for, or %NULL
+ *
+ * Asynchronously writes the host memory referenced by @data into a
+ * rectangular region of the image. The operation is enqueued in @queue,
+ * and the program execution continues without blocking. The memory pointed
+ * by @data must remain valid until the returned event resolves.
+ *
+ * Returns: (transfer none): A #GoclEvent to get notified when the write
+ * operation finishes
+ **/
+GoclEvent *
+gocl_image_write_region (GoclImage     *self,
+                         GoclQueue     *queue,
+                         gconstpointer  data,
+                         const gsize   *origin,
+                         const gsize   *region,
+                         gsize          row_pitch,
+                         gsize          slice_pitch,
+                         GList         *event_wait_list)
+{
+  cl_int err_code;
+  cl_event event;
+
+  g_return_val_if_fail (GOCL_IS_IMAGE (self), NULL);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), NULL);
+  g_return_val_if_fail (data != NULL, NULL);
+  g_return_val_if_fail (origin != NULL && region != NULL, NULL);
+
+  err_code = enqueue_region (self,
+                             queue,
+                             TRUE,
+                             FALSE,
+                             (gpointer) data,
+                             origin,
+                             region,
+                             row_pitch,
+                             slice_pitch,
+                             event_wait_list,
+                             &event);
+
+  return gocl_event_new_for_command (queue,
+                                     err_code,
+                                     event,
+                                     event_wait_list,
+                                     "image-write",
+                                     get_region_size (self, region, row_pitch, slice_pitch));
+}
+
+/**
+ * gocl_image_copy:
+ * @self: The #GoclImage to copy from
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @target: The #GoclImage to copy to
+ * @src_origin: (array fixed-size=3): The (x, y, z) offset in pixels of the
+ * region in @self
+ * @dst_origin: (array fixed-size=3): The (x, y, z) offset in pixels of the
+ * region in @target
+ * @region: (array fixed-size=3): The (width, height, depth) in pixels of
+ * the region to copy
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List of
+ * #GoclEvent objects to wait for, or %NULL
+ *
+ * Asynchronously copies a rectangular region of pixels from @self into
+ * @target. Both images must have the same pixel format.
+ *
+ * Returns: (transfer none): A #GoclEvent to get notified when the copy
+ * operation finishes
+ **/
+GoclEvent *
+gocl_image_copy (GoclImage   *self,
+                 GoclQueue   *queue,
+                 GoclImage   *target,
+                 const gsize *src_origin,
+                 const gsize *dst_origin,
+                 const gsize *region,
+                 GList       *event_wait_list)
+{
+  cl_int err_code;
+  cl_event event;
+  GoclWaitList wait_list;
+
+  g_return_val_if_fail (GOCL_IS_IMAGE (self), NULL);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), NULL);
+  g_return_val_if_fail (GOCL_IS_IMAGE (target), NULL);
+  g_return_val_if_fail (src_origin != NULL && dst_origin != NULL, NULL);
+  g_return_val_if_fail (region != NULL, NULL);
+
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
+
+  err_code = clEnqueueCopyImage (gocl_queue_get_queue (queue),
+                                 gocl_buffer_get_buffer (GOCL_BUFFER (self)),
+                                 gocl_buffer_get_buffer (GOCL_BUFFER (target)),
+                                 src_origin,
+                                 dst_origin,
+                                 region,
+                                 wait_list.len,
+                                 wait_list.cl_events,
+                                 &event);
+  gocl_wait_list_clear (&wait_list);
+
+  return gocl_event_new_for_command (queue,
+                                     err_code,
+                                     event,
+                                     event_wait_list,
+                                     "image-copy",
+                                     get_region_size (self, region, 0, 0));
+}
+
+/**
+ * gocl_image_copy_to_buffer:
+ * @self: The #GoclImage to copy from
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @target: The #GoclBuffer to copy to
+ * @src_origin: (array fixed-size=3): The (x, y, z) offset in pixels of the
+ * region in @self
+ * @region: (array fixed-size=3): The (width, height, depth) in pixels of
+ * the region to copy
+ * @dst_offset: The offset inside @target where to start writing, in bytes
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List of
+ * #GoclEvent objects to wait for, or %NULL
+ *
+ * Asynchronously copies a rectangular region of pixels from @self into
+ * @target. Pixels are stored tightly packed in the buffer.
+ *
+ * Returns: (transfer none): A #GoclEvent to get notified when the copy
+ * operation finishes
+ **/
+GoclEvent *
+gocl_image_copy_to_buffer (GoclImage   *self,
+                           GoclQueue   *queue,
+                           GoclBuffer  *target,
+                           const gsize *src_origin,
+                           const gsize *region,
+                           goffset      dst_offset,
+                           GList       *event_wait_list)
+{
+  cl_int err_code;
+  cl_event event;
+  GoclWaitList wait_list;
+
+  g_return_val_if_fail (GOCL_IS_IMAGE (self), NULL);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), NULL);
+  g_return_val_if_fail (GOCL_IS_BUFFER (target), NULL);
+  g_return_val_if_fail (src_origin != NULL && region != NULL, NULL);
+
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
+
+  err_code = clEnqueueCopyImageToBuffer (gocl_queue_get_queue (queue),
+                                         gocl_buffer_get_buffer (GOCL_BUFFER (self)),
+                                         gocl_buffer_get_buffer (target),
+                                         src_origin,
+                                         region,
+                                         dst_offset,
+                                         wait_list.len,
+                                         wait_list.cl_events,
+                                         &event);
+  gocl_wait_list_clear (&wait_list);
+
+  return gocl_event_new_for_command (queue,
+                                     err_code,
+                                     event,
+                                     event_wait_list,
+                                     "image-to-buffer",
+                                     get_region_size (self, region, 0, 0));
+}
+
+/**
+ * gocl_image_copy_from_buffer:
+ * @self: The #GoclImage to copy to
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @source: The #GoclBuffer to copy from
+ * @src_offset: The offset inside @source where to start reading, in bytes
+ * @dst_origin: (array fixed-size=3): The (x, y, z) offset in pixels of the
+ * region in @self
+ * @region: (array fixed-size=3): The (width, height, depth) in pixels of
+ * the region to copy
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List of
+ * #GoclEvent objects to wait for, or %NULL
+ *
+ * Asynchronously copies tightly packed pixels from @source into a
+ * rectangular region of @self.
+ *
+ * Returns: (transfer none): A #GoclEvent to get notified when the copy
+ * operation finishes
+ **/
+GoclEvent *
+gocl_image_copy_from_buffer (GoclImage   *self,
+                             GoclQueue   *queue,
+                             GoclBuffer  *source,
+                             goffset      src_offset,
+                             const gsize *dst_origin,
+                             const gsize *region,
+                             GList       *event_wait_list)
+{
+  cl_int err_code;
+  cl_event event;
+  GoclWaitList wait_list;
+
+  g_return_val_if_fail (GOCL_IS_IMAGE (self), NULL);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), NULL);
+  g_return_val_if_fail (GOCL_IS_BUFFER (source), NULL);
+  g_return_val_if_fail (dst_origin != NULL && region != NULL, NULL);
+
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
+
+  err_code = clEnqueueCopyBufferToImage (gocl_queue_get_queue (queue),
+                                         gocl_buffer_get_buffer (source),
+                                         gocl_buffer_get_buffer (GOCL_BUFFER (self)),
+                                         src_offset,
+                                         dst_origin,
+                                         region,
+                                         wait_list.len,
+                                         wait_list.cl_events,
+                                         &event);
+  gocl_wait_list_clear (&wait_list);
+
+  return gocl_event_new_for_command (queue,
+                                     err_code,
+                                     event,
+                                     event_wait_list,
+                                     "buffer-to-image",
+                                     get_region_size (self, region, 0, 0));
+}
+
+/**
+ * gocl_image_get_channel_order:
+ * @self: The #GoclImage
+ *
+ * Obtains the channels of each pixel of the image. For images created from
+ * GL textures, this is the format chosen for the texture.
+ *
+ * Returns: A #GoclImageChannelOrder value
+ **/
+GoclImageChannelOrder
+gocl_image_get_channel_order (GoclImage *self)
+{
+  g_return_val_if_fail (GOCL_IS_IMAGE (self), 0);
+
+  return self->priv->format.image_channel_order;
+}
+
+/**
+ * gocl_image_get_channel_type:
+ * @self: The #GoclImage
+ *
+ * Obtains the data type of each channel of the image's pixels.
+ *
+ * Returns: A #GoclImageChannelType value
+ **/
+GoclImageChannelType
+gocl_image_get_channel_type (GoclImage *self)
+{
+  g_return_val_if_fail (GOCL_IS_IMAGE (self), 0);
+
+  return self->priv->format.image_channel_data_type;
+}
+
+/**
+ * gocl_image_get_element_size:
+ * @self: The #GoclImage
+ *
+ * Obtains the size of a single pixel of the image, as determined by its
+ * format. A tightly packed row of the image takes its width times this
+ * size, in bytes.
+ *
+ * Returns: The size of a pixel in bytes, or 0 if the image could not be
+ *   created
+ **/
+gsize
+gocl_image_get_element_size (GoclImage *self)
+{
+  g_return_val_if_fail (GOCL_IS_IMAGE (self), 0);
+
+  return self->priv->element_size;
+}
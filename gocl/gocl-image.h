@@ -27,6 +27,8 @@
 
 #include "gocl-decls.h"
 #include "gocl-buffer.h"
+#include "gocl-queue.h"
+#include "gocl-event.h"
 
 G_BEGIN_DECLS
 
@@ -55,6 +57,66 @@ struct _GoclImageClass
 
 GType                  gocl_image_get_type                   (void) G_GNUC_CONST;
 
+GoclImageChannelOrder  gocl_image_get_channel_order          (GoclImage *self);
+GoclImageChannelType   gocl_image_get_channel_type           (GoclImage *self);
+gsize                  gocl_image_get_element_size           (GoclImage *self);
+
+gboolean               gocl_image_read_region_sync           (GoclImage   *self,
+                                                              GoclQueue   *queue,
+                                                              gpointer     target_ptr,
+                                                              const gsize *origin,
+                                                              const gsize *region,
+                                                              gsize        row_pitch,
+                                                              gsize        slice_pitch,
+                                                              GList       *event_wait_list);
+GoclEvent *            gocl_image_read_region                (GoclImage   *self,
+                                                              GoclQueue   *queue,
+                                                              gpointer     target_ptr,
+                                                              const gsize *origin,
+                                                              const gsize *region,
+                                                              gsize        row_pitch,
+                                                              gsize        slice_pitch,
+                                                              GList       *event_wait_list);
+
+gboolean               gocl_image_write_region_sync          (GoclImage     *self,
+                                                              GoclQueue     *queue,
+                                                              gconstpointer  data,
+                                                              const gsize   *origin,
+                                                              const gsize   *region,
+                                                              gsize          row_pitch,
+                                                              gsize          slice_pitch,
+                                                              GList         *event_wait_list);
+GoclEvent *            gocl_image_write_region               (GoclImage     *self,
+                                                              GoclQueue     *queue,
+                                                              gconstpointer  data,
+                                                              const gsize   *origin,
+                                                              const gsize   *region,
+                                                              gsize          row_pitch,
+                                                              gsize          slice_pitch,
+                                                              GList         *event_wait_list);
+
+GoclEvent *            gocl_image_copy                       (GoclImage   *self,
+                                                              GoclQueue   *queue,
+                                                              GoclImage   *target,
+                                                              const gsize *src_origin,
+                                                              const gsize *dst_origin,
+                                                              const gsize *region,
+                                                              GList       *event_wait_list);
+GoclEvent *            gocl_image_copy_to_buffer             (GoclImage   *self,
+                                                              GoclQueue   *queue,
+                                                              GoclBuffer  *target,
+                                                              const gsize *src_origin,
+                                                              const gsize *region,
+                                                              goffset      dst_offset,
+                                                              GList       *event_wait_list);
+GoclEvent *            gocl_image_copy_from_buffer           (GoclImage   *self,
+                                                              GoclQueue   *queue,
+                                                              GoclBuffer  *source,
+                                                              goffset      src_offset,
+                                                              const gsize *dst_origin,
+                                                              const gsize *region,
+                                                              GList       *event_wait_list);
+
 G_END_DECLS
 
 #endif /* __GOCL_IMAGE_H__ */
@@ -41,9 +41,18 @@
  * Once all arguments are set, the kernel is ready to be executed on a device.
  * For this, the gocl_kernel_run_in_device() is used for non-blocking execution,
  * and gocl_kernel_run_in_device_sync() for a blocking version. Notice that
- * these methods will use the device's default command queue. In the future,
- * methods will be provided to run the kernel on arbitrary command queues
- * as well.
+ * these methods will use the device's default command queue. To run the kernel
+ * on any other command queue, gocl_kernel_run_in_queue() and
+ * gocl_kernel_run_in_queue_sync() are provided.
+ *
+ * A kernel keeps a copy of the last value set for each of its arguments, so
+ * setting an argument to the value it already has does not reach OpenCL at
+ * all. For kernels that are executed repeatedly with mostly the same
+ * arguments, see also #GoclLaunch.
+ *
+ * Kernel arguments are not safe to change from several threads. Threads that
+ * run the same kernel function concurrently should each use their own
+ * kernel, which gocl_kernel_clone() obtains cheaply from a configured one.
  **/
 
 /**
@@ -55,12 +64,17 @@
 
 #include <string.h>
 #include <gio/gio.h>
+#include <glib/gstdio.h>
 
 #include "gocl-kernel.h"
 
 #include "gocl-private.h"
 #include "gocl-program.h"
 
+/* local sizes benchmarked at most, and runs timed for each of them */
+#define MAX_TUNING_CANDIDATES 64
+#define TUNING_RUNS            3
+
 typedef gsize WorkSize[3];
 
 struct _GoclKernelPrivate
@@ -73,6 +87,12 @@ struct _GoclKernelPrivate
   WorkSize global_work_size;
   WorkSize local_work_size;
   guint8 work_dim;
+
+  /* shadow copy of the arguments last set on the cl_kernel */
+  GArray *args;
+
+  /* tuned local sizes, by device and global size class */
+  GHashTable *tuned_sizes;
 };
 
 /* properties */
@@ -149,15 +169,25 @@ gocl_kernel_initable_init (GInitable     *initable,
                            GError       **error)
 {
   GoclKernel *self = GOCL_KERNEL (initable);
-  cl_program program;
   cl_int err_code = 0;
+  cl_uint num_args = 0;
 
-  program = gocl_program_get_program (self->priv->program);
+  self->priv->kernel = gocl_program_create_kernel (self->priv->program,
+                                                  self->priv->name,
+                                                  &err_code);
+  if (gocl_error_check_opencl (err_code, error))
+    return FALSE;
 
-  self->priv->kernel = clCreateKernel (program, self->priv->name, &err_code);
+  err_code = clGetKernelInfo (self->priv->kernel,
+                              CL_KERNEL_NUM_ARGS,
+                              sizeof (cl_uint),
+                              &num_args,
+                              NULL);
   if (gocl_error_check_opencl (err_code, error))
     return FALSE;
 
+  g_array_set_size (self->priv->args, num_args);
+
   return TRUE;
 }
 
@@ -169,14 +199,28 @@ gocl_kernel_init (GoclKernel *self)
   self->priv = priv = GOCL_KERNEL_GET_PRIVATE (self);
 
   priv->work_dim = 1;
-  memset (&priv->global_work_size, 0, 3);
-  memset (&priv->local_work_size, 0, 3);
+  memset (&priv->global_work_size, 0, sizeof (WorkSize));
+  memset (&priv->local_work_size, 0, sizeof (WorkSize));
+
+  priv->args = g_array_new (FALSE, TRUE, sizeof (GoclKernelArg));
+
+  priv->tuned_sizes = g_hash_table_new_full (g_str_hash,
+                                             g_str_equal,
+                                             g_free,
+                                             g_free);
 }
 
 static void
 gocl_kernel_finalize (GObject *obj)
 {
   GoclKernel *self = GOCL_KERNEL (obj);
+  guint i;
+
+  for (i = 0; i < self->priv->args->len; i++)
+    gocl_kernel_arg_clear (&g_array_index (self->priv->args, GoclKernelArg, i));
+  g_array_free (self->priv->args, TRUE);
+
+  g_hash_table_unref (self->priv->tuned_sizes);
 
   g_free (self->priv->name);
 
@@ -239,6 +283,678 @@ get_property (GObject    *obj,
     }
 }
 
+static gsize
+round_up (gsize value, gsize multiple)
+{
+  return ((value + multiple - 1) / multiple) * multiple;
+}
+
+static gsize
+next_power_of_two (gsize value)
+{
+  gsize result = 1;
+
+  while (result < value)
+    result <<= 1;
+
+  return result;
+}
+
+/* global sizes are grouped by rounding each dimension up to a power of two,
+   so that one tuning result serves a range of similar problem sizes */
+static gchar *
+get_size_class (guint8 work_dim, const gsize *global_work_size)
+{
+  gsize class[3] = { 1, 1, 1 };
+  guint i;
+
+  for (i = 0; i < work_dim; i++)
+    class[i] = next_power_of_two (global_work_size[i]);
+
+  return g_strdup_printf ("%" G_GSIZE_FORMAT "x%" G_GSIZE_FORMAT "x%" G_GSIZE_FORMAT,
+                          class[0], class[1], class[2]);
+}
+
+static gboolean
+use_tuning_cache (GoclKernel *self)
+{
+  gboolean use_cache = FALSE;
+
+  g_object_get (self->priv->program, "use-binary-cache", &use_cache, NULL);
+
+  return use_cache;
+}
+
+static gboolean
+load_tuned_size (GoclKernel   *self,
+                 cl_device_id  device_id,
+                 const gchar  *size_class,
+                 gsize        *local_work_size)
+{
+  gchar *filename;
+  GKeyFile *key_file;
+  gint *values = NULL;
+  gsize len = 0;
+  guint i;
+
+  filename = gocl_program_get_tuning_filename (self->priv->program, device_id);
+  key_file = g_key_file_new ();
+
+  if (g_key_file_load_from_file (key_file, filename, G_KEY_FILE_NONE, NULL))
+    values = g_key_file_get_integer_list (key_file,
+                                          self->priv->name,
+                                          size_class,
+                                          &len,
+                                          NULL);
+
+  g_key_file_free (key_file);
+  g_free (filename);
+
+  if (values == NULL || len != 3)
+    {
+      g_free (values);
+      return FALSE;
+    }
+
+  for (i = 0; i < 3; i++)
+    local_work_size[i] = MAX (values[i], 0);
+  g_free (values);
+
+  return TRUE;
+}
+
+static void
+store_tuned_size (GoclKernel   *self,
+                  cl_device_id  device_id,
+                  const gchar  *size_class,
+                  const gsize  *local_work_size)
+{
+  gchar *filename;
+  gchar *dir;
+  GKeyFile *key_file;
+  gint values[3];
+  gchar *data;
+  gsize len = 0;
+  guint i;
+
+  filename = gocl_program_get_tuning_filename (self->priv->program, device_id);
+  key_file = g_key_file_new ();
+
+  /* keep the results of other kernels and size classes */
+  g_key_file_load_from_file (key_file, filename, G_KEY_FILE_NONE, NULL);
+
+  for (i = 0; i < 3; i++)
+    values[i] = local_work_size[i];
+  g_key_file_set_integer_list (key_file, self->priv->name, size_class, values, 3);
+
+  dir = g_path_get_dirname (filename);
+  g_mkdir_with_parents (dir, 0700);
+  g_free (dir);
+
+  /* like the binary cache, failing to write an entry is not an error */
+  data = g_key_file_to_data (key_file, &len, NULL);
+  g_file_set_contents (filename, data, len, NULL);
+
+  g_free (data);
+  g_key_file_free (key_file);
+  g_free (filename);
+}
+
+static void
+add_candidate (GArray       *candidates,
+               gsize         size1,
+               gsize         size2,
+               gsize         size3)
+{
+  WorkSize candidate;
+
+  candidate[0] = size1;
+  candidate[1] = size2;
+  candidate[2] = size3;
+
+  g_array_append_val (candidates, candidate);
+}
+
+static GArray *
+get_candidates (GoclKernel   *self,
+                cl_device_id  device_id,
+                cl_int       *err_code)
+{
+  GArray *candidates;
+  const GoclDeviceProps *props;
+  GoclDeviceProps own_props = { 0, };
+  gsize max_size;
+  gsize multiple = 1;
+  gsize limit[3] = { 1, 1, 1 };
+  gsize x, y, z;
+  guint i;
+
+  *err_code = clGetKernelWorkGroupInfo (self->priv->kernel,
+                                        device_id,
+                                        CL_KERNEL_WORK_GROUP_SIZE,
+                                        sizeof (gsize),
+                                        &max_size,
+                                        NULL);
+  if (*err_code != CL_SUCCESS)
+    return NULL;
+
+  /* not available before OpenCL 1.1, assume no preference then */
+  if (clGetKernelWorkGroupInfo (self->priv->kernel,
+                                device_id,
+                                CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE,
+                                sizeof (gsize),
+                                &multiple,
+                                NULL) != CL_SUCCESS || multiple == 0)
+    {
+      multiple = 1;
+    }
+
+  props = gocl_context_get_device_props (gocl_program_get_context (self->priv->program),
+                                         device_id);
+  if (props == NULL)
+    {
+      *err_code = gocl_device_props_query (&own_props, device_id);
+      if (*err_code != CL_SUCCESS)
+        {
+          gocl_device_props_clear (&own_props);
+          return NULL;
+        }
+      props = &own_props;
+    }
+
+  /* no dimension needs to be larger than its padded global size */
+  for (i = 0; i < self->priv->work_dim; i++)
+    limit[i] = MIN (MIN (max_size, props->max_work_item_sizes[i]),
+                    next_power_of_two (self->priv->global_work_size[i]));
+
+  gocl_device_props_clear (&own_props);
+
+  candidates = g_array_new (FALSE, FALSE, sizeof (WorkSize));
+
+  /* letting the implementation choose is always a candidate */
+  add_candidate (candidates, 0, 0, 0);
+
+  /* powers of two, plus multiples of the preferred multiple when it is not
+     one itself, whose total is a multiple of the preferred multiple */
+  for (x = 1; x <= limit[0]; x = (x < multiple && x * 2 > multiple) ? multiple : x * 2)
+    for (y = 1; y <= limit[1]; y *= 2)
+      for (z = 1; z <= limit[2]; z *= 2)
+        {
+          gsize total = x * y * z;
+
+          if (total > max_size)
+            break;
+
+          if (total % multiple != 0 && total < max_size)
+            continue;
+
+          if (candidates->len < MAX_TUNING_CANDIDATES)
+            add_candidate (candidates, x, y, z);
+        }
+
+  *err_code = CL_SUCCESS;
+
+  return candidates;
+}
+
+static cl_int
+time_launch (GoclKernel       *self,
+             cl_command_queue  queue,
+             const gsize      *local_work_size,
+             guint64          *elapsed)
+{
+  WorkSize global_work_size;
+  cl_event event;
+  cl_ulong start = 0;
+  cl_ulong end = 0;
+  gint64 enqueue_time;
+  cl_int err_code;
+  guint i;
+
+  for (i = 0; i < 3; i++)
+    global_work_size[i] = local_work_size[0] == 0 ?
+      self->priv->global_work_size[i] :
+      round_up (self->priv->global_work_size[i], local_work_size[i]);
+
+  enqueue_time = g_get_monotonic_time ();
+
+  err_code = clEnqueueNDRangeKernel (queue,
+                                     self->priv->kernel,
+                                     self->priv->work_dim,
+                                     NULL,
+                                     global_work_size,
+                                     local_work_size[0] == 0 ?
+                                       NULL : local_work_size,
+                                     0,
+                                     NULL,
+                                     &event);
+  if (err_code != CL_SUCCESS)
+    return err_code;
+
+  err_code = clWaitForEvents (1, &event);
+  if (err_code == CL_SUCCESS)
+    {
+      /* profiling is only available on queues created for it */
+      if (clGetEventProfilingInfo (event,
+                                   CL_PROFILING_COMMAND_START,
+                                   sizeof (cl_ulong),
+                                   &start,
+                                   NULL) == CL_SUCCESS &&
+          clGetEventProfilingInfo (event,
+                                   CL_PROFILING_COMMAND_END,
+                                   sizeof (cl_ulong),
+                                   &end,
+                                   NULL) == CL_SUCCESS &&
+          end > start)
+        {
+          *elapsed = end - start;
+        }
+      else
+        {
+          *elapsed = (g_get_monotonic_time () - enqueue_time) * 1000;
+        }
+    }
+
+  clReleaseEvent (event);
+
+  return err_code;
+}
+
+static cl_int
+benchmark_candidates (GoclKernel       *self,
+                      cl_command_queue  queue,
+                      GArray           *candidates,
+                      gsize            *best)
+{
+  guint64 best_time = G_MAXUINT64;
+  cl_int err_code = CL_SUCCESS;
+  guint i, j;
+
+  for (i = 0; i < candidates->len; i++)
+    {
+      gsize *candidate = g_array_index (candidates, WorkSize, i);
+      guint64 candidate_time = G_MAXUINT64;
+
+      /* the fastest of a few runs discards warm-up effects */
+      for (j = 0; j < TUNING_RUNS; j++)
+        {
+          guint64 elapsed = 0;
+
+          err_code = time_launch (self, queue, candidate, &elapsed);
+          if (err_code != CL_SUCCESS)
+            break;
+
+          candidate_time = MIN (candidate_time, elapsed);
+        }
+
+      /* sizes the kernel cannot be launched with are just skipped */
+      if (err_code != CL_SUCCESS)
+        continue;
+
+      if (candidate_time < best_time)
+        {
+          best_time = candidate_time;
+          memcpy (best, candidate, sizeof (WorkSize));
+        }
+    }
+
+  if (best_time == G_MAXUINT64)
+    return err_code != CL_SUCCESS ? err_code : CL_INVALID_WORK_GROUP_SIZE;
+
+  return CL_SUCCESS;
+}
+
+static cl_int
+enqueue_in_queue (GoclKernel         *self,
+                  GoclQueue          *queue,
+                  const GoclWaitList *wait_list,
+                  cl_event           *event)
+{
+  cl_command_queue cl_queue;
+  GArray *merged = NULL;
+  cl_event *events = wait_list->cl_events;
+  guint num_events = wait_list->len;
+  cl_int err_code;
+
+  cl_queue = gocl_queue_get_queue (queue);
+
+  /* managed buffers send their host changes first */
+  err_code = gocl_kernel_args_upload_managed (self->priv->args,
+                                              cl_queue,
+                                              wait_list->cl_events,
+                                              wait_list->len,
+                                              &merged);
+  if (err_code != CL_SUCCESS)
+    return err_code;
+
+  if (merged != NULL)
+    {
+      num_events = merged->len;
+      events = num_events > 0 ? (cl_event *) merged->data : NULL;
+    }
+
+  err_code = clEnqueueNDRangeKernel (cl_queue,
+                                     self->priv->kernel,
+                                     self->priv->work_dim,
+                                     NULL,
+                                     self->priv->global_work_size[0] == 0 ?
+                                       NULL : (gsize *) &self->priv->global_work_size,
+                                     self->priv->local_work_size[0] == 0 ?
+                                       NULL : (gsize *) &self->priv->local_work_size,
+                                     num_events,
+                                     events,
+                                     event);
+
+  gocl_kernel_args_complete_managed (self->priv->args,
+                                     merged,
+                                     wait_list->len,
+                                     event,
+                                     err_code == CL_SUCCESS ? 1 : 0);
+
+  return err_code;
+}
+
+static gboolean
+run_in_queue_sync (GoclKernel          *self,
+                   GoclQueue           *queue,
+                   const GoclWaitList  *wait_list,
+                   GError             **error)
+{
+  cl_int err_code;
+  cl_event event;
+
+  err_code = enqueue_in_queue (self, queue, wait_list, &event);
+  if (gocl_error_check_opencl (err_code, error))
+    return FALSE;
+
+  clWaitForEvents (1, &event);
+  clReleaseEvent (event);
+
+  return TRUE;
+}
+
+static GoclEvent *
+run_in_queue (GoclKernel         *self,
+              GoclQueue          *queue,
+              const GoclWaitList *wait_list)
+{
+  GError *error = NULL;
+
+  cl_int err_code;
+  cl_event event;
+
+  GoclEvent *_event = NULL;
+  GoclEventResolverFunc resolver_func;
+
+  err_code = enqueue_in_queue (self, queue, wait_list, &event);
+
+  if (gocl_error_check_opencl (err_code, &error))
+    {
+      _event = g_object_new (GOCL_TYPE_EVENT,
+                             "queue", queue,
+                             NULL);
+      resolver_func = gocl_event_steal_resolver_func (_event);
+      resolver_func (_event, error);
+      g_error_free (error);
+    }
+  else
+    {
+      _event = g_object_new (GOCL_TYPE_EVENT,
+                             "queue", queue,
+                             "event", event,
+                             "label", self->priv->name,
+                             NULL);
+      gocl_event_set_wait_list (_event, wait_list);
+      gocl_event_steal_resolver_func (_event);
+    }
+
+  gocl_event_idle_unref (_event);
+
+  return _event;
+}
+
+/* internal */
+
+gboolean
+gocl_kernel_arg_equals (const GoclKernelArg *arg,
+                        gsize                size,
+                        gconstpointer        value)
+{
+  if (! arg->is_set || arg->size != size)
+    return FALSE;
+
+  /* a NULL value is used for __local arguments, where only size matters */
+  if (value == NULL || arg->value == NULL)
+    return value == arg->value;
+
+  return memcmp (arg->value, value, size) == 0;
+}
+
+void
+gocl_kernel_arg_store (GoclKernelArg *arg,
+                       gsize          size,
+                       gconstpointer  value)
+{
+  if (value == NULL)
+    {
+      g_free (arg->value);
+      arg->value = NULL;
+    }
+  else
+    {
+      if (arg->value == NULL || arg->size != size)
+        arg->value = g_realloc (arg->value, size);
+      memcpy (arg->value, value, size);
+    }
+
+  arg->size = size;
+  arg->is_set = TRUE;
+  arg->is_svm = FALSE;
+  gocl_kernel_arg_set_managed_buffer (arg, NULL, FALSE);
+}
+
+void
+gocl_kernel_arg_clear (GoclKernelArg *arg)
+{
+  g_free (arg->value);
+  arg->value = NULL;
+  arg->size = 0;
+  arg->is_set = FALSE;
+  arg->is_svm = FALSE;
+  gocl_kernel_arg_set_managed_buffer (arg, NULL, FALSE);
+}
+
+void
+gocl_kernel_arg_set_managed_buffer (GoclKernelArg *arg,
+                                    GoclBuffer    *buffer,
+                                    gboolean       read_only)
+{
+  if (buffer != NULL)
+    g_object_ref (buffer);
+  if (arg->managed_buffer != NULL)
+    g_object_unref (arg->managed_buffer);
+
+  arg->managed_buffer = buffer;
+  arg->managed_read_only = read_only;
+}
+
+cl_int
+gocl_kernel_args_upload_managed (GArray           *args,
+                                 cl_command_queue  queue,
+                                 const cl_event   *event_wait_list,
+                                 guint             event_wait_list_len,
+                                 GArray          **merged_wait_list)
+{
+  GArray *merged = NULL;
+  cl_int err_code = CL_SUCCESS;
+  guint i;
+
+  *merged_wait_list = NULL;
+
+  for (i = 0; i < args->len; i++)
+    {
+      GoclKernelArg *arg = &g_array_index (args, GoclKernelArg, i);
+
+      if (arg->managed_buffer == NULL)
+        continue;
+
+      if (merged == NULL)
+        {
+          merged = g_array_new (FALSE, FALSE, sizeof (cl_event));
+          g_array_append_vals (merged, event_wait_list, event_wait_list_len);
+        }
+
+      /* the kernel waits for the transfers, even on out-of-order queues */
+      err_code = gocl_buffer_upload_managed (arg->managed_buffer, queue, merged);
+      if (err_code != CL_SUCCESS)
+        break;
+    }
+
+  if (err_code != CL_SUCCESS)
+    gocl_kernel_args_complete_managed (args,
+                                       merged,
+                                       event_wait_list_len,
+                                       NULL,
+                                       0);
+  else
+    *merged_wait_list = merged;
+
+  return err_code;
+}
+
+void
+gocl_kernel_args_complete_managed (GArray         *args,
+                                   GArray         *merged_wait_list,
+                                   guint           event_wait_list_len,
+                                   const cl_event *events,
+                                   guint           num_events)
+{
+  guint i;
+
+  if (merged_wait_list == NULL)
+    return;
+
+  for (i = 0; i < args->len && num_events > 0; i++)
+    {
+      GoclKernelArg *arg = &g_array_index (args, GoclKernelArg, i);
+
+      if (arg->managed_buffer != NULL)
+        gocl_buffer_complete_managed (arg->managed_buffer,
+                                      events,
+                                      num_events,
+                                      ! arg->managed_read_only);
+    }
+
+  /* the events of the caller's wait list are only borrowed */
+  for (i = event_wait_list_len; i < merged_wait_list->len; i++)
+    clReleaseEvent (g_array_index (merged_wait_list, cl_event, i));
+  g_array_free (merged_wait_list, TRUE);
+}
+
+gboolean
+gocl_kernel_is_argument_const (GoclKernel *self, guint index)
+{
+#ifdef CL_VERSION_1_2
+  cl_kernel_arg_type_qualifier qualifier = 0;
+
+  /* argument info may be missing for programs built from binaries */
+  if (clGetKernelArgInfo (self->priv->kernel,
+                          index,
+                          CL_KERNEL_ARG_TYPE_QUALIFIER,
+                          sizeof (cl_kernel_arg_type_qualifier),
+                          &qualifier,
+                          NULL) == CL_SUCCESS)
+    return (qualifier & CL_KERNEL_ARG_TYPE_CONST) != 0;
+#endif
+
+  return FALSE;
+}
+
+cl_int
+gocl_kernel_set_argument_internal (GoclKernel    *self,
+                                   guint          index,
+                                   gsize          size,
+                                   gconstpointer  value)
+{
+  cl_int err_code;
+  GoclKernelArg *arg = NULL;
+
+  /* an out of range index is left for OpenCL to report */
+  if (index < self->priv->args->len)
+    {
+      arg = &g_array_index (self->priv->args, GoclKernelArg, index);
+      if (! arg->is_svm && gocl_kernel_arg_equals (arg, size, value))
+        return CL_SUCCESS;
+    }
+
+  err_code = clSetKernelArg (self->priv->kernel, index, size, value);
+
+  if (arg != NULL)
+    {
+      if (err_code == CL_SUCCESS)
+        gocl_kernel_arg_store (arg, size, value);
+      else
+        gocl_kernel_arg_clear (arg);
+    }
+
+  return err_code;
+}
+
+cl_int
+gocl_kernel_set_argument_svm_internal (GoclKernel    *self,
+                                       guint          index,
+                                       gconstpointer  svm_ptr)
+{
+  cl_int err_code;
+  GoclKernelArg *arg = NULL;
+
+  if (index < self->priv->args->len)
+    {
+      arg = &g_array_index (self->priv->args, GoclKernelArg, index);
+      if (arg->is_svm &&
+          gocl_kernel_arg_equals (arg, sizeof (gpointer), &svm_ptr))
+        return CL_SUCCESS;
+    }
+
+#ifdef CL_VERSION_2_0
+  err_code = clSetKernelArgSVMPointer (self->priv->kernel, index, svm_ptr);
+#else
+  err_code = CL_INVALID_OPERATION;
+#endif
+
+  if (arg != NULL)
+    {
+      if (err_code == CL_SUCCESS)
+        {
+          gocl_kernel_arg_store (arg, sizeof (gpointer), &svm_ptr);
+          arg->is_svm = TRUE;
+        }
+      else
+        {
+          gocl_kernel_arg_clear (arg);
+        }
+    }
+
+  return err_code;
+}
+
+GArray *
+gocl_kernel_get_arguments (GoclKernel *self)
+{
+  return self->priv->args;
+}
+
+void
+gocl_kernel_get_work_size (GoclKernel *self,
+                           guint8     *work_dim,
+                           gsize      *global_work_size,
+                           gsize      *local_work_size)
+{
+  *work_dim = self->priv->work_dim;
+  memcpy (global_work_size, self->priv->global_work_size, sizeof (WorkSize));
+  memcpy (local_work_size, self->priv->local_work_size, sizeof (WorkSize));
+}
+
 /* public */
 
 /**
@@ -258,6 +974,89 @@ gocl_kernel_get_kernel (GoclKernel *self)
   return self->priv->kernel;
 }
 
+/**
+ * gocl_kernel_clone:
+ * @self: The #GoclKernel
+ *
+ * Creates a new kernel for the same kernel function as @self, with the same
+ * argument values, work sizes and tuned local sizes. Since the arguments of
+ * a kernel cannot be changed safely from several threads, this is the cheap
+ * way for each worker thread to get a kernel of its own, without looking it
+ * up by name again. The clone and @self are independent afterwards.
+ * Upon error, %NULL is returned.
+ *
+ * Returns: (transfer full): A newly created #GoclKernel, or %NULL on error
+ **/
+GoclKernel *
+gocl_kernel_clone (GoclKernel *self)
+{
+  GoclKernel *clone;
+  GHashTableIter iter;
+  gpointer key;
+  gpointer value;
+  cl_int err_code = CL_SUCCESS;
+  guint i;
+
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), NULL);
+
+  clone = g_initable_new (GOCL_TYPE_KERNEL,
+                          NULL,
+                          gocl_error_prepare (),
+                          "program", self->priv->program,
+                          "name", self->priv->name,
+                          NULL);
+  if (clone == NULL)
+    return NULL;
+
+  for (i = 0; i < self->priv->args->len && err_code == CL_SUCCESS; i++)
+    {
+      GoclKernelArg *arg;
+
+      arg = &g_array_index (self->priv->args, GoclKernelArg, i);
+      if (! arg->is_set)
+        continue;
+
+      if (arg->is_svm)
+        err_code = gocl_kernel_set_argument_svm_internal (clone,
+                                                          i,
+                                                          *(gpointer *) arg->value);
+      else
+        err_code = gocl_kernel_set_argument_internal (clone,
+                                                      i,
+                                                      arg->size,
+                                                      arg->value);
+
+      if (err_code == CL_SUCCESS && arg->managed_buffer != NULL)
+        gocl_kernel_arg_set_managed_buffer (&g_array_index (clone->priv->args,
+                                                            GoclKernelArg,
+                                                            i),
+                                            arg->managed_buffer,
+                                            arg->managed_read_only);
+    }
+
+  if (gocl_error_check_opencl_internal (err_code))
+    {
+      g_object_unref (clone);
+      return NULL;
+    }
+
+  clone->priv->work_dim = self->priv->work_dim;
+  memcpy (clone->priv->global_work_size,
+          self->priv->global_work_size,
+          sizeof (WorkSize));
+  memcpy (clone->priv->local_work_size,
+          self->priv->local_work_size,
+          sizeof (WorkSize));
+
+  g_hash_table_iter_init (&iter, self->priv->tuned_sizes);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    g_hash_table_insert (clone->priv->tuned_sizes,
+                         g_strdup (key),
+                         g_memdup (value, sizeof (WorkSize)));
+
+  return clone;
+}
+
 /**
  * gocl_kernel_set_argument:
  * @self: The #GoclKernel
@@ -266,7 +1065,7 @@ gocl_kernel_get_kernel (GoclKernel *self)
  * @buffer: A pointer to an arbitrary block of memory
  *
  * Sets the value of the kernel argument at @index, as an arbitrary block of
- * memory.
+ * memory. If the argument already holds the same value, the call is a no-op.
  *
  * Returns: %TRUE on success, %FALSE on error
  **/
@@ -275,17 +1074,41 @@ gocl_kernel_set_argument (GoclKernel      *self,
                           guint            index,
                           gsize            size,
                           const gpointer  *buffer)
+{
+  return gocl_kernel_set_argument_full (self,
+                                        index,
+                                        size,
+                                        buffer,
+                                        gocl_error_prepare ());
+}
+
+/**
+ * gocl_kernel_set_argument_full:
+ * @self: The #GoclKernel
+ * @index: The index of this argument in the kernel function
+ * @size: The size of @buffer, in bytes
+ * @buffer: A pointer to an arbitrary block of memory
+ * @error: (allow-none): Return location for a #GError, or %NULL
+ *
+ * Like gocl_kernel_set_argument(), but reports a failure in @error instead of
+ * the last error of the calling thread.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_kernel_set_argument_full (GoclKernel      *self,
+                               guint            index,
+                               gsize            size,
+                               const gpointer  *buffer,
+                               GError         **error)
 {
   cl_int err_code;
 
   g_return_val_if_fail (GOCL_IS_KERNEL (self), FALSE);
 
-  err_code = clSetKernelArg (self->priv->kernel,
-                             index,
-                             size,
-                             buffer);
+  err_code = gocl_kernel_set_argument_internal (self, index, size, buffer);
 
-  return ! gocl_error_check_opencl_internal (err_code);
+  return ! gocl_error_check_opencl (err_code, error);
 }
 
 /**
@@ -342,7 +1165,11 @@ gocl_kernel_set_argument_float (GoclKernel  *self,
  * @index: The index of this argument in the kernel function
  * @buffer: A #GoclBuffer
  *
- * Sets the value of the kernel argument at @index, as a buffer object.
+ * Sets the value of the kernel argument at @index, as a buffer object. If
+ * @buffer is managed, see gocl_buffer_new_managed(), the kernel keeps a
+ * reference to it, sends its host changes to the device before each run, and
+ * unless the argument is declared <i>const</i>, marks its host copy stale
+ * afterwards.
  *
  * Returns: %TRUE on success, %FALSE on error
  **/
@@ -351,21 +1178,249 @@ gocl_kernel_set_argument_buffer (GoclKernel  *self,
                                  guint        index,
                                  GoclBuffer  *buffer)
 {
-  cl_int err_code;
   cl_mem buf;
 
   g_return_val_if_fail (GOCL_IS_KERNEL (self), FALSE);
 
   buf = gocl_buffer_get_buffer (buffer);
 
-  err_code = clSetKernelArg (self->priv->kernel,
-                             index,
-                             sizeof (cl_mem),
-                             &buf);
+  if (! gocl_kernel_set_argument (self,
+                                  index,
+                                  sizeof (cl_mem),
+                                  (const gpointer) &buf))
+    return FALSE;
+
+  if (gocl_buffer_is_managed (buffer) && index < self->priv->args->len)
+    gocl_kernel_arg_set_managed_buffer (&g_array_index (self->priv->args,
+                                                        GoclKernelArg,
+                                                        index),
+                                        buffer,
+                                        gocl_kernel_is_argument_const (self,
+                                                                       index));
+
+  return TRUE;
+}
+
+/**
+ * gocl_kernel_set_argument_svm_buffer:
+ * @self: The #GoclKernel
+ * @index: The index of this argument in the kernel function
+ * @buffer: A #GoclSvmBuffer
+ *
+ * Sets the value of the kernel argument at @index, as a pointer to the
+ * start of a shared virtual memory buffer. If @buffer fell back to a regular
+ * buffer because the devices lack SVM support, it is set as a buffer object
+ * instead, like gocl_kernel_set_argument_buffer() does.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_kernel_set_argument_svm_buffer (GoclKernel     *self,
+                                     guint           index,
+                                     GoclSvmBuffer  *buffer)
+{
+  gpointer svm_ptr;
+
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), FALSE);
+  g_return_val_if_fail (GOCL_IS_SVM_BUFFER (buffer), FALSE);
+
+  svm_ptr = gocl_svm_buffer_get_svm_pointer (buffer);
+  if (svm_ptr == NULL)
+    return gocl_kernel_set_argument_buffer (self, index, GOCL_BUFFER (buffer));
+
+  return gocl_kernel_set_argument_svm_pointer (self, index, svm_ptr);
+}
+
+/**
+ * gocl_kernel_set_argument_svm_pointer:
+ * @self: The #GoclKernel
+ * @index: The index of this argument in the kernel function
+ * @svm_ptr: An address inside a #GoclSvmBuffer
+ *
+ * Sets the value of the kernel argument at @index, as a pointer to any
+ * address inside a shared virtual memory buffer, like a node of a tree built
+ * on the host. See gocl_svm_buffer_get_svm_pointer().
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_kernel_set_argument_svm_pointer (GoclKernel *self,
+                                      guint       index,
+                                      gpointer    svm_ptr)
+{
+  cl_int err_code;
+
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), FALSE);
+
+  err_code = gocl_kernel_set_argument_svm_internal (self, index, svm_ptr);
 
   return ! gocl_error_check_opencl_internal (err_code);
 }
 
+/**
+ * gocl_kernel_run_in_queue_sync:
+ * @self: The #GoclKernel
+ * @queue: A #GoclQueue to enqueue the kernel in
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List of #GoclEvent
+ * events to wait for, or %NULL
+ *
+ * Runs the kernel on the device of @queue, by enqueuing it in @queue, and
+ * blocks the program until the kernel execution finishes. For non-blocking
+ * version, gocl_kernel_run_in_queue() is provided.
+ *
+ * If @event_wait_list is provided, the kernel execution will start
+ * only when all the events in the list have triggered.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_kernel_run_in_queue_sync (GoclKernel  *self,
+                               GoclQueue   *queue,
+                               GList       *event_wait_list)
+{
+  return gocl_kernel_run_in_queue_sync_full (self,
+                                             queue,
+                                             event_wait_list,
+                                             gocl_error_prepare ());
+}
+
+/**
+ * gocl_kernel_run_in_queue_sync_full:
+ * @self: The #GoclKernel
+ * @queue: A #GoclQueue to enqueue the kernel in
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List of #GoclEvent
+ * events to wait for, or %NULL
+ * @error: (allow-none): Return location for a #GError, or %NULL
+ *
+ * Like gocl_kernel_run_in_queue_sync(), but reports a failure in @error
+ * instead of the last error of the calling thread.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_kernel_run_in_queue_sync_full (GoclKernel  *self,
+                                    GoclQueue   *queue,
+                                    GList       *event_wait_list,
+                                    GError     **error)
+{
+  GoclWaitList wait_list;
+  gboolean result;
+
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), FALSE);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), FALSE);
+
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
+  result = run_in_queue_sync (self, queue, &wait_list, error);
+  gocl_wait_list_clear (&wait_list);
+
+  return result;
+}
+
+/**
+ * gocl_kernel_run_in_queue:
+ * @self: The #GoclKernel
+ * @queue: A #GoclQueue to enqueue the kernel in
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List of #GoclEvent
+ * events to wait for, or %NULL
+ *
+ * Runs the kernel on the device of @queue, asynchronously, by enqueuing it
+ * in @queue. A #GoclEvent is returned, and can be used to get notified when
+ * the execution finishes, or as wait event input to other operations,
+ * possibly on other queues.
+ *
+ * If @event_wait_list is provided, the kernel execution will start
+ * only when all the events in the list have triggered.
+ *
+ * Returns: (transfer none): A #GoclEvent to get notified when execution
+ * finishes
+ **/
+GoclEvent *
+gocl_kernel_run_in_queue (GoclKernel *self,
+                          GoclQueue  *queue,
+                          GList      *event_wait_list)
+{
+  GoclWaitList wait_list;
+  GoclEvent *event;
+
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), NULL);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), NULL);
+
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
+  event = run_in_queue (self, queue, &wait_list);
+  gocl_wait_list_clear (&wait_list);
+
+  return event;
+}
+
+/**
+ * gocl_kernel_run_in_queue_sync_with_events:
+ * @self: The #GoclKernel
+ * @queue: A #GoclQueue to enqueue the kernel in
+ * @event_wait_list: (array length=event_wait_list_len) (allow-none): Array
+ * of #GoclEvent events to wait for, or %NULL
+ * @event_wait_list_len: The number of events in @event_wait_list
+ *
+ * Like gocl_kernel_run_in_queue_sync(), but takes the events to wait for as
+ * a C array, such as the pdata member of a #GPtrArray. For up to four
+ * events, no memory is allocated for the wait list.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_kernel_run_in_queue_sync_with_events (GoclKernel  *self,
+                                           GoclQueue   *queue,
+                                           GoclEvent  **event_wait_list,
+                                           guint        event_wait_list_len)
+{
+  GoclWaitList wait_list;
+  gboolean result;
+
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), FALSE);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), FALSE);
+  g_return_val_if_fail (event_wait_list != NULL || event_wait_list_len == 0, FALSE);
+
+  gocl_wait_list_init (&wait_list, event_wait_list, event_wait_list_len);
+  result = run_in_queue_sync (self, queue, &wait_list, gocl_error_prepare ());
+  gocl_wait_list_clear (&wait_list);
+
+  return result;
+}
+
+/**
+ * gocl_kernel_run_in_queue_with_events:
+ * @self: The #GoclKernel
+ * @queue: A #GoclQueue to enqueue the kernel in
+ * @event_wait_list: (array length=event_wait_list_len) (allow-none): Array
+ * of #GoclEvent events to wait for, or %NULL
+ * @event_wait_list_len: The number of events in @event_wait_list
+ *
+ * Like gocl_kernel_run_in_queue(), but takes the events to wait for as a C
+ * array, such as the pdata member of a #GPtrArray. For up to four events,
+ * no memory is allocated for the wait list.
+ *
+ * Returns: (transfer none): A #GoclEvent to get notified when execution
+ * finishes
+ **/
+GoclEvent *
+gocl_kernel_run_in_queue_with_events (GoclKernel  *self,
+                                      GoclQueue   *queue,
+                                      GoclEvent  **event_wait_list,
+                                      guint        event_wait_list_len)
+{
+  GoclWaitList wait_list;
+  GoclEvent *event;
+
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), NULL);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), NULL);
+  g_return_val_if_fail (event_wait_list != NULL || event_wait_list_len == 0, NULL);
+
+  gocl_wait_list_init (&wait_list, event_wait_list, event_wait_list_len);
+  event = run_in_queue (self, queue, &wait_list);
+  gocl_wait_list_clear (&wait_list);
+
+  return event;
+}
+
 /**
  * gocl_kernel_run_in_device_sync:
  * @self: The #GoclKernel
@@ -375,7 +1430,9 @@ gocl_kernel_set_argument_buffer (GoclKernel  *self,
  *
  * Runs the kernel on the specified device, blocking the program
  * until the kernel execution finishes. For non-blocking version,
- * gocl_kernel_run_in_device() is provided.
+ * gocl_kernel_run_in_device() is provided. The kernel is enqueued in the
+ * device's default queue, see gocl_kernel_run_in_queue_sync() to use a
+ * different queue.
  *
  * If @event_wait_list is provided, the kernel execution will start
  * only when all the events in the list have triggered.
@@ -387,11 +1444,7 @@ gocl_kernel_run_in_device_sync (GoclKernel  *self,
                                 GoclDevice  *device,
                                 GList       *event_wait_list)
 {
-  cl_int err_code;
-  cl_event event;
   GoclQueue *queue;
-  cl_command_queue _queue;
-  cl_event *_event_wait_list = NULL;
 
   g_return_val_if_fail (GOCL_IS_KERNEL (self), FALSE);
   g_return_val_if_fail (GOCL_IS_DEVICE (device), FALSE);
@@ -400,31 +1453,7 @@ gocl_kernel_run_in_device_sync (GoclKernel  *self,
   if (queue == NULL)
     return FALSE;
 
-  _event_wait_list = gocl_event_list_to_array (event_wait_list, NULL);
-
-  _queue = gocl_queue_get_queue (queue);
-
-  err_code =
-    clEnqueueNDRangeKernel (_queue,
-                            self->priv->kernel,
-                            self->priv->work_dim,
-                            NULL,
-                            self->priv->global_work_size[0] == 0 ?
-                              NULL : (gsize *) &self->priv->global_work_size,
-                            self->priv->local_work_size[0] == 0 ?
-                              NULL : (gsize *) &self->priv->local_work_size,
-                            g_list_length (event_wait_list),
-                            _event_wait_list,
-                            &event);
-  g_free (_event_wait_list);
-
-  if (gocl_error_check_opencl_internal (err_code))
-    return FALSE;
-
-  clWaitForEvents (1, &event);
-  clReleaseEvent (event);
-
-  return TRUE;
+  return gocl_kernel_run_in_queue_sync (self, queue, event_wait_list);
 }
 
 /**
@@ -436,82 +1465,31 @@ gocl_kernel_run_in_device_sync (GoclKernel  *self,
  *
  * Runs the kernel on the specified device, asynchronously. A #GoclEvent
  * is returned, and can be used to get notified when the execution finishes,
- * or as wait event input to other operations on the device.
+ * or as wait event input to other operations on the device. The kernel is
+ * enqueued in the device's default queue, see gocl_kernel_run_in_queue() to
+ * use a different queue.
  *
  * If @event_wait_list is provided, the kernel execution will start
  * only when all the events in the list have triggered.
  *
  * Returns: (transfer none): A #GoclEvent to get notified when execution
- * finishes
+ * finishes, or %NULL if the device's default queue could not be created
  **/
 GoclEvent *
 gocl_kernel_run_in_device (GoclKernel *self,
                            GoclDevice *device,
                            GList      *event_wait_list)
 {
-  GError *error = NULL;
-
-  cl_int err_code;
-  cl_event event;
-  GoclQueue *queue = NULL;
-  cl_command_queue _queue;
-
-  GoclEvent *_event = NULL;
-  GoclEventResolverFunc resolver_func;
-
-  cl_event *_event_wait_list = NULL;
-  guint event_wait_list_len;
-
-  g_return_val_if_fail (GOCL_IS_KERNEL (self), FALSE);
-  g_return_val_if_fail (GOCL_IS_DEVICE (device), FALSE);
+  GoclQueue *queue;
 
-  _event_wait_list = gocl_event_list_to_array (event_wait_list,
-                                               &event_wait_list_len);
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), NULL);
+  g_return_val_if_fail (GOCL_IS_DEVICE (device), NULL);
 
   queue = gocl_device_get_default_queue (device);
   if (queue == NULL)
-    goto out;
-
-  _queue = gocl_queue_get_queue (queue);
-
-  err_code =
-    clEnqueueNDRangeKernel (_queue,
-                            self->priv->kernel,
-                            self->priv->work_dim,
-                            NULL,
-                            self->priv->global_work_size[0] == 0 ?
-                              NULL : (gsize *) &self->priv->global_work_size,
-                            self->priv->local_work_size[0] == 0 ?
-                              NULL : (gsize *) &self->priv->local_work_size,
-                            event_wait_list_len,
-                            _event_wait_list,
-                            &event);
-  g_free (_event_wait_list);
-
-  if (! gocl_error_check_opencl (err_code, &error))
-    {
-      _event = g_object_new (GOCL_TYPE_EVENT,
-                             "queue", queue,
-                             "event", event,
-                             NULL);
-      gocl_event_set_event_wait_list (_event, event_wait_list);
-      gocl_event_steal_resolver_func (_event);
-    }
+    return NULL;
 
- out:
-  if (error != NULL)
-    {
-      _event = g_object_new (GOCL_TYPE_EVENT,
-                             "queue", queue,
-                             NULL);
-      resolver_func = gocl_event_steal_resolver_func (_event);
-      resolver_func (_event, error);
-      g_error_free (error);
-    }
-
-  gocl_event_idle_unref (_event);
-
-  return _event;
+  return gocl_kernel_run_in_queue (self, queue, event_wait_list);
 }
 
 /**
@@ -583,3 +1561,157 @@ gocl_kernel_set_local_work_size (GoclKernel *self,
   self->priv->local_work_size[1] = size2;
   self->priv->local_work_size[2] = size3;
 }
+
+/**
+ * gocl_kernel_get_global_work_size:
+ * @self: The #GoclKernel
+ * @size1: (out) (allow-none): Return location for the first dimension
+ * @size2: (out) (allow-none): Return location for the second dimension
+ * @size3: (out) (allow-none): Return location for the third dimension
+ *
+ * Obtains the global work sizes used when executing the kernel. After
+ * gocl_kernel_autotune_sync(), these include any padding added to make them
+ * multiples of the local work sizes.
+ **/
+void
+gocl_kernel_get_global_work_size (GoclKernel *self,
+                                  gsize      *size1,
+                                  gsize      *size2,
+                                  gsize      *size3)
+{
+  g_return_if_fail (GOCL_IS_KERNEL (self));
+
+  if (size1 != NULL)
+    *size1 = self->priv->global_work_size[0];
+  if (size2 != NULL)
+    *size2 = self->priv->global_work_size[1];
+  if (size3 != NULL)
+    *size3 = self->priv->global_work_size[2];
+}
+
+/**
+ * gocl_kernel_get_local_work_size:
+ * @self: The #GoclKernel
+ * @size1: (out) (allow-none): Return location for the first dimension
+ * @size2: (out) (allow-none): Return location for the second dimension
+ * @size3: (out) (allow-none): Return location for the third dimension
+ *
+ * Obtains the local work sizes used when executing the kernel.
+ **/
+void
+gocl_kernel_get_local_work_size (GoclKernel *self,
+                                 gsize      *size1,
+                                 gsize      *size2,
+                                 gsize      *size3)
+{
+  g_return_if_fail (GOCL_IS_KERNEL (self));
+
+  if (size1 != NULL)
+    *size1 = self->priv->local_work_size[0];
+  if (size2 != NULL)
+    *size2 = self->priv->local_work_size[1];
+  if (size3 != NULL)
+    *size3 = self->priv->local_work_size[2];
+}
+
+/**
+ * gocl_kernel_autotune_sync:
+ * @self: The #GoclKernel
+ * @device: The #GoclDevice to tune for
+ *
+ * Chooses the local work size that executes the kernel fastest on @device,
+ * for the current work dimension and global work size, and sets it on the
+ * kernel. The global work size is then padded up to a multiple of the local
+ * work size in each dimension, so the kernel must ignore work-items whose
+ * global id falls beyond the original size; the padded size can be
+ * retrieved with gocl_kernel_get_global_work_size(). Should the
+ * implementation's own choice be the fastest, the local work size is
+ * cleared and the global work size left untouched.
+ *
+ * Candidates are derived from the %CL_KERNEL_WORK_GROUP_SIZE and
+ * %CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE of the kernel on @device,
+ * and each one is benchmarked by running the kernel a few times on the
+ * device's default queue, with the arguments currently set. This blocks the
+ * program, and any side effect of the kernel happens several times.
+ *
+ * Results are remembered per device and per class of global work size,
+ * where each dimension is rounded up to a power of two. Unless the program
+ * has #GoclProgram:use-binary-cache disabled, they are also kept on disk
+ * next to the program binary cache, so later runs of the application skip
+ * the benchmark altogether.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_kernel_autotune_sync (GoclKernel *self, GoclDevice *device)
+{
+  GoclQueue *queue;
+  cl_device_id device_id;
+  gchar *size_class;
+  gchar *key;
+  gsize *tuned;
+  WorkSize best = { 0, };
+  cl_int err_code = CL_SUCCESS;
+  guint i;
+
+  g_return_val_if_fail (GOCL_IS_KERNEL (self), FALSE);
+  g_return_val_if_fail (GOCL_IS_DEVICE (device), FALSE);
+  g_return_val_if_fail (self->priv->global_work_size[0] > 0, FALSE);
+
+  device_id = gocl_device_get_id (device);
+
+  size_class = get_size_class (self->priv->work_dim,
+                               self->priv->global_work_size);
+  key = g_strdup_printf ("%p:%s", device_id, size_class);
+
+  tuned = g_hash_table_lookup (self->priv->tuned_sizes, key);
+  if (tuned != NULL)
+    {
+      memcpy (best, tuned, sizeof (WorkSize));
+    }
+  else if (! use_tuning_cache (self) ||
+           ! load_tuned_size (self, device_id, size_class, best))
+    {
+      GArray *candidates;
+
+      queue = gocl_device_get_default_queue (device);
+      if (queue == NULL)
+        {
+          err_code = CL_INVALID_COMMAND_QUEUE;
+          goto out;
+        }
+
+      candidates = get_candidates (self, device_id, &err_code);
+      if (candidates == NULL)
+        goto out;
+
+      err_code = benchmark_candidates (self,
+                                       gocl_queue_get_queue (queue),
+                                       candidates,
+                                       best);
+      g_array_free (candidates, TRUE);
+
+      if (err_code != CL_SUCCESS)
+        goto out;
+
+      if (use_tuning_cache (self))
+        store_tuned_size (self, device_id, size_class, best);
+    }
+
+  if (tuned == NULL)
+    g_hash_table_insert (self->priv->tuned_sizes,
+                         g_strdup (key),
+                         g_memdup (best, sizeof (WorkSize)));
+
+  memcpy (self->priv->local_work_size, best, sizeof (WorkSize));
+  if (best[0] != 0)
+    for (i = 0; i < self->priv->work_dim; i++)
+      self->priv->global_work_size[i] =
+        round_up (self->priv->global_work_size[i], best[i]);
+
+ out:
+  g_free (key);
+  g_free (size_class);
+
+  return ! gocl_error_check_opencl_internal (err_code);
+}
@@ -26,6 +26,7 @@
 
 #include "gocl-device.h"
 #include "gocl-event.h"
+#include "gocl-svm-buffer.h"
 
 G_BEGIN_DECLS
 
@@ -54,10 +55,17 @@ struct _GoclKernelClass
 
 GType                  gocl_kernel_get_type                   (void) G_GNUC_CONST;
 
+GoclKernel *           gocl_kernel_clone                      (GoclKernel *self);
+
 gboolean               gocl_kernel_set_argument               (GoclKernel      *self,
                                                                guint            index,
                                                                gsize            size,
                                                                const gpointer  *buffer);
+gboolean               gocl_kernel_set_argument_full          (GoclKernel      *self,
+                                                               guint            index,
+                                                               gsize            size,
+                                                               const gpointer  *buffer,
+                                                               GError         **error);
 gboolean               gocl_kernel_set_argument_int32         (GoclKernel  *self,
                                                                guint        index,
                                                                gsize        num_elements,
@@ -69,6 +77,12 @@ gboolean               gocl_kernel_set_argument_float         (GoclKernel  *self
 gboolean               gocl_kernel_set_argument_buffer        (GoclKernel  *self,
                                                                guint        index,
                                                                GoclBuffer  *buffer);
+gboolean               gocl_kernel_set_argument_svm_buffer    (GoclKernel     *self,
+                                                               guint           index,
+                                                               GoclSvmBuffer  *buffer);
+gboolean               gocl_kernel_set_argument_svm_pointer   (GoclKernel *self,
+                                                               guint       index,
+                                                               gpointer    svm_ptr);
 
 gboolean               gocl_kernel_run_in_device_sync         (GoclKernel  *self,
                                                                GoclDevice  *device,
@@ -76,6 +90,25 @@ gboolean               gocl_kernel_run_in_device_sync         (GoclKernel  *self
 GoclEvent *            gocl_kernel_run_in_device              (GoclKernel  *self,
                                                                GoclDevice  *device,
                                                                GList       *event_wait_list);
+gboolean               gocl_kernel_run_in_queue_sync          (GoclKernel  *self,
+                                                               GoclQueue   *queue,
+                                                               GList       *event_wait_list);
+gboolean               gocl_kernel_run_in_queue_sync_full     (GoclKernel  *self,
+                                                               GoclQueue   *queue,
+                                                               GList       *event_wait_list,
+                                                               GError     **error);
+GoclEvent *            gocl_kernel_run_in_queue               (GoclKernel  *self,
+                                                               GoclQueue   *queue,
+                                                               GList       *event_wait_list);
+gboolean               gocl_kernel_run_in_queue_sync_with_events
+                                                              (GoclKernel  *self,
+                                                               GoclQueue   *queue,
+                                                               GoclEvent  **event_wait_list,
+                                                               guint        event_wait_list_len);
+GoclEvent *            gocl_kernel_run_in_queue_with_events   (GoclKernel  *self,
+                                                               GoclQueue   *queue,
+                                                               GoclEvent  **event_wait_list,
+                                                               guint        event_wait_list_len);
 
 void                   gocl_kernel_set_work_dimension         (GoclKernel *self,
                                                                guint8      work_dim);
@@ -87,6 +120,17 @@ void                   gocl_kernel_set_local_work_size        (GoclKernel *self,
                                                                gsize       size1,
                                                                gsize       size2,
                                                                gsize       size3);
+void                   gocl_kernel_get_global_work_size       (GoclKernel *self,
+                                                               gsize      *size1,
+                                                               gsize      *size2,
+                                                               gsize      *size3);
+void                   gocl_kernel_get_local_work_size        (GoclKernel *self,
+                                                               gsize      *size1,
+                                                               gsize      *size2,
+                                                               gsize      *size3);
+
+gboolean               gocl_kernel_autotune_sync              (GoclKernel *self,
+                                                               GoclDevice *device);
 
 G_END_DECLS
 
@@ -0,0 +1,807 @@
+/*
+ * gocl-launch.c
+ *
+ * Gocl - GLib/GObject wrapper for OpenCL
+ * Copyright (C) 2012-2013 Igalia S.L.
+ *
+ * Authors:
+ *  Eduardo Lima Mitev <elima@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License at http://www.gnu.org/licenses/lgpl-3.0.txt
+ * for more details.
+ */
+
+/**
+ * SECTION:gocl-launch
+ * @short_description: Object that represents a reusable kernel execution
+ * @stability: Unstable
+ *
+ * A #GoclLaunch bundles everything needed to execute a #GoclKernel: the
+ * kernel itself, the values of its arguments, the work sizes and the
+ * #GoclQueue to enqueue it in. Once prepared, a launch can be executed
+ * repeatedly with gocl_launch_run() or gocl_launch_run_sync(), without
+ * resolving any of these again.
+ *
+ * A launch is created with gocl_launch_new(), and takes a snapshot of the
+ * current arguments and work sizes of the kernel. From then on, the
+ * arguments and work sizes of the launch are independent from those of the
+ * kernel, and are changed with gocl_launch_set_argument(),
+ * gocl_launch_set_global_work_size(), etc.
+ *
+ * Several launches can share the same kernel. Before each execution, only
+ * the arguments that differ from the values currently set on the kernel are
+ * uploaded to OpenCL, so changing a single scalar between executions costs
+ * a single argument update.
+ **/
+
+/**
+ * GoclLaunchClass:
+ * @parent_class: The parent class
+ *
+ * The class for #GoclLaunch objects.
+ **/
+
+#include <string.h>
+
+#include "gocl-launch.h"
+
+#include "gocl-private.h"
+
+typedef gsize WorkSize[3];
+
+struct _GoclLaunchPrivate
+{
+  GoclKernel *kernel;
+  GoclQueue *queue;
+
+  cl_kernel cl_kernel;
+  cl_command_queue cl_queue;
+
+  gchar *label;
+
+  WorkSize global_work_size;
+  WorkSize local_work_size;
+  guint8 work_dim;
+
+  GArray *args;
+};
+
+/* properties */
+enum
+{
+  PROP_0,
+  PROP_KERNEL,
+  PROP_QUEUE
+};
+
+static void           gocl_launch_class_init            (GoclLaunchClass *class);
+static void           gocl_launch_init                  (GoclLaunch *self);
+static void           gocl_launch_constructed           (GObject *obj);
+static void           gocl_launch_finalize              (GObject *obj);
+
+static void           set_property                      (GObject      *obj,
+                                                         guint         prop_id,
+                                                         const GValue *value,
+                                                         GParamSpec   *pspec);
+static void           get_property                      (GObject    *obj,
+                                                         guint       prop_id,
+                                                         GValue     *value,
+                                                         GParamSpec *pspec);
+
+G_DEFINE_TYPE (GoclLaunch, gocl_launch, G_TYPE_OBJECT)
+
+#define GOCL_LAUNCH_GET_PRIVATE(obj)                    \
+  (G_TYPE_INSTANCE_GET_PRIVATE ((obj),                  \
+                                GOCL_TYPE_LAUNCH,       \
+                                GoclLaunchPrivate))     \
+
+static void
+gocl_launch_class_init (GoclLaunchClass *class)
+{
+  GObjectClass *obj_class = G_OBJECT_CLASS (class);
+
+  obj_class->constructed = gocl_launch_constructed;
+  obj_class->finalize = gocl_launch_finalize;
+  obj_class->get_property = get_property;
+  obj_class->set_property = set_property;
+
+  g_object_class_install_property (obj_class, PROP_KERNEL,
+                                   g_param_spec_object ("kernel",
+                                                        "Kernel",
+                                                        "The kernel executed by this launch",
+                                                        GOCL_TYPE_KERNEL,
+                                                        G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
+                                                        G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (obj_class, PROP_QUEUE,
+                                   g_param_spec_object ("queue",
+                                                        "Queue",
+                                                        "The command queue where the kernel is enqueued",
+                                                        GOCL_TYPE_QUEUE,
+                                                        G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
+                                                        G_PARAM_STATIC_STRINGS));
+
+  g_type_class_add_private (class, sizeof (GoclLaunchPrivate));
+}
+
+static void
+gocl_launch_init (GoclLaunch *self)
+{
+  GoclLaunchPrivate *priv;
+
+  self->priv = priv = GOCL_LAUNCH_GET_PRIVATE (self);
+
+  priv->work_dim = 1;
+  memset (&priv->global_work_size, 0, sizeof (WorkSize));
+  memset (&priv->local_work_size, 0, sizeof (WorkSize));
+
+  priv->args = g_array_new (FALSE, TRUE, sizeof (GoclKernelArg));
+}
+
+static void
+gocl_launch_constructed (GObject *obj)
+{
+  GoclLaunch *self = GOCL_LAUNCH (obj);
+  GArray *kernel_args;
+  guint i;
+
+  self->priv->cl_kernel = gocl_kernel_get_kernel (self->priv->kernel);
+  self->priv->cl_queue = gocl_queue_get_queue (self->priv->queue);
+
+  g_object_get (self->priv->kernel, "name", &self->priv->label, NULL);
+
+  gocl_kernel_get_work_size (self->priv->kernel,
+                             &self->priv->work_dim,
+                             self->priv->global_work_size,
+                             self->priv->local_work_size);
+
+  /* start from the arguments currently set on the kernel */
+  kernel_args = gocl_kernel_get_arguments (self->priv->kernel);
+  g_array_set_size (self->priv->args, kernel_args->len);
+
+  for (i = 0; i < kernel_args->len; i++)
+    {
+      GoclKernelArg *arg;
+
+      arg = &g_array_index (kernel_args, GoclKernelArg, i);
+      if (arg->is_set)
+        {
+          GoclKernelArg *own_arg;
+
+          own_arg = &g_array_index (self->priv->args, GoclKernelArg, i);
+          gocl_kernel_arg_store (own_arg, arg->size, arg->value);
+          own_arg->is_svm = arg->is_svm;
+          gocl_kernel_arg_set_managed_buffer (own_arg,
+                                              arg->managed_buffer,
+                                              arg->managed_read_only);
+        }
+    }
+
+  if (G_OBJECT_CLASS (gocl_launch_parent_class)->constructed != NULL)
+    G_OBJECT_CLASS (gocl_launch_parent_class)->constructed (obj);
+}
+
+static void
+gocl_launch_finalize (GObject *obj)
+{
+  GoclLaunch *self = GOCL_LAUNCH (obj);
+  guint i;
+
+  for (i = 0; i < self->priv->args->len; i++)
+    gocl_kernel_arg_clear (&g_array_index (self->priv->args, GoclKernelArg, i));
+  g_array_free (self->priv->args, TRUE);
+
+  g_free (self->priv->label);
+
+  g_object_unref (self->priv->queue);
+  g_object_unref (self->priv->kernel);
+
+  G_OBJECT_CLASS (gocl_launch_parent_class)->finalize (obj);
+}
+
+static void
+set_property (GObject      *obj,
+              guint         prop_id,
+              const GValue *value,
+              GParamSpec   *pspec)
+{
+  GoclLaunch *self;
+
+  self = GOCL_LAUNCH (obj);
+
+  switch (prop_id)
+    {
+    case PROP_KERNEL:
+      self->priv->kernel = g_value_dup_object (value);
+      break;
+
+    case PROP_QUEUE:
+      self->priv->queue = g_value_dup_object (value);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
+      break;
+    }
+}
+
+static void
+get_property (GObject    *obj,
+              guint       prop_id,
+              GValue     *value,
+              GParamSpec *pspec)
+{
+  GoclLaunch *self;
+
+  self = GOCL_LAUNCH (obj);
+
+  switch (prop_id)
+    {
+    case PROP_KERNEL:
+      g_value_set_object (value, self->priv->kernel);
+      break;
+
+    case PROP_QUEUE:
+      g_value_set_object (value, self->priv->queue);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
+      break;
+    }
+}
+
+/* internal */
+
+cl_int
+gocl_launch_enqueue (GoclLaunch *self,
+                     cl_event   *event_wait_list,
+                     guint       event_wait_list_len,
+                     cl_event   *out_event)
+{
+  GArray *kernel_args;
+  GArray *merged = NULL;
+  cl_event event;
+  cl_int err_code;
+  guint i;
+
+  kernel_args = gocl_kernel_get_arguments (self->priv->kernel);
+
+  /* the kernel skips the arguments it already holds */
+  for (i = 0; i < self->priv->args->len; i++)
+    {
+      GoclKernelArg *arg;
+
+      arg = &g_array_index (self->priv->args, GoclKernelArg, i);
+      if (! arg->is_set)
+        continue;
+
+      if (arg->is_svm)
+        err_code = gocl_kernel_set_argument_svm_internal (self->priv->kernel,
+                                                          i,
+                                                          *(gpointer *) arg->value);
+      else
+        err_code = gocl_kernel_set_argument_internal (self->priv->kernel,
+                                                      i,
+                                                      arg->size,
+                                                      arg->value);
+      if (err_code != CL_SUCCESS)
+        return err_code;
+
+      if (arg->managed_buffer != NULL && i < kernel_args->len)
+        gocl_kernel_arg_set_managed_buffer (&g_array_index (kernel_args,
+                                                            GoclKernelArg,
+                                                            i),
+                                            arg->managed_buffer,
+                                            arg->managed_read_only);
+    }
+
+  /* managed buffers send their host changes first */
+  err_code = gocl_kernel_args_upload_managed (self->priv->args,
+                                              self->priv->cl_queue,
+                                              event_wait_list,
+                                              event_wait_list_len,
+                                              &merged);
+  if (err_code != CL_SUCCESS)
+    return err_code;
+
+  if (merged == NULL)
+    return clEnqueueNDRangeKernel (self->priv->cl_queue,
+                                   self->priv->cl_kernel,
+                                   self->priv->work_dim,
+                                   NULL,
+                                   self->priv->global_work_size[0] == 0 ?
+                                     NULL : self->priv->global_work_size,
+                                   self->priv->local_work_size[0] == 0 ?
+                                     NULL : self->priv->local_work_size,
+                                   event_wait_list_len,
+                                   event_wait_list,
+                                   out_event);
+
+  /* the buffers need the kernel's event even if the caller does not */
+  err_code = clEnqueueNDRangeKernel (self->priv->cl_queue,
+                                     self->priv->cl_kernel,
+                                     self->priv->work_dim,
+                                     NULL,
+                                     self->priv->global_work_size[0] == 0 ?
+                                       NULL : self->priv->global_work_size,
+                                     self->priv->local_work_size[0] == 0 ?
+                                       NULL : self->priv->local_work_size,
+                                     merged->len,
+                                     merged->len > 0 ?
+                                       (cl_event *) merged->data : NULL,
+                                     &event);
+
+  gocl_kernel_args_complete_managed (self->priv->args,
+                                     merged,
+                                     event_wait_list_len,
+                                     &event,
+                                     err_code == CL_SUCCESS ? 1 : 0);
+
+  if (err_code == CL_SUCCESS)
+    {
+      if (out_event != NULL)
+        *out_event = event;
+      else
+        clReleaseEvent (event);
+    }
+
+  return err_code;
+}
+
+static gboolean
+run_sync (GoclLaunch          *self,
+          const GoclWaitList  *wait_list,
+          GError             **error)
+{
+  cl_int err_code;
+  cl_event event;
+
+  err_code = gocl_launch_enqueue (self,
+                                  wait_list->cl_events,
+                                  wait_list->len,
+                                  &event);
+  if (gocl_error_check_opencl (err_code, error))
+    return FALSE;
+
+  clWaitForEvents (1, &event);
+  clReleaseEvent (event);
+
+  return TRUE;
+}
+
+static GoclEvent *
+run (GoclLaunch *self, const GoclWaitList *wait_list)
+{
+  GError *error = NULL;
+  cl_int err_code;
+  cl_event event;
+
+  GoclEvent *_event = NULL;
+  GoclEventResolverFunc resolver_func;
+
+  err_code = gocl_launch_enqueue (self,
+                                  wait_list->cl_events,
+                                  wait_list->len,
+                                  &event);
+
+  if (gocl_error_check_opencl (err_code, &error))
+    {
+      _event = g_object_new (GOCL_TYPE_EVENT,
+                             "queue", self->priv->queue,
+                             NULL);
+      resolver_func = gocl_event_steal_resolver_func (_event);
+      resolver_func (_event, error);
+      g_error_free (error);
+    }
+  else
+    {
+      _event = g_object_new (GOCL_TYPE_EVENT,
+                             "queue", self->priv->queue,
+                             "event", event,
+                             "label", self->priv->label,
+                             NULL);
+      gocl_event_set_wait_list (_event, wait_list);
+      gocl_event_steal_resolver_func (_event);
+    }
+
+  gocl_event_idle_unref (_event);
+
+  return _event;
+}
+
+/* public */
+
+/**
+ * gocl_launch_new:
+ * @kernel: The #GoclKernel to execute
+ * @queue: The #GoclQueue to enqueue the kernel in
+ *
+ * Creates a new launch object for executing @kernel in @queue. The current
+ * arguments and work sizes of @kernel are copied into the launch.
+ *
+ * Returns: (transfer full): A newly created #GoclLaunch
+ **/
+GoclLaunch *
+gocl_launch_new (GoclKernel *kernel, GoclQueue *queue)
+{
+  g_return_val_if_fail (GOCL_IS_KERNEL (kernel), NULL);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), NULL);
+
+  return g_object_new (GOCL_TYPE_LAUNCH,
+                       "kernel", kernel,
+                       "queue", queue,
+                       NULL);
+}
+
+/**
+ * gocl_launch_get_kernel:
+ * @self: The #GoclLaunch
+ *
+ * Obtains the kernel executed by this launch.
+ *
+ * Returns: (transfer none): The #GoclKernel
+ **/
+GoclKernel *
+gocl_launch_get_kernel (GoclLaunch *self)
+{
+  g_return_val_if_fail (GOCL_IS_LAUNCH (self), NULL);
+
+  return self->priv->kernel;
+}
+
+/**
+ * gocl_launch_get_queue:
+ * @self: The #GoclLaunch
+ *
+ * Obtains the command queue where this launch enqueues its kernel.
+ *
+ * Returns: (transfer none): The #GoclQueue
+ **/
+GoclQueue *
+gocl_launch_get_queue (GoclLaunch *self)
+{
+  g_return_val_if_fail (GOCL_IS_LAUNCH (self), NULL);
+
+  return self->priv->queue;
+}
+
+/**
+ * gocl_launch_set_argument:
+ * @self: The #GoclLaunch
+ * @index: The index of this argument in the kernel function
+ * @size: The size of @buffer, in bytes
+ * @buffer: (allow-none): A pointer to an arbitrary block of memory, or %NULL
+ * for local memory arguments
+ *
+ * Sets the value of the kernel argument at @index for this launch, as an
+ * arbitrary block of memory. The value is copied, and uploaded to the kernel
+ * on the next execution of the launch.
+ *
+ * Returns: %TRUE on success, %FALSE if @index is out of range
+ **/
+gboolean
+gocl_launch_set_argument (GoclLaunch      *self,
+                          guint            index,
+                          gsize            size,
+                          const gpointer  *buffer)
+{
+  g_return_val_if_fail (GOCL_IS_LAUNCH (self), FALSE);
+
+  if (index >= self->priv->args->len)
+    return ! gocl_error_check_opencl_internal (CL_INVALID_ARG_INDEX);
+
+  gocl_kernel_arg_store (&g_array_index (self->priv->args, GoclKernelArg, index),
+                         size,
+                         buffer);
+
+  return ! gocl_error_check_opencl_internal (CL_SUCCESS);
+}
+
+/**
+ * gocl_launch_set_argument_int32:
+ * @self: The #GoclLaunch
+ * @index: The index of this argument in the kernel function
+ * @num_elements: The number of int32 elements in @buffer
+ * @buffer: (array length=num_elements) (element-type guint32): Array of int32
+ * values
+ *
+ * Sets the value of the kernel argument at @index for this launch, as an
+ * array of int32.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_launch_set_argument_int32 (GoclLaunch  *self,
+                                guint        index,
+                                gsize        num_elements,
+                                gint32      *buffer)
+{
+  return gocl_launch_set_argument (self,
+                                   index,
+                                   sizeof (cl_uint) * num_elements,
+                                   (const gpointer) buffer);
+}
+
+/**
+ * gocl_launch_set_argument_float:
+ * @self: The #GoclLaunch
+ * @index: The index of this argument in the kernel function
+ * @num_elements: The number of float elements in @buffer
+ * @buffer: (array length=num_elements) (element-type gfloat): Array of float
+ * values
+ *
+ * Sets the value of the kernel argument at @index for this launch, as an
+ * array of floats.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_launch_set_argument_float (GoclLaunch  *self,
+                                guint        index,
+                                gsize        num_elements,
+                                gfloat      *buffer)
+{
+  return gocl_launch_set_argument (self,
+                                   index,
+                                   sizeof (cl_float) * num_elements,
+                                   (const gpointer) buffer);
+}
+
+/**
+ * gocl_launch_set_argument_buffer:
+ * @self: The #GoclLaunch
+ * @index: The index of this argument in the kernel function
+ * @buffer: A #GoclBuffer
+ *
+ * Sets the value of the kernel argument at @index for this launch, as a
+ * buffer object. The launch does not keep a reference to @buffer, so it must
+ * stay alive for as long as the launch is executed with it. Managed buffers,
+ * those created with gocl_buffer_new_managed(), are the exception: the
+ * launch holds a reference to them, and synchronizes them around each run.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_launch_set_argument_buffer (GoclLaunch  *self,
+                                 guint        index,
+                                 GoclBuffer  *buffer)
+{
+  cl_mem buf;
+
+  g_return_val_if_fail (GOCL_IS_LAUNCH (self), FALSE);
+  g_return_val_if_fail (GOCL_IS_BUFFER (buffer), FALSE);
+
+  buf = gocl_buffer_get_buffer (buffer);
+
+  if (! gocl_launch_set_argument (self,
+                                  index,
+                                  sizeof (cl_mem),
+                                  (const gpointer) &buf))
+    return FALSE;
+
+  if (gocl_buffer_is_managed (buffer))
+    gocl_kernel_arg_set_managed_buffer (&g_array_index (self->priv->args,
+                                                        GoclKernelArg,
+                                                        index),
+                                        buffer,
+                                        gocl_kernel_is_argument_const (self->priv->kernel,
+                                                                       index));
+
+  return TRUE;
+}
+
+/**
+ * gocl_launch_set_work_dimension:
+ * @self: The #GoclLaunch
+ * @work_dim: The work dimension
+ *
+ * Sets the work dimension (1, 2, 3) to use when executing the launch.
+ **/
+void
+gocl_launch_set_work_dimension (GoclLaunch *self, guint8 work_dim)
+{
+  g_return_if_fail (GOCL_IS_LAUNCH (self));
+  g_return_if_fail (work_dim > 0 && work_dim <= 3);
+
+  self->priv->work_dim = work_dim;
+}
+
+/**
+ * gocl_launch_set_global_work_size:
+ * @self: The #GoclLaunch
+ * @size1: global work size for the first dimension
+ * @size2: global work size for the second dimension
+ * @size3: global work size for the third dimension
+ *
+ * Sets the global work sizes to use when executing the launch. See
+ * gocl_kernel_set_global_work_size() for details.
+ **/
+void
+gocl_launch_set_global_work_size (GoclLaunch *self,
+                                  gsize       size1,
+                                  gsize       size2,
+                                  gsize       size3)
+{
+  g_return_if_fail (GOCL_IS_LAUNCH (self));
+
+  self->priv->global_work_size[0] = size1;
+  self->priv->global_work_size[1] = size2;
+  self->priv->global_work_size[2] = size3;
+}
+
+/**
+ * gocl_launch_set_local_work_size:
+ * @self: The #GoclLaunch
+ * @size1: local work size for the first dimension
+ * @size2: local work size for the second dimension
+ * @size3: local work size for the third dimension
+ *
+ * Sets the local work sizes to use when executing the launch. See
+ * gocl_kernel_set_local_work_size() for details.
+ **/
+void
+gocl_launch_set_local_work_size (GoclLaunch *self,
+                                 gsize       size1,
+                                 gsize       size2,
+                                 gsize       size3)
+{
+  g_return_if_fail (GOCL_IS_LAUNCH (self));
+
+  self->priv->local_work_size[0] = size1;
+  self->priv->local_work_size[1] = size2;
+  self->priv->local_work_size[2] = size3;
+}
+
+/**
+ * gocl_launch_run_sync:
+ * @self: The #GoclLaunch
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List of #GoclEvent
+ * events to wait for, or %NULL
+ *
+ * Executes the launch, blocking the program until the kernel execution
+ * finishes. For a non-blocking version, gocl_launch_run() is provided.
+ *
+ * If @event_wait_list is provided, the kernel execution will start
+ * only when all the events in the list have triggered.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_launch_run_sync (GoclLaunch *self, GList *event_wait_list)
+{
+  return gocl_launch_run_sync_full (self,
+                                    event_wait_list,
+                                    gocl_error_prepare ());
+}
+
+/**
+ * gocl_launch_run_sync_full:
+ * @self: The #GoclLaunch
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List of #GoclEvent
+ * events to wait for, or %NULL
+ * @error: (allow-none): Return location for a #GError, or %NULL
+ *
+ * Like gocl_launch_run_sync(), but reports a failure in @error instead of the
+ * last error of the calling thread.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_launch_run_sync_full (GoclLaunch  *self,
+                           GList       *event_wait_list,
+                           GError     **error)
+{
+  GoclWaitList wait_list;
+  gboolean result;
+
+  g_return_val_if_fail (GOCL_IS_LAUNCH (self), FALSE);
+
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
+  result = run_sync (self, &wait_list, error);
+  gocl_wait_list_clear (&wait_list);
+
+  return result;
+}
+
+/**
+ * gocl_launch_run:
+ * @self: The #GoclLaunch
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List of #GoclEvent
+ * events to wait for, or %NULL
+ *
+ * Executes the launch asynchronously. A #GoclEvent is returned, and can be
+ * used to get notified when the execution finishes, or as wait event input
+ * to other operations.
+ *
+ * If @event_wait_list is provided, the kernel execution will start
+ * only when all the events in the list have triggered.
+ *
+ * Returns: (transfer none): A #GoclEvent to get notified when execution
+ * finishes
+ **/
+GoclEvent *
+gocl_launch_run (GoclLaunch *self, GList *event_wait_list)
+{
+  GoclWaitList wait_list;
+  GoclEvent *event;
+
+  g_return_val_if_fail (GOCL_IS_LAUNCH (self), NULL);
+
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
+  event = run (self, &wait_list);
+  gocl_wait_list_clear (&wait_list);
+
+  return event;
+}
+
+/**
+ * gocl_launch_run_sync_with_events:
+ * @self: The #GoclLaunch
+ * @event_wait_list: (array length=event_wait_list_len) (allow-none): Array
+ * of #GoclEvent events to wait for, or %NULL
+ * @event_wait_list_len: The number of events in @event_wait_list
+ *
+ * Like gocl_launch_run_sync(), but takes the events to wait for as a C
+ * array, such as the pdata member of a #GPtrArray. For up to four events,
+ * no memory is allocated for the wait list.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_launch_run_sync_with_events (GoclLaunch  *self,
+                                  GoclEvent  **event_wait_list,
+                                  guint        event_wait_list_len)
+{
+  GoclWaitList wait_list;
+  gboolean result;
+
+  g_return_val_if_fail (GOCL_IS_LAUNCH (self), FALSE);
+  g_return_val_if_fail (event_wait_list != NULL || event_wait_list_len == 0, FALSE);
+
+  gocl_wait_list_init (&wait_list, event_wait_list, event_wait_list_len);
+  result = run_sync (self, &wait_list, gocl_error_prepare ());
+  gocl_wait_list_clear (&wait_list);
+
+  return result;
+}
+
+/**
+ * gocl_launch_run_with_events:
+ * @self: The #GoclLaunch
+ * @event_wait_list: (array length=event_wait_list_len) (allow-none): Array
+ * of #GoclEvent events to wait for, or %NULL
+ * @event_wait_list_len: The number of events in @event_wait_list
+ *
+ * Like gocl_launch_run(), but takes the events to wait for as a C array,
+ * such as the pdata member of a #GPtrArray. For up to four events, no
+ * memory is allocated for the wait list.
+ *
+ * Returns: (transfer none): A #GoclEvent to get notified when execution
+ * finishes
+ **/
+GoclEvent *
+gocl_launch_run_with_events (GoclLaunch  *self,
+                             GoclEvent  **event_wait_list,
+                             guint        event_wait_list_len)
+{
+  GoclWaitList wait_list;
+  GoclEvent *event;
+
+  g_return_val_if_fail (GOCL_IS_LAUNCH (self), NULL);
+  g_return_val_if_fail (event_wait_list != NULL || event_wait_list_len == 0, NULL);
+
+  gocl_wait_list_init (&wait_list, event_wait_list, event_wait_list_len);
+  event = run (self, &wait_list);
+  gocl_wait_list_clear (&wait_list);
+
+  return event;
+}
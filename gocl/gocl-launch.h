@@ -0,0 +1,107 @@
+/*
+ * gocl-launch.h
+ *
+ * Gocl - GLib/GObject wrapper for OpenCL
+ * Copyright (C) 2012-2013 Igalia S.L.
+ *
+ * Authors:
+ *  Eduardo Lima Mitev <elima@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License at http://www.gnu.org/licenses/lgpl-3.0.txt
+ * for more details.
+ */
+
+#ifndef __GOCL_LAUNCH_H__
+#define __GOCL_LAUNCH_H__
+
+#include <glib-object.h>
+
+#include "gocl-kernel.h"
+#include "gocl-queue.h"
+#include "gocl-event.h"
+
+G_BEGIN_DECLS
+
+#define GOCL_TYPE_LAUNCH              (gocl_launch_get_type ())
+#define GOCL_LAUNCH(obj)              (G_TYPE_CHECK_INSTANCE_CAST ((obj), GOCL_TYPE_LAUNCH, GoclLaunch))
+#define GOCL_LAUNCH_CLASS(klass)      (G_TYPE_CHECK_CLASS_CAST ((klass), GOCL_TYPE_LAUNCH, GoclLaunchClass))
+#define GOCL_IS_LAUNCH(obj)           (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GOCL_TYPE_LAUNCH))
+#define GOCL_IS_LAUNCH_CLASS(klass)   (G_TYPE_CHECK_CLASS_TYPE ((klass), GOCL_TYPE_LAUNCH))
+#define GOCL_LAUNCH_GET_CLASS(obj)    (G_TYPE_INSTANCE_GET_CLASS ((obj), GOCL_TYPE_LAUNCH, GoclLaunchClass))
+
+typedef struct _GoclLaunchClass GoclLaunchClass;
+typedef struct _GoclLaunch GoclLaunch;
+typedef struct _GoclLaunchPrivate GoclLaunchPrivate;
+
+struct _GoclLaunch
+{
+  GObject parent_instance;
+
+  GoclLaunchPrivate *priv;
+};
+
+struct _GoclLaunchClass
+{
+  GObjectClass parent_class;
+};
+
+GType                  gocl_launch_get_type                   (void) G_GNUC_CONST;
+
+GoclLaunch *           gocl_launch_new                        (GoclKernel *kernel,
+                                                               GoclQueue  *queue);
+
+GoclKernel *           gocl_launch_get_kernel                 (GoclLaunch *self);
+GoclQueue *            gocl_launch_get_queue                  (GoclLaunch *self);
+
+gboolean               gocl_launch_set_argument               (GoclLaunch      *self,
+                                                               guint            index,
+                                                               gsize            size,
+                                                               const gpointer  *buffer);
+gboolean               gocl_launch_set_argument_int32         (GoclLaunch  *self,
+                                                               guint        index,
+                                                               gsize        num_elements,
+                                                               gint32      *buffer);
+gboolean               gocl_launch_set_argument_float         (GoclLaunch  *self,
+                                                               guint        index,
+                                                               gsize        num_elements,
+                                                               gfloat      *buffer);
+gboolean               gocl_launch_set_argument_buffer        (GoclLaunch  *self,
+                                                               guint        index,
+                                                               GoclBuffer  *buffer);
+
+void                   gocl_launch_set_work_dimension         (GoclLaunch *self,
+                                                               guint8      work_dim);
+void                   gocl_launch_set_global_work_size       (GoclLaunch *self,
+                                                               gsize       size1,
+                                                               gsize       size2,
+                                                               gsize       size3);
+void                   gocl_launch_set_local_work_size        (GoclLaunch *self,
+                                                               gsize       size1,
+                                                               gsize       size2,
+                                                               gsize       size3);
+
+gboolean               gocl_launch_run_sync                   (GoclLaunch *self,
+                                                               GList      *event_wait_list);
+gboolean               gocl_launch_run_sync_full              (GoclLaunch  *self,
+                                                               GList       *event_wait_list,
+                                                               GError     **error);
+GoclEvent *            gocl_launch_run                        (GoclLaunch *self,
+                                                               GList      *event_wait_list);
+gboolean               gocl_launch_run_sync_with_events       (GoclLaunch  *self,
+                                                               GoclEvent  **event_wait_list,
+                                                               guint        event_wait_list_len);
+GoclEvent *            gocl_launch_run_with_events            (GoclLaunch  *self,
+                                                               GoclEvent  **event_wait_list,
+                                                               guint        event_wait_list_len);
+
+G_END_DECLS
+
+#endif /* __GOCL_LAUNCH_H__ */
@@ -0,0 +1,857 @@
+/*
+ * gocl-pipeline.c
+ *
+ * Gocl - GLib/GObject wrapper for OpenCL
+ * Copyright (C) 2012-2013 Igalia S.L.
+ *
+ * Authors:
+ *  Eduardo Lima Mitev <elima@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License at http://www.gnu.org/licenses/lgpl-3.0.txt
+ * for more details.
+ */
+
+/**
+ * SECTION:gocl-pipeline
+ * @short_description: Object that streams frames through a kernel,
+ * overlapping transfers and computation
+ * @stability: Unstable
+ *
+ * A #GoclPipeline processes a continuous stream of frames with the same
+ * kernel: each frame is written to the device, processed, and read back.
+ * Issuing these three steps one after the other leaves the device idle
+ * during transfers. A pipeline instead keeps several frames in flight, so
+ * that the upload of a frame, the computation of the previous one and the
+ * download of the one before that can all happen at the same time.
+ *
+ * A pipeline is created with gocl_pipeline_new(), for a #GoclKernel whose
+ * work sizes and other arguments are already set, and a #GoclDevice. It owns
+ * @depth slots, each with an input and an output buffer, which are used in
+ * turn for consecutive frames. A depth of 2 is double buffering, and a depth
+ * of 3 (the minimum for the three steps to overlap) is triple buffering.
+ * Slots can hold other buffers, like #GoclImage objects, by setting them
+ * with gocl_pipeline_set_slot_buffers(). The kernel arguments that receive
+ * the input and output buffers of each frame are set with
+ * gocl_pipeline_set_argument_indices(), and default to 0 and 1.
+ *
+ * Uploads are enqueued in the copy queue of the device (see
+ * gocl_device_get_copy_queue()), kernels in its default queue, and downloads
+ * in a queue of their own, so that no step waits behind another in the same
+ * command queue.
+ *
+ * Frames are submitted with gocl_pipeline_push(), which returns a #GoclEvent
+ * that triggers when the output of that frame is available. When all slots
+ * hold frames in flight, pushing a new frame blocks until the oldest one
+ * completes. This provides backpressure: a producer cannot get more than
+ * @depth frames ahead of the device and the consumer. Non-blocking producers
+ * can check gocl_pipeline_can_push() first. gocl_pipeline_flush_sync()
+ * waits for all frames in flight.
+ **/
+
+/**
+ * GoclPipelineClass:
+ * @parent_class: The parent class
+ *
+ * The class for #GoclPipeline objects.
+ **/
+
+#include <gio/gio.h>
+
+#include "gocl-pipeline.h"
+
+#include "gocl-private.h"
+#include "gocl-error.h"
+#include "gocl-context.h"
+#include "gocl-image.h"
+
+#define DEFAULT_DEPTH 3
+#define MAX_DEPTH     16
+
+typedef struct
+{
+  GoclBuffer *input;
+  GoclBuffer *output;
+
+  /* the download of the last frame processed in this slot */
+  GoclEvent *done_event;
+} Slot;
+
+struct _GoclPipelinePrivate
+{
+  GoclKernel *kernel;
+  GoclDevice *device;
+  guint depth;
+  gsize input_size;
+  gsize output_size;
+
+  guint input_index;
+  guint output_index;
+
+  GoclQueue *upload_queue;
+  GoclQueue *compute_queue;
+  GoclQueue *download_queue;
+
+  Slot *slots;
+  guint next_slot;
+};
+
+/* properties */
+enum
+{
+  PROP_0,
+  PROP_KERNEL,
+  PROP_DEVICE,
+  PROP_DEPTH,
+  PROP_INPUT_SIZE,
+  PROP_OUTPUT_SIZE
+};
+
+static void           gocl_pipeline_class_init            (GoclPipelineClass *class);
+static void           gocl_pipeline_initable_iface_init   (GInitableIface *iface);
+static gboolean       gocl_pipeline_initable_init         (GInitable     *initable,
+                                                           GCancellable  *cancellable,
+                                                           GError       **error);
+static void           gocl_pipeline_init                  (GoclPipeline *self);
+static void           gocl_pipeline_dispose               (GObject *obj);
+static void           gocl_pipeline_finalize              (GObject *obj);
+
+static void           set_property                        (GObject      *obj,
+                                                           guint         prop_id,
+                                                           const GValue *value,
+                                                           GParamSpec   *pspec);
+static void           get_property                        (GObject    *obj,
+                                                           guint       prop_id,
+                                                           GValue     *value,
+                                                           GParamSpec *pspec);
+
+G_DEFINE_TYPE_WITH_CODE (GoclPipeline, gocl_pipeline, G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE (G_TYPE_INITABLE,
+                                                gocl_pipeline_initable_iface_init));
+
+#define GOCL_PIPELINE_GET_PRIVATE(obj)                  \
+  (G_TYPE_INSTANCE_GET_PRIVATE ((obj),                  \
+                                GOCL_TYPE_PIPELINE,     \
+                                GoclPipelinePrivate))   \
+
+static void
+gocl_pipeline_class_init (GoclPipelineClass *class)
+{
+  GObjectClass *obj_class = G_OBJECT_CLASS (class);
+
+  obj_class->dispose = gocl_pipeline_dispose;
+  obj_class->finalize = gocl_pipeline_finalize;
+  obj_class->get_property = get_property;
+  obj_class->set_property = set_property;
+
+  g_object_class_install_property (obj_class, PROP_KERNEL,
+                                   g_param_spec_object ("kernel",
+                                                        "Kernel",
+                                                        "The kernel every frame is processed with",
+                                                        GOCL_TYPE_KERNEL,
+                                                        G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
+                                                        G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (obj_class, PROP_DEVICE,
+                                   g_param_spec_object ("device",
+                                                        "Device",
+                                                        "The device frames are processed on",
+                                                        GOCL_TYPE_DEVICE,
+                                                        G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
+                                                        G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (obj_class, PROP_DEPTH,
+                                   g_param_spec_uint ("depth",
+                                                      "Depth",
+                                                      "The number of frames that can be in flight at once",
+                                                      2,
+                                                      MAX_DEPTH,
+                                                      DEFAULT_DEPTH,
+                                                      G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
+                                                      G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (obj_class, PROP_INPUT_SIZE,
+                                   g_param_spec_uint64 ("input-size",
+                                                        "Input size",
+                                                        "The size of the input of a frame, in bytes",
+                                                        0,
+                                                        G_MAXUINT64,
+                                                        0,
+                                                        G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
+                                                        G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (obj_class, PROP_OUTPUT_SIZE,
+                                   g_param_spec_uint64 ("output-size",
+                                                        "Output size",
+                                                        "The size of the output of a frame, in bytes",
+                                                        0,
+                                                        G_MAXUINT64,
+                                                        0,
+                                                        G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
+                                                        G_PARAM_STATIC_STRINGS));
+
+  g_type_class_add_private (class, sizeof (GoclPipelinePrivate));
+}
+
+static void
+gocl_pipeline_initable_iface_init (GInitableIface *iface)
+{
+  iface->init = gocl_pipeline_initable_init;
+}
+
+static gboolean
+propagate_last_error (GError **error)
+{
+  GError *last;
+
+  /* @error may well be the thread's last error itself, which is set by the
+     failed call, see gocl_pipeline_new() */
+  last = gocl_error_get_last ();
+  g_clear_error (error);
+
+  if (last != NULL)
+    g_propagate_error (error, last);
+  else
+    gocl_error_check_opencl (CL_OUT_OF_RESOURCES, error);
+
+  return FALSE;
+}
+
+static gboolean
+gocl_pipeline_initable_init (GInitable     *initable,
+                             GCancellable  *cancellable,
+                             GError       **error)
+{
+  GoclPipeline *self = GOCL_PIPELINE (initable);
+  GoclContext *context;
+  guint i;
+
+  context = gocl_device_get_context (self->priv->device);
+
+  self->priv->compute_queue = gocl_device_get_default_queue (self->priv->device);
+  self->priv->upload_queue = gocl_device_get_copy_queue (self->priv->device);
+  if (self->priv->compute_queue == NULL || self->priv->upload_queue == NULL)
+    return propagate_last_error (error);
+
+  g_object_ref (self->priv->compute_queue);
+  g_object_ref (self->priv->upload_queue);
+
+  self->priv->download_queue = gocl_queue_new (self->priv->device, 0);
+  if (self->priv->download_queue == NULL)
+    return propagate_last_error (error);
+
+  self->priv->slots = g_new0 (Slot, self->priv->depth);
+
+  for (i = 0; i < self->priv->depth; i++)
+    {
+      Slot *slot = &self->priv->slots[i];
+
+      if (self->priv->input_size > 0)
+        {
+          slot->input = gocl_buffer_new_full (context,
+                                              GOCL_BUFFER_FLAGS_READ_ONLY,
+                                              self->priv->input_size,
+                                              NULL,
+                                              error);
+          if (slot->input == NULL)
+            return FALSE;
+        }
+
+      if (self->priv->output_size > 0)
+        {
+          slot->output = gocl_buffer_new_full (context,
+                                               GOCL_BUFFER_FLAGS_WRITE_ONLY,
+                                               self->priv->output_size,
+                                               NULL,
+                                               error);
+          if (slot->output == NULL)
+            return FALSE;
+        }
+    }
+
+  return TRUE;
+}
+
+static void
+gocl_pipeline_init (GoclPipeline *self)
+{
+  GoclPipelinePrivate *priv;
+
+  self->priv = priv = GOCL_PIPELINE_GET_PRIVATE (self);
+
+  priv->input_index = 0;
+  priv->output_index = 1;
+
+  priv->upload_queue = NULL;
+  priv->compute_queue = NULL;
+  priv->download_queue = NULL;
+
+  priv->slots = NULL;
+  priv->next_slot = 0;
+}
+
+static void
+clear_slot (Slot *slot)
+{
+  if (slot->input != NULL)
+    {
+      g_object_unref (slot->input);
+      slot->input = NULL;
+    }
+
+  if (slot->output != NULL)
+    {
+      g_object_unref (slot->output);
+      slot->output = NULL;
+    }
+
+  if (slot->done_event != NULL)
+    {
+      g_object_unref (slot->done_event);
+      slot->done_event = NULL;
+    }
+}
+
+static void
+gocl_pipeline_dispose (GObject *obj)
+{
+  GoclPipeline *self = GOCL_PIPELINE (obj);
+  guint i;
+
+  if (self->priv->slots != NULL)
+    {
+      for (i = 0; i < self->priv->depth; i++)
+        clear_slot (&self->priv->slots[i]);
+    }
+
+  if (self->priv->upload_queue != NULL)
+    {
+      g_object_unref (self->priv->upload_queue);
+      self->priv->upload_queue = NULL;
+    }
+
+  if (self->priv->compute_queue != NULL)
+    {
+      g_object_unref (self->priv->compute_queue);
+      self->priv->compute_queue = NULL;
+    }
+
+  if (self->priv->download_queue != NULL)
+    {
+      g_object_unref (self->priv->download_queue);
+      self->priv->download_queue = NULL;
+    }
+
+  if (self->priv->kernel != NULL)
+    {
+      g_object_unref (self->priv->kernel);
+      self->priv->kernel = NULL;
+    }
+
+  if (self->priv->device != NULL)
+    {
+      g_object_unref (self->priv->device);
+      self->priv->device = NULL;
+    }
+
+  G_OBJECT_CLASS (gocl_pipeline_parent_class)->dispose (obj);
+}
+
+static void
+gocl_pipeline_finalize (GObject *obj)
+{
+  GoclPipeline *self = GOCL_PIPELINE (obj);
+
+  g_free (self->priv->slots);
+
+  G_OBJECT_CLASS (gocl_pipeline_parent_class)->finalize (obj);
+}
+
+static void
+set_property (GObject      *obj,
+              guint         prop_id,
+              const GValue *value,
+              GParamSpec   *pspec)
+{
+  GoclPipeline *self;
+
+  self = GOCL_PIPELINE (obj);
+
+  switch (prop_id)
+    {
+    case PROP_KERNEL:
+      self->priv->kernel = g_value_dup_object (value);
+      break;
+
+    case PROP_DEVICE:
+      self->priv->device = g_value_dup_object (value);
+      break;
+
+    case PROP_DEPTH:
+      self->priv->depth = g_value_get_uint (value);
+      break;
+
+    case PROP_INPUT_SIZE:
+      self->priv->input_size = g_value_get_uint64 (value);
+      break;
+
+    case PROP_OUTPUT_SIZE:
+      self->priv->output_size = g_value_get_uint64 (value);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
+      break;
+    }
+}
+
+static void
+get_property (GObject    *obj,
+              guint       prop_id,
+              GValue     *value,
+              GParamSpec *pspec)
+{
+  GoclPipeline *self;
+
+  self = GOCL_PIPELINE (obj);
+
+  switch (prop_id)
+    {
+    case PROP_KERNEL:
+      g_value_set_object (value, self->priv->kernel);
+      break;
+
+    case PROP_DEVICE:
+      g_value_set_object (value, self->priv->device);
+      break;
+
+    case PROP_DEPTH:
+      g_value_set_uint (value, self->priv->depth);
+      break;
+
+    case PROP_INPUT_SIZE:
+      g_value_set_uint64 (value, self->priv->input_size);
+      break;
+
+    case PROP_OUTPUT_SIZE:
+      g_value_set_uint64 (value, self->priv->output_size);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
+      break;
+    }
+}
+
+static gboolean
+event_is_complete (GoclEvent *event)
+{
+  cl_int status;
+  cl_int err_code;
+
+  err_code = clGetEventInfo (gocl_event_get_event (event),
+                             CL_EVENT_COMMAND_EXECUTION_STATUS,
+                             sizeof (cl_int),
+                             &status,
+                             NULL);
+
+  /* negative values are errors, which also mean the command is over */
+  return err_code != CL_SUCCESS || status <= CL_COMPLETE;
+}
+
+static void
+get_image_region (GoclImage *image, gsize *region)
+{
+  guint type;
+  guint64 width, height, depth;
+
+  g_object_get (image,
+                "type", &type,
+                "width", &width,
+                "height", &height,
+                "depth", &depth,
+                NULL);
+
+  region[0] = width;
+  region[1] = MAX (height, 1);
+  region[2] = type == GOCL_IMAGE_TYPE_3D ? MAX (depth, 1) : 1;
+}
+
+static GoclEvent *
+upload (GoclPipeline *self, Slot *slot, gconstpointer input)
+{
+  guint64 size;
+
+  if (GOCL_IS_IMAGE (slot->input))
+    {
+      gsize origin[3] = { 0, };
+      gsize region[3];
+
+      get_image_region (GOCL_IMAGE (slot->input), region);
+
+      return gocl_image_write_region (GOCL_IMAGE (slot->input),
+                                      self->priv->upload_queue,
+                                      input,
+                                      origin,
+                                      region,
+                                      0,
+                                      0,
+                                      NULL);
+    }
+
+  g_object_get (slot->input, "size", &size, NULL);
+
+  return gocl_buffer_write_with_events (slot->input,
+                                        self->priv->upload_queue,
+                                        (const gpointer) input,
+                                        size,
+                                        0,
+                                        NULL,
+                                        0);
+}
+
+static GoclEvent *
+download (GoclPipeline *self,
+          Slot         *slot,
+          gpointer      output,
+          GoclEvent    *compute_event)
+{
+  guint64 size;
+
+  if (GOCL_IS_IMAGE (slot->output))
+    {
+      gsize origin[3] = { 0, };
+      gsize region[3];
+      GList wait_list = { compute_event, NULL, NULL };
+
+      get_image_region (GOCL_IMAGE (slot->output), region);
+
+      return gocl_image_read_region (GOCL_IMAGE (slot->output),
+                                     self->priv->download_queue,
+                                     output,
+                                     origin,
+                                     region,
+                                     0,
+                                     0,
+                                     &wait_list);
+    }
+
+  g_object_get (slot->output, "size", &size, NULL);
+
+  return gocl_buffer_read_with_events (slot->output,
+                                       self->priv->download_queue,
+                                       output,
+                                       size,
+                                       0,
+                                       &compute_event,
+                                       1);
+}
+
+/* public */
+
+/**
+ * gocl_pipeline_new:
+ * @kernel: The #GoclKernel to process frames with
+ * @device: The #GoclDevice to process frames on
+ * @depth: The number of slots, between 2 and 16, or 0 for the default of 3
+ * @input_size: The size in bytes of the input of a frame, or 0 to set the
+ * input buffers later with gocl_pipeline_set_slot_buffers()
+ * @output_size: The size in bytes of the output of a frame, or 0 to set the
+ * output buffers later with gocl_pipeline_set_slot_buffers()
+ *
+ * Creates a new pipeline that processes frames with @kernel on @device,
+ * keeping up to @depth frames in flight. A read-only input buffer of
+ * @input_size bytes and a write-only output buffer of @output_size bytes are
+ * allocated for each slot.
+ *
+ * Returns: (transfer full): A newly created #GoclPipeline, or %NULL on error
+ **/
+GoclPipeline *
+gocl_pipeline_new (GoclKernel *kernel,
+                   GoclDevice *device,
+                   guint       depth,
+                   gsize       input_size,
+                   gsize       output_size)
+{
+  GError **error;
+
+  g_return_val_if_fail (GOCL_IS_KERNEL (kernel), NULL);
+  g_return_val_if_fail (GOCL_IS_DEVICE (device), NULL);
+  g_return_val_if_fail (depth == 0 || (depth >= 2 && depth <= MAX_DEPTH), NULL);
+
+  error = gocl_error_prepare ();
+
+  return g_initable_new (GOCL_TYPE_PIPELINE,
+                         NULL,
+                         error,
+                         "kernel", kernel,
+                         "device", device,
+                         "depth", depth == 0 ? DEFAULT_DEPTH : depth,
+                         "input-size", (guint64) input_size,
+                         "output-size", (guint64) output_size,
+                         NULL);
+}
+
+/**
+ * gocl_pipeline_get_kernel:
+ * @self: The #GoclPipeline
+ *
+ * Obtains the kernel frames are processed with.
+ *
+ * Returns: (transfer none): The #GoclKernel
+ **/
+GoclKernel *
+gocl_pipeline_get_kernel (GoclPipeline *self)
+{
+  g_return_val_if_fail (GOCL_IS_PIPELINE (self), NULL);
+
+  return self->priv->kernel;
+}
+
+/**
+ * gocl_pipeline_get_device:
+ * @self: The #GoclPipeline
+ *
+ * Obtains the device frames are processed on.
+ *
+ * Returns: (transfer none): The #GoclDevice
+ **/
+GoclDevice *
+gocl_pipeline_get_device (GoclPipeline *self)
+{
+  g_return_val_if_fail (GOCL_IS_PIPELINE (self), NULL);
+
+  return self->priv->device;
+}
+
+/**
+ * gocl_pipeline_get_depth:
+ * @self: The #GoclPipeline
+ *
+ * Obtains the number of slots of the pipeline, which is the maximum number
+ * of frames in flight.
+ *
+ * Returns: The number of slots
+ **/
+guint
+gocl_pipeline_get_depth (GoclPipeline *self)
+{
+  g_return_val_if_fail (GOCL_IS_PIPELINE (self), 0);
+
+  return self->priv->depth;
+}
+
+/**
+ * gocl_pipeline_set_argument_indices:
+ * @self: The #GoclPipeline
+ * @input_index: The index of the kernel argument that receives the input
+ * buffer of each frame
+ * @output_index: The index of the kernel argument that receives the output
+ * buffer of each frame
+ *
+ * Sets which arguments of the kernel are set to the buffers of the slot of
+ * each frame. The defaults are 0 for the input and 1 for the output.
+ **/
+void
+gocl_pipeline_set_argument_indices (GoclPipeline *self,
+                                    guint         input_index,
+                                    guint         output_index)
+{
+  g_return_if_fail (GOCL_IS_PIPELINE (self));
+  g_return_if_fail (input_index != output_index);
+
+  self->priv->input_index = input_index;
+  self->priv->output_index = output_index;
+}
+
+/**
+ * gocl_pipeline_set_slot_buffers:
+ * @self: The #GoclPipeline
+ * @slot: The index of the slot, between 0 and the depth minus one
+ * @input: (allow-none): The #GoclBuffer or #GoclImage to upload input to, or
+ * %NULL to keep the current one
+ * @output: (allow-none): The #GoclBuffer or #GoclImage to download output
+ * from, or %NULL to keep the current one
+ *
+ * Replaces the buffers of a slot. Images are transferred whole, and host
+ * memory is expected to be tightly packed. This must not be called while
+ * the slot holds a frame in flight, so it is normally done right after
+ * creating the pipeline.
+ *
+ * Returns: %TRUE on success, %FALSE if the slot holds a frame in flight
+ **/
+gboolean
+gocl_pipeline_set_slot_buffers (GoclPipeline *self,
+                                guint         slot,
+                                GoclBuffer   *input,
+                                GoclBuffer   *output)
+{
+  Slot *_slot;
+
+  g_return_val_if_fail (GOCL_IS_PIPELINE (self), FALSE);
+  g_return_val_if_fail (slot < self->priv->depth, FALSE);
+  g_return_val_if_fail (input == NULL || GOCL_IS_BUFFER (input), FALSE);
+  g_return_val_if_fail (output == NULL || GOCL_IS_BUFFER (output), FALSE);
+
+  _slot = &self->priv->slots[slot];
+
+  if (_slot->done_event != NULL && ! event_is_complete (_slot->done_event))
+    return FALSE;
+
+  if (input != NULL)
+    {
+      g_object_ref (input);
+      if (_slot->input != NULL)
+        g_object_unref (_slot->input);
+      _slot->input = input;
+    }
+
+  if (output != NULL)
+    {
+      g_object_ref (output);
+      if (_slot->output != NULL)
+        g_object_unref (_slot->output);
+      _slot->output = output;
+    }
+
+  return TRUE;
+}
+
+/**
+ * gocl_pipeline_can_push:
+ * @self: The #GoclPipeline
+ *
+ * Tells whether gocl_pipeline_push() would return right away, because the
+ * next slot holds no frame in flight.
+ *
+ * Returns: %TRUE if a frame can be pushed without blocking, %FALSE otherwise
+ **/
+gboolean
+gocl_pipeline_can_push (GoclPipeline *self)
+{
+  Slot *slot;
+
+  g_return_val_if_fail (GOCL_IS_PIPELINE (self), FALSE);
+
+  slot = &self->priv->slots[self->priv->next_slot];
+
+  return slot->done_event == NULL || event_is_complete (slot->done_event);
+}
+
+/**
+ * gocl_pipeline_push:
+ * @self: The #GoclPipeline
+ * @input: The host memory to upload the input of the frame from
+ * @output: The host memory to download the output of the frame to
+ *
+ * Submits a new frame to the pipeline, by enqueuing the upload of @input,
+ * the execution of the kernel, and the download of the result into @output.
+ * The memory pointed by @input must remain valid until the upload completes,
+ * and @output must not be accessed until the returned event triggers.
+ *
+ * If all slots hold frames in flight, this method blocks until the oldest
+ * of these frames completes. See gocl_pipeline_can_push().
+ *
+ * Returns: (transfer none): A #GoclEvent to get notified when the output of
+ * the frame is available in @output
+ **/
+GoclEvent *
+gocl_pipeline_push (GoclPipeline  *self,
+                    gconstpointer  input,
+                    gpointer       output)
+{
+  Slot *slot;
+  GoclEvent *upload_event;
+  GoclEvent *compute_event;
+  GoclEvent *download_event;
+
+  g_return_val_if_fail (GOCL_IS_PIPELINE (self), NULL);
+  g_return_val_if_fail (input != NULL, NULL);
+  g_return_val_if_fail (output != NULL, NULL);
+
+  slot = &self->priv->slots[self->priv->next_slot];
+  g_return_val_if_fail (slot->input != NULL && slot->output != NULL, NULL);
+
+  self->priv->next_slot = (self->priv->next_slot + 1) % self->priv->depth;
+
+  /* backpressure: the slot is reused only after its last frame is out */
+  if (slot->done_event != NULL)
+    {
+      gocl_event_wait (slot->done_event);
+      g_object_unref (slot->done_event);
+      slot->done_event = NULL;
+    }
+
+  upload_event = upload (self, slot, input);
+
+  /* arguments are captured when the kernel is enqueued */
+  gocl_kernel_set_argument_buffer (self->priv->kernel,
+                                   self->priv->input_index,
+                                   slot->input);
+  gocl_kernel_set_argument_buffer (self->priv->kernel,
+                                   self->priv->output_index,
+                                   slot->output);
+  compute_event = gocl_kernel_run_in_queue_with_events (self->priv->kernel,
+                                                        self->priv->compute_queue,
+                                                        &upload_event,
+                                                        1);
+
+  download_event = download (self, slot, output, compute_event);
+  slot->done_event = g_object_ref (download_event);
+
+  /* submit right away, each queue would otherwise wait for its own flush */
+  gocl_queue_flush (self->priv->upload_queue);
+  gocl_queue_flush (self->priv->compute_queue);
+  gocl_queue_flush (self->priv->download_queue);
+
+  return download_event;
+}
+
+/**
+ * gocl_pipeline_flush_sync:
+ * @self: The #GoclPipeline
+ *
+ * Blocks program execution until all the frames in flight have completed.
+ *
+ * Returns: %TRUE if all frames completed successfully, %FALSE on error
+ **/
+gboolean
+gocl_pipeline_flush_sync (GoclPipeline *self)
+{
+  GList *event_list = NULL;
+  gboolean result;
+  guint i;
+
+  g_return_val_if_fail (GOCL_IS_PIPELINE (self), FALSE);
+
+  for (i = 0; i < self->priv->depth; i++)
+    {
+      Slot *slot = &self->priv->slots[i];
+
+      if (slot->done_event != NULL)
+        event_list = g_list_prepend (event_list, slot->done_event);
+    }
+
+  result = gocl_event_wait_all (event_list);
+  g_list_free (event_list);
+
+  for (i = 0; i < self->priv->depth; i++)
+    {
+      Slot *slot = &self->priv->slots[i];
+
+      if (slot->done_event != NULL)
+        {
+          g_object_unref (slot->done_event);
+          slot->done_event = NULL;
+        }
+    }
+
+  return result;
+}
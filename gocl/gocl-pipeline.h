@@ -0,0 +1,85 @@
+/*
+ * gocl-pipeline.h
+ *
+ * Gocl - GLib/GObject wrapper for OpenCL
+ * Copyright (C) 2012-2013 Igalia S.L.
+ *
+ * Authors:
+ *  Eduardo Lima Mitev <elima@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License at http://www.gnu.org/licenses/lgpl-3.0.txt
+ * for more details.
+ */
+
+#ifndef __GOCL_PIPELINE_H__
+#define __GOCL_PIPELINE_H__
+
+#include <glib-object.h>
+
+#include "gocl-kernel.h"
+#include "gocl-device.h"
+#include "gocl-buffer.h"
+#include "gocl-event.h"
+
+G_BEGIN_DECLS
+
+#define GOCL_TYPE_PIPELINE              (gocl_pipeline_get_type ())
+#define GOCL_PIPELINE(obj)              (G_TYPE_CHECK_INSTANCE_CAST ((obj), GOCL_TYPE_PIPELINE, GoclPipeline))
+#define GOCL_PIPELINE_CLASS(klass)      (G_TYPE_CHECK_CLASS_CAST ((klass), GOCL_TYPE_PIPELINE, GoclPipelineClass))
+#define GOCL_IS_PIPELINE(obj)           (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GOCL_TYPE_PIPELINE))
+#define GOCL_IS_PIPELINE_CLASS(klass)   (G_TYPE_CHECK_CLASS_TYPE ((klass), GOCL_TYPE_PIPELINE))
+#define GOCL_PIPELINE_GET_CLASS(obj)    (G_TYPE_INSTANCE_GET_CLASS ((obj), GOCL_TYPE_PIPELINE, GoclPipelineClass))
+
+typedef struct _GoclPipelineClass GoclPipelineClass;
+typedef struct _GoclPipeline GoclPipeline;
+typedef struct _GoclPipelinePrivate GoclPipelinePrivate;
+
+struct _GoclPipeline
+{
+  GObject parent_instance;
+
+  GoclPipelinePrivate *priv;
+};
+
+struct _GoclPipelineClass
+{
+  GObjectClass parent_class;
+};
+
+GType                  gocl_pipeline_get_type                 (void) G_GNUC_CONST;
+
+GoclPipeline *         gocl_pipeline_new                      (GoclKernel *kernel,
+                                                               GoclDevice *device,
+                                                               guint       depth,
+                                                               gsize       input_size,
+                                                               gsize       output_size);
+
+GoclKernel *           gocl_pipeline_get_kernel               (GoclPipeline *self);
+GoclDevice *           gocl_pipeline_get_device               (GoclPipeline *self);
+guint                  gocl_pipeline_get_depth                (GoclPipeline *self);
+
+void                   gocl_pipeline_set_argument_indices     (GoclPipeline *self,
+                                                               guint         input_index,
+                                                               guint         output_index);
+gboolean               gocl_pipeline_set_slot_buffers         (GoclPipeline *self,
+                                                               guint         slot,
+                                                               GoclBuffer   *input,
+                                                               GoclBuffer   *output);
+
+gboolean               gocl_pipeline_can_push                 (GoclPipeline *self);
+GoclEvent *            gocl_pipeline_push                     (GoclPipeline  *self,
+                                                               gconstpointer  input,
+                                                               gpointer       output);
+gboolean               gocl_pipeline_flush_sync               (GoclPipeline *self);
+
+G_END_DECLS
+
+#endif /* __GOCL_PIPELINE_H__ */
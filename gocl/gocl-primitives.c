@@ -0,0 +1,1837 @@
+/*
+ * gocl-primitives.c
+ *
+ * Gocl - GLib/GObject wrapper for OpenCL
+ * Copyright (C) 2012-2013 Igalia S.L.
+ *
+ * Authors:
+ *  Eduardo Lima Mitev <elima@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License at http://www.gnu.org/licenses/lgpl-3.0.txt
+ * for more details.
+ */
+
+/**
+ * SECTION:gocl-primitives
+ * @short_description: Object that runs common parallel algorithms
+ * @stability: Unstable
+ *
+ * A #GoclPrimitives provides ready-made implementations of the parallel
+ * building blocks most applications end up writing themselves: reductions
+ * with gocl_primitives_reduce(), exclusive prefix sums with
+ * gocl_primitives_scan(), radix sort of unsigned integer keys with
+ * gocl_primitives_sort(), histograms with gocl_primitives_histogram() and
+ * separable 2D convolutions, like a gaussian blur, with
+ * gocl_primitives_convolve_separable().
+ *
+ * A #GoclPrimitives is created for a #GoclContext with
+ * gocl_primitives_new(). The kernels are built for each #GoclPrimitivesType
+ * the first time an operation uses it, which blocks, and the program binary
+ * cache of #GoclProgram makes later runs of the application skip the
+ * compilation. gocl_primitives_prepare_sync() builds them upfront.
+ *
+ * Work-group sizes are chosen for the device of the queue each operation is
+ * enqueued in, from the limits of the kernels on that device and its local
+ * memory size, and remembered afterwards. Reductions and histograms run a
+ * number of work-groups proportional to the device's compute units, each
+ * going over the input with vector loads where possible. Convolutions stage
+ * each tile of the input, including the borders the mask reaches, in local
+ * memory, and apply the mask by rows and then by columns, so the cost per
+ * pixel grows linearly with the mask size.
+ *
+ * All operations are asynchronous and return a #GoclEvent that completes
+ * when the result is available. Temporary buffers are allocated as needed
+ * and released when the commands using them finish. Buffers passed to
+ * these operations must not be managed buffers.
+ **/
+
+/**
+ * GoclPrimitivesClass:
+ * @parent_class: The parent class
+ *
+ * The class for #GoclPrimitives objects.
+ **/
+
+#include <math.h>
+#include <string.h>
+
+#include "gocl-primitives.h"
+
+#include "gocl-private.h"
+#include "gocl-error.h"
+
+#define NUM_TYPES               3
+#define ELEMENT_SIZE            4
+#define MAX_WORK_GROUP_SIZE     256
+#define GROUPS_PER_COMPUTE_UNIT 4
+#define TILE_SIZE               16
+#define RADIX_BITS              4
+#define RADIX                   (1 << RADIX_BITS)
+#define TEMP_TAG                "primitives"
+
+enum
+{
+  KERNEL_REDUCE,
+  KERNEL_SCAN_BLOCKS,
+  KERNEL_SCAN_ADD,
+  KERNEL_HISTOGRAM,
+  KERNEL_HISTOGRAM_GLOBAL,
+  KERNEL_RADIX_COUNT,
+  KERNEL_RADIX_SCATTER,
+  KERNEL_CONVOLVE_ROWS,
+  KERNEL_CONVOLVE_COLUMNS,
+  NUM_KERNELS
+};
+
+static const gchar *kernel_names[NUM_KERNELS] =
+  {
+    "reduce",
+    "scan_blocks",
+    "scan_add",
+    "histogram",
+    "histogram_global",
+    "radix_count",
+    "radix_scatter",
+    "convolve_rows",
+    "convolve_columns"
+  };
+
+/* bytes of local memory each work-item needs, for 1D kernels */
+static const gsize kernel_local_bytes[NUM_KERNELS] =
+  {
+    ELEMENT_SIZE,
+    ELEMENT_SIZE * 2,
+    0,
+    0,
+    0,
+    0,
+    ELEMENT_SIZE * 2,
+    0,
+    0
+  };
+
+static const gchar *type_options[NUM_TYPES] =
+  {
+    "-D T=float -D T4=float4 -D T_FLOAT",
+    "-D T=int -D T4=int4 -D T_INT",
+    "-D T=uint -D T4=uint4 -D T_UINT"
+  };
+
+static const gchar *primitives_source =
+  "/* T and T4 are the element type and its vector of four, and one of\n"
+  "   T_FLOAT, T_INT or T_UINT is defined, all given as build options */\n"
+  "\n"
+  "#define OP_SUM 0\n"
+  "#define OP_MIN 1\n"
+  "#define OP_MAX 2\n"
+  "\n"
+  "#define RADIX_BITS 4\n"
+  "#define RADIX (1 << RADIX_BITS)\n"
+  "\n"
+  "inline T\n"
+  "combine (T a, T b, uint op)\n"
+  "{\n"
+  "  if (op == OP_MIN)\n"
+  "    return min (a, b);\n"
+  "  else if (op == OP_MAX)\n"
+  "    return max (a, b);\n"
+  "  else\n"
+  "    return a + b;\n"
+  "}\n"
+  "\n"
+  "__kernel void\n"
+  "reduce (__global const T *input,\n"
+  "        uint              count,\n"
+  "        __global T       *output,\n"
+  "        __local T        *scratch,\n"
+  "        uint              op,\n"
+  "        T                 identity)\n"
+  "{\n"
+  "  uint lid = get_local_id (0);\n"
+  "  uint stride = get_global_size (0);\n"
+  "  uint i;\n"
+  "  T acc = identity;\n"
+  "\n"
+  "  /* vector loads over the bulk of the input, scalar ones for the tail */\n"
+  "  for (i = get_global_id (0); i < count / 4; i += stride)\n"
+  "    {\n"
+  "      T4 v = vload4 (i, input);\n"
+  "\n"
+  "      acc = combine (acc, combine (combine (v.x, v.y), combine (v.z, v.w), op), op);\n"
+  "    }\n"
+  "  for (i = (count & ~3u) + get_global_id (0); i < count; i += stride)\n"
+  "    acc = combine (acc, input[i], op);\n"
+  "\n"
+  "  scratch[lid] = acc;\n"
+  "  barrier (CLK_LOCAL_MEM_FENCE);\n"
+  "\n"
+  "  for (i = get_local_size (0) / 2; i > 0; i >>= 1)\n"
+  "    {\n"
+  "      if (lid < i)\n"
+  "        scratch[lid] = combine (scratch[lid], scratch[lid + i], op);\n"
+  "      barrier (CLK_LOCAL_MEM_FENCE);\n"
+  "    }\n"
+  "\n"
+  "  if (lid == 0)\n"
+  "    output[get_group_id (0)] = scratch[0];\n"
+  "}\n"
+  "\n"
+  "/* exclusive scan of a block of twice the work-group size, which must be a\n"
+  "   power of two; input and output may be the same buffer */\n"
+  "__kernel void\n"
+  "scan_blocks (__global const T *input,\n"
+  "             __global T       *output,\n"
+  "             uint              count,\n"
+  "             __global T       *block_sums,\n"
+  "             __local T        *scratch)\n"
+  "{\n"
+  "  uint lid = get_local_id (0);\n"
+  "  uint n = get_local_size (0) * 2;\n"
+  "  uint base = get_group_id (0) * n;\n"
+  "  uint offset = 1;\n"
+  "  uint d;\n"
+  "\n"
+  "  scratch[2 * lid] = base + 2 * lid < count ? input[base + 2 * lid] : 0;\n"
+  "  scratch[2 * lid + 1] = base + 2 * lid + 1 < count ? input[base + 2 * lid + 1] : 0;\n"
+  "\n"
+  "  for (d = n / 2; d > 0; d /= 2)\n"
+  "    {\n"
+  "      barrier (CLK_LOCAL_MEM_FENCE);\n"
+  "      if (lid < d)\n"
+  "        scratch[offset * (2 * lid + 2) - 1] += scratch[offset * (2 * lid + 1) - 1];\n"
+  "      offset *= 2;\n"
+  "    }\n"
+  "\n"
+  "  if (lid == 0)\n"
+  "    {\n"
+  "      block_sums[get_group_id (0)] = scratch[n - 1];\n"
+  "      scratch[n - 1] = 0;\n"
+  "    }\n"
+  "\n"
+  "  for (d = 1; d < n; d *= 2)\n"
+  "    {\n"
+  "      offset /= 2;\n"
+  "      barrier (CLK_LOCAL_MEM_FENCE);\n"
+  "      if (lid < d)\n"
+  "        {\n"
+  "          uint ai = offset * (2 * lid + 1) - 1;\n"
+  "          uint bi = offset * (2 * lid + 2) - 1;\n"
+  "          T t = scratch[ai];\n"
+  "\n"
+  "          scratch[ai] = scratch[bi];\n"
+  "          scratch[bi] += t;\n"
+  "        }\n"
+  "    }\n"
+  "  barrier (CLK_LOCAL_MEM_FENCE);\n"
+  "\n"
+  "  if (base + 2 * lid < count)\n"
+  "    output[base + 2 * lid] = scratch[2 * lid];\n"
+  "  if (base + 2 * lid + 1 < count)\n"
+  "    output[base + 2 * lid + 1] = scratch[2 * lid + 1];\n"
+  "}\n"
+  "\n"
+  "__kernel void\n"
+  "scan_add (__global T       *output,\n"
+  "          uint              count,\n"
+  "          __global const T *block_offsets)\n"
+  "{\n"
+  "  uint half_block = get_local_size (0);\n"
+  "  uint i = get_group_id (0) * half_block * 2 + get_local_id (0);\n"
+  "  T offset = block_offsets[get_group_id (0)];\n"
+  "\n"
+  "  if (i < count)\n"
+  "    output[i] += offset;\n"
+  "  if (i + half_block < count)\n"
+  "    output[i + half_block] += offset;\n"
+  "}\n"
+  "\n"
+  "#ifdef T_UINT\n"
+  "\n"
+  "__kernel void\n"
+  "histogram (__global const uint *input,\n"
+  "           uint                 count,\n"
+  "           __global uint       *bins,\n"
+  "           uint                 num_bins,\n"
+  "           __local uint        *local_bins)\n"
+  "{\n"
+  "  uint lid = get_local_id (0);\n"
+  "  uint size = get_local_size (0);\n"
+  "  uint i;\n"
+  "\n"
+  "  for (i = lid; i < num_bins; i += size)\n"
+  "    local_bins[i] = 0;\n"
+  "  barrier (CLK_LOCAL_MEM_FENCE);\n"
+  "\n"
+  "  for (i = get_global_id (0); i < count; i += get_global_size (0))\n"
+  "    {\n"
+  "      uint value = input[i];\n"
+  "\n"
+  "      if (value < num_bins)\n"
+  "        atomic_inc (&local_bins[value]);\n"
+  "    }\n"
+  "  barrier (CLK_LOCAL_MEM_FENCE);\n"
+  "\n"
+  "  for (i = lid; i < num_bins; i += size)\n"
+  "    if (local_bins[i] > 0)\n"
+  "      atomic_add (&bins[i], local_bins[i]);\n"
+  "}\n"
+  "\n"
+  "/* for bin counts that do not fit in local memory */\n"
+  "__kernel void\n"
+  "histogram_global (__global const uint *input,\n"
+  "                  uint                 count,\n"
+  "                  __global uint       *bins,\n"
+  "                  uint                 num_bins)\n"
+  "{\n"
+  "  uint i;\n"
+  "\n"
+  "  for (i = get_global_id (0); i < count; i += get_global_size (0))\n"
+  "    {\n"
+  "      uint value = input[i];\n"
+  "\n"
+  "      if (value < num_bins)\n"
+  "        atomic_inc (&bins[value]);\n"
+  "    }\n"
+  "}\n"
+  "\n"
+  "/* digit counts of each tile, stored digit-major so that their exclusive\n"
+  "   scan gives where each tile scatters each digit */\n"
+  "__kernel void\n"
+  "radix_count (__global const uint *keys,\n"
+  "             uint                 count,\n"
+  "             uint                 shift,\n"
+  "             uint                 tile,\n"
+  "             __global uint       *histograms)\n"
+  "{\n"
+  "  __local uint counts[RADIX];\n"
+  "  uint lid = get_local_id (0);\n"
+  "  uint size = get_local_size (0);\n"
+  "  uint group = get_group_id (0);\n"
+  "  uint start = group * tile;\n"
+  "  uint end = min (start + tile, count);\n"
+  "  uint i;\n"
+  "\n"
+  "  for (i = lid; i < RADIX; i += size)\n"
+  "    counts[i] = 0;\n"
+  "  barrier (CLK_LOCAL_MEM_FENCE);\n"
+  "\n"
+  "  for (i = start + lid; i < end; i += size)\n"
+  "    atomic_inc (&counts[(keys[i] >> shift) & (RADIX - 1)]);\n"
+  "  barrier (CLK_LOCAL_MEM_FENCE);\n"
+  "\n"
+  "  for (i = lid; i < RADIX; i += size)\n"
+  "    histograms[i * get_num_groups (0) + group] = counts[i];\n"
+  "}\n"
+  "\n"
+  "inline uint\n"
+  "scan_local (uint value, __local uint *scratch, uint *total)\n"
+  "{\n"
+  "  uint lid = get_local_id (0);\n"
+  "  uint size = get_local_size (0);\n"
+  "  uint offset;\n"
+  "  uint result;\n"
+  "\n"
+  "  scratch[lid] = value;\n"
+  "  barrier (CLK_LOCAL_MEM_FENCE);\n"
+  "\n"
+  "  for (offset = 1; offset < size; offset *= 2)\n"
+  "    {\n"
+  "      uint t = lid >= offset ? scratch[lid - offset] : 0;\n"
+  "\n"
+  "      barrier (CLK_LOCAL_MEM_FENCE);\n"
+  "      scratch[lid] += t;\n"
+  "      barrier (CLK_LOCAL_MEM_FENCE);\n"
+  "    }\n"
+  "\n"
+  "  *total = scratch[size - 1];\n"
+  "  result = scratch[lid] - value;\n"
+  "  barrier (CLK_LOCAL_MEM_FENCE);\n"
+  "\n"
+  "  return result;\n"
+  "}\n"
+  "\n"
+  "__kernel void\n"
+  "radix_scatter (__global const uint *keys,\n"
+  "               uint                 count,\n"
+  "               uint                 shift,\n"
+  "               uint                 tile,\n"
+  "               __global const uint *offsets,\n"
+  "               __global uint       *output,\n"
+  "               __local uint        *local_keys,\n"
+  "               __local uint        *scratch)\n"
+  "{\n"
+  "  __local uint digit_start[RADIX];\n"
+  "  __local uint digit_base[RADIX];\n"
+  "  uint lid = get_local_id (0);\n"
+  "  uint size = get_local_size (0);\n"
+  "  uint group = get_group_id (0);\n"
+  "  uint start = group * tile;\n"
+  "  uint end = min (start + tile, count);\n"
+  "  uint chunk;\n"
+  "  uint i;\n"
+  "\n"
+  "  for (i = lid; i < RADIX; i += size)\n"
+  "    digit_base[i] = offsets[i * get_num_groups (0) + group];\n"
+  "  barrier (CLK_LOCAL_MEM_FENCE);\n"
+  "\n"
+  "  for (chunk = start; chunk < end; chunk += size)\n"
+  "    {\n"
+  "      uint valid = min (size, end - chunk);\n"
+  "      uint key = lid < valid ? keys[chunk + lid] : 0xffffffffu;\n"
+  "      uint digit;\n"
+  "      uint bit;\n"
+  "\n"
+  "      /* stable sort of the chunk by the digit, one bit at a time; padding\n"
+  "         keys have all bits set, so they stay at the end */\n"
+  "      for (bit = 0; bit < RADIX_BITS; bit++)\n"
+  "        {\n"
+  "          uint is_zero = ((key >> (shift + bit)) & 1) == 0;\n"
+  "          uint zeros;\n"
+  "          uint pos;\n"
+  "\n"
+  "          pos = scan_local (is_zero, scratch, &zeros);\n"
+  "          if (! is_zero)\n"
+  "            pos = zeros + lid - pos;\n"
+  "\n"
+  "          local_keys[pos] = key;\n"
+  "          barrier (CLK_LOCAL_MEM_FENCE);\n"
+  "          key = local_keys[lid];\n"
+  "          barrier (CLK_LOCAL_MEM_FENCE);\n"
+  "        }\n"
+  "\n"
+  "      digit = (key >> shift) & (RADIX - 1);\n"
+  "      scratch[lid] = digit;\n"
+  "      barrier (CLK_LOCAL_MEM_FENCE);\n"
+  "\n"
+  "      if (lid < valid && (lid == 0 || scratch[lid - 1] != digit))\n"
+  "        digit_start[digit] = lid;\n"
+  "      barrier (CLK_LOCAL_MEM_FENCE);\n"
+  "\n"
+  "      if (lid < valid)\n"
+  "        output[digit_base[digit] + lid - digit_start[digit]] = key;\n"
+  "      barrier (CLK_LOCAL_MEM_FENCE);\n"
+  "\n"
+  "      if (lid < valid && (lid == valid - 1 || scratch[lid + 1] != digit))\n"
+  "        digit_base[digit] += lid + 1 - digit_start[digit];\n"
+  "      barrier (CLK_LOCAL_MEM_FENCE);\n"
+  "    }\n"
+  "}\n"
+  "\n"
+  "#endif /* T_UINT */\n"
+  "\n"
+  "#ifdef T_FLOAT\n"
+  "\n"
+  "/* each work-group loads its rows, plus the borders the mask reaches, into\n"
+  "   local memory once, instead of every work-item reading them again */\n"
+  "__kernel void\n"
+  "convolve_rows (__global const float *input,\n"
+  "               __global float       *output,\n"
+  "               uint                  width,\n"
+  "               uint                  height,\n"
+  "               __constant float     *mask,\n"
+  "               uint                  radius,\n"
+  "               __local float        *tile)\n"
+  "{\n"
+  "  uint lx = get_local_id (0);\n"
+  "  uint lw = get_local_size (0);\n"
+  "  uint x = get_global_id (0);\n"
+  "  uint y = get_global_id (1);\n"
+  "  uint row_len = lw + 2 * radius;\n"
+  "  int origin = (int) (get_group_id (0) * lw) - (int) radius;\n"
+  "  __local float *row = tile + get_local_id (1) * row_len;\n"
+  "  __global const float *src = input + min (y, height - 1) * width;\n"
+  "  uint i;\n"
+  "\n"
+  "  for (i = lx; i < row_len; i += lw)\n"
+  "    row[i] = src[clamp (origin + (int) i, 0, (int) width - 1)];\n"
+  "  barrier (CLK_LOCAL_MEM_FENCE);\n"
+  "\n"
+  "  if (x < width && y < height)\n"
+  "    {\n"
+  "      float sum = 0.0f;\n"
+  "\n"
+  "      for (i = 0; i <= 2 * radius; i++)\n"
+  "        sum = mad (mask[i], row[lx + i], sum);\n"
+  "\n"
+  "      output[y * width + x] = sum;\n"
+  "    }\n"
+  "}\n"
+  "\n"
+  "__kernel void\n"
+  "convolve_columns (__global const float *input,\n"
+  "                  __global float       *output,\n"
+  "                  uint                  width,\n"
+  "                  uint                  height,\n"
+  "                  __constant float     *mask,\n"
+  "                  uint                  radius,\n"
+  "                  __local float        *tile)\n"
+  "{\n"
+  "  uint lx = get_local_id (0);\n"
+  "  uint ly = get_local_id (1);\n"
+  "  uint lw = get_local_size (0);\n"
+  "  uint lh = get_local_size (1);\n"
+  "  uint x = get_global_id (0);\n"
+  "  uint y = get_global_id (1);\n"
+  "  uint column_len = lh + 2 * radius;\n"
+  "  int origin = (int) (get_group_id (1) * lh) - (int) radius;\n"
+  "  __global const float *src = input + min (x, width - 1);\n"
+  "  uint i;\n"
+  "\n"
+  "  for (i = ly; i < column_len; i += lh)\n"
+  "    tile[i * lw + lx] = src[clamp (origin + (int) i, 0, (int) height - 1) * width];\n"
+  "  barrier (CLK_LOCAL_MEM_FENCE);\n"
+  "\n"
+  "  if (x < width && y < height)\n"
+  "    {\n"
+  "      float sum = 0.0f;\n"
+  "\n"
+  "      for (i = 0; i <= 2 * radius; i++)\n"
+  "        sum = mad (mask[i], tile[(ly + i) * lw + lx], sum);\n"
+  "\n"
+  "      output[y * width + x] = sum;\n"
+  "    }\n"
+  "}\n"
+  "\n"
+  "#endif /* T_FLOAT */\n";
+
+typedef struct
+{
+  GoclProgram *program;
+  GoclKernel *kernels[NUM_KERNELS];
+} TypeData;
+
+struct _GoclPrimitivesPrivate
+{
+  GoclContext *context;
+
+  /* kernel arguments are shared, so operations are enqueued one at a time */
+  GMutex mutex;
+  TypeData types[NUM_TYPES];
+
+  /* arrays of NUM_TYPES * NUM_KERNELS work-group sizes, by cl_device_id */
+  GHashTable *work_group_sizes;
+};
+
+/* the state of an operation being enqueued */
+typedef struct
+{
+  GoclPrimitives *self;
+  GoclQueue *queue;
+  cl_command_queue cl_queue;
+  const GoclDeviceProps *props;
+  GoclPrimitivesType type;
+
+  /* the first command waits for these, and each of the others for the
+     previous one, so that out-of-order queues keep the sequence */
+  const GoclWaitList *wait_list;
+  cl_event last_event;
+
+  GError *error;
+} Op;
+
+typedef union
+{
+  gfloat f;
+  gint32 i;
+  guint32 u;
+} Element;
+
+/* properties */
+enum
+{
+  PROP_0,
+  PROP_CONTEXT
+};
+
+static void           gocl_primitives_class_init         (GoclPrimitivesClass *class);
+static void           gocl_primitives_init               (GoclPrimitives *self);
+static void           gocl_primitives_finalize           (GObject *obj);
+
+static void           set_property                       (GObject      *obj,
+                                                          guint         prop_id,
+                                                          const GValue *value,
+                                                          GParamSpec   *pspec);
+static void           get_property                       (GObject    *obj,
+                                                          guint       prop_id,
+                                                          GValue     *value,
+                                                          GParamSpec *pspec);
+
+static void           enqueue_scan                       (Op     *op,
+                                                          cl_mem  input,
+                                                          cl_mem  output,
+                                                          gsize   count);
+
+G_DEFINE_TYPE (GoclPrimitives, gocl_primitives, G_TYPE_OBJECT)
+
+#define GOCL_PRIMITIVES_GET_PRIVATE(obj)                        \
+  (G_TYPE_INSTANCE_GET_PRIVATE ((obj),                          \
+                                GOCL_TYPE_PRIMITIVES,           \
+                                GoclPrimitivesPrivate))         \
+
+static void
+gocl_primitives_class_init (GoclPrimitivesClass *class)
+{
+  GObjectClass *obj_class = G_OBJECT_CLASS (class);
+
+  obj_class->finalize = gocl_primitives_finalize;
+  obj_class->get_property = get_property;
+  obj_class->set_property = set_property;
+
+  g_object_class_install_property (obj_class, PROP_CONTEXT,
+                                   g_param_spec_object ("context",
+                                                        "Context",
+                                                        "The context where operations run",
+                                                        GOCL_TYPE_CONTEXT,
+                                                        G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
+                                                        G_PARAM_STATIC_STRINGS));
+
+  g_type_class_add_private (class, sizeof (GoclPrimitivesPrivate));
+}
+
+static void
+gocl_primitives_init (GoclPrimitives *self)
+{
+  GoclPrimitivesPrivate *priv;
+
+  self->priv = priv = GOCL_PRIMITIVES_GET_PRIVATE (self);
+
+  priv->context = NULL;
+
+  g_mutex_init (&priv->mutex);
+  memset (priv->types, 0, sizeof (priv->types));
+
+  priv->work_group_sizes = g_hash_table_new_full (g_direct_hash,
+                                                  g_direct_equal,
+                                                  NULL,
+                                                  g_free);
+}
+
+static void
+gocl_primitives_finalize (GObject *obj)
+{
+  GoclPrimitives *self = GOCL_PRIMITIVES (obj);
+  guint i;
+  guint j;
+
+  for (i = 0; i < NUM_TYPES; i++)
+    {
+      for (j = 0; j < NUM_KERNELS; j++)
+        if (self->priv->types[i].kernels[j] != NULL)
+          g_object_unref (self->priv->types[i].kernels[j]);
+
+      if (self->priv->types[i].program != NULL)
+        g_object_unref (self->priv->types[i].program);
+    }
+
+  g_hash_table_unref (self->priv->work_group_sizes);
+  g_mutex_clear (&self->priv->mutex);
+
+  g_object_unref (self->priv->context);
+
+  G_OBJECT_CLASS (gocl_primitives_parent_class)->finalize (obj);
+}
+
+static void
+set_property (GObject      *obj,
+              guint         prop_id,
+              const GValue *value,
+              GParamSpec   *pspec)
+{
+  GoclPrimitives *self;
+
+  self = GOCL_PRIMITIVES (obj);
+
+  switch (prop_id)
+    {
+    case PROP_CONTEXT:
+      self->priv->context = g_value_dup_object (value);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
+      break;
+    }
+}
+
+static void
+get_property (GObject    *obj,
+              guint       prop_id,
+              GValue     *value,
+              GParamSpec *pspec)
+{
+  GoclPrimitives *self;
+
+  self = GOCL_PRIMITIVES (obj);
+
+  switch (prop_id)
+    {
+    case PROP_CONTEXT:
+      g_value_set_object (value, self->priv->context);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
+      break;
+    }
+}
+
+static void
+set_error (GError **error)
+{
+  *error = gocl_error_get_last ();
+  if (*error == NULL)
+    gocl_error_check_opencl (CL_BUILD_PROGRAM_FAILURE, error);
+}
+
+/* called with the mutex held */
+static gboolean
+ensure_program (GoclPrimitives *self, GoclPrimitivesType type, GError **error)
+{
+  TypeData *data = &self->priv->types[type];
+  const gchar *sources[] = { primitives_source, NULL };
+
+  if (data->program != NULL)
+    return TRUE;
+
+  data->program = gocl_program_new (self->priv->context, sources, 1);
+  if (data->program == NULL)
+    {
+      set_error (error);
+      return FALSE;
+    }
+
+  if (! gocl_program_build_sync (data->program, type_options[type]))
+    {
+      set_error (error);
+      g_object_unref (data->program);
+      data->program = NULL;
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+op_init (Op                 *op,
+         GoclPrimitives     *self,
+         GoclQueue          *queue,
+         GoclPrimitivesType  type,
+         const GoclWaitList *wait_list)
+{
+  cl_device_id device_id;
+
+  op->self = self;
+  op->queue = queue;
+  op->cl_queue = gocl_queue_get_queue (queue);
+  op->type = type;
+  op->wait_list = wait_list;
+  op->last_event = NULL;
+  op->error = NULL;
+
+  device_id = gocl_device_get_id (gocl_queue_get_device (queue));
+  op->props = gocl_context_get_device_props (self->priv->context, device_id);
+  if (op->props == NULL)
+    {
+      gocl_error_check_opencl (CL_INVALID_DEVICE, &op->error);
+      return FALSE;
+    }
+
+  return ensure_program (self, type, &op->error);
+}
+
+static GoclKernel *
+op_get_kernel (Op *op, guint kernel_index)
+{
+  TypeData *data = &op->self->priv->types[op->type];
+
+  if (op->error != NULL)
+    return NULL;
+
+  if (data->kernels[kernel_index] == NULL)
+    {
+      data->kernels[kernel_index] =
+        gocl_program_get_kernel (data->program, kernel_names[kernel_index]);
+      if (data->kernels[kernel_index] == NULL)
+        set_error (&op->error);
+    }
+
+  return data->kernels[kernel_index];
+}
+
+/* the largest power of two the kernel accepts on the device, within the
+   local memory the work-items need */
+static gsize
+op_get_work_group_size (Op *op, guint kernel_index)
+{
+  GoclKernel *kernel;
+  gsize *sizes;
+  gsize *size;
+  gsize max_size;
+  cl_ulong static_local_size = 0;
+  cl_int err_code;
+
+  kernel = op_get_kernel (op, kernel_index);
+  if (kernel == NULL)
+    return 0;
+
+  sizes = g_hash_table_lookup (op->self->priv->work_group_sizes,
+                               op->props->id);
+  if (sizes == NULL)
+    {
+      sizes = g_new0 (gsize, NUM_TYPES * NUM_KERNELS);
+      g_hash_table_insert (op->self->priv->work_group_sizes,
+                           op->props->id,
+                           sizes);
+    }
+
+  size = &sizes[op->type * NUM_KERNELS + kernel_index];
+  if (*size > 0)
+    return *size;
+
+  err_code = clGetKernelWorkGroupInfo (gocl_kernel_get_kernel (kernel),
+                                       op->props->id,
+                                       CL_KERNEL_WORK_GROUP_SIZE,
+                                       sizeof (gsize),
+                                       &max_size,
+                                       NULL);
+  if (gocl_error_check_opencl (err_code, &op->error))
+    return 0;
+
+  clGetKernelWorkGroupInfo (gocl_kernel_get_kernel (kernel),
+                            op->props->id,
+                            CL_KERNEL_LOCAL_MEM_SIZE,
+                            sizeof (cl_ulong),
+                            &static_local_size,
+                            NULL);
+
+  max_size = MIN (max_size, MAX_WORK_GROUP_SIZE);
+  max_size = MIN (max_size, op->props->max_work_item_sizes[0]);
+
+  *size = 1;
+  while (*size * 2 <= max_size &&
+         static_local_size + *size * 2 * kernel_local_bytes[kernel_index] <=
+         op->props->local_mem_size)
+    {
+      *size *= 2;
+    }
+
+  return *size;
+}
+
+static gsize
+op_get_num_groups (Op *op, gsize count, gsize work_group_size)
+{
+  gsize num_groups;
+
+  num_groups = (count + work_group_size - 1) / work_group_size;
+
+  return MAX (MIN (num_groups,
+                   op->props->max_compute_units * GROUPS_PER_COMPUTE_UNIT),
+              1);
+}
+
+static void
+op_set_arg (Op            *op,
+            GoclKernel    *kernel,
+            guint          index,
+            gsize          size,
+            gconstpointer  value)
+{
+  cl_int err_code;
+
+  if (op->error != NULL)
+    return;
+
+  err_code = gocl_kernel_set_argument_internal (kernel, index, size, value);
+  gocl_error_check_opencl (err_code, &op->error);
+}
+
+static void
+op_set_mem (Op *op, GoclKernel *kernel, guint index, cl_mem mem)
+{
+  op_set_arg (op, kernel, index, sizeof (cl_mem), &mem);
+}
+
+static void
+op_set_uint (Op *op, GoclKernel *kernel, guint index, gsize value)
+{
+  cl_uint arg = value;
+
+  op_set_arg (op, kernel, index, sizeof (cl_uint), &arg);
+}
+
+static void
+op_set_event (Op *op, cl_event event)
+{
+  if (op->last_event != NULL)
+    clReleaseEvent (op->last_event);
+  op->last_event = event;
+}
+
+static void
+op_run (Op          *op,
+        GoclKernel  *kernel,
+        guint        work_dim,
+        const gsize *global_work_size,
+        const gsize *local_work_size)
+{
+  cl_event event;
+  cl_int err_code;
+
+  if (op->error != NULL)
+    return;
+
+  err_code = clEnqueueNDRangeKernel (op->cl_queue,
+                                     gocl_kernel_get_kernel (kernel),
+                                     work_dim,
+                                     NULL,
+                                     global_work_size,
+                                     local_work_size,
+                                     op->last_event != NULL ?
+                                       1 : op->wait_list->len,
+                                     op->last_event != NULL ?
+                                       &op->last_event : op->wait_list->cl_events,
+                                     &event);
+  if (! gocl_error_check_opencl (err_code, &op->error))
+    op_set_event (op, event);
+}
+
+static void
+op_fill_zero (Op *op, cl_mem mem, gsize size)
+{
+  cl_uint zero = 0;
+  cl_event event;
+  cl_int err_code;
+
+  if (op->error != NULL)
+    return;
+
+  err_code = clEnqueueFillBuffer (op->cl_queue,
+                                  mem,
+                                  &zero,
+                                  sizeof (cl_uint),
+                                  0,
+                                  size,
+                                  op->last_event != NULL ?
+                                    1 : op->wait_list->len,
+                                  op->last_event != NULL ?
+                                    &op->last_event : op->wait_list->cl_events,
+                                  &event);
+  if (! gocl_error_check_opencl (err_code, &op->error))
+    op_set_event (op, event);
+}
+
+/* OpenCL keeps the memory of a released object until the commands using it
+   complete, so temporaries are unreferenced right after being enqueued */
+static cl_mem
+op_new_buffer (Op            *op,
+               GoclBuffer   **buffer,
+               guint          flags,
+               gsize          size,
+               gconstpointer  data)
+{
+  *buffer = NULL;
+  if (op->error != NULL)
+    return NULL;
+
+  *buffer = gocl_buffer_new_full (op->self->priv->context,
+                                  flags,
+                                  size,
+                                  (gpointer) data,
+                                  &op->error);
+  if (*buffer == NULL)
+    return NULL;
+
+  gocl_buffer_set_tag (*buffer, TEMP_TAG);
+
+  return gocl_buffer_get_buffer (*buffer);
+}
+
+static GoclEvent *
+op_finish (Op *op, const gchar *label)
+{
+  GoclEvent *_event = NULL;
+  GoclEventResolverFunc resolver_func;
+
+  if (op->error != NULL)
+    {
+      op_set_event (op, NULL);
+
+      _event = g_object_new (GOCL_TYPE_EVENT,
+                             "queue", op->queue,
+                             NULL);
+      resolver_func = gocl_event_steal_resolver_func (_event);
+      resolver_func (_event, op->error);
+      g_error_free (op->error);
+    }
+  else
+    {
+      /* the event takes the reference of the last command */
+      _event = g_object_new (GOCL_TYPE_EVENT,
+                             "queue", op->queue,
+                             "event", op->last_event,
+                             "label", label,
+                             NULL);
+      gocl_event_set_wait_list (_event, op->wait_list);
+      gocl_event_steal_resolver_func (_event);
+    }
+
+  gocl_event_idle_unref (_event);
+
+  return _event;
+}
+
+static void
+get_identity (GoclPrimitivesType type, GoclPrimitivesOp op, Element *identity)
+{
+  switch (type)
+    {
+    case GOCL_PRIMITIVES_TYPE_FLOAT:
+      identity->f = op == GOCL_PRIMITIVES_OP_MIN ? INFINITY :
+        op == GOCL_PRIMITIVES_OP_MAX ? -INFINITY : 0.0f;
+      break;
+
+    case GOCL_PRIMITIVES_TYPE_INT32:
+      identity->i = op == GOCL_PRIMITIVES_OP_MIN ? G_MAXINT32 :
+        op == GOCL_PRIMITIVES_OP_MAX ? G_MININT32 : 0;
+      break;
+
+    case GOCL_PRIMITIVES_TYPE_UINT32:
+      identity->u = op == GOCL_PRIMITIVES_OP_MIN ? G_MAXUINT32 : 0;
+      break;
+    }
+}
+
+static void
+enqueue_reduce (Op               *op,
+                GoclPrimitivesOp  reduce_op,
+                cl_mem            input,
+                gsize             count,
+                cl_mem            output)
+{
+  GoclKernel *kernel;
+  GoclBuffer *partial;
+  cl_mem partial_mem;
+  gsize work_group_size;
+  gsize num_groups;
+  gsize global_work_size;
+  Element identity;
+
+  kernel = op_get_kernel (op, KERNEL_REDUCE);
+  work_group_size = op_get_work_group_size (op, KERNEL_REDUCE);
+  if (op->error != NULL)
+    return;
+
+  get_identity (op->type, reduce_op, &identity);
+
+  op_set_arg (op, kernel, 3, work_group_size * ELEMENT_SIZE, NULL);
+  op_set_uint (op, kernel, 4, reduce_op);
+  op_set_arg (op, kernel, 5, ELEMENT_SIZE, &identity);
+
+  /* a first pass leaves one partial result per work-group, and a single
+     work-group combines them */
+  num_groups = op_get_num_groups (op, (count + 3) / 4, work_group_size);
+  if (num_groups > 1)
+    {
+      partial_mem = op_new_buffer (op,
+                                   &partial,
+                                   GOCL_BUFFER_FLAGS_READ_WRITE,
+                                   num_groups * ELEMENT_SIZE,
+                                   NULL);
+
+      op_set_mem (op, kernel, 0, input);
+      op_set_uint (op, kernel, 1, count);
+      op_set_mem (op, kernel, 2, partial_mem);
+      global_work_size = num_groups * work_group_size;
+      op_run (op, kernel, 1, &global_work_size, &work_group_size);
+
+      input = partial_mem;
+      count = num_groups;
+    }
+  else
+    {
+      partial = NULL;
+    }
+
+  op_set_mem (op, kernel, 0, input);
+  op_set_uint (op, kernel, 1, count);
+  op_set_mem (op, kernel, 2, output);
+  op_run (op, kernel, 1, &work_group_size, &work_group_size);
+
+  if (partial != NULL)
+    g_object_unref (partial);
+}
+
+/* exclusive prefix sum, where output may be the same as input; the sums of
+   the blocks are scanned the same way, until a single block is left */
+static void
+enqueue_scan (Op *op, cl_mem input, cl_mem output, gsize count)
+{
+  GoclKernel *blocks_kernel;
+  GoclKernel *add_kernel;
+  GoclBuffer *sums;
+  cl_mem sums_mem;
+  gsize work_group_size;
+  gsize num_blocks;
+  gsize global_work_size;
+
+  blocks_kernel = op_get_kernel (op, KERNEL_SCAN_BLOCKS);
+  add_kernel = op_get_kernel (op, KERNEL_SCAN_ADD);
+  work_group_size = MIN (op_get_work_group_size (op, KERNEL_SCAN_BLOCKS),
+                         op_get_work_group_size (op, KERNEL_SCAN_ADD));
+  if (op->error != NULL)
+    return;
+
+  num_blocks = (count + work_group_size * 2 - 1) / (work_group_size * 2);
+
+  sums_mem = op_new_buffer (op,
+                            &sums,
+                            GOCL_BUFFER_FLAGS_READ_WRITE,
+                            num_blocks * ELEMENT_SIZE,
+                            NULL);
+
+  op_set_mem (op, blocks_kernel, 0, input);
+  op_set_mem (op, blocks_kernel, 1, output);
+  op_set_uint (op, blocks_kernel, 2, count);
+  op_set_mem (op, blocks_kernel, 3, sums_mem);
+  op_set_arg (op, blocks_kernel, 4, work_group_size * 2 * ELEMENT_SIZE, NULL);
+  global_work_size = num_blocks * work_group_size;
+  op_run (op, blocks_kernel, 1, &global_work_size, &work_group_size);
+
+  if (num_blocks > 1)
+    {
+      enqueue_scan (op, sums_mem, sums_mem, num_blocks);
+
+      op_set_mem (op, add_kernel, 0, output);
+      op_set_uint (op, add_kernel, 1, count);
+      op_set_mem (op, add_kernel, 2, sums_mem);
+      op_run (op, add_kernel, 1, &global_work_size, &work_group_size);
+    }
+
+  if (sums != NULL)
+    g_object_unref (sums);
+}
+
+/* least significant digit radix sort, with a stable scatter of each tile
+   to where the scan of the digit counts of all tiles says */
+static void
+enqueue_sort (Op *op, cl_mem keys, gsize count)
+{
+  GoclKernel *count_kernel;
+  GoclKernel *scatter_kernel;
+  GoclBuffer *temp;
+  GoclBuffer *histograms;
+  cl_mem temp_mem;
+  cl_mem histograms_mem;
+  cl_mem src;
+  cl_mem dst;
+  gsize work_group_size;
+  gsize num_groups;
+  gsize tile;
+  gsize global_work_size;
+  guint shift;
+
+  count_kernel = op_get_kernel (op, KERNEL_RADIX_COUNT);
+  scatter_kernel = op_get_kernel (op, KERNEL_RADIX_SCATTER);
+  work_group_size = MIN (op_get_work_group_size (op, KERNEL_RADIX_COUNT),
+                         op_get_work_group_size (op, KERNEL_RADIX_SCATTER));
+  if (op->error != NULL)
+    return;
+
+  num_groups = op_get_num_groups (op, count, work_group_size);
+  tile = (count + num_groups - 1) / num_groups;
+  tile = (tile + work_group_size - 1) / work_group_size * work_group_size;
+  num_groups = (count + tile - 1) / tile;
+
+  temp_mem = op_new_buffer (op,
+                            &temp,
+                            GOCL_BUFFER_FLAGS_READ_WRITE,
+                            count * ELEMENT_SIZE,
+                            NULL);
+  histograms_mem = op_new_buffer (op,
+                                  &histograms,
+                                  GOCL_BUFFER_FLAGS_READ_WRITE,
+                                  RADIX * num_groups * ELEMENT_SIZE,
+                                  NULL);
+
+  global_work_size = num_groups * work_group_size;
+  src = keys;
+  dst = temp_mem;
+
+  /* an even number of passes leaves the result back in keys */
+  for (shift = 0; shift < 32 && op->error == NULL; shift += RADIX_BITS)
+    {
+      cl_mem swap;
+
+      op_set_mem (op, count_kernel, 0, src);
+      op_set_uint (op, count_kernel, 1, count);
+      op_set_uint (op, count_kernel, 2, shift);
+      op_set_uint (op, count_kernel, 3, tile);
+      op_set_mem (op, count_kernel, 4, histograms_mem);
+      op_run (op, count_kernel, 1, &global_work_size, &work_group_size);
+
+      enqueue_scan (op, histograms_mem, histograms_mem, RADIX * num_groups);
+
+      op_set_mem (op, scatter_kernel, 0, src);
+      op_set_uint (op, scatter_kernel, 1, count);
+      op_set_uint (op, scatter_kernel, 2, shift);
+      op_set_uint (op, scatter_kernel, 3, tile);
+      op_set_mem (op, scatter_kernel, 4, histograms_mem);
+      op_set_mem (op, scatter_kernel, 5, dst);
+      op_set_arg (op, scatter_kernel, 6, work_group_size * ELEMENT_SIZE, NULL);
+      op_set_arg (op, scatter_kernel, 7, work_group_size * ELEMENT_SIZE, NULL);
+      op_run (op, scatter_kernel, 1, &global_work_size, &work_group_size);
+
+      swap = src;
+      src = dst;
+      dst = swap;
+    }
+
+  if (temp != NULL)
+    g_object_unref (temp);
+  if (histograms != NULL)
+    g_object_unref (histograms);
+}
+
+static void
+enqueue_histogram (Op     *op,
+                   cl_mem  input,
+                   gsize   count,
+                   cl_mem  bins,
+                   guint   num_bins)
+{
+  GoclKernel *kernel;
+  gboolean use_local;
+  gsize work_group_size;
+  gsize global_work_size;
+
+  /* work-groups count in local memory when the bins fit there */
+  use_local = (guint64) num_bins * ELEMENT_SIZE <= op->props->local_mem_size;
+
+  kernel = op_get_kernel (op, use_local ?
+                          KERNEL_HISTOGRAM : KERNEL_HISTOGRAM_GLOBAL);
+  work_group_size = op_get_work_group_size (op, use_local ?
+                                            KERNEL_HISTOGRAM : KERNEL_HISTOGRAM_GLOBAL);
+  if (op->error != NULL)
+    return;
+
+  op_fill_zero (op, bins, (gsize) num_bins * ELEMENT_SIZE);
+
+  op_set_mem (op, kernel, 0, input);
+  op_set_uint (op, kernel, 1, count);
+  op_set_mem (op, kernel, 2, bins);
+  op_set_uint (op, kernel, 3, num_bins);
+  if (use_local)
+    op_set_arg (op, kernel, 4, (gsize) num_bins * ELEMENT_SIZE, NULL);
+
+  global_work_size = op_get_num_groups (op, count, work_group_size) *
+    work_group_size;
+  op_run (op, kernel, 1, &global_work_size, &work_group_size);
+}
+
+/* a work-group covers a tile of TILE_SIZE pixels along the direction of
+   the convolution, and as many lines across it as the limits allow */
+static gboolean
+get_tile_shape (Op    *op,
+                gsize  max_size,
+                guint  radius,
+                gsize *along,
+                gsize *across)
+{
+  *along = MIN (TILE_SIZE, max_size);
+  *across = TILE_SIZE;
+
+  while (*across > 1 &&
+         (*along * *across > max_size ||
+          (*along + 2 * radius) * *across * sizeof (gfloat) >
+          op->props->local_mem_size))
+    {
+      *across /= 2;
+    }
+
+  if ((*along + 2 * radius) * *across * sizeof (gfloat) >
+      op->props->local_mem_size)
+    {
+      gocl_error_check_opencl (CL_OUT_OF_RESOURCES, &op->error);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+enqueue_convolve (Op           *op,
+                  cl_mem        input,
+                  cl_mem        output,
+                  gsize         width,
+                  gsize         height,
+                  const gfloat *row_mask,
+                  const gfloat *column_mask,
+                  guint         radius)
+{
+  GoclKernel *rows_kernel;
+  GoclKernel *columns_kernel;
+  GoclBuffer *row_mask_buf;
+  GoclBuffer *column_mask_buf = NULL;
+  GoclBuffer *temp;
+  cl_mem row_mask_mem;
+  cl_mem column_mask_mem;
+  cl_mem temp_mem;
+  gsize rows_size;
+  gsize columns_size;
+  gsize local_work_size[2];
+  gsize global_work_size[2];
+  gsize mask_size;
+
+  rows_kernel = op_get_kernel (op, KERNEL_CONVOLVE_ROWS);
+  columns_kernel = op_get_kernel (op, KERNEL_CONVOLVE_COLUMNS);
+  rows_size = op_get_work_group_size (op, KERNEL_CONVOLVE_ROWS);
+  columns_size = op_get_work_group_size (op, KERNEL_CONVOLVE_COLUMNS);
+  if (op->error != NULL)
+    return;
+
+  mask_size = (2 * radius + 1) * sizeof (gfloat);
+  row_mask_mem = op_new_buffer (op,
+                                &row_mask_buf,
+                                GOCL_BUFFER_FLAGS_READ_ONLY |
+                                GOCL_BUFFER_FLAGS_COPY_HOST_PTR,
+                                mask_size,
+                                row_mask);
+  if (column_mask != NULL && column_mask != row_mask)
+    column_mask_mem = op_new_buffer (op,
+                                     &column_mask_buf,
+                                     GOCL_BUFFER_FLAGS_READ_ONLY |
+                                     GOCL_BUFFER_FLAGS_COPY_HOST_PTR,
+                                     mask_size,
+                                     column_mask);
+  else
+    column_mask_mem = row_mask_mem;
+
+  temp_mem = op_new_buffer (op,
+                            &temp,
+                            GOCL_BUFFER_FLAGS_READ_WRITE,
+                            width * height * sizeof (gfloat),
+                            NULL);
+
+  /* rows, from the input into the temporary buffer */
+  if (op->error == NULL &&
+      get_tile_shape (op,
+                      rows_size,
+                      radius,
+                      &local_work_size[0],
+                      &local_work_size[1]))
+    {
+      global_work_size[0] = (width + local_work_size[0] - 1) /
+        local_work_size[0] * local_work_size[0];
+      global_work_size[1] = (height + local_work_size[1] - 1) /
+        local_work_size[1] * local_work_size[1];
+
+      op_set_mem (op, rows_kernel, 0, input);
+      op_set_mem (op, rows_kernel, 1, temp_mem);
+      op_set_uint (op, rows_kernel, 2, width);
+      op_set_uint (op, rows_kernel, 3, height);
+      op_set_mem (op, rows_kernel, 4, row_mask_mem);
+      op_set_uint (op, rows_kernel, 5, radius);
+      op_set_arg (op, rows_kernel, 6,
+                  (local_work_size[0] + 2 * radius) * local_work_size[1] *
+                  sizeof (gfloat),
+                  NULL);
+      op_run (op, rows_kernel, 2, global_work_size, local_work_size);
+    }
+
+  /* columns, from the temporary buffer into the output */
+  if (op->error == NULL &&
+      get_tile_shape (op,
+                      columns_size,
+                      radius,
+                      &local_work_size[1],
+                      &local_work_size[0]))
+    {
+      global_work_size[0] = (width + local_work_size[0] - 1) /
+        local_work_size[0] * local_work_size[0];
+      global_work_size[1] = (height + local_work_size[1] - 1) /
+        local_work_size[1] * local_work_size[1];
+
+      op_set_mem (op, columns_kernel, 0, temp_mem);
+      op_set_mem (op, columns_kernel, 1, output);
+      op_set_uint (op, columns_kernel, 2, width);
+      op_set_uint (op, columns_kernel, 3, height);
+      op_set_mem (op, columns_kernel, 4, column_mask_mem);
+      op_set_uint (op, columns_kernel, 5, radius);
+      op_set_arg (op, columns_kernel, 6,
+                  (local_work_size[1] + 2 * radius) * local_work_size[0] *
+                  sizeof (gfloat),
+                  NULL);
+      op_run (op, columns_kernel, 2, global_work_size, local_work_size);
+    }
+
+  if (row_mask_buf != NULL)
+    g_object_unref (row_mask_buf);
+  if (column_mask_buf != NULL)
+    g_object_unref (column_mask_buf);
+  if (temp != NULL)
+    g_object_unref (temp);
+}
+
+/* public */
+
+/**
+ * gocl_primitives_new:
+ * @context: The #GoclContext where operations run
+ *
+ * Creates a new #GoclPrimitives. Kernels are built the first time an
+ * operation needs them, see gocl_primitives_prepare_sync().
+ *
+ * Returns: (transfer full): A newly created #GoclPrimitives
+ **/
+GoclPrimitives *
+gocl_primitives_new (GoclContext *context)
+{
+  g_return_val_if_fail (GOCL_IS_CONTEXT (context), NULL);
+
+  return g_object_new (GOCL_TYPE_PRIMITIVES,
+                       "context", context,
+                       NULL);
+}
+
+/**
+ * gocl_primitives_get_context:
+ * @self: The #GoclPrimitives
+ *
+ * Retrieves the #GoclContext where operations run.
+ *
+ * Returns: (transfer none): A #GoclContext object
+ **/
+GoclContext *
+gocl_primitives_get_context (GoclPrimitives *self)
+{
+  g_return_val_if_fail (GOCL_IS_PRIMITIVES (self), NULL);
+
+  return self->priv->context;
+}
+
+/**
+ * gocl_primitives_prepare_sync:
+ * @self: The #GoclPrimitives
+ * @type: The element type to build the kernels for
+ *
+ * Builds the kernels operating on elements of @type, if not built yet.
+ * Otherwise, this happens the first time an operation on @type is
+ * enqueued. This method is blocking.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_primitives_prepare_sync (GoclPrimitives     *self,
+                              GoclPrimitivesType  type)
+{
+  GError *error = NULL;
+  gboolean result;
+
+  g_return_val_if_fail (GOCL_IS_PRIMITIVES (self), FALSE);
+  g_return_val_if_fail (type < NUM_TYPES, FALSE);
+
+  g_mutex_lock (&self->priv->mutex);
+  result = ensure_program (self, type, &error);
+  g_mutex_unlock (&self->priv->mutex);
+
+  if (! result)
+    {
+      g_propagate_error (gocl_error_prepare (), error);
+      return FALSE;
+    }
+
+  return ! gocl_error_check_opencl_internal (CL_SUCCESS);
+}
+
+/**
+ * gocl_primitives_reduce:
+ * @self: The #GoclPrimitives
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @op: The #GoclPrimitivesOp combining the elements
+ * @type: The type of the elements
+ * @input: The #GoclBuffer holding the elements
+ * @count: The number of elements, at least 1
+ * @output: The #GoclBuffer where the result is written, as its first element
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List of
+ * #GoclEvent objects to wait for, or %NULL
+ *
+ * Asynchronously combines the first @count elements of @input with @op,
+ * like computing their sum, and stores the result in @output. The work is
+ * split among a number of work-groups proportional to the compute units of
+ * the device, followed by a single work-group combining their results.
+ *
+ * Returns: (transfer none): A #GoclEvent to get notified when the result is
+ * available in @output
+ **/
+GoclEvent *
+gocl_primitives_reduce (GoclPrimitives     *self,
+                        GoclQueue          *queue,
+                        GoclPrimitivesOp    op,
+                        GoclPrimitivesType  type,
+                        GoclBuffer         *input,
+                        gsize               count,
+                        GoclBuffer         *output,
+                        GList              *event_wait_list)
+{
+  GoclWaitList wait_list;
+  GoclEvent *event;
+  Op _op;
+
+  g_return_val_if_fail (GOCL_IS_PRIMITIVES (self), NULL);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), NULL);
+  g_return_val_if_fail (op <= GOCL_PRIMITIVES_OP_MAX, NULL);
+  g_return_val_if_fail (type < NUM_TYPES, NULL);
+  g_return_val_if_fail (GOCL_IS_BUFFER (input), NULL);
+  g_return_val_if_fail (GOCL_IS_BUFFER (output), NULL);
+  g_return_val_if_fail (count > 0 && count <= G_MAXUINT32, NULL);
+
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
+  g_mutex_lock (&self->priv->mutex);
+
+  if (op_init (&_op, self, queue, type, &wait_list))
+    enqueue_reduce (&_op,
+                    op,
+                    gocl_buffer_get_buffer (input),
+                    count,
+                    gocl_buffer_get_buffer (output));
+
+  event = op_finish (&_op, "primitives-reduce");
+
+  g_mutex_unlock (&self->priv->mutex);
+  gocl_wait_list_clear (&wait_list);
+
+  return event;
+}
+
+/**
+ * gocl_primitives_reduce_sync:
+ * @self: The #GoclPrimitives
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @op: The #GoclPrimitivesOp combining the elements
+ * @type: The type of the elements
+ * @input: The #GoclBuffer holding the elements
+ * @count: The number of elements, at least 1
+ * @result: (out caller-allocates): Return location for the result, a
+ * single element of @type
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List of
+ * #GoclEvent objects to wait for, or %NULL
+ *
+ * Like gocl_primitives_reduce(), but blocks until the result is available,
+ * and returns it in host memory. This method is blocking.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_primitives_reduce_sync (GoclPrimitives     *self,
+                             GoclQueue          *queue,
+                             GoclPrimitivesOp    op,
+                             GoclPrimitivesType  type,
+                             GoclBuffer         *input,
+                             gsize               count,
+                             gpointer            result,
+                             GList              *event_wait_list)
+{
+  GoclWaitList wait_list;
+  GoclBuffer *output;
+  cl_mem output_mem;
+  cl_int err_code;
+  Op _op;
+
+  g_return_val_if_fail (GOCL_IS_PRIMITIVES (self), FALSE);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), FALSE);
+  g_return_val_if_fail (op <= GOCL_PRIMITIVES_OP_MAX, FALSE);
+  g_return_val_if_fail (type < NUM_TYPES, FALSE);
+  g_return_val_if_fail (GOCL_IS_BUFFER (input), FALSE);
+  g_return_val_if_fail (count > 0 && count <= G_MAXUINT32, FALSE);
+  g_return_val_if_fail (result != NULL, FALSE);
+
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
+  g_mutex_lock (&self->priv->mutex);
+
+  output = NULL;
+  if (op_init (&_op, self, queue, type, &wait_list))
+    {
+      output_mem = op_new_buffer (&_op,
+                                  &output,
+                                  GOCL_BUFFER_FLAGS_READ_WRITE,
+                                  ELEMENT_SIZE,
+                                  NULL);
+      enqueue_reduce (&_op, op, gocl_buffer_get_buffer (input), count, output_mem);
+
+      if (_op.error == NULL)
+        {
+          err_code = clEnqueueReadBuffer (_op.cl_queue,
+                                          output_mem,
+                                          CL_TRUE,
+                                          0,
+                                          ELEMENT_SIZE,
+                                          result,
+                                          1,
+                                          &_op.last_event,
+                                          NULL);
+          gocl_error_check_opencl (err_code, &_op.error);
+        }
+    }
+
+  op_set_event (&_op, NULL);
+  if (output != NULL)
+    g_object_unref (output);
+
+  g_mutex_unlock (&self->priv->mutex);
+  gocl_wait_list_clear (&wait_list);
+
+  if (_op.error != NULL)
+    {
+      g_propagate_error (gocl_error_prepare (), _op.error);
+      return FALSE;
+    }
+
+  return ! gocl_error_check_opencl_internal (CL_SUCCESS);
+}
+
+/**
+ * gocl_primitives_scan:
+ * @self: The #GoclPrimitives
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @type: The type of the elements
+ * @input: The #GoclBuffer holding the elements
+ * @output: The #GoclBuffer where the prefix sums are written, which can be
+ * @input itself
+ * @count: The number of elements, at least 1
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List of
+ * #GoclEvent objects to wait for, or %NULL
+ *
+ * Asynchronously computes the exclusive prefix sum of the first @count
+ * elements of @input: each element of @output is the sum of the elements of
+ * @input before it, and the first one is 0. Each work-group scans a block
+ * in local memory, and the sums of the blocks are scanned in turn and added
+ * back.
+ *
+ * Returns: (transfer none): A #GoclEvent to get notified when the prefix
+ * sums are available in @output
+ **/
+GoclEvent *
+gocl_primitives_scan (GoclPrimitives     *self,
+                      GoclQueue          *queue,
+                      GoclPrimitivesType  type,
+                      GoclBuffer         *input,
+                      GoclBuffer         *output,
+                      gsize               count,
+                      GList              *event_wait_list)
+{
+  GoclWaitList wait_list;
+  GoclEvent *event;
+  Op op;
+
+  g_return_val_if_fail (GOCL_IS_PRIMITIVES (self), NULL);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), NULL);
+  g_return_val_if_fail (type < NUM_TYPES, NULL);
+  g_return_val_if_fail (GOCL_IS_BUFFER (input), NULL);
+  g_return_val_if_fail (GOCL_IS_BUFFER (output), NULL);
+  g_return_val_if_fail (count > 0 && count <= G_MAXUINT32, NULL);
+
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
+  g_mutex_lock (&self->priv->mutex);
+
+  if (op_init (&op, self, queue, type, &wait_list))
+    enqueue_scan (&op,
+                  gocl_buffer_get_buffer (input),
+                  gocl_buffer_get_buffer (output),
+                  count);
+
+  event = op_finish (&op, "primitives-scan");
+
+  g_mutex_unlock (&self->priv->mutex);
+  gocl_wait_list_clear (&wait_list);
+
+  return event;
+}
+
+/**
+ * gocl_primitives_sort:
+ * @self: The #GoclPrimitives
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @keys: The #GoclBuffer holding unsigned 32 bits integer keys
+ * @count: The number of keys, at least 1
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List of
+ * #GoclEvent objects to wait for, or %NULL
+ *
+ * Asynchronously sorts the first @count keys of @keys in ascending order,
+ * in place. This is a radix sort processing 4 bits per pass, whose cost
+ * grows linearly with @count. A temporary buffer as large as the keys is
+ * used.
+ *
+ * Returns: (transfer none): A #GoclEvent to get notified when the keys are
+ * sorted
+ **/
+GoclEvent *
+gocl_primitives_sort (GoclPrimitives *self,
+                      GoclQueue      *queue,
+                      GoclBuffer     *keys,
+                      gsize           count,
+                      GList          *event_wait_list)
+{
+  GoclWaitList wait_list;
+  GoclEvent *event;
+  Op op;
+
+  g_return_val_if_fail (GOCL_IS_PRIMITIVES (self), NULL);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), NULL);
+  g_return_val_if_fail (GOCL_IS_BUFFER (keys), NULL);
+  g_return_val_if_fail (count > 0 && count <= G_MAXINT32, NULL);
+
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
+  g_mutex_lock (&self->priv->mutex);
+
+  if (op_init (&op, self, queue, GOCL_PRIMITIVES_TYPE_UINT32, &wait_list))
+    enqueue_sort (&op, gocl_buffer_get_buffer (keys), count);
+
+  event = op_finish (&op, "primitives-sort");
+
+  g_mutex_unlock (&self->priv->mutex);
+  gocl_wait_list_clear (&wait_list);
+
+  return event;
+}
+
+/**
+ * gocl_primitives_histogram:
+ * @self: The #GoclPrimitives
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @input: The #GoclBuffer holding unsigned 32 bits integer values
+ * @count: The number of values, at least 1
+ * @bins: The #GoclBuffer where the counts are written, as @num_bins
+ * unsigned 32 bits integers
+ * @num_bins: The number of bins, at least 1
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List of
+ * #GoclEvent objects to wait for, or %NULL
+ *
+ * Asynchronously counts how many of the first @count values of @input are
+ * equal to each integer between 0 and @num_bins minus one, and stores the
+ * counts in @bins. Values outside that range are ignored. When the bins fit
+ * in local memory, each work-group counts its share there before adding
+ * its counts to @bins.
+ *
+ * Returns: (transfer none): A #GoclEvent to get notified when the counts
+ * are available in @bins
+ **/
+GoclEvent *
+gocl_primitives_histogram (GoclPrimitives *self,
+                           GoclQueue      *queue,
+                           GoclBuffer     *input,
+                           gsize           count,
+                           GoclBuffer     *bins,
+                           guint           num_bins,
+                           GList          *event_wait_list)
+{
+  GoclWaitList wait_list;
+  GoclEvent *event;
+  Op op;
+
+  g_return_val_if_fail (GOCL_IS_PRIMITIVES (self), NULL);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), NULL);
+  g_return_val_if_fail (GOCL_IS_BUFFER (input), NULL);
+  g_return_val_if_fail (GOCL_IS_BUFFER (bins), NULL);
+  g_return_val_if_fail (count > 0 && count <= G_MAXUINT32, NULL);
+  g_return_val_if_fail (num_bins > 0, NULL);
+
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
+  g_mutex_lock (&self->priv->mutex);
+
+  if (op_init (&op, self, queue, GOCL_PRIMITIVES_TYPE_UINT32, &wait_list))
+    enqueue_histogram (&op,
+                       gocl_buffer_get_buffer (input),
+                       count,
+                       gocl_buffer_get_buffer (bins),
+                       num_bins);
+
+  event = op_finish (&op, "primitives-histogram");
+
+  g_mutex_unlock (&self->priv->mutex);
+  gocl_wait_list_clear (&wait_list);
+
+  return event;
+}
+
+/**
+ * gocl_primitives_convolve_separable:
+ * @self: The #GoclPrimitives
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @input: The #GoclBuffer holding a @width by @height array of floats, row
+ * after row
+ * @output: The #GoclBuffer where the result is written, with the same
+ * layout, which can be @input itself
+ * @width: The number of columns
+ * @height: The number of rows
+ * @row_mask: (array) (element-type gfloat): The 2 * @radius + 1
+ * coefficients applied along each row
+ * @column_mask: (array) (element-type gfloat) (allow-none): The
+ * 2 * @radius + 1 coefficients applied along each column, or %NULL to use
+ * @row_mask
+ * @radius: The number of neighbours on each side that the masks reach
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List of
+ * #GoclEvent objects to wait for, or %NULL
+ *
+ * Asynchronously convolves @input with the 2D mask that is the product of
+ * @row_mask and @column_mask, such as a gaussian, in two passes: one along
+ * the rows and one along the columns. Coefficient @radius of each mask
+ * applies to the pixel itself, and pixels beyond the borders take the value
+ * of the nearest border pixel. The masks are copied before this function
+ * returns.
+ *
+ * Returns: (transfer none): A #GoclEvent to get notified when the result is
+ * available in @output
+ **/
+GoclEvent *
+gocl_primitives_convolve_separable (GoclPrimitives *self,
+                                    GoclQueue      *queue,
+                                    GoclBuffer     *input,
+                                    GoclBuffer     *output,
+                                    gsize           width,
+                                    gsize           height,
+                                    const gfloat   *row_mask,
+                                    const gfloat   *column_mask,
+                                    guint           radius,
+                                    GList          *event_wait_list)
+{
+  GoclWaitList wait_list;
+  GoclEvent *event;
+  Op op;
+
+  g_return_val_if_fail (GOCL_IS_PRIMITIVES (self), NULL);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), NULL);
+  g_return_val_if_fail (GOCL_IS_BUFFER (input), NULL);
+  g_return_val_if_fail (GOCL_IS_BUFFER (output), NULL);
+  g_return_val_if_fail (width > 0 && height > 0, NULL);
+  g_return_val_if_fail ((guint64) width * height <= G_MAXUINT32, NULL);
+  g_return_val_if_fail (row_mask != NULL, NULL);
+
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
+  g_mutex_lock (&self->priv->mutex);
+
+  if (op_init (&op, self, queue, GOCL_PRIMITIVES_TYPE_FLOAT, &wait_list))
+    enqueue_convolve (&op,
+                      gocl_buffer_get_buffer (input),
+                      gocl_buffer_get_buffer (output),
+                      width,
+                      height,
+                      row_mask,
+                      column_mask,
+                      radius);
+
+  event = op_finish (&op, "primitives-convolve");
+
+  g_mutex_unlock (&self->priv->mutex);
+  gocl_wait_list_clear (&wait_list);
+
+  return event;
+}
@@ -0,0 +1,119 @@
+/*
+ * gocl-primitives.h
+ *
+ * Gocl - GLib/GObject wrapper for OpenCL
+ * Copyright (C) 2012-2013 Igalia S.L.
+ *
+ * Authors:
+ *  Eduardo Lima Mitev <elima@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License at http://www.gnu.org/licenses/lgpl-3.0.txt
+ * for more details.
+ */
+
+#ifndef __GOCL_PRIMITIVES_H__
+#define __GOCL_PRIMITIVES_H__
+
+#include <glib-object.h>
+
+#include "gocl-decls.h"
+#include "gocl-context.h"
+#include "gocl-buffer.h"
+#include "gocl-queue.h"
+#include "gocl-event.h"
+
+G_BEGIN_DECLS
+
+#define GOCL_TYPE_PRIMITIVES              (gocl_primitives_get_type ())
+#define GOCL_PRIMITIVES(obj)              (G_TYPE_CHECK_INSTANCE_CAST ((obj), GOCL_TYPE_PRIMITIVES, GoclPrimitives))
+#define GOCL_PRIMITIVES_CLASS(klass)      (G_TYPE_CHECK_CLASS_CAST ((klass), GOCL_TYPE_PRIMITIVES, GoclPrimitivesClass))
+#define GOCL_IS_PRIMITIVES(obj)           (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GOCL_TYPE_PRIMITIVES))
+#define GOCL_IS_PRIMITIVES_CLASS(klass)   (G_TYPE_CHECK_CLASS_TYPE ((klass), GOCL_TYPE_PRIMITIVES))
+#define GOCL_PRIMITIVES_GET_CLASS(obj)    (G_TYPE_INSTANCE_GET_CLASS ((obj), GOCL_TYPE_PRIMITIVES, GoclPrimitivesClass))
+
+typedef struct _GoclPrimitivesClass GoclPrimitivesClass;
+typedef struct _GoclPrimitives GoclPrimitives;
+typedef struct _GoclPrimitivesPrivate GoclPrimitivesPrivate;
+
+struct _GoclPrimitives
+{
+  GObject parent_instance;
+
+  GoclPrimitivesPrivate *priv;
+};
+
+struct _GoclPrimitivesClass
+{
+  GObjectClass parent_class;
+};
+
+GType                  gocl_primitives_get_type               (void) G_GNUC_CONST;
+
+GoclPrimitives *       gocl_primitives_new                    (GoclContext *context);
+
+GoclContext *          gocl_primitives_get_context            (GoclPrimitives *self);
+
+gboolean               gocl_primitives_prepare_sync           (GoclPrimitives     *self,
+                                                               GoclPrimitivesType  type);
+
+GoclEvent *            gocl_primitives_reduce                 (GoclPrimitives     *self,
+                                                               GoclQueue          *queue,
+                                                               GoclPrimitivesOp    op,
+                                                               GoclPrimitivesType  type,
+                                                               GoclBuffer         *input,
+                                                               gsize               count,
+                                                               GoclBuffer         *output,
+                                                               GList              *event_wait_list);
+gboolean               gocl_primitives_reduce_sync            (GoclPrimitives     *self,
+                                                               GoclQueue          *queue,
+                                                               GoclPrimitivesOp    op,
+                                                               GoclPrimitivesType  type,
+                                                               GoclBuffer         *input,
+                                                               gsize               count,
+                                                               gpointer            result,
+                                                               GList              *event_wait_list);
+
+GoclEvent *            gocl_primitives_scan                   (GoclPrimitives     *self,
+                                                               GoclQueue          *queue,
+                                                               GoclPrimitivesType  type,
+                                                               GoclBuffer         *input,
+                                                               GoclBuffer         *output,
+                                                               gsize               count,
+                                                               GList              *event_wait_list);
+
+GoclEvent *            gocl_primitives_sort                   (GoclPrimitives *self,
+                                                               GoclQueue      *queue,
+                                                               GoclBuffer     *keys,
+                                                               gsize           count,
+                                                               GList          *event_wait_list);
+
+GoclEvent *            gocl_primitives_histogram              (GoclPrimitives *self,
+                                                               GoclQueue      *queue,
+                                                               GoclBuffer     *input,
+                                                               gsize           count,
+                                                               GoclBuffer     *bins,
+                                                               guint           num_bins,
+                                                               GList          *event_wait_list);
+
+GoclEvent *            gocl_primitives_convolve_separable     (GoclPrimitives *self,
+                                                               GoclQueue      *queue,
+                                                               GoclBuffer     *input,
+                                                               GoclBuffer     *output,
+                                                               gsize           width,
+                                                               gsize           height,
+                                                               const gfloat   *row_mask,
+                                                               const gfloat   *column_mask,
+                                                               guint           radius,
+                                                               GList          *event_wait_list);
+
+G_END_DECLS
+
+#endif /* __GOCL_PRIMITIVES_H__ */
@@ -28,6 +28,7 @@
 #include "gocl-context.h"
 #include "gocl-program.h"
 #include "gocl-kernel.h"
+#include "gocl-launch.h"
 #include "gocl-buffer.h"
 #include "gocl-queue.h"
 #include "gocl-event.h"
@@ -36,16 +37,157 @@ G_BEGIN_DECLS
 
 cl_context        gocl_context_get_context         (GoclContext *self);
 
+typedef struct
+{
+  cl_device_id id;
+  cl_device_type type;
+  gchar *name;
+  gchar *vendor;
+  cl_uint max_compute_units;
+  cl_uint max_clock_frequency;
+  gsize max_work_group_size;
+  gsize max_work_item_sizes[3];
+  guint64 global_mem_size;
+  guint64 max_mem_alloc_size;
+  guint64 local_mem_size;
+  cl_uint mem_base_addr_align;
+  cl_bool host_unified_memory;
+  cl_bitfield svm_capabilities;
+} GoclDeviceProps;
+
+const GoclDeviceProps *
+                  gocl_context_get_device_props    (GoclContext  *self,
+                                                    cl_device_id  device_id);
+cl_bitfield       gocl_context_get_svm_capabilities (GoclContext *self);
+void              gocl_context_add_allocation      (GoclContext *self,
+                                                    gpointer     owner,
+                                                    guint        flags,
+                                                    guint64      size,
+                                                    const gchar *tag);
+void              gocl_context_remove_allocation   (GoclContext *self,
+                                                    gpointer     owner);
+void              gocl_context_set_allocation_tag  (GoclContext *self,
+                                                    gpointer     owner,
+                                                    const gchar *tag);
+
+cl_int            gocl_device_props_query          (GoclDeviceProps *props,
+                                                    cl_device_id     device_id);
+void              gocl_device_props_clear          (GoclDeviceProps *props);
+
 cl_program        gocl_program_get_program         (GoclProgram *self);
+gchar *           gocl_program_get_tuning_filename (GoclProgram  *self,
+                                                    cl_device_id  device);
+cl_kernel         gocl_program_create_kernel       (GoclProgram *self,
+                                                    const gchar *name,
+                                                    cl_int      *err_code);
 
 cl_kernel         gocl_kernel_get_kernel           (GoclKernel *self);
 
+typedef struct
+{
+  gboolean is_set;
+  gsize size;
+  gpointer value;
+
+  /* value holds an SVM address, set with clSetKernelArgSVMPointer() */
+  gboolean is_svm;
+
+  /* managed buffer bound, synchronized around each run, or NULL */
+  GoclBuffer *managed_buffer;
+  gboolean managed_read_only;
+} GoclKernelArg;
+
+gboolean          gocl_kernel_arg_equals           (const GoclKernelArg *arg,
+                                                    gsize                size,
+                                                    gconstpointer        value);
+void              gocl_kernel_arg_store            (GoclKernelArg *arg,
+                                                    gsize          size,
+                                                    gconstpointer  value);
+void              gocl_kernel_arg_clear            (GoclKernelArg *arg);
+void              gocl_kernel_arg_set_managed_buffer (GoclKernelArg *arg,
+                                                      GoclBuffer    *buffer,
+                                                      gboolean       read_only);
+
+cl_int            gocl_kernel_args_upload_managed  (GArray           *args,
+                                                    cl_command_queue  queue,
+                                                    const cl_event   *event_wait_list,
+                                                    guint             event_wait_list_len,
+                                                    GArray          **merged_wait_list);
+void              gocl_kernel_args_complete_managed (GArray         *args,
+                                                     GArray         *merged_wait_list,
+                                                     guint           event_wait_list_len,
+                                                     const cl_event *events,
+                                                     guint           num_events);
+gboolean          gocl_kernel_is_argument_const    (GoclKernel *self,
+                                                    guint       index);
+
+cl_int            gocl_kernel_set_argument_internal (GoclKernel    *self,
+                                                     guint          index,
+                                                     gsize          size,
+                                                     gconstpointer  value);
+cl_int            gocl_kernel_set_argument_svm_internal (GoclKernel    *self,
+                                                         guint          index,
+                                                         gconstpointer  svm_ptr);
+GArray *          gocl_kernel_get_arguments        (GoclKernel *self);
+void              gocl_kernel_get_work_size        (GoclKernel *self,
+                                                    guint8     *work_dim,
+                                                    gsize      *global_work_size,
+                                                    gsize      *local_work_size);
+
+cl_int            gocl_launch_enqueue              (GoclLaunch *self,
+                                                    cl_event   *event_wait_list,
+                                                    guint       event_wait_list_len,
+                                                    cl_event   *out_event);
+
 cl_mem            gocl_buffer_get_buffer           (GoclBuffer *self);
+cl_int            gocl_buffer_upload_managed       (GoclBuffer       *self,
+                                                    cl_command_queue  queue,
+                                                    GArray           *out_events);
+void              gocl_buffer_complete_managed     (GoclBuffer     *self,
+                                                    const cl_event *events,
+                                                    guint           num_events,
+                                                    gboolean        written);
+
+gboolean          gocl_image_is_gl_shared          (GoclImage *self);
 
 cl_command_queue  gocl_queue_get_queue             (GoclQueue *self);
+void              gocl_queue_record_command        (GoclQueue   *self,
+                                                    cl_event     event,
+                                                    const gchar *label,
+                                                    guint64      bytes);
 
 cl_event          gocl_event_get_event             (GoclEvent *self);
 
+/* wait lists of up to this many events live entirely on the stack */
+#define GOCL_WAIT_LIST_INLINE_LEN 4
+
+typedef struct
+{
+  guint len;
+  GoclEvent **events;
+  cl_event *cl_events;
+
+  GoclEvent *inline_events[GOCL_WAIT_LIST_INLINE_LEN];
+  cl_event inline_cl_events[GOCL_WAIT_LIST_INLINE_LEN];
+} GoclWaitList;
+
+void              gocl_wait_list_init              (GoclWaitList  *wait_list,
+                                                    GoclEvent    **events,
+                                                    guint          len);
+void              gocl_wait_list_init_from_list    (GoclWaitList *wait_list,
+                                                    GList        *event_list);
+void              gocl_wait_list_clear             (GoclWaitList *wait_list);
+
+void              gocl_event_set_wait_list         (GoclEvent          *self,
+                                                    const GoclWaitList *wait_list);
+void              gocl_event_dispatcher_add_event  (cl_event event);
+GoclEvent *       gocl_event_new_for_command       (GoclQueue   *queue,
+                                                    cl_int       err_code,
+                                                    cl_event     event,
+                                                    GList       *event_wait_list,
+                                                    const gchar *label,
+                                                    guint64      bytes);
+
 
 gboolean          gocl_error_check_opencl          (cl_int   err_code,
                                                     GError **error);
@@ -35,10 +35,28 @@
  * Currently, creating a program from pre-compiled, binary code is not supported,
  * but will be in the future.
  *
+ * To reduce start-up time, successfully built programs are stored in an
+ * on-disk cache of program binaries, under the user's cache directory. An
+ * entry is keyed by the source code, the build options, and the name, vendor
+ * and driver version of each device. When a matching entry exists, it is
+ * loaded instead of compiling the sources again. Entries rejected by the
+ * OpenCL runtime are discarded, and the program is then rebuilt from source.
+ * Notice that changes in files included by the sources are not detected. The
+ * cache can be disabled per program with the #GoclProgram:use-binary-cache
+ * property. Work-group sizes found by gocl_kernel_autotune_sync() are kept in
+ * the same directory.
+ *
  * Once a program is created, it needs to be built before kernels can be created
  * from it. To build a program asynchronously, gocl_program_build() and
- * gocl_program_build_finish() methods are provided. For building synchronously,
- * gocl_program_build_sync() is used.
+ * gocl_program_build_finish() methods are provided. These rely on the completion
+ * notification of the OpenCL runtime rather than on a thread per build, so
+ * many programs can be built at once. For building synchronously,
+ * gocl_program_build_sync() is used. When a build fails, the compiler output
+ * is available through gocl_program_get_build_log().
+ *
+ * On OpenCL 1.2 and later, compiling and linking can also be done as separate
+ * steps, with gocl_program_compile_sync() and gocl_program_link_sync(). This
+ * way, code shared by many programs is compiled only once.
  *
  * Once a program is successfully built, kernels can be obtained from it using
  * gocl_program_get_kernel() method.
@@ -51,7 +69,9 @@
  * The class for #GoclProgram objects.
  **/
 
+#include <stdio.h>
 #include <string.h>
+#include <glib/gstdio.h>
 
 #include "gocl-program.h"
 
@@ -64,14 +84,26 @@ struct _GoclProgramPrivate
 
   GoclContext *context;
 
-  gboolean building;
+  gint building;
+
+  gchar **sources;
+  gboolean from_binary;
+  gboolean use_binary_cache;
+
+  /* kernel objects of the built program, by function name, only used as
+     templates for the kernels handed out, and left empty when the platform
+     cannot clone them */
+  GMutex kernels_mutex;
+  GHashTable *kernels;
+  gboolean can_clone_kernels;
 };
 
 /* properties */
 enum
 {
   PROP_0,
-  PROP_CONTEXT
+  PROP_CONTEXT,
+  PROP_USE_BINARY_CACHE
 };
 
 static void           gocl_program_class_init            (GoclProgramClass *class);
@@ -114,6 +146,14 @@ gocl_program_class_init (GoclProgramClass *class)
                                                         G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
                                                         G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (obj_class, PROP_USE_BINARY_CACHE,
+                                   g_param_spec_boolean ("use-binary-cache",
+                                                         "Use binary cache",
+                                                         "Whether to store and reuse built binaries on disk",
+                                                         TRUE,
+                                                         G_PARAM_READWRITE |
+                                                         G_PARAM_STATIC_STRINGS));
+
   g_type_class_add_private (class, sizeof (GoclProgramPrivate));
 }
 
@@ -125,6 +165,14 @@ gocl_program_init (GoclProgram *self)
   self->priv = priv = GOCL_PROGRAM_GET_PRIVATE (self);
 
   priv->building = FALSE;
+
+  priv->sources = NULL;
+  priv->from_binary = FALSE;
+  priv->use_binary_cache = TRUE;
+
+  g_mutex_init (&priv->kernels_mutex);
+  priv->kernels = NULL;
+  priv->can_clone_kernels = FALSE;
 }
 
 static void
@@ -140,7 +188,14 @@ gocl_program_finalize (GObject *obj)
 
   g_object_unref (self->priv->context);
 
-  clReleaseProgram (self->priv->program);
+  g_strfreev (self->priv->sources);
+
+  if (self->priv->kernels != NULL)
+    g_hash_table_unref (self->priv->kernels);
+  g_mutex_clear (&self->priv->kernels_mutex);
+
+  if (self->priv->program != NULL)
+    clReleaseProgram (self->priv->program);
 
   G_OBJECT_CLASS (gocl_program_parent_class)->finalize (obj);
 }
@@ -161,6 +216,10 @@ set_property (GObject      *obj,
       self->priv->context = g_value_dup_object (value);
       break;
 
+    case PROP_USE_BINARY_CACHE:
+      self->priv->use_binary_cache = g_value_get_boolean (value);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
       break;
@@ -183,33 +242,595 @@ get_property (GObject    *obj,
       g_value_set_object (value, self->priv->context);
       break;
 
+    case PROP_USE_BINARY_CACHE:
+      g_value_set_boolean (value, self->priv->use_binary_cache);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
       break;
     }
 }
 
+static cl_int
+create_program_from_source (GoclProgram *self)
+{
+  cl_int err_code;
+
+  self->priv->program =
+    clCreateProgramWithSource (gocl_context_get_context (self->priv->context),
+                               g_strv_length (self->priv->sources),
+                               (const gchar **) self->priv->sources,
+                               NULL,
+                               &err_code);
+  self->priv->from_binary = FALSE;
+
+  return err_code;
+}
+
+static cl_device_id *
+get_program_devices (cl_program program, cl_uint *num_devices)
+{
+  cl_device_id *devices;
+  cl_int err_code;
+
+  err_code = clGetProgramInfo (program,
+                               CL_PROGRAM_NUM_DEVICES,
+                               sizeof (cl_uint),
+                               num_devices,
+                               NULL);
+  if (err_code != CL_SUCCESS || *num_devices == 0)
+    return NULL;
+
+  devices = g_new (cl_device_id, *num_devices);
+  err_code = clGetProgramInfo (program,
+                               CL_PROGRAM_DEVICES,
+                               sizeof (cl_device_id) * (*num_devices),
+                               devices,
+                               NULL);
+  if (err_code != CL_SUCCESS)
+    {
+      g_free (devices);
+      return NULL;
+    }
+
+  return devices;
+}
+
+static void
+checksum_device_info (GChecksum      *checksum,
+                      cl_device_id    device,
+                      cl_device_info  param)
+{
+  gchar *value;
+  gsize size = 0;
+
+  if (clGetDeviceInfo (device, param, 0, NULL, &size) != CL_SUCCESS)
+    return;
+
+  value = g_malloc0 (size + 1);
+  if (clGetDeviceInfo (device, param, size, value, NULL) == CL_SUCCESS)
+    g_checksum_update (checksum, (const guchar *) value, size);
+  g_free (value);
+}
+
+static gchar *
+get_cache_dir (void)
+{
+  return g_build_filename (g_get_user_cache_dir (), "gocl", "programs", NULL);
+}
+
+static gchar *
+get_cache_filename (GoclProgram  *self,
+                    cl_device_id  device,
+                    const gchar  *options,
+                    const gchar  *suffix)
+{
+  GChecksum *checksum;
+  gchar *dir;
+  gchar *basename;
+  gchar *filename;
+  guint i;
+
+  checksum = g_checksum_new (G_CHECKSUM_SHA256);
+
+  /* include the terminating null in each chunk, so that moving text between
+     two adjacent sources yields a different key */
+  for (i = 0; self->priv->sources[i] != NULL; i++)
+    g_checksum_update (checksum,
+                       (const guchar *) self->priv->sources[i],
+                       strlen (self->priv->sources[i]) + 1);
+
+  g_checksum_update (checksum,
+                     (const guchar *) (options != NULL ? options : ""),
+                     (options != NULL ? strlen (options) : 0) + 1);
+
+  checksum_device_info (checksum, device, CL_DEVICE_NAME);
+  checksum_device_info (checksum, device, CL_DEVICE_VENDOR);
+  checksum_device_info (checksum, device, CL_DRIVER_VERSION);
+
+  dir = get_cache_dir ();
+  basename = g_strconcat (g_checksum_get_string (checksum), suffix, NULL);
+  filename = g_build_filename (dir, basename, NULL);
+
+  g_free (basename);
+  g_free (dir);
+  g_checksum_free (checksum);
+
+  return filename;
+}
+
+static gboolean
+build_from_cached_binaries (GoclProgram *self, const gchar *options)
+{
+  cl_device_id *devices;
+  cl_uint num_devices = 0;
+  gchar **filenames;
+  guchar **binaries;
+  gsize *lengths;
+  cl_program program = NULL;
+  cl_int err_code = CL_SUCCESS;
+  gboolean result = FALSE;
+  guint i;
+
+  devices = get_program_devices (self->priv->program, &num_devices);
+  if (devices == NULL)
+    return FALSE;
+
+  filenames = g_new0 (gchar *, num_devices + 1);
+  binaries = g_new0 (guchar *, num_devices);
+  lengths = g_new0 (gsize, num_devices);
+
+  for (i = 0; i < num_devices; i++)
+    {
+      filenames[i] = get_cache_filename (self, devices[i], options, ".bin");
+
+      /* all devices need a cached binary, otherwise build from source */
+      if (! g_file_get_contents (filenames[i],
+                                 (gchar **) &binaries[i],
+                                 &lengths[i],
+                                 NULL))
+        goto out;
+    }
+
+  program =
+    clCreateProgramWithBinary (gocl_context_get_context (self->priv->context),
+                               num_devices,
+                               devices,
+                               lengths,
+                               (const guchar **) binaries,
+                               NULL,
+                               &err_code);
+  if (err_code == CL_SUCCESS)
+    err_code = clBuildProgram (program, 0, NULL, options, NULL, NULL);
+
+  if (err_code != CL_SUCCESS)
+    {
+      /* stale or corrupt entry, drop it so it gets rebuilt from source */
+      if (program != NULL)
+        clReleaseProgram (program);
+
+      for (i = 0; i < num_devices; i++)
+        g_unlink (filenames[i]);
+
+      goto out;
+    }
+
+  clReleaseProgram (self->priv->program);
+  self->priv->program = program;
+  self->priv->from_binary = TRUE;
+
+  result = TRUE;
+
+ out:
+  for (i = 0; i < num_devices; i++)
+    g_free (binaries[i]);
+  g_free (binaries);
+  g_free (lengths);
+  g_strfreev (filenames);
+  g_free (devices);
+
+  return result;
+}
+
+static void
+store_binaries (GoclProgram *self, const gchar *options)
+{
+  cl_device_id *devices;
+  cl_uint num_devices = 0;
+  guchar **binaries;
+  gsize *sizes;
+  gchar *dir;
+  guint i;
+
+  devices = get_program_devices (self->priv->program, &num_devices);
+  if (devices == NULL)
+    return;
+
+  sizes = g_new0 (gsize, num_devices);
+  binaries = g_new0 (guchar *, num_devices);
+
+  if (clGetProgramInfo (self->priv->program,
+                        CL_PROGRAM_BINARY_SIZES,
+                        sizeof (gsize) * num_devices,
+                        sizes,
+                        NULL) != CL_SUCCESS)
+    goto out;
+
+  for (i = 0; i < num_devices; i++)
+    binaries[i] = g_malloc (sizes[i]);
+
+  if (clGetProgramInfo (self->priv->program,
+                        CL_PROGRAM_BINARIES,
+                        sizeof (guchar *) * num_devices,
+                        binaries,
+                        NULL) != CL_SUCCESS)
+    goto out;
+
+  dir = get_cache_dir ();
+  g_mkdir_with_parents (dir, 0700);
+  g_free (dir);
+
+  /* the cache is best-effort, failing to write an entry is not an error */
+  for (i = 0; i < num_devices; i++)
+    {
+      gchar *filename;
+
+      if (sizes[i] == 0)
+        continue;
+
+      filename = get_cache_filename (self, devices[i], options, ".bin");
+      g_file_set_contents (filename,
+                           (const gchar *) binaries[i],
+                           sizes[i],
+                           NULL);
+      g_free (filename);
+    }
+
+ out:
+  for (i = 0; i < num_devices; i++)
+    g_free (binaries[i]);
+  g_free (binaries);
+  g_free (sizes);
+  g_free (devices);
+}
+
+static gchar *
+get_build_log (cl_program program, cl_device_id device)
+{
+  gchar *log;
+  gsize size = 0;
+
+  if (clGetProgramBuildInfo (program,
+                             device,
+                             CL_PROGRAM_BUILD_LOG,
+                             0,
+                             NULL,
+                             &size) != CL_SUCCESS)
+    {
+      return NULL;
+    }
+
+  log = g_malloc0 (size + 1);
+  if (clGetProgramBuildInfo (program,
+                             device,
+                             CL_PROGRAM_BUILD_LOG,
+                             size,
+                             log,
+                             NULL) != CL_SUCCESS)
+    {
+      g_free (log);
+      return NULL;
+    }
+
+  return log;
+}
+
+static cl_int
+get_build_status (cl_program program)
+{
+  cl_device_id *devices;
+  cl_uint num_devices = 0;
+  cl_int err_code = CL_SUCCESS;
+  guint i;
+
+  devices = get_program_devices (program, &num_devices);
+  if (devices == NULL)
+    return CL_INVALID_PROGRAM;
+
+  for (i = 0; i < num_devices && err_code == CL_SUCCESS; i++)
+    {
+      cl_build_status status = CL_BUILD_NONE;
+
+      err_code = clGetProgramBuildInfo (program,
+                                        devices[i],
+                                        CL_PROGRAM_BUILD_STATUS,
+                                        sizeof (cl_build_status),
+                                        &status,
+                                        NULL);
+      if (err_code == CL_SUCCESS && status != CL_BUILD_SUCCESS)
+        err_code = CL_BUILD_PROGRAM_FAILURE;
+    }
+
+  g_free (devices);
+
+  return err_code;
+}
+
 static void
-build_in_thread (GSimpleAsyncResult *res,
-                 GObject            *object,
-                 GCancellable       *cancellable)
+release_kernel (gpointer data)
+{
+  clReleaseKernel (data);
+}
+
+static void
+release_kernels (GoclProgram *self)
+{
+  /* kernels attached to a program prevent building it again */
+  g_mutex_lock (&self->priv->kernels_mutex);
+  if (self->priv->kernels != NULL)
+    {
+      g_hash_table_unref (self->priv->kernels);
+      self->priv->kernels = NULL;
+    }
+  g_mutex_unlock (&self->priv->kernels_mutex);
+}
+
+static gboolean
+platform_can_clone_kernels (cl_program program)
 {
-  GoclProgram *self = GOCL_PROGRAM (object);
+#ifdef CL_VERSION_2_1
+  cl_device_id *devices;
+  cl_uint num_devices = 0;
+  cl_platform_id platform;
+  gchar version[64] = { 0 };
+  gint major = 0;
+  gint minor = 0;
+  cl_int err_code;
+
+  devices = get_program_devices (program, &num_devices);
+  if (devices == NULL)
+    return FALSE;
+
+  err_code = clGetDeviceInfo (devices[0],
+                              CL_DEVICE_PLATFORM,
+                              sizeof (cl_platform_id),
+                              &platform,
+                              NULL);
+  g_free (devices);
+
+  /* the ICD loader exports clCloneKernel() even when the platform behind it
+     is older, so the version of the platform itself is checked */
+  if (err_code != CL_SUCCESS ||
+      clGetPlatformInfo (platform,
+                         CL_PLATFORM_VERSION,
+                         sizeof (version) - 1,
+                         version,
+                         NULL) != CL_SUCCESS ||
+      sscanf (version, "OpenCL %d.%d", &major, &minor) != 2)
+    {
+      return FALSE;
+    }
+
+  return major > 2 || (major == 2 && minor >= 1);
+#else
+  return FALSE;
+#endif
+}
+
+static void
+load_kernels (GoclProgram *self)
+{
+  cl_kernel *kernels;
+  cl_uint num_kernels = 0;
+  guint i;
+
+  /* an empty registry is kept on failure too, so that it is not retried;
+     kernels are then created one by one, which reports errors properly */
+  self->priv->kernels = g_hash_table_new_full (g_str_hash,
+                                               g_str_equal,
+                                               g_free,
+                                               release_kernel);
+
+  /* templates are only of use for cloning */
+  self->priv->can_clone_kernels =
+    platform_can_clone_kernels (self->priv->program);
+  if (! self->priv->can_clone_kernels)
+    return;
+
+  if (clCreateKernelsInProgram (self->priv->program,
+                                0,
+                                NULL,
+                                &num_kernels) != CL_SUCCESS ||
+      num_kernels == 0)
+    {
+      return;
+    }
+
+  kernels = g_new0 (cl_kernel, num_kernels);
+  if (clCreateKernelsInProgram (self->priv->program,
+                                num_kernels,
+                                kernels,
+                                NULL) == CL_SUCCESS)
+    {
+      for (i = 0; i < num_kernels; i++)
+        {
+          gchar *name;
+          gsize size = 0;
+
+          name = NULL;
+          if (clGetKernelInfo (kernels[i],
+                               CL_KERNEL_FUNCTION_NAME,
+                               0,
+                               NULL,
+                               &size) == CL_SUCCESS)
+            {
+              name = g_malloc0 (size + 1);
+              if (clGetKernelInfo (kernels[i],
+                                   CL_KERNEL_FUNCTION_NAME,
+                                   size,
+                                   name,
+                                   NULL) != CL_SUCCESS)
+                {
+                  g_free (name);
+                  name = NULL;
+                }
+            }
+
+          if (name != NULL)
+            g_hash_table_insert (self->priv->kernels, name, kernels[i]);
+          else
+            clReleaseKernel (kernels[i]);
+        }
+    }
+  g_free (kernels);
+}
+
+typedef struct
+{
+  gint ref_count;
+
+  GoclProgram *self;
+  GSimpleAsyncResult *res;
   gchar *options;
 
-  options = g_simple_async_result_get_op_res_gpointer (res);
+  GCancellable *cancellable;
+  gulong cancelled_id;
 
-  if (! gocl_program_build_sync (self, options))
+  /* whoever flips these first owns the transition; the build finishing and
+     the result being delivered are distinct, since cancelling delivers the
+     result early while the runtime keeps compiling */
+  gint build_done;
+  gint completed;
+} BuildData;
+
+/* drops everything the build holds but the structure itself, which the
+   runtime callback may still point to */
+static void
+build_data_release (BuildData *data)
+{
+  if (data->cancelled_id != 0)
     {
-      GError *error;
+      /* also waits for a cancellation handler running in another thread */
+      g_cancellable_disconnect (data->cancellable, data->cancelled_id);
+      data->cancelled_id = 0;
+    }
+  g_clear_object (&data->cancellable);
+
+  g_clear_object (&data->res);
+  g_clear_object (&data->self);
+
+  g_free (data->options);
+  data->options = NULL;
+}
+
+static void
+build_data_unref (BuildData *data)
+{
+  if (! g_atomic_int_dec_and_test (&data->ref_count))
+    return;
+
+  build_data_release (data);
 
-      error = gocl_error_get_last ();
-      g_simple_async_result_take_error (res, error);
+  g_slice_free (BuildData, data);
+}
+
+static void
+build_complete (BuildData *data, GError *error)
+{
+  if (! g_atomic_int_compare_and_exchange (&data->completed, FALSE, TRUE))
+    {
+      if (error != NULL)
+        g_error_free (error);
+      return;
     }
 
-  g_object_unref (res);
+  if (error != NULL)
+    g_simple_async_result_take_error (data->res, error);
+
+  g_simple_async_result_complete_in_idle (data->res);
+}
+
+static void
+build_finished (BuildData *data, cl_int err_code)
+{
+  GError *error = NULL;
+
+  if (! g_atomic_int_compare_and_exchange (&data->build_done, FALSE, TRUE))
+    return;
+
+  if (err_code == CL_SUCCESS && data->self->priv->use_binary_cache)
+    store_binaries (data->self, data->options);
+
+  g_atomic_int_set (&data->self->priv->building, FALSE);
 
-  self->priv->building = FALSE;
+  gocl_error_check_opencl (err_code, &error);
+  build_complete (data, error);
+
+  /* only the first caller gets here, so nothing else uses the references */
+  build_data_release (data);
+}
+
+static void
+build_on_notify (cl_program program, void *user_data)
+{
+  BuildData *data = user_data;
+
+  /* runs in a thread owned by the OpenCL runtime */
+  build_finished (data, get_build_status (program));
+  build_data_unref (data);
+}
+
+static void
+build_on_cancelled (GCancellable *cancellable, gpointer user_data)
+{
+  BuildData *data = user_data;
+
+  /* OpenCL cannot abort a build in progress, so the result is delivered
+     now and the runtime is left to finish in the background */
+  build_complete (data, g_error_new_literal (G_IO_ERROR,
+                                             G_IO_ERROR_CANCELLED,
+                                             "Operation was cancelled"));
+}
+
+/* internal */
+
+gchar *
+gocl_program_get_tuning_filename (GoclProgram *self, cl_device_id device)
+{
+  return get_cache_filename (self, device, NULL, ".tune");
+}
+
+cl_kernel
+gocl_program_create_kernel (GoclProgram *self,
+                            const gchar *name,
+                            cl_int      *err_code)
+{
+  cl_kernel kernel = NULL;
+
+  g_mutex_lock (&self->priv->kernels_mutex);
+
+  if (self->priv->kernels == NULL)
+    load_kernels (self);
+
+#ifdef CL_VERSION_2_1
+  if (self->priv->can_clone_kernels)
+    {
+      cl_kernel template;
+
+      /* the template never has arguments set, so its clones start clean */
+      template = g_hash_table_lookup (self->priv->kernels, name);
+      if (template != NULL)
+        kernel = clCloneKernel (template, err_code);
+    }
+#endif
+
+  g_mutex_unlock (&self->priv->kernels_mutex);
+
+  if (kernel == NULL)
+    kernel = clCreateKernel (self->priv->program, name, err_code);
+
+  return kernel;
 }
 
 /* public */
@@ -232,6 +853,7 @@ gocl_program_new (GoclContext  *context,
 {
   GoclProgram *self;
   cl_int err_code;
+  guint i;
 
   g_return_val_if_fail (GOCL_IS_CONTEXT (context), NULL);
   g_return_val_if_fail (sources != NULL, NULL);
@@ -243,14 +865,17 @@ gocl_program_new (GoclContext  *context,
   if (num_sources < 1)
     num_sources = g_strv_length ((gchar **) sources);
 
-  self->priv->program =
-    clCreateProgramWithSource (gocl_context_get_context (context),
-                               num_sources,
-                               sources,
-                               NULL,
-                               &err_code);
+  /* sources are kept for the binary cache key and for rebuilding */
+  self->priv->sources = g_new0 (gchar *, num_sources + 1);
+  for (i = 0; i < num_sources; i++)
+    self->priv->sources[i] = g_strdup (sources[i]);
+
+  err_code = create_program_from_source (self);
   if (gocl_error_check_opencl_internal (err_code))
-    return NULL;
+    {
+      g_object_unref (self);
+      return NULL;
+    }
 
   return self;
 }
@@ -334,6 +959,12 @@ gocl_program_get_context (GoclProgram *self)
  * in the source code, specified by @kernel_name string. Upon success,
  * a new #GoclKernel is returned, otherwise %NULL is returned.
  *
+ * Every call returns an independent kernel, with no arguments set. On
+ * platforms supporting OpenCL 2.1, the first call after a build creates all
+ * the kernels of the program at once, and keeps them as templates that are
+ * cloned for later calls. For a thread to get its own copy of a kernel that
+ * is already configured, see gocl_kernel_clone().
+ *
  * Returns: (transfer full): A newly created #GoclKernel object
  **/
 GoclKernel *
@@ -363,6 +994,10 @@ gocl_program_get_kernel (GoclProgram *self, const gchar *kernel_name)
  * @options. This method is blocking. For an asynchronous version,
  * gocl_program_build() is provided. On error, %FALSE is returned.
  *
+ * If #GoclProgram:use-binary-cache is %TRUE, binaries from a previous build
+ * with the same sources, options and devices are reused when available, and
+ * the resulting binaries are stored for future builds otherwise.
+ *
  * A detailed description of the build options is available at Kronos
  * documentation website:
  * http://www.khronos.org/registry/cl/sdk/1.0/docs/man/xhtml/clBuildProgram.html
@@ -376,14 +1011,37 @@ gocl_program_build_sync (GoclProgram *self, const gchar *options)
 
   g_return_val_if_fail (GOCL_IS_PROGRAM (self), FALSE);
 
+  release_kernels (self);
+
+  if (self->priv->use_binary_cache &&
+      build_from_cached_binaries (self, options))
+    {
+      return ! gocl_error_check_opencl_internal (CL_SUCCESS);
+    }
+
+  /* a program loaded from binaries cannot be rebuilt with other options */
+  if (self->priv->from_binary)
+    {
+      clReleaseProgram (self->priv->program);
+
+      err_code = create_program_from_source (self);
+      if (gocl_error_check_opencl_internal (err_code))
+        return FALSE;
+    }
+
   err_code = clBuildProgram (self->priv->program,
                              0,
                              NULL,
                              options,
                              NULL,
                              NULL);
+  if (gocl_error_check_opencl_internal (err_code))
+    return FALSE;
 
-  return ! gocl_error_check_opencl_internal (err_code);
+  if (self->priv->use_binary_cache)
+    store_binaries (self, options);
+
+  return TRUE;
 }
 
 /**
@@ -399,8 +1057,16 @@ gocl_program_build_sync (GoclProgram *self, const gchar *options)
  * be called when the operation completes, and gocl_program_build_finish()
  * can be used within the callback to retrieve the result of the operation.
  *
+ * No thread is spawned for the build. The OpenCL runtime compiles in the
+ * background and notifies completion, so any number of programs can be built
+ * concurrently. @callback is invoked in the thread-default main context of
+ * the caller. A program only allows one build at a time, a build requested
+ * while another one is in progress fails with %G_IO_ERROR_PENDING.
+ *
  * A #GCancellable object can be passed in @cancellable to allow cancelling
- * the operation.
+ * the operation. Since OpenCL cannot abort a build in progress, cancelling
+ * completes the operation immediately with %G_IO_ERROR_CANCELLED, but the
+ * program remains busy until the runtime has finished compiling it.
  **/
 void
 gocl_program_build (GoclProgram         *self,
@@ -410,39 +1076,94 @@ gocl_program_build (GoclProgram         *self,
                     gpointer             user_data)
 {
   GSimpleAsyncResult *res;
+  BuildData *data;
+  GError *error = NULL;
+  cl_int err_code;
 
   g_return_if_fail (GOCL_IS_PROGRAM (self));
+  g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
 
   res = g_simple_async_result_new (G_OBJECT (self),
                                    callback,
                                    user_data,
                                    gocl_program_build);
 
-  if (self->priv->building)
+  if (g_cancellable_set_error_if_cancelled (cancellable, &error))
+    goto fail;
+
+  if (! g_atomic_int_compare_and_exchange (&self->priv->building, FALSE, TRUE))
+    {
+      g_set_error_literal (&error,
+                           G_IO_ERROR,
+                           G_IO_ERROR_PENDING,
+                           "A previous build operation is pending");
+      goto fail;
+    }
+
+  release_kernels (self);
+
+  /* loading cached binaries involves no compilation, so it is done here */
+  if (self->priv->use_binary_cache &&
+      build_from_cached_binaries (self, options))
     {
-      g_simple_async_result_set_error (res,
-                                       G_IO_ERROR,
-                                       G_IO_ERROR_PENDING,
-                                       "A previous build operation is pending");
+      g_atomic_int_set (&self->priv->building, FALSE);
       g_simple_async_result_complete_in_idle (res);
       g_object_unref (res);
+      return;
     }
-  else
+
+  if (self->priv->from_binary)
     {
-      self->priv->building = TRUE;
+      clReleaseProgram (self->priv->program);
+
+      err_code = create_program_from_source (self);
+      if (gocl_error_check_opencl (err_code, &error))
+        {
+          g_atomic_int_set (&self->priv->building, FALSE);
+          goto fail;
+        }
+    }
 
-      if (options == NULL)
-        options = "";
+  data = g_slice_new0 (BuildData);
+  data->ref_count = 2;
+  data->self = g_object_ref (self);
+  data->res = res;
+  data->options = g_strdup (options);
 
-      g_simple_async_result_set_op_res_gpointer (res,
-                                                 g_strdup (options),
-                                                 g_free);
+  if (cancellable != NULL)
+    {
+      data->cancellable = g_object_ref (cancellable);
+      data->cancelled_id = g_cancellable_connect (cancellable,
+                                                  G_CALLBACK (build_on_cancelled),
+                                                  data,
+                                                  NULL);
+    }
 
-      g_simple_async_result_run_in_thread (res,
-                                           build_in_thread,
-                                           G_PRIORITY_DEFAULT,
-                                           cancellable);
+  err_code = clBuildProgram (self->priv->program,
+                             0,
+                             NULL,
+                             data->options,
+                             build_on_notify,
+                             data);
+  if (err_code != CL_SUCCESS)
+    {
+      build_finished (data, err_code);
+
+      /* runtimes disagree on whether the callback still fires after a
+         failed build is reported here, so its reference is only released
+         when it certainly will not. The build already dropped the program
+         and the result, so at most the bare structure is left behind */
+      if (err_code != CL_BUILD_PROGRAM_FAILURE)
+        build_data_unref (data);
     }
+
+  build_data_unref (data);
+  return;
+
+ fail:
+  g_simple_async_result_take_error (res, error);
+  g_simple_async_result_complete_in_idle (res);
+  g_object_unref (res);
 }
 
 /**
@@ -471,3 +1192,202 @@ gocl_program_build_finish (GoclProgram   *self,
     ! g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (result),
                                              error);
 }
+
+/**
+ * gocl_program_get_build_log:
+ * @self: The #GoclProgram
+ * @device: (allow-none): The #GoclDevice to get the log for, or %NULL
+ *
+ * Retrieves the log of the last build, compile or link operation on the
+ * program, as reported by the OpenCL compiler for @device. If @device is
+ * %NULL, the non-empty logs of all the devices of the program are returned,
+ * one after another. This is most useful after a build has failed.
+ *
+ * Returns: (transfer full): A newly allocated string with the build log, or
+ *   %NULL on error. Free with g_free().
+ **/
+gchar *
+gocl_program_get_build_log (GoclProgram *self, GoclDevice *device)
+{
+  cl_device_id *devices;
+  cl_uint num_devices = 0;
+  GString *log;
+  guint i;
+
+  g_return_val_if_fail (GOCL_IS_PROGRAM (self), NULL);
+  g_return_val_if_fail (device == NULL || GOCL_IS_DEVICE (device), NULL);
+
+  if (self->priv->program == NULL)
+    return NULL;
+
+  if (device != NULL)
+    return get_build_log (self->priv->program, gocl_device_get_id (device));
+
+  devices = get_program_devices (self->priv->program, &num_devices);
+  if (devices == NULL)
+    return NULL;
+
+  log = g_string_new ("");
+  for (i = 0; i < num_devices; i++)
+    {
+      gchar *device_log;
+
+      device_log = get_build_log (self->priv->program, devices[i]);
+      if (device_log != NULL && device_log[0] != '\0')
+        {
+          if (log->len > 0 && log->str[log->len - 1] != '\n')
+            g_string_append_c (log, '\n');
+          g_string_append (log, device_log);
+        }
+      g_free (device_log);
+    }
+
+  g_free (devices);
+
+  return g_string_free (log, FALSE);
+}
+
+#ifdef CL_VERSION_1_2
+
+/**
+ * gocl_program_compile_sync:
+ * @self: The #GoclProgram
+ * @options: (allow-none): A string specifying OpenCL compile options, or %NULL
+ * @headers: (array length=num_headers) (allow-none): Programs holding the
+ *   source of embedded headers, or %NULL
+ * @header_names: (array length=num_headers) (allow-none): The names by which
+ *   the sources include each of @headers, or %NULL
+ * @num_headers: The number of elements in @headers and @header_names
+ *
+ * Compiles the sources of the program into an intermediate object, without
+ * producing an executable. Compiled programs are then combined into
+ * executable programs with gocl_program_link_sync(), which allows a library of
+ * shared code to be compiled once and linked into many programs. The sources
+ * of @headers are made available to `#include` directives under the matching
+ * @header_names, they need not be built. The binary cache is not used. This
+ * method is blocking. On error, %FALSE is returned.
+ *
+ * Returns: %TRUE on success or %FALSE on error
+ **/
+gboolean
+gocl_program_compile_sync (GoclProgram  *self,
+                           const gchar  *options,
+                           GoclProgram **headers,
+                           const gchar **header_names,
+                           guint         num_headers)
+{
+  cl_program *cl_headers = NULL;
+  cl_int err_code;
+  guint i;
+
+  g_return_val_if_fail (GOCL_IS_PROGRAM (self), FALSE);
+  g_return_val_if_fail (num_headers == 0 ||
+                        (headers != NULL && header_names != NULL), FALSE);
+
+  release_kernels (self);
+
+  if (self->priv->from_binary)
+    {
+      clReleaseProgram (self->priv->program);
+
+      err_code = create_program_from_source (self);
+      if (gocl_error_check_opencl_internal (err_code))
+        return FALSE;
+    }
+
+  if (num_headers > 0)
+    {
+      cl_headers = g_new (cl_program, num_headers);
+      for (i = 0; i < num_headers; i++)
+        cl_headers[i] = headers[i]->priv->program;
+    }
+
+  err_code = clCompileProgram (self->priv->program,
+                               0,
+                               NULL,
+                               options,
+                               num_headers,
+                               cl_headers,
+                               header_names,
+                               NULL,
+                               NULL);
+  g_free (cl_headers);
+
+  return ! gocl_error_check_opencl_internal (err_code);
+}
+
+/**
+ * gocl_program_link_sync:
+ * @context: The #GoclContext
+ * @programs: (array length=num_programs): Programs previously compiled with
+ *   gocl_program_compile_sync()
+ * @num_programs: The number of elements in @programs
+ * @options: (allow-none): A string specifying OpenCL link options, or %NULL
+ *
+ * Links compiled programs into a new executable program, from which kernels
+ * can be obtained right away with gocl_program_get_kernel(). The returned
+ * program is already built and must not be built again. Each of @programs
+ * can be linked into any number of executables. This method is blocking.
+ * Upon error, %NULL is returned, and the linker output can be retrieved with
+ * gocl_program_get_build_log() on the compiled programs.
+ *
+ * Returns: (transfer full): A newly created #GoclProgram, or %NULL on error
+ **/
+GoclProgram *
+gocl_program_link_sync (GoclContext  *context,
+                        GoclProgram **programs,
+                        guint         num_programs,
+                        const gchar  *options)
+{
+  GoclProgram *self;
+  cl_program *cl_programs;
+  cl_program program;
+  GPtrArray *sources;
+  cl_int err_code;
+  guint i;
+  guint j;
+
+  g_return_val_if_fail (GOCL_IS_CONTEXT (context), NULL);
+  g_return_val_if_fail (programs != NULL && num_programs > 0, NULL);
+
+  cl_programs = g_new (cl_program, num_programs);
+  for (i = 0; i < num_programs; i++)
+    cl_programs[i] = programs[i]->priv->program;
+
+  program = clLinkProgram (gocl_context_get_context (context),
+                           0,
+                           NULL,
+                           options,
+                           num_programs,
+                           cl_programs,
+                           NULL,
+                           NULL,
+                           &err_code);
+  g_free (cl_programs);
+
+  if (gocl_error_check_opencl_internal (err_code))
+    {
+      if (program != NULL)
+        clReleaseProgram (program);
+      return NULL;
+    }
+
+  /* a linked program cannot be rebuilt from its inputs, so it bypasses the
+     binary cache; the sources of the inputs still key its tuning data */
+  self = g_object_new (GOCL_TYPE_PROGRAM,
+                       "context", context,
+                       "use-binary-cache", FALSE,
+                       NULL);
+  self->priv->program = program;
+
+  sources = g_ptr_array_new ();
+  for (i = 0; i < num_programs; i++)
+    for (j = 0; programs[i]->priv->sources[j] != NULL; j++)
+      g_ptr_array_add (sources, g_strdup (programs[i]->priv->sources[j]));
+  g_ptr_array_add (sources, NULL);
+  self->priv->sources = (gchar **) g_ptr_array_free (sources, FALSE);
+
+  return self;
+}
+
+#endif /* CL_VERSION_1_2 */
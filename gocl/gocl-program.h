@@ -78,6 +78,21 @@ gboolean               gocl_program_build_finish               (GoclProgram   *s
                                                                 GAsyncResult  *result,
                                                                 GError       **error);
 
+gchar *                gocl_program_get_build_log              (GoclProgram *self,
+                                                                GoclDevice  *device);
+
+#ifdef CL_VERSION_1_2
+gboolean               gocl_program_compile_sync               (GoclProgram  *self,
+                                                                const gchar  *options,
+                                                                GoclProgram **headers,
+                                                                const gchar **header_names,
+                                                                guint         num_headers);
+GoclProgram *          gocl_program_link_sync                  (GoclContext  *context,
+                                                                GoclProgram **programs,
+                                                                guint         num_programs,
+                                                                const gchar  *options);
+#endif
+
 G_END_DECLS
 
 #endif /* __GOCL_PROGRAM_H__ */
@@ -24,15 +24,35 @@
  * @short_description: Object that represents an OpenCL command queue
  * @stability: Unstable
  *
- * A #GoclQueue represents an OpenCL command queue that is created from a
- * device, using gocl_device_get_default_queue(). Currently, there is no
- * API for creating command queues directly, but that can change as soon
- * as practical use cases require it.
+ * A #GoclQueue represents an OpenCL command queue on a device. Each device
+ * provides a default queue, obtained with gocl_device_get_default_queue(), and
+ * a pool of additional queues (see gocl_device_add_queue()). Queues can also be
+ * created directly with gocl_queue_new(), for example to enable out-of-order
+ * execution or profiling through #GoclQueueFlags.
  *
  * For API simplicity, operations on a command queue are handled
  * elsewhere, like gocl_kernel_run_in_device(), which internally enqueues
  * the execution; or gocl_buffer_read_sync() and gocl_buffer_write_sync(), which
- * internally enqueues read/write operations on the command queue.
+ * internally enqueues read/write operations on the command queue. Kernels
+ * are executed on a specific queue with gocl_kernel_run_in_queue().
+ *
+ * A queue created with %GOCL_QUEUE_FLAGS_PROFILING can optionally aggregate
+ * the device execution time of its commands, grouped by kernel name or
+ * buffer operation. Collection is enabled with gocl_queue_set_collect_stats(),
+ * and the aggregated figures can be retrieved at any time with
+ * gocl_queue_get_stats().
+ *
+ * Short host steps between device commands can be enqueued like any other
+ * command with gocl_queue_enqueue_host_func(). Commands depending on a host
+ * step can then be enqueued right away, and start as soon as the step
+ * finishes, without a round trip through the application's main loop.
+ **/
+
+/**
+ * GoclHostFunc:
+ * @user_data: The arbitrary pointer passed to gocl_queue_enqueue_host_func()
+ *
+ * Prototype of the @func argument of gocl_queue_enqueue_host_func().
  **/
 
 /**
@@ -42,6 +62,8 @@
  * The class for #GoclQueue objects.
  **/
 
+#include <stdlib.h>
+#include <string.h>
 #include <gio/gio.h>
 
 #include "gocl-queue.h"
@@ -57,8 +79,33 @@ struct _GoclQueuePrivate
   GoclDevice *device;
 
   guint flags;
+
+  gint collect_stats;
+  GMutex stats_mutex;
+  GHashTable *stats;
+
+  gint callback_dispatch;
+  GThreadPool *callback_pool;
+
+  gboolean native_kernels;
 };
 
+/* number of recent samples kept per label to estimate the 99th percentile */
+#define STATS_NUM_SAMPLES 1024
+
+typedef struct
+{
+  guint64 count;
+  guint64 total_time;
+  guint64 min_time;
+  guint64 max_time;
+  guint64 bytes;
+
+  guint64 samples[STATS_NUM_SAMPLES];
+  guint num_samples;
+  guint next_sample;
+} StatsEntry;
+
 /* properties */
 enum
 {
@@ -85,6 +132,11 @@ static void           get_property                     (GObject    *obj,
                                                         GValue     *value,
                                                         GParamSpec *pspec);
 
+G_DEFINE_BOXED_TYPE (GoclCommandStats,
+                     gocl_command_stats,
+                     gocl_command_stats_copy,
+                     gocl_command_stats_free)
+
 G_DEFINE_TYPE_WITH_CODE (GoclQueue, gocl_queue, G_TYPE_OBJECT,
                          G_IMPLEMENT_INTERFACE (G_TYPE_INITABLE,
                                                 gocl_queue_initable_iface_init));
@@ -117,6 +169,7 @@ gocl_queue_class_init (GoclQueueClass *class)
                                                       "Flags",
                                                       "The command queue properties",
                                                       0,
+                                                      GOCL_QUEUE_FLAGS_OUT_OF_ORDER |
                                                       GOCL_QUEUE_FLAGS_PROFILING,
                                                       0,
                                                       G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
@@ -149,6 +202,19 @@ gocl_queue_initable_init (GInitable     *initable,
                                             self->priv->flags,
                                             &err_code);
 
+  /* CPU devices can usually run host functions as commands themselves */
+  if (err_code == CL_SUCCESS)
+    {
+      cl_device_exec_capabilities capabilities = 0;
+
+      clGetDeviceInfo (device_id,
+                       CL_DEVICE_EXECUTION_CAPABILITIES,
+                       sizeof (cl_device_exec_capabilities),
+                       &capabilities,
+                       NULL);
+      self->priv->native_kernels = (capabilities & CL_EXEC_NATIVE_KERNEL) != 0;
+    }
+
   if (gocl_error_check_opencl (err_code, error))
     return FALSE;
   else
@@ -163,6 +229,19 @@ gocl_queue_init (GoclQueue *self)
   self->priv = priv = GOCL_QUEUE_GET_PRIVATE (self);
 
   priv->queue = NULL;
+
+  priv->collect_stats = FALSE;
+
+  priv->callback_dispatch = GOCL_CALLBACK_DISPATCH_MAIN_CONTEXT;
+  priv->callback_pool = NULL;
+
+  priv->native_kernels = FALSE;
+
+  g_mutex_init (&priv->stats_mutex);
+  priv->stats = g_hash_table_new_full (g_str_hash,
+                                       g_str_equal,
+                                       g_free,
+                                       g_free);
 }
 
 static void
@@ -193,6 +272,9 @@ gocl_queue_finalize (GObject *obj)
   if (self->priv->queue != NULL)
     clReleaseCommandQueue (self->priv->queue);
 
+  g_hash_table_unref (self->priv->stats);
+  g_mutex_clear (&self->priv->stats_mutex);
+
   G_OBJECT_CLASS (gocl_queue_parent_class)->finalize (obj);
 }
 
@@ -248,8 +330,270 @@ get_property (GObject    *obj,
     }
 }
 
+static gint
+compare_samples (gconstpointer a, gconstpointer b)
+{
+  guint64 x = *(const guint64 *) a;
+  guint64 y = *(const guint64 *) b;
+
+  return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static guint64
+get_p99_time (const StatsEntry *entry)
+{
+  guint64 samples[STATS_NUM_SAMPLES];
+  guint index;
+
+  if (entry->num_samples == 0)
+    return 0;
+
+  memcpy (samples, entry->samples, sizeof (guint64) * entry->num_samples);
+  qsort (samples, entry->num_samples, sizeof (guint64), compare_samples);
+
+  /* nearest-rank method */
+  index = (entry->num_samples * 99 + 99) / 100 - 1;
+
+  return samples[index];
+}
+
+typedef struct
+{
+  GoclHostFunc func;
+  gpointer user_data;
+  GDestroyNotify destroy;
+
+  /* set once the function returns, to release the commands after it */
+  cl_event done_event;
+} HostTask;
+
+static void
+host_task_free (HostTask *task)
+{
+  if (task->destroy != NULL)
+    task->destroy (task->user_data);
+  g_slice_free (HostTask, task);
+}
+
+static void
+host_task_on_complete (cl_event  event,
+                       cl_int    event_command_exec_status,
+                       void     *user_data)
+{
+  host_task_free (user_data);
+}
+
+/* clEnqueueNativeKernel() passes a copy of the HostTask it was given */
+static void
+host_task_run_native (void *args)
+{
+  HostTask *task = args;
+
+  task->func (task->user_data);
+}
+
+static void
+host_task_on_ready (cl_event  event,
+                    cl_int    event_command_exec_status,
+                    void     *user_data)
+{
+  HostTask *task = user_data;
+
+  /* a failure of the commands waited for propagates, skipping the task */
+  if (event_command_exec_status == CL_COMPLETE)
+    task->func (task->user_data);
+
+  clSetUserEventStatus (task->done_event,
+                        event_command_exec_status < 0 ?
+                          event_command_exec_status : CL_COMPLETE);
+  clReleaseEvent (task->done_event);
+
+  host_task_free (task);
+}
+
+static cl_int
+enqueue_native_task (GoclQueue          *self,
+                     HostTask           *task,
+                     const GoclWaitList *wait_list,
+                     cl_event           *out_event)
+{
+  cl_int err_code;
+
+  err_code = clEnqueueNativeKernel (self->priv->queue,
+                                    host_task_run_native,
+                                    task,
+                                    sizeof (HostTask),
+                                    0,
+                                    NULL,
+                                    NULL,
+                                    wait_list->len,
+                                    wait_list->cl_events,
+                                    out_event);
+  if (err_code != CL_SUCCESS)
+    return err_code;
+
+  /* the copy run by OpenCL does not own the user data */
+  if (clSetEventCallback (*out_event,
+                          CL_COMPLETE,
+                          host_task_on_complete,
+                          task) != CL_SUCCESS)
+    {
+      clWaitForEvents (1, out_event);
+      host_task_free (task);
+    }
+
+  return CL_SUCCESS;
+}
+
+/* a marker tells when the task may run, and a barrier waiting for a user
+   event holds the commands enqueued after it until the task is done */
+static cl_int
+enqueue_user_event_task (GoclQueue          *self,
+                         HostTask           *task,
+                         const GoclWaitList *wait_list,
+                         cl_event           *out_event)
+{
+  cl_context context;
+  cl_event ready_event;
+  cl_int err_code;
+
+  context = gocl_context_get_context (gocl_device_get_context (self->priv->device));
+
+  task->done_event = clCreateUserEvent (context, &err_code);
+  if (err_code != CL_SUCCESS)
+    return err_code;
+
+  err_code = clEnqueueMarkerWithWaitList (self->priv->queue,
+                                          wait_list->len,
+                                          wait_list->cl_events,
+                                          &ready_event);
+  if (err_code != CL_SUCCESS)
+    {
+      clReleaseEvent (task->done_event);
+      return err_code;
+    }
+
+  err_code = clEnqueueBarrierWithWaitList (self->priv->queue,
+                                           1,
+                                           &task->done_event,
+                                           out_event);
+  if (err_code == CL_SUCCESS)
+    {
+      err_code = clSetEventCallback (ready_event,
+                                     CL_COMPLETE,
+                                     host_task_on_ready,
+                                     task);
+      if (err_code != CL_SUCCESS)
+        clReleaseEvent (*out_event);
+    }
+
+  if (err_code != CL_SUCCESS)
+    {
+      /* unblock the barrier, if it was enqueued */
+      clSetUserEventStatus (task->done_event, err_code);
+      clReleaseEvent (task->done_event);
+      clReleaseEvent (ready_event);
+      return err_code;
+    }
+
+  /* some platforms only call back while someone waits on the event */
+  gocl_event_dispatcher_add_event (ready_event);
+  clReleaseEvent (ready_event);
+
+  /* some platforms do not start the marker before a flush */
+  clFlush (self->priv->queue);
+
+  return CL_SUCCESS;
+}
+
+/* internal */
+
+void
+gocl_queue_record_command (GoclQueue   *self,
+                           cl_event     event,
+                           const gchar *label,
+                           guint64      bytes)
+{
+  cl_ulong start;
+  cl_ulong end;
+  guint64 elapsed;
+  StatsEntry *entry;
+
+  if (! g_atomic_int_get (&self->priv->collect_stats))
+    return;
+
+  if (clGetEventProfilingInfo (event,
+                               CL_PROFILING_COMMAND_START,
+                               sizeof (cl_ulong),
+                               &start,
+                               NULL) != CL_SUCCESS ||
+      clGetEventProfilingInfo (event,
+                               CL_PROFILING_COMMAND_END,
+                               sizeof (cl_ulong),
+                               &end,
+                               NULL) != CL_SUCCESS)
+    {
+      return;
+    }
+
+  elapsed = end > start ? end - start : 0;
+
+  if (label == NULL)
+    label = "unknown";
+
+  g_mutex_lock (&self->priv->stats_mutex);
+
+  entry = g_hash_table_lookup (self->priv->stats, label);
+  if (entry == NULL)
+    {
+      entry = g_new0 (StatsEntry, 1);
+      entry->min_time = G_MAXUINT64;
+      g_hash_table_insert (self->priv->stats, g_strdup (label), entry);
+    }
+
+  entry->count++;
+  entry->total_time += elapsed;
+  entry->min_time = MIN (entry->min_time, elapsed);
+  entry->max_time = MAX (entry->max_time, elapsed);
+  entry->bytes += bytes;
+
+  entry->samples[entry->next_sample] = elapsed;
+  entry->next_sample = (entry->next_sample + 1) % STATS_NUM_SAMPLES;
+  if (entry->num_samples < STATS_NUM_SAMPLES)
+    entry->num_samples++;
+
+  g_mutex_unlock (&self->priv->stats_mutex);
+}
+
 /* public */
 
+/**
+ * gocl_queue_new:
+ * @device: The #GoclDevice to create the queue on
+ * @flags: An OR'ed combination of values from #GoclQueueFlags
+ *
+ * Creates a new command queue on @device, with the properties specified in
+ * @flags. Commands enqueued in different queues may execute concurrently.
+ *
+ * Returns: (transfer full): A newly created #GoclQueue, or %NULL on error
+ **/
+GoclQueue *
+gocl_queue_new (GoclDevice *device, guint flags)
+{
+  GError **error;
+
+  g_return_val_if_fail (GOCL_IS_DEVICE (device), NULL);
+
+  error = gocl_error_prepare ();
+
+  return g_initable_new (GOCL_TYPE_QUEUE,
+                         NULL,
+                         error,
+                         "device", device,
+                         "flags", flags,
+                         NULL);
+}
+
 /**
  * gocl_queue_get_queue:
  * @self: The #GoclQueue
@@ -341,3 +685,290 @@ gocl_queue_finish (GoclQueue *self)
 
   return ! gocl_error_check_opencl_internal (ret);
 };
+
+/**
+ * gocl_queue_set_collect_stats:
+ * @self: The #GoclQueue
+ * @collect: %TRUE to collect statistics, %FALSE to stop collecting
+ *
+ * Enables or disables the collection of statistics about the commands
+ * completed on this queue. The queue must have been created with
+ * %GOCL_QUEUE_FLAGS_PROFILING. Already collected statistics are kept when
+ * collection is disabled; use gocl_queue_reset_stats() to clear them.
+ **/
+void
+gocl_queue_set_collect_stats (GoclQueue *self, gboolean collect)
+{
+  g_return_if_fail (GOCL_IS_QUEUE (self));
+  g_return_if_fail (! collect ||
+                    (self->priv->flags & GOCL_QUEUE_FLAGS_PROFILING) != 0);
+
+  g_atomic_int_set (&self->priv->collect_stats, collect ? 1 : 0);
+}
+
+/**
+ * gocl_queue_get_collect_stats:
+ * @self: The #GoclQueue
+ *
+ * Tells whether this queue is collecting statistics about its commands.
+ *
+ * Returns: %TRUE if statistics are being collected, %FALSE otherwise
+ **/
+gboolean
+gocl_queue_get_collect_stats (GoclQueue *self)
+{
+  g_return_val_if_fail (GOCL_IS_QUEUE (self), FALSE);
+
+  return g_atomic_int_get (&self->priv->collect_stats) != 0;
+}
+
+/**
+ * gocl_queue_set_callback_dispatch:
+ * @self: The #GoclQueue
+ * @dispatch: A value from #GoclCallbackDispatch
+ * @pool: (allow-none): The #GThreadPool to push callbacks to, or %NULL
+ *
+ * Sets how the callbacks passed to gocl_event_then() are invoked for the
+ * events of commands enqueued from now on in this queue.
+ *
+ * By default, a completed command is first noticed on an internal thread,
+ * then resolved from an idle source of the main context the event was
+ * created in, and each callback runs from another idle source on the
+ * thread-default main context of its caller. Applications that have no main
+ * loop running, or a busy one, can instead use
+ * %GOCL_CALLBACK_DISPATCH_COMPLETION_THREAD to run callbacks as soon as the
+ * command completes, on whatever thread observes it. Such callbacks should
+ * return quickly, since they delay the notification of other events.
+ *
+ * With %GOCL_CALLBACK_DISPATCH_THREAD_POOL, callbacks are pushed to @pool
+ * instead, which must have been created with gocl_event_dispatch_func() as its
+ * function, and must outlive the events of this queue.
+ **/
+void
+gocl_queue_set_callback_dispatch (GoclQueue            *self,
+                                  GoclCallbackDispatch  dispatch,
+                                  GThreadPool          *pool)
+{
+  g_return_if_fail (GOCL_IS_QUEUE (self));
+  g_return_if_fail (dispatch != GOCL_CALLBACK_DISPATCH_THREAD_POOL ||
+                    pool != NULL);
+
+  g_atomic_pointer_set (&self->priv->callback_pool,
+                        dispatch == GOCL_CALLBACK_DISPATCH_THREAD_POOL ?
+                          pool : NULL);
+  g_atomic_int_set (&self->priv->callback_dispatch, dispatch);
+}
+
+/**
+ * gocl_queue_get_callback_dispatch:
+ * @self: The #GoclQueue
+ * @pool: (out) (allow-none) (transfer none): Return location for the
+ * #GThreadPool callbacks are pushed to, or %NULL
+ *
+ * Retrieves how the callbacks of the events of this queue are invoked. See
+ * gocl_queue_set_callback_dispatch().
+ *
+ * Returns: A value from #GoclCallbackDispatch
+ **/
+GoclCallbackDispatch
+gocl_queue_get_callback_dispatch (GoclQueue    *self,
+                                  GThreadPool **pool)
+{
+  GoclCallbackDispatch dispatch;
+
+  g_return_val_if_fail (GOCL_IS_QUEUE (self), GOCL_CALLBACK_DISPATCH_MAIN_CONTEXT);
+
+  dispatch = g_atomic_int_get (&self->priv->callback_dispatch);
+
+  if (pool != NULL)
+    *pool = g_atomic_pointer_get (&self->priv->callback_pool);
+
+  return dispatch;
+}
+
+/**
+ * gocl_queue_get_stats:
+ * @self: The #GoclQueue
+ *
+ * Retrieves a snapshot of the statistics collected so far, with one
+ * #GoclCommandStats per command label. Kernel executions are labeled with the
+ * kernel name, and buffer operations with names like "buffer-read" or
+ * "buffer-write". Times are device execution times, measured from the start
+ * to the end of each command.
+ *
+ * Returns: (transfer full) (element-type Gocl.CommandStats): A #GList of
+ *   #GoclCommandStats. Free with g_list_free_full() and
+ *   gocl_command_stats_free().
+ **/
+GList *
+gocl_queue_get_stats (GoclQueue *self)
+{
+  GList *list = NULL;
+  GHashTableIter iter;
+  gpointer key;
+  gpointer value;
+
+  g_return_val_if_fail (GOCL_IS_QUEUE (self), NULL);
+
+  g_mutex_lock (&self->priv->stats_mutex);
+
+  g_hash_table_iter_init (&iter, self->priv->stats);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      StatsEntry *entry = value;
+      GoclCommandStats *stats;
+
+      stats = g_slice_new (GoclCommandStats);
+      stats->label = g_strdup (key);
+      stats->count = entry->count;
+      stats->total_time = entry->total_time;
+      stats->min_time = entry->min_time;
+      stats->max_time = entry->max_time;
+      stats->p99_time = get_p99_time (entry);
+      stats->bytes = entry->bytes;
+
+      list = g_list_prepend (list, stats);
+    }
+
+  g_mutex_unlock (&self->priv->stats_mutex);
+
+  return list;
+}
+
+/**
+ * gocl_queue_reset_stats:
+ * @self: The #GoclQueue
+ *
+ * Clears all the statistics collected so far.
+ **/
+void
+gocl_queue_reset_stats (GoclQueue *self)
+{
+  g_return_if_fail (GOCL_IS_QUEUE (self));
+
+  g_mutex_lock (&self->priv->stats_mutex);
+  g_hash_table_remove_all (self->priv->stats);
+  g_mutex_unlock (&self->priv->stats_mutex);
+}
+
+/**
+ * gocl_queue_enqueue_host_func:
+ * @self: The #GoclQueue
+ * @func: (scope notified): The function to run
+ * @user_data: (closure): Arbitrary data to pass to @func, or %NULL
+ * @destroy: (allow-none): A function to free @user_data, or %NULL
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List of
+ * #GoclEvent objects to wait for, or %NULL
+ *
+ * Enqueues a call to @func as a command of @self. The call starts after the
+ * events in @event_wait_list, and on in-order queues after the previous
+ * commands, complete. Commands enqueued in @self afterwards, or waiting for
+ * the returned event, start only once @func returns. Dependent device work
+ * can therefore be enqueued ahead of time, instead of from a
+ * gocl_event_then() callback.
+ *
+ * On devices able to run native kernels, usually CPU devices, @func runs as
+ * one of them. Otherwise it runs in a thread of the OpenCL implementation,
+ * when the commands it waits for complete. In both cases it must return
+ * quickly, and must not block on commands of @self. If a command waited for
+ * fails, @func is not called, and the returned event resolves with the
+ * error. @destroy is called on @user_data once it is no longer needed.
+ *
+ * Returns: (transfer none): A #GoclEvent to get notified when @func returns
+ **/
+GoclEvent *
+gocl_queue_enqueue_host_func (GoclQueue      *self,
+                              GoclHostFunc    func,
+                              gpointer        user_data,
+                              GDestroyNotify  destroy,
+                              GList          *event_wait_list)
+{
+  GError *error = NULL;
+  HostTask *task;
+  GoclWaitList wait_list;
+  cl_event event;
+  cl_int err_code;
+
+  GoclEvent *_event = NULL;
+  GoclEventResolverFunc resolver_func;
+
+  g_return_val_if_fail (GOCL_IS_QUEUE (self), NULL);
+  g_return_val_if_fail (func != NULL, NULL);
+
+  task = g_slice_new0 (HostTask);
+  task->func = func;
+  task->user_data = user_data;
+  task->destroy = destroy;
+
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
+
+  if (self->priv->native_kernels)
+    err_code = enqueue_native_task (self, task, &wait_list, &event);
+  else
+    err_code = enqueue_user_event_task (self, task, &wait_list, &event);
+
+  gocl_wait_list_clear (&wait_list);
+
+  if (gocl_error_check_opencl (err_code, &error))
+    {
+      host_task_free (task);
+
+      _event = g_object_new (GOCL_TYPE_EVENT,
+                             "queue", self,
+                             NULL);
+      resolver_func = gocl_event_steal_resolver_func (_event);
+      resolver_func (_event, error);
+      g_error_free (error);
+    }
+  else
+    {
+      _event = g_object_new (GOCL_TYPE_EVENT,
+                             "queue", self,
+                             "event", event,
+                             "label", "host-func",
+                             NULL);
+      gocl_event_set_event_wait_list (_event, event_wait_list);
+      gocl_event_steal_resolver_func (_event);
+    }
+
+  gocl_event_idle_unref (_event);
+
+  return _event;
+}
+
+/**
+ * gocl_command_stats_copy:
+ * @stats: A #GoclCommandStats
+ *
+ * Makes a copy of @stats.
+ *
+ * Returns: (transfer full): A newly allocated #GoclCommandStats. Free with
+ *   gocl_command_stats_free().
+ **/
+GoclCommandStats *
+gocl_command_stats_copy (const GoclCommandStats *stats)
+{
+  GoclCommandStats *copy;
+
+  g_return_val_if_fail (stats != NULL, NULL);
+
+  copy = g_slice_dup (GoclCommandStats, stats);
+  copy->label = g_strdup (stats->label);
+
+  return copy;
+}
+
+/**
+ * gocl_command_stats_free:
+ * @stats: A #GoclCommandStats
+ *
+ * Frees a #GoclCommandStats.
+ **/
+void
+gocl_command_stats_free (GoclCommandStats *stats)
+{
+  g_return_if_fail (stats != NULL);
+
+  g_free (stats->label);
+  g_slice_free (GoclCommandStats, stats);
+}
@@ -25,6 +25,8 @@
 #include <glib-object.h>
 #include <CL/opencl.h>
 
+#include "gocl-decls.h"
+
 G_BEGIN_DECLS
 
 #define GOCL_TYPE_QUEUE              (gocl_queue_get_type ())
@@ -38,6 +40,10 @@ typedef struct _GoclQueueClass GoclQueueClass;
 typedef struct _GoclQueue GoclQueue;
 typedef struct _GoclQueuePrivate GoclQueuePrivate;
 
+#define GOCL_TYPE_COMMAND_STATS      (gocl_command_stats_get_type ())
+
+typedef struct _GoclCommandStats GoclCommandStats;
+
 struct _GoclQueue
 {
   GObject parent_instance;
@@ -50,6 +56,31 @@ struct _GoclQueueClass
   GObjectClass parent_class;
 };
 
+/**
+ * GoclCommandStats:
+ * @label: The label identifying the commands, like the kernel name
+ * @count: The number of commands completed
+ * @total_time: The accumulated device execution time, in nanoseconds
+ * @min_time: The shortest device execution time, in nanoseconds
+ * @max_time: The longest device execution time, in nanoseconds
+ * @p99_time: The 99th percentile of the device execution time over the most
+ *            recent commands, in nanoseconds
+ * @bytes: The accumulated number of bytes transferred by the commands
+ *
+ * Aggregated statistics of the commands completed on a #GoclQueue that share
+ * the same label. See gocl_queue_get_stats().
+ **/
+struct _GoclCommandStats
+{
+  gchar *label;
+  guint64 count;
+  guint64 total_time;
+  guint64 min_time;
+  guint64 max_time;
+  guint64 p99_time;
+  guint64 bytes;
+};
+
 GType                  gocl_queue_get_type                   (void) G_GNUC_CONST;
 
 guint                  gocl_queue_get_flags                  (GoclQueue *self);
@@ -58,6 +89,22 @@ gboolean               gocl_queue_flush                      (GoclQueue *self);
 
 gboolean               gocl_queue_finish                     (GoclQueue *self);
 
+void                   gocl_queue_set_collect_stats          (GoclQueue *self,
+                                                              gboolean   collect);
+gboolean               gocl_queue_get_collect_stats          (GoclQueue *self);
+GList *                gocl_queue_get_stats                  (GoclQueue *self);
+void                   gocl_queue_reset_stats                (GoclQueue *self);
+
+void                   gocl_queue_set_callback_dispatch      (GoclQueue            *self,
+                                                              GoclCallbackDispatch  dispatch,
+                                                              GThreadPool          *pool);
+GoclCallbackDispatch   gocl_queue_get_callback_dispatch      (GoclQueue    *self,
+                                                              GThreadPool **pool);
+
+GType                  gocl_command_stats_get_type           (void) G_GNUC_CONST;
+GoclCommandStats *     gocl_command_stats_copy               (const GoclCommandStats *stats);
+void                   gocl_command_stats_free               (GoclCommandStats *stats);
+
 G_END_DECLS
 
 #endif /* __GOCL_QUEUE_H__ */
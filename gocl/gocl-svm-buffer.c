@@ -0,0 +1,562 @@
+/*
+ * gocl-svm-buffer.c
+ *
+ * Gocl - GLib/GObject wrapper for OpenCL
+ * Copyright (C) 2012-2013 Igalia S.L.
+ *
+ * Authors:
+ *  Eduardo Lima Mitev <elima@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License at http://www.gnu.org/licenses/lgpl-3.0.txt
+ * for more details.
+ */
+
+/**
+ * SECTION:gocl-svm-buffer
+ * @short_description: Buffer whose memory is shared between the host and
+ * the devices of a context
+ * @stability: Unstable
+ *
+ * A #GoclSvmBuffer is a #GoclBuffer allocated as OpenCL 2.0 shared virtual
+ * memory (SVM), when every device of the context supports it. Pointers
+ * stored inside an SVM buffer are valid both on the host and in kernels,
+ * so pointer-based data structures like lists, trees or graphs can be built
+ * on the host and traversed by a kernel without first flattening them into
+ * index-based arrays.
+ *
+ * SVM buffers are created with gocl_svm_buffer_new(), and passed to kernels
+ * with gocl_kernel_set_argument_svm_buffer(). Pointers into the middle of
+ * the buffer can be passed with gocl_kernel_set_argument_svm_pointer().
+ *
+ * The host accesses the contents by mapping the whole buffer with
+ * gocl_svm_buffer_map() or gocl_svm_buffer_map_sync(), and releases it with
+ * gocl_svm_buffer_unmap() or gocl_svm_buffer_unmap_sync() before running a
+ * kernel that uses it. When the devices support fine-grained SVM, the
+ * buffer is allocated as such and mapping only waits for the given events,
+ * since host and devices see the same memory at all times.
+ *
+ * On devices without SVM, like OpenCL 1.2 devices, a #GoclSvmBuffer falls
+ * back to a regular buffer allocated from host accessible memory, and
+ * mapping goes through gocl_buffer_map(). Code written against this API
+ * works in both cases, as long as it does not rely on pointers stored inside
+ * the buffer; gocl_svm_buffer_get_svm_pointer() returns %NULL in the
+ * fallback mode, which can be used to choose a different code path.
+ *
+ * All the #GoclBuffer APIs, like gocl_buffer_read() or gocl_buffer_copy(),
+ * also work on SVM buffers.
+ **/
+
+/**
+ * GoclSvmBufferClass:
+ * @parent_class: The parent class
+ *
+ * The class for #GoclSvmBuffer objects.
+ **/
+
+#include <string.h>
+#include <gio/gio.h>
+
+#include "gocl-svm-buffer.h"
+
+#include "gocl-private.h"
+#include "gocl-context.h"
+
+struct _GoclSvmBufferPrivate
+{
+  gpointer svm_ptr;
+  gboolean fine_grained;
+
+  /* the host address of the mapped buffer, in fallback mode */
+  gpointer mapped_ptr;
+};
+
+typedef struct
+{
+  cl_context context;
+  gpointer svm_ptr;
+} SvmAllocation;
+
+static void           gocl_svm_buffer_class_init          (GoclSvmBufferClass *class);
+static void           gocl_svm_buffer_init                (GoclSvmBuffer *self);
+
+static cl_int         create_cl_mem                       (GoclBuffer  *buffer,
+                                                           cl_context   context,
+                                                           cl_mem      *obj,
+                                                           guint        flags,
+                                                           gsize        size,
+                                                           gpointer     host_ptr);
+
+G_DEFINE_TYPE (GoclSvmBuffer, gocl_svm_buffer, GOCL_TYPE_BUFFER)
+
+#define GOCL_SVM_BUFFER_GET_PRIVATE(obj)                  \
+  (G_TYPE_INSTANCE_GET_PRIVATE ((obj),                    \
+                                GOCL_TYPE_SVM_BUFFER,     \
+                                GoclSvmBufferPrivate))    \
+
+static void
+gocl_svm_buffer_class_init (GoclSvmBufferClass *class)
+{
+  GoclBufferClass *gocl_buf_class = GOCL_BUFFER_CLASS (class);
+
+  gocl_buf_class->create_cl_mem = create_cl_mem;
+
+  g_type_class_add_private (class, sizeof (GoclSvmBufferPrivate));
+}
+
+static void
+gocl_svm_buffer_init (GoclSvmBuffer *self)
+{
+  GoclSvmBufferPrivate *priv;
+
+  self->priv = priv = GOCL_SVM_BUFFER_GET_PRIVATE (self);
+
+  priv->svm_ptr = NULL;
+  priv->fine_grained = FALSE;
+
+  priv->mapped_ptr = NULL;
+}
+
+#ifdef CL_VERSION_2_0
+/* the SVM allocation must outlive the cl_mem object wrapping it, which may
+   still be retained by pending commands when the buffer is finalized */
+static void
+free_svm_allocation (cl_mem obj, gpointer user_data)
+{
+  SvmAllocation *alloc = user_data;
+
+  clSVMFree (alloc->context, alloc->svm_ptr);
+  clReleaseContext (alloc->context);
+
+  g_slice_free (SvmAllocation, alloc);
+}
+#endif
+
+static cl_int
+create_cl_mem (GoclBuffer  *buffer,
+               cl_context   context,
+               cl_mem      *obj,
+               guint        flags,
+               gsize        size,
+               gpointer     host_ptr)
+{
+  cl_int err_code;
+#ifdef CL_VERSION_2_0
+  GoclSvmBuffer *self = GOCL_SVM_BUFFER (buffer);
+  cl_bitfield caps;
+  cl_mem_flags access_flags;
+
+  caps = gocl_context_get_svm_capabilities (gocl_buffer_get_context (buffer));
+  access_flags = flags & (CL_MEM_READ_WRITE |
+                          CL_MEM_WRITE_ONLY |
+                          CL_MEM_READ_ONLY);
+
+  if ((caps & CL_DEVICE_SVM_COARSE_GRAIN_BUFFER) != 0)
+    {
+      SvmAllocation *alloc;
+
+      self->priv->fine_grained =
+        (caps & CL_DEVICE_SVM_FINE_GRAIN_BUFFER) != 0;
+
+      self->priv->svm_ptr = clSVMAlloc (context,
+                                        access_flags |
+                                        (self->priv->fine_grained ?
+                                           CL_MEM_SVM_FINE_GRAIN_BUFFER : 0),
+                                        size,
+                                        0);
+      if (self->priv->svm_ptr == NULL)
+        return CL_MEM_OBJECT_ALLOCATION_FAILURE;
+
+      /* wrapping the allocation in a cl_mem keeps all GoclBuffer APIs
+         working on it */
+      *obj = clCreateBuffer (context,
+                             access_flags | CL_MEM_USE_HOST_PTR,
+                             size,
+                             self->priv->svm_ptr,
+                             &err_code);
+      if (err_code != CL_SUCCESS)
+        {
+          clSVMFree (context, self->priv->svm_ptr);
+          self->priv->svm_ptr = NULL;
+          return err_code;
+        }
+
+      alloc = g_slice_new (SvmAllocation);
+      alloc->context = context;
+      alloc->svm_ptr = self->priv->svm_ptr;
+      clRetainContext (context);
+
+      clSetMemObjectDestructorCallback (*obj, free_svm_allocation, alloc);
+
+      return CL_SUCCESS;
+    }
+#endif
+
+  /* no SVM, use memory the host can map cheaply instead */
+  *obj = clCreateBuffer (context,
+                         flags | CL_MEM_ALLOC_HOST_PTR,
+                         size,
+                         host_ptr,
+                         &err_code);
+
+  return err_code;
+}
+
+static cl_int
+enqueue_map (GoclSvmBuffer       *self,
+             GoclQueue           *queue,
+             gboolean             blocking,
+             guint                flags,
+             const GoclWaitList  *wait_list,
+             gpointer            *mapped_ptr,
+             cl_event            *out_event)
+{
+  cl_command_queue _queue;
+  cl_mem buf;
+  guint64 size;
+  cl_int err_code;
+
+  _queue = gocl_queue_get_queue (queue);
+  buf = gocl_buffer_get_buffer (GOCL_BUFFER (self));
+  g_object_get (self, "size", &size, NULL);
+
+#ifdef CL_VERSION_2_0
+  if (self->priv->svm_ptr != NULL)
+    {
+      *mapped_ptr = self->priv->svm_ptr;
+
+      /* fine-grained memory is always coherent, only the wait list matters */
+      if (self->priv->fine_grained)
+        {
+          if (blocking)
+            return wait_list->len == 0 ?
+              CL_SUCCESS : clWaitForEvents (wait_list->len, wait_list->cl_events);
+          else
+            return clEnqueueMarkerWithWaitList (_queue,
+                                                wait_list->len,
+                                                wait_list->cl_events,
+                                                out_event);
+        }
+
+      return clEnqueueSVMMap (_queue,
+                              blocking,
+                              flags,
+                              self->priv->svm_ptr,
+                              size,
+                              wait_list->len,
+                              wait_list->cl_events,
+                              out_event);
+    }
+#endif
+
+  *mapped_ptr = clEnqueueMapBuffer (_queue,
+                                    buf,
+                                    blocking,
+                                    flags,
+                                    0,
+                                    size,
+                                    wait_list->len,
+                                    wait_list->cl_events,
+                                    out_event,
+                                    &err_code);
+  if (err_code == CL_SUCCESS)
+    self->priv->mapped_ptr = *mapped_ptr;
+
+  return err_code;
+}
+
+static cl_int
+enqueue_unmap (GoclSvmBuffer       *self,
+               GoclQueue           *queue,
+               const GoclWaitList  *wait_list,
+               cl_event            *out_event)
+{
+  cl_command_queue _queue;
+  cl_mem buf;
+  gpointer mapped_ptr;
+
+  _queue = gocl_queue_get_queue (queue);
+  buf = gocl_buffer_get_buffer (GOCL_BUFFER (self));
+
+#ifdef CL_VERSION_2_0
+  if (self->priv->svm_ptr != NULL)
+    {
+      if (self->priv->fine_grained)
+        return clEnqueueMarkerWithWaitList (_queue,
+                                            wait_list->len,
+                                            wait_list->cl_events,
+                                            out_event);
+
+      return clEnqueueSVMUnmap (_queue,
+                                self->priv->svm_ptr,
+                                wait_list->len,
+                                wait_list->cl_events,
+                                out_event);
+    }
+#endif
+
+  if (self->priv->mapped_ptr == NULL)
+    return CL_INVALID_OPERATION;
+
+  mapped_ptr = self->priv->mapped_ptr;
+  self->priv->mapped_ptr = NULL;
+
+  return clEnqueueUnmapMemObject (_queue,
+                                  buf,
+                                  mapped_ptr,
+                                  wait_list->len,
+                                  wait_list->cl_events,
+                                  out_event);
+}
+
+/* public */
+
+/**
+ * gocl_svm_buffer_new:
+ * @context: A #GoclContext to create the buffer in
+ * @flags: An OR'ed combination of values from #GoclBufferFlags. Only the
+ * access flags are used
+ * @size: The size of the buffer, in bytes
+ *
+ * Creates a new shared virtual memory buffer of @size bytes. If some device
+ * of @context does not support SVM, a regular buffer allocated from host
+ * accessible memory is created instead. The contents of the buffer are
+ * undefined until written.
+ *
+ * Returns: (transfer full): A newly created #GoclSvmBuffer, or %NULL on error
+ **/
+GoclSvmBuffer *
+gocl_svm_buffer_new (GoclContext *context,
+                     guint        flags,
+                     gsize        size)
+{
+  GError **error;
+
+  g_return_val_if_fail (GOCL_IS_CONTEXT (context), NULL);
+  g_return_val_if_fail (size > 0, NULL);
+
+  error = gocl_error_prepare ();
+
+  return g_initable_new (GOCL_TYPE_SVM_BUFFER,
+                         NULL,
+                         error,
+                         "context", context,
+                         "flags", flags & (GOCL_BUFFER_FLAGS_READ_WRITE |
+                                           GOCL_BUFFER_FLAGS_WRITE_ONLY |
+                                           GOCL_BUFFER_FLAGS_READ_ONLY),
+                         "size", (guint64) size,
+                         NULL);
+}
+
+/**
+ * gocl_svm_buffer_get_svm_pointer:
+ * @self: The #GoclSvmBuffer
+ *
+ * Retrieves the address of the shared virtual memory allocation backing
+ * this buffer. The same address is valid on the host and in kernels, but
+ * for coarse-grained SVM the host may only dereference it while the buffer
+ * is mapped.
+ *
+ * Returns: (transfer none): The SVM address, or %NULL if the buffer is not
+ * backed by SVM
+ **/
+gpointer
+gocl_svm_buffer_get_svm_pointer (GoclSvmBuffer *self)
+{
+  g_return_val_if_fail (GOCL_IS_SVM_BUFFER (self), NULL);
+
+  return self->priv->svm_ptr;
+}
+
+/**
+ * gocl_svm_buffer_is_fine_grained:
+ * @self: The #GoclSvmBuffer
+ *
+ * Tells whether the buffer was allocated as fine-grained SVM, in which case
+ * host and devices can access it concurrently without mapping.
+ *
+ * Returns: %TRUE if the buffer is fine-grained SVM, %FALSE otherwise
+ **/
+gboolean
+gocl_svm_buffer_is_fine_grained (GoclSvmBuffer *self)
+{
+  g_return_val_if_fail (GOCL_IS_SVM_BUFFER (self), FALSE);
+
+  return self->priv->fine_grained;
+}
+
+/**
+ * gocl_svm_buffer_map:
+ * @self: The #GoclSvmBuffer
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @flags: An OR'ed combination of values from #GoclBufferMapFlags
+ * @mapped_ptr: (out): A pointer to retrieve the host address of the buffer
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List or #GoclEvent
+ * object to wait for, or %NULL
+ *
+ * Asynchronously maps the whole buffer into host address space. The address
+ * is stored in @mapped_ptr right away, but the contents must not be accessed
+ * until the returned #GoclEvent has triggered. For SVM buffers, the address
+ * is the one returned by gocl_svm_buffer_get_svm_pointer().
+ *
+ * The buffer must be released with gocl_svm_buffer_unmap() or
+ * gocl_svm_buffer_unmap_sync() before it is used again by a kernel, or
+ * mapped again. Nested maps are not supported.
+ *
+ * Returns: (transfer none): A #GoclEvent to get notified when the map
+ * operation finishes
+ **/
+GoclEvent *
+gocl_svm_buffer_map (GoclSvmBuffer  *self,
+                     GoclQueue      *queue,
+                     guint           flags,
+                     gpointer       *mapped_ptr,
+                     GList          *event_wait_list)
+{
+  cl_int err_code;
+  cl_event event;
+  GoclWaitList wait_list;
+  gpointer ptr = NULL;
+
+  g_return_val_if_fail (GOCL_IS_SVM_BUFFER (self), NULL);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), NULL);
+  g_return_val_if_fail (mapped_ptr != NULL, NULL);
+  g_return_val_if_fail (self->priv->mapped_ptr == NULL, NULL);
+
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
+  err_code = enqueue_map (self, queue, FALSE, flags, &wait_list, &ptr, &event);
+  gocl_wait_list_clear (&wait_list);
+
+  *mapped_ptr = err_code == CL_SUCCESS ? ptr : NULL;
+
+  return gocl_event_new_for_command (queue,
+                                     err_code,
+                                     event,
+                                     event_wait_list,
+                                     "svm-buffer-map",
+                                     0);
+}
+
+/**
+ * gocl_svm_buffer_map_sync:
+ * @self: The #GoclSvmBuffer
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @flags: An OR'ed combination of values from #GoclBufferMapFlags
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List or #GoclEvent
+ * object to wait for, or %NULL
+ *
+ * Maps the whole buffer into host address space, blocking the program
+ * execution until it is accessible from the host. See gocl_svm_buffer_map()
+ * for details.
+ *
+ * Returns: (transfer none): The host address of the buffer, or %NULL on
+ * error
+ **/
+gpointer
+gocl_svm_buffer_map_sync (GoclSvmBuffer *self,
+                          GoclQueue     *queue,
+                          guint          flags,
+                          GList         *event_wait_list)
+{
+  cl_int err_code;
+  GoclWaitList wait_list;
+  gpointer ptr = NULL;
+
+  g_return_val_if_fail (GOCL_IS_SVM_BUFFER (self), NULL);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), NULL);
+  g_return_val_if_fail (self->priv->mapped_ptr == NULL, NULL);
+
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
+  err_code = enqueue_map (self, queue, TRUE, flags, &wait_list, &ptr, NULL);
+  gocl_wait_list_clear (&wait_list);
+
+  if (gocl_error_check_opencl_internal (err_code))
+    return NULL;
+
+  return ptr;
+}
+
+/**
+ * gocl_svm_buffer_unmap:
+ * @self: The #GoclSvmBuffer
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List or #GoclEvent
+ * object to wait for, or %NULL
+ *
+ * Asynchronously releases the buffer previously mapped with
+ * gocl_svm_buffer_map() or gocl_svm_buffer_map_sync(). Any change done by
+ * the host is visible to the devices once the returned #GoclEvent has
+ * triggered.
+ *
+ * Returns: (transfer none): A #GoclEvent to get notified when the unmap
+ * operation finishes
+ **/
+GoclEvent *
+gocl_svm_buffer_unmap (GoclSvmBuffer *self,
+                       GoclQueue     *queue,
+                       GList         *event_wait_list)
+{
+  cl_int err_code;
+  cl_event event;
+  GoclWaitList wait_list;
+
+  g_return_val_if_fail (GOCL_IS_SVM_BUFFER (self), NULL);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), NULL);
+
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
+  err_code = enqueue_unmap (self, queue, &wait_list, &event);
+  gocl_wait_list_clear (&wait_list);
+
+  return gocl_event_new_for_command (queue,
+                                     err_code,
+                                     event,
+                                     event_wait_list,
+                                     "svm-buffer-unmap",
+                                     0);
+}
+
+/**
+ * gocl_svm_buffer_unmap_sync:
+ * @self: The #GoclSvmBuffer
+ * @queue: A #GoclQueue where the operation will be enqueued
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List or #GoclEvent
+ * object to wait for, or %NULL
+ *
+ * Releases the buffer previously mapped with gocl_svm_buffer_map() or
+ * gocl_svm_buffer_map_sync(), blocking the program execution until the unmap
+ * finishes.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_svm_buffer_unmap_sync (GoclSvmBuffer *self,
+                            GoclQueue     *queue,
+                            GList         *event_wait_list)
+{
+  cl_int err_code;
+  cl_event event;
+  GoclWaitList wait_list;
+
+  g_return_val_if_fail (GOCL_IS_SVM_BUFFER (self), FALSE);
+  g_return_val_if_fail (GOCL_IS_QUEUE (queue), FALSE);
+
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
+  err_code = enqueue_unmap (self, queue, &wait_list, &event);
+  gocl_wait_list_clear (&wait_list);
+
+  /* unmapping is never blocking in OpenCL, so wait for the event */
+  if (err_code == CL_SUCCESS)
+    {
+      err_code = clWaitForEvents (1, &event);
+      clReleaseEvent (event);
+    }
+
+  return ! gocl_error_check_opencl_internal (err_code);
+}
@@ -0,0 +1,79 @@
+/*
+ * gocl-svm-buffer.h
+ *
+ * Gocl - GLib/GObject wrapper for OpenCL
+ * Copyright (C) 2012-2013 Igalia S.L.
+ *
+ * Authors:
+ *  Eduardo Lima Mitev <elima@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License at http://www.gnu.org/licenses/lgpl-3.0.txt
+ * for more details.
+ */
+
+#ifndef __GOCL_SVM_BUFFER_H__
+#define __GOCL_SVM_BUFFER_H__
+
+#include <glib-object.h>
+
+#include "gocl-buffer.h"
+#include "gocl-queue.h"
+#include "gocl-event.h"
+
+G_BEGIN_DECLS
+
+#define GOCL_TYPE_SVM_BUFFER              (gocl_svm_buffer_get_type ())
+#define GOCL_SVM_BUFFER(obj)              (G_TYPE_CHECK_INSTANCE_CAST ((obj), GOCL_TYPE_SVM_BUFFER, GoclSvmBuffer))
+#define GOCL_SVM_BUFFER_CLASS(klass)      (G_TYPE_CHECK_CLASS_CAST ((klass), GOCL_TYPE_SVM_BUFFER, GoclSvmBufferClass))
+#define GOCL_IS_SVM_BUFFER(obj)           (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GOCL_TYPE_SVM_BUFFER))
+#define GOCL_IS_SVM_BUFFER_CLASS(klass)   (G_TYPE_CHECK_CLASS_TYPE ((klass), GOCL_TYPE_SVM_BUFFER))
+#define GOCL_SVM_BUFFER_GET_CLASS(obj)    (G_TYPE_INSTANCE_GET_CLASS ((obj), GOCL_TYPE_SVM_BUFFER, GoclSvmBufferClass))
+
+typedef struct _GoclSvmBufferClass GoclSvmBufferClass;
+typedef struct _GoclSvmBuffer GoclSvmBuffer;
+typedef struct _GoclSvmBufferPrivate GoclSvmBufferPrivate;
+
+struct _GoclSvmBuffer
+{
+  GoclBuffer parent_instance;
+
+  GoclSvmBufferPrivate *priv;
+};
+
+struct _GoclSvmBufferClass
+{
+  GoclBufferClass parent_class;
+};
+
+GType                  gocl_svm_buffer_get_type               (void) G_GNUC_CONST;
+
+gpointer               gocl_svm_buffer_get_svm_pointer        (GoclSvmBuffer *self);
+gboolean               gocl_svm_buffer_is_fine_grained        (GoclSvmBuffer *self);
+
+GoclEvent *            gocl_svm_buffer_map                    (GoclSvmBuffer  *self,
+                                                               GoclQueue      *queue,
+                                                               guint           flags,
+                                                               gpointer       *mapped_ptr,
+                                                               GList          *event_wait_list);
+gpointer               gocl_svm_buffer_map_sync               (GoclSvmBuffer *self,
+                                                               GoclQueue     *queue,
+                                                               guint          flags,
+                                                               GList         *event_wait_list);
+GoclEvent *            gocl_svm_buffer_unmap                  (GoclSvmBuffer *self,
+                                                               GoclQueue     *queue,
+                                                               GList         *event_wait_list);
+gboolean               gocl_svm_buffer_unmap_sync             (GoclSvmBuffer *self,
+                                                               GoclQueue     *queue,
+                                                               GList         *event_wait_list);
+
+G_END_DECLS
+
+#endif /* __GOCL_SVM_BUFFER_H__ */
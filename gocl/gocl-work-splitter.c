@@ -0,0 +1,867 @@
+/*
+ * gocl-work-splitter.c
+ *
+ * Gocl - GLib/GObject wrapper for OpenCL
+ * Copyright (C) 2012-2013 Igalia S.L.
+ *
+ * Authors:
+ *  Eduardo Lima Mitev <elima@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License at http://www.gnu.org/licenses/lgpl-3.0.txt
+ * for more details.
+ */
+
+/**
+ * SECTION:gocl-work-splitter
+ * @short_description: Object that runs a kernel across several devices
+ * @stability: Unstable
+ *
+ * A #GoclWorkSplitter executes a single #GoclKernel launch over all the
+ * devices of the kernel's context, by splitting its global work size. Each
+ * device receives a contiguous range of the first dimension, enqueued in
+ * its default queue using a global work offset, so kernels see the same
+ * global ids they would see on a single device.
+ *
+ * A splitter is created with gocl_work_splitter_new(), and executed with
+ * gocl_work_splitter_run() or gocl_work_splitter_run_sync(). The arguments
+ * and work sizes currently set on the kernel are used. Ranges are always a
+ * multiple of the local work size in the first dimension, if one is set.
+ *
+ * The share of work given to each device, which can be inspected with
+ * gocl_work_splitter_get_share(), initially follows the compute units and
+ * clock frequency of the devices. Unless disabled with
+ * gocl_work_splitter_set_adaptive(), the shares are rebalanced after every
+ * successful run according to the throughput measured on each device, so
+ * that all devices tend to finish at the same time. Device execution times
+ * are taken from profiling information when the default queue of the device
+ * has %GOCL_QUEUE_FLAGS_PROFILING, and measured on the host otherwise.
+ *
+ * The event returned by gocl_work_splitter_run() resolves once the parts
+ * on all devices complete, and can be used in the wait list of subsequent
+ * commands on any device of the context.
+ **/
+
+/**
+ * GoclWorkSplitterClass:
+ * @parent_class: The parent class
+ *
+ * The class for #GoclWorkSplitter objects.
+ **/
+
+#include "gocl-work-splitter.h"
+
+#include "gocl-private.h"
+#include "gocl-program.h"
+
+/* weight of the last measurement when rebalancing shares */
+#define REBALANCE_FACTOR 0.5
+
+typedef struct _Run Run;
+
+typedef struct
+{
+  Run *run;
+
+  guint device_index;
+  gsize offset;
+  gsize count;
+
+  cl_event event;
+  gint64 enqueue_time;
+  guint64 elapsed;
+} Part;
+
+struct _Run
+{
+  GoclWorkSplitter *self;
+
+  GoclEvent *event;
+  GoclEventResolverFunc resolver_func;
+
+  Part *parts;
+  guint num_parts;
+  volatile gint pending;
+
+  cl_int err_code;
+};
+
+struct _GoclWorkSplitterPrivate
+{
+  GoclKernel *kernel;
+  gboolean adaptive;
+
+  GPtrArray *devices;
+  GPtrArray *queues;
+
+  GMutex mutex;
+  gdouble *shares;
+};
+
+/* properties */
+enum
+{
+  PROP_0,
+  PROP_KERNEL,
+  PROP_ADAPTIVE
+};
+
+static void           gocl_work_splitter_class_init      (GoclWorkSplitterClass *class);
+static void           gocl_work_splitter_init            (GoclWorkSplitter *self);
+static void           gocl_work_splitter_constructed     (GObject *obj);
+static void           gocl_work_splitter_dispose         (GObject *obj);
+static void           gocl_work_splitter_finalize        (GObject *obj);
+
+static void           set_property                       (GObject      *obj,
+                                                          guint         prop_id,
+                                                          const GValue *value,
+                                                          GParamSpec   *pspec);
+static void           get_property                       (GObject    *obj,
+                                                          guint       prop_id,
+                                                          GValue     *value,
+                                                          GParamSpec *pspec);
+
+G_DEFINE_TYPE (GoclWorkSplitter, gocl_work_splitter, G_TYPE_OBJECT)
+
+#define GOCL_WORK_SPLITTER_GET_PRIVATE(obj)                     \
+  (G_TYPE_INSTANCE_GET_PRIVATE ((obj),                          \
+                                GOCL_TYPE_WORK_SPLITTER,        \
+                                GoclWorkSplitterPrivate))       \
+
+static void
+gocl_work_splitter_class_init (GoclWorkSplitterClass *class)
+{
+  GObjectClass *obj_class = G_OBJECT_CLASS (class);
+
+  obj_class->constructed = gocl_work_splitter_constructed;
+  obj_class->dispose = gocl_work_splitter_dispose;
+  obj_class->finalize = gocl_work_splitter_finalize;
+  obj_class->get_property = get_property;
+  obj_class->set_property = set_property;
+
+  g_object_class_install_property (obj_class, PROP_KERNEL,
+                                   g_param_spec_object ("kernel",
+                                                        "Kernel",
+                                                        "The kernel executed by this splitter",
+                                                        GOCL_TYPE_KERNEL,
+                                                        G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
+                                                        G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (obj_class, PROP_ADAPTIVE,
+                                   g_param_spec_boolean ("adaptive",
+                                                         "Adaptive",
+                                                         "Whether shares are rebalanced from measured timings",
+                                                         TRUE,
+                                                         G_PARAM_READWRITE |
+                                                         G_PARAM_STATIC_STRINGS));
+
+  g_type_class_add_private (class, sizeof (GoclWorkSplitterPrivate));
+}
+
+static void
+gocl_work_splitter_init (GoclWorkSplitter *self)
+{
+  GoclWorkSplitterPrivate *priv;
+
+  self->priv = priv = GOCL_WORK_SPLITTER_GET_PRIVATE (self);
+
+  priv->adaptive = TRUE;
+
+  priv->devices = g_ptr_array_new_with_free_func (g_object_unref);
+  priv->queues = g_ptr_array_new_with_free_func (g_object_unref);
+
+  g_mutex_init (&priv->mutex);
+  priv->shares = NULL;
+}
+
+static void
+gocl_work_splitter_constructed (GObject *obj)
+{
+  GoclWorkSplitter *self = GOCL_WORK_SPLITTER (obj);
+  GoclProgram *program = NULL;
+  GoclContext *context;
+  gdouble total = 0.0;
+  guint num_devices;
+  guint i;
+
+  g_object_get (self->priv->kernel, "program", &program, NULL);
+  context = gocl_program_get_context (program);
+
+  num_devices = gocl_context_get_num_devices (context);
+  self->priv->shares = g_new0 (gdouble, MAX (num_devices, 1));
+
+  for (i = 0; i < num_devices; i++)
+    {
+      GoclDevice *device;
+      GoclQueue *queue;
+      const GoclDeviceProps *props;
+      gdouble estimate = 1.0;
+
+      device = gocl_context_get_device_by_index (context, i);
+      queue = gocl_device_get_default_queue (device);
+      if (queue == NULL)
+        {
+          g_object_unref (device);
+          continue;
+        }
+
+      props = gocl_context_get_device_props (context,
+                                             gocl_device_get_id (device));
+      if (props != NULL && props->max_compute_units > 0)
+        estimate = (gdouble) props->max_compute_units *
+          MAX (props->max_clock_frequency, 1);
+
+      self->priv->shares[self->priv->devices->len] = estimate;
+      total += estimate;
+
+      g_ptr_array_add (self->priv->devices, device);
+      g_ptr_array_add (self->priv->queues, g_object_ref (queue));
+    }
+
+  for (i = 0; i < self->priv->devices->len; i++)
+    self->priv->shares[i] /= total;
+
+  g_object_unref (program);
+
+  if (G_OBJECT_CLASS (gocl_work_splitter_parent_class)->constructed != NULL)
+    G_OBJECT_CLASS (gocl_work_splitter_parent_class)->constructed (obj);
+}
+
+static void
+gocl_work_splitter_dispose (GObject *obj)
+{
+  GoclWorkSplitter *self = GOCL_WORK_SPLITTER (obj);
+
+  if (self->priv->queues != NULL)
+    {
+      g_ptr_array_unref (self->priv->queues);
+      self->priv->queues = NULL;
+    }
+
+  if (self->priv->devices != NULL)
+    {
+      g_ptr_array_unref (self->priv->devices);
+      self->priv->devices = NULL;
+    }
+
+  if (self->priv->kernel != NULL)
+    {
+      g_object_unref (self->priv->kernel);
+      self->priv->kernel = NULL;
+    }
+
+  G_OBJECT_CLASS (gocl_work_splitter_parent_class)->dispose (obj);
+}
+
+static void
+gocl_work_splitter_finalize (GObject *obj)
+{
+  GoclWorkSplitter *self = GOCL_WORK_SPLITTER (obj);
+
+  g_free (self->priv->shares);
+  g_mutex_clear (&self->priv->mutex);
+
+  G_OBJECT_CLASS (gocl_work_splitter_parent_class)->finalize (obj);
+}
+
+static void
+set_property (GObject      *obj,
+              guint         prop_id,
+              const GValue *value,
+              GParamSpec   *pspec)
+{
+  GoclWorkSplitter *self;
+
+  self = GOCL_WORK_SPLITTER (obj);
+
+  switch (prop_id)
+    {
+    case PROP_KERNEL:
+      self->priv->kernel = g_value_dup_object (value);
+      break;
+
+    case PROP_ADAPTIVE:
+      gocl_work_splitter_set_adaptive (self, g_value_get_boolean (value));
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
+      break;
+    }
+}
+
+static void
+get_property (GObject    *obj,
+              guint       prop_id,
+              GValue     *value,
+              GParamSpec *pspec)
+{
+  GoclWorkSplitter *self;
+
+  self = GOCL_WORK_SPLITTER (obj);
+
+  switch (prop_id)
+    {
+    case PROP_KERNEL:
+      g_value_set_object (value, self->priv->kernel);
+      break;
+
+    case PROP_ADAPTIVE:
+      g_value_set_boolean (value, gocl_work_splitter_get_adaptive (self));
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
+      break;
+    }
+}
+
+static Run *
+split_work (GoclWorkSplitter *self, gsize global_size, gsize granule)
+{
+  Run *run;
+  gsize units;
+  gsize start = 0;
+  gdouble accum = 0.0;
+  guint i;
+
+  run = g_slice_new0 (Run);
+  run->self = g_object_ref (self);
+  run->parts = g_new0 (Part, self->priv->devices->len);
+
+  units = global_size / granule;
+
+  g_mutex_lock (&self->priv->mutex);
+
+  /* cumulative rounding keeps ranges contiguous and adding up exactly */
+  for (i = 0; i < self->priv->devices->len; i++)
+    {
+      Part *part;
+      gsize end;
+
+      accum += self->priv->shares[i];
+      if (i == self->priv->devices->len - 1)
+        end = global_size;
+      else
+        end = MIN ((gsize) (units * accum + 0.5), units) * granule;
+
+      /* devices whose share rounds to zero take no part in this run */
+      if (end <= start)
+        continue;
+
+      part = &run->parts[run->num_parts];
+      part->run = run;
+      part->device_index = i;
+      part->offset = start;
+      part->count = end - start;
+      run->num_parts++;
+
+      start = end;
+    }
+
+  g_mutex_unlock (&self->priv->mutex);
+
+  return run;
+}
+
+static void
+free_run (Run *run)
+{
+  guint i;
+
+  for (i = 0; i < run->num_parts; i++)
+    if (run->parts[i].event != NULL)
+      clReleaseEvent (run->parts[i].event);
+
+  if (run->event != NULL)
+    g_object_unref (run->event);
+
+  g_object_unref (run->self);
+  g_free (run->parts);
+  g_slice_free (Run, run);
+}
+
+static void
+measure_part (Part *part)
+{
+  cl_ulong start = 0;
+  cl_ulong end = 0;
+  cl_int err_code;
+
+  err_code = clGetEventProfilingInfo (part->event,
+                                      CL_PROFILING_COMMAND_START,
+                                      sizeof (cl_ulong),
+                                      &start,
+                                      NULL);
+  if (err_code == CL_SUCCESS)
+    err_code = clGetEventProfilingInfo (part->event,
+                                        CL_PROFILING_COMMAND_END,
+                                        sizeof (cl_ulong),
+                                        &end,
+                                        NULL);
+
+  if (err_code == CL_SUCCESS && end > start)
+    part->elapsed = end - start;
+  else
+    part->elapsed = (g_get_monotonic_time () - part->enqueue_time) * 1000;
+}
+
+static void
+rebalance (GoclWorkSplitter *self, Run *run)
+{
+  gdouble share_sum = 0.0;
+  gdouble throughput_sum = 0.0;
+  guint i;
+
+  for (i = 0; i < run->num_parts; i++)
+    if (run->parts[i].elapsed == 0)
+      return;
+
+  g_mutex_lock (&self->priv->mutex);
+
+  /* only devices that took part are rebalanced, among themselves */
+  for (i = 0; i < run->num_parts; i++)
+    {
+      Part *part = &run->parts[i];
+
+      share_sum += self->priv->shares[part->device_index];
+      throughput_sum += (gdouble) part->count / part->elapsed;
+    }
+
+  for (i = 0; i < run->num_parts; i++)
+    {
+      Part *part = &run->parts[i];
+      gdouble target;
+      gdouble *share;
+
+      target = share_sum * ((gdouble) part->count / part->elapsed) / throughput_sum;
+
+      share = &self->priv->shares[part->device_index];
+      *share = (1.0 - REBALANCE_FACTOR) * *share + REBALANCE_FACTOR * target;
+    }
+
+  g_mutex_unlock (&self->priv->mutex);
+}
+
+static void
+finish_run (Run *run)
+{
+  GError *error = NULL;
+
+  if (run->err_code == CL_SUCCESS && gocl_work_splitter_get_adaptive (run->self))
+    rebalance (run->self, run);
+
+  if (run->event != NULL)
+    {
+      gocl_error_check_opencl (run->err_code, &error);
+      run->resolver_func (run->event, error);
+      if (error != NULL)
+        g_error_free (error);
+    }
+
+  free_run (run);
+}
+
+static void
+part_on_complete (cl_event event,
+                  cl_int   event_command_exec_status,
+                  gpointer user_data)
+{
+  Part *part = user_data;
+  Run *run = part->run;
+
+  if (event_command_exec_status < 0)
+    g_atomic_int_compare_and_exchange (&run->err_code,
+                                       CL_SUCCESS,
+                                       event_command_exec_status);
+  else
+    measure_part (part);
+
+  if (g_atomic_int_dec_and_test (&run->pending))
+    finish_run (run);
+}
+
+static cl_int
+enqueue_parts (GoclWorkSplitter *self,
+               Run              *run,
+               GList            *event_wait_list)
+{
+  cl_kernel kernel;
+  guint8 work_dim;
+  gsize global_work_size[3];
+  gsize local_work_size[3];
+  GoclWaitList wait_list;
+  GArray *merged = NULL;
+  cl_event *events;
+  guint num_events;
+  cl_int err_code = CL_SUCCESS;
+  guint i;
+
+  kernel = gocl_kernel_get_kernel (self->priv->kernel);
+  gocl_kernel_get_work_size (self->priv->kernel,
+                             &work_dim,
+                             global_work_size,
+                             local_work_size);
+
+  gocl_wait_list_init_from_list (&wait_list, event_wait_list);
+
+  /* managed buffers are sent once, and every part waits for them */
+  if (run->num_parts > 0)
+    {
+      GoclQueue *queue;
+
+      queue = g_ptr_array_index (self->priv->queues, run->parts[0].device_index);
+      err_code = gocl_kernel_args_upload_managed (gocl_kernel_get_arguments (self->priv->kernel),
+                                                  gocl_queue_get_queue (queue),
+                                                  wait_list.cl_events,
+                                                  wait_list.len,
+                                                  &merged);
+      if (err_code != CL_SUCCESS)
+        {
+          run->num_parts = 0;
+          gocl_wait_list_clear (&wait_list);
+          return err_code;
+        }
+    }
+
+  events = wait_list.cl_events;
+  num_events = wait_list.len;
+  if (merged != NULL)
+    {
+      num_events = merged->len;
+      events = num_events > 0 ? (cl_event *) merged->data : NULL;
+    }
+
+  for (i = 0; i < run->num_parts; i++)
+    {
+      Part *part = &run->parts[i];
+      GoclQueue *queue;
+      gsize offset[3] = { 0, };
+      gsize size[3];
+
+      queue = g_ptr_array_index (self->priv->queues, part->device_index);
+
+      offset[0] = part->offset;
+      size[0] = part->count;
+      size[1] = global_work_size[1];
+      size[2] = global_work_size[2];
+
+      part->enqueue_time = g_get_monotonic_time ();
+      err_code = clEnqueueNDRangeKernel (gocl_queue_get_queue (queue),
+                                         kernel,
+                                         work_dim,
+                                         offset,
+                                         size,
+                                         local_work_size[0] == 0 ?
+                                           NULL : local_work_size,
+                                         num_events,
+                                         events,
+                                         &part->event);
+      if (err_code != CL_SUCCESS)
+        {
+          /* parts already enqueued still run, so keep waiting for them */
+          part->event = NULL;
+          run->num_parts = i;
+          break;
+        }
+
+      /* on devices sharing a host thread with the caller, nothing starts
+         before a flush */
+      clFlush (gocl_queue_get_queue (queue));
+    }
+
+  if (merged != NULL)
+    {
+      cl_event *part_events;
+
+      part_events = g_new (cl_event, MAX (run->num_parts, 1));
+      for (i = 0; i < run->num_parts; i++)
+        part_events[i] = run->parts[i].event;
+
+      gocl_kernel_args_complete_managed (gocl_kernel_get_arguments (self->priv->kernel),
+                                         merged,
+                                         wait_list.len,
+                                         part_events,
+                                         run->num_parts);
+      g_free (part_events);
+    }
+
+  gocl_wait_list_clear (&wait_list);
+
+  return err_code;
+}
+
+static gboolean
+prepare_run (GoclWorkSplitter *self, Run **run)
+{
+  guint8 work_dim;
+  gsize global_work_size[3];
+  gsize local_work_size[3];
+
+  gocl_kernel_get_work_size (self->priv->kernel,
+                             &work_dim,
+                             global_work_size,
+                             local_work_size);
+
+  g_return_val_if_fail (global_work_size[0] > 0, FALSE);
+  g_return_val_if_fail (self->priv->devices->len > 0, FALSE);
+
+  *run = split_work (self,
+                     global_work_size[0],
+                     local_work_size[0] > 0 ? local_work_size[0] : 1);
+
+  return TRUE;
+}
+
+/* public */
+
+/**
+ * gocl_work_splitter_new:
+ * @kernel: The #GoclKernel to execute
+ *
+ * Creates a new splitter that executes @kernel across all the devices of
+ * the context of its program.
+ *
+ * Returns: (transfer full): A newly created #GoclWorkSplitter
+ **/
+GoclWorkSplitter *
+gocl_work_splitter_new (GoclKernel *kernel)
+{
+  g_return_val_if_fail (GOCL_IS_KERNEL (kernel), NULL);
+
+  return g_object_new (GOCL_TYPE_WORK_SPLITTER,
+                       "kernel", kernel,
+                       NULL);
+}
+
+/**
+ * gocl_work_splitter_get_kernel:
+ * @self: The #GoclWorkSplitter
+ *
+ * Obtains the kernel executed by the splitter.
+ *
+ * Returns: (transfer none): The #GoclKernel
+ **/
+GoclKernel *
+gocl_work_splitter_get_kernel (GoclWorkSplitter *self)
+{
+  g_return_val_if_fail (GOCL_IS_WORK_SPLITTER (self), NULL);
+
+  return self->priv->kernel;
+}
+
+/**
+ * gocl_work_splitter_get_num_devices:
+ * @self: The #GoclWorkSplitter
+ *
+ * Obtains the number of devices work is split across.
+ *
+ * Returns: The number of devices
+ **/
+guint
+gocl_work_splitter_get_num_devices (GoclWorkSplitter *self)
+{
+  g_return_val_if_fail (GOCL_IS_WORK_SPLITTER (self), 0);
+
+  return self->priv->devices->len;
+}
+
+/**
+ * gocl_work_splitter_get_device_by_index:
+ * @self: The #GoclWorkSplitter
+ * @device_index: The index of the device
+ *
+ * Obtains the @device_index-th device work is split across.
+ *
+ * Returns: (transfer none): The #GoclDevice
+ **/
+GoclDevice *
+gocl_work_splitter_get_device_by_index (GoclWorkSplitter *self,
+                                        guint             device_index)
+{
+  g_return_val_if_fail (GOCL_IS_WORK_SPLITTER (self), NULL);
+  g_return_val_if_fail (device_index < self->priv->devices->len, NULL);
+
+  return g_ptr_array_index (self->priv->devices, device_index);
+}
+
+/**
+ * gocl_work_splitter_get_share:
+ * @self: The #GoclWorkSplitter
+ * @device_index: The index of the device
+ *
+ * Obtains the fraction of the global work size the @device_index-th device
+ * will receive in the next run. Shares of all devices add up to 1.
+ *
+ * Returns: The share of the device, between 0 and 1
+ **/
+gdouble
+gocl_work_splitter_get_share (GoclWorkSplitter *self, guint device_index)
+{
+  gdouble share;
+
+  g_return_val_if_fail (GOCL_IS_WORK_SPLITTER (self), 0.0);
+  g_return_val_if_fail (device_index < self->priv->devices->len, 0.0);
+
+  g_mutex_lock (&self->priv->mutex);
+  share = self->priv->shares[device_index];
+  g_mutex_unlock (&self->priv->mutex);
+
+  return share;
+}
+
+/**
+ * gocl_work_splitter_set_adaptive:
+ * @self: The #GoclWorkSplitter
+ * @adaptive: %TRUE to rebalance shares after each run, %FALSE otherwise
+ *
+ * Sets whether the shares of the devices are adjusted after each successful
+ * run, from the throughput measured on each device. This is enabled by
+ * default.
+ **/
+void
+gocl_work_splitter_set_adaptive (GoclWorkSplitter *self, gboolean adaptive)
+{
+  g_return_if_fail (GOCL_IS_WORK_SPLITTER (self));
+
+  g_atomic_int_set (&self->priv->adaptive, adaptive);
+}
+
+/**
+ * gocl_work_splitter_get_adaptive:
+ * @self: The #GoclWorkSplitter
+ *
+ * Returns whether the shares of the devices are adjusted after each run.
+ *
+ * Returns: %TRUE if shares are rebalanced, %FALSE otherwise
+ **/
+gboolean
+gocl_work_splitter_get_adaptive (GoclWorkSplitter *self)
+{
+  g_return_val_if_fail (GOCL_IS_WORK_SPLITTER (self), FALSE);
+
+  return g_atomic_int_get (&self->priv->adaptive);
+}
+
+/**
+ * gocl_work_splitter_run_sync:
+ * @self: The #GoclWorkSplitter
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List of
+ * #GoclEvent objects to wait for, or %NULL
+ *
+ * Executes the kernel across all devices, blocking the program until the
+ * part on every device finishes.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gocl_work_splitter_run_sync (GoclWorkSplitter *self, GList *event_wait_list)
+{
+  Run *run = NULL;
+  cl_int err_code;
+  guint i;
+
+  g_return_val_if_fail (GOCL_IS_WORK_SPLITTER (self), FALSE);
+
+  if (! prepare_run (self, &run))
+    return FALSE;
+
+  err_code = enqueue_parts (self, run, event_wait_list);
+
+  for (i = 0; i < run->num_parts; i++)
+    {
+      cl_int wait_err;
+
+      wait_err = clWaitForEvents (1, &run->parts[i].event);
+      if (wait_err == CL_SUCCESS)
+        measure_part (&run->parts[i]);
+      else if (err_code == CL_SUCCESS)
+        err_code = wait_err;
+    }
+
+  run->err_code = err_code;
+  finish_run (run);
+
+  return ! gocl_error_check_opencl_internal (err_code);
+}
+
+/**
+ * gocl_work_splitter_run:
+ * @self: The #GoclWorkSplitter
+ * @event_wait_list: (element-type Gocl.Event) (allow-none): List of
+ * #GoclEvent objects to wait for, or %NULL
+ *
+ * Executes the kernel across all devices, without blocking. The returned
+ * event resolves when the parts on all the devices complete, or with an
+ * error if any of them fails.
+ *
+ * Returns: (transfer none): A #GoclEvent to get notified when the whole
+ * execution finishes
+ **/
+GoclEvent *
+gocl_work_splitter_run (GoclWorkSplitter *self, GList *event_wait_list)
+{
+  Run *run = NULL;
+  GoclEvent *event;
+  guint num_parts;
+  guint i;
+
+  g_return_val_if_fail (GOCL_IS_WORK_SPLITTER (self), NULL);
+
+  if (! prepare_run (self, &run))
+    return NULL;
+
+  /* a user event on the first device's queue aggregates all the parts */
+  event = g_object_new (GOCL_TYPE_EVENT,
+                        "queue", g_ptr_array_index (self->priv->queues, 0),
+                        NULL);
+  gocl_event_set_event_wait_list (event, event_wait_list);
+
+  run->event = g_object_ref (event);
+  run->resolver_func = gocl_event_steal_resolver_func (event);
+
+  run->err_code = enqueue_parts (self, run, event_wait_list);
+
+  num_parts = run->num_parts;
+  if (num_parts == 0)
+    {
+      finish_run (run);
+    }
+  else
+    {
+      /* hold one extra count so that no part finishes the run before all
+         the callbacks are set */
+      run->pending = num_parts + 1;
+
+      for (i = 0; i < num_parts; i++)
+        {
+          cl_int err_code;
+
+          err_code = clSetEventCallback (run->parts[i].event,
+                                         CL_COMPLETE,
+                                         part_on_complete,
+                                         &run->parts[i]);
+          if (err_code != CL_SUCCESS)
+            {
+              g_atomic_int_compare_and_exchange (&run->err_code,
+                                                 CL_SUCCESS,
+                                                 err_code);
+              g_atomic_int_add (&run->pending, -1);
+            }
+        }
+
+      if (g_atomic_int_dec_and_test (&run->pending))
+        finish_run (run);
+    }
+
+  gocl_event_idle_unref (event);
+
+  return event;
+}
@@ -0,0 +1,79 @@
+/*
+ * gocl-work-splitter.h
+ *
+ * Gocl - GLib/GObject wrapper for OpenCL
+ * Copyright (C) 2012-2013 Igalia S.L.
+ *
+ * Authors:
+ *  Eduardo Lima Mitev <elima@igalia.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License at http://www.gnu.org/licenses/lgpl-3.0.txt
+ * for more details.
+ */
+
+#ifndef __GOCL_WORK_SPLITTER_H__
+#define __GOCL_WORK_SPLITTER_H__
+
+#include <glib-object.h>
+
+#include "gocl-kernel.h"
+#include "gocl-device.h"
+#include "gocl-event.h"
+
+G_BEGIN_DECLS
+
+#define GOCL_TYPE_WORK_SPLITTER              (gocl_work_splitter_get_type ())
+#define GOCL_WORK_SPLITTER(obj)              (G_TYPE_CHECK_INSTANCE_CAST ((obj), GOCL_TYPE_WORK_SPLITTER, GoclWorkSplitter))
+#define GOCL_WORK_SPLITTER_CLASS(klass)      (G_TYPE_CHECK_CLASS_CAST ((klass), GOCL_TYPE_WORK_SPLITTER, GoclWorkSplitterClass))
+#define GOCL_IS_WORK_SPLITTER(obj)           (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GOCL_TYPE_WORK_SPLITTER))
+#define GOCL_IS_WORK_SPLITTER_CLASS(klass)   (G_TYPE_CHECK_CLASS_TYPE ((klass), GOCL_TYPE_WORK_SPLITTER))
+#define GOCL_WORK_SPLITTER_GET_CLASS(obj)    (G_TYPE_INSTANCE_GET_CLASS ((obj), GOCL_TYPE_WORK_SPLITTER, GoclWorkSplitterClass))
+
+typedef struct _GoclWorkSplitterClass GoclWorkSplitterClass;
+typedef struct _GoclWorkSplitter GoclWorkSplitter;
+typedef struct _GoclWorkSplitterPrivate GoclWorkSplitterPrivate;
+
+struct _GoclWorkSplitter
+{
+  GObject parent_instance;
+
+  GoclWorkSplitterPrivate *priv;
+};
+
+struct _GoclWorkSplitterClass
+{
+  GObjectClass parent_class;
+};
+
+GType                  gocl_work_splitter_get_type            (void) G_GNUC_CONST;
+
+GoclWorkSplitter *     gocl_work_splitter_new                 (GoclKernel *kernel);
+
+GoclKernel *           gocl_work_splitter_get_kernel          (GoclWorkSplitter *self);
+
+guint                  gocl_work_splitter_get_num_devices     (GoclWorkSplitter *self);
+GoclDevice *           gocl_work_splitter_get_device_by_index (GoclWorkSplitter *self,
+                                                               guint             device_index);
+gdouble                gocl_work_splitter_get_share           (GoclWorkSplitter *self,
+                                                               guint             device_index);
+
+void                   gocl_work_splitter_set_adaptive        (GoclWorkSplitter *self,
+                                                               gboolean          adaptive);
+gboolean               gocl_work_splitter_get_adaptive        (GoclWorkSplitter *self);
+
+gboolean               gocl_work_splitter_run_sync            (GoclWorkSplitter *self,
+                                                               GList            *event_wait_list);
+GoclEvent *            gocl_work_splitter_run                 (GoclWorkSplitter *self,
+                                                               GList            *event_wait_list);
+
+G_END_DECLS
+
+#endif /* __GOCL_WORK_SPLITTER_H__ */
@@ -27,10 +27,18 @@
 #include "gocl-context.h"
 #include "gocl-device.h"
 #include "gocl-buffer.h"
+#include "gocl-buffer-pool.h"
 #include "gocl-program.h"
 #include "gocl-kernel.h"
+#include "gocl-launch.h"
+#include "gocl-command-list.h"
+#include "gocl-graph.h"
+#include "gocl-work-splitter.h"
+#include "gocl-pipeline.h"
+#include "gocl-primitives.h"
 #include "gocl-queue.h"
 #include "gocl-image.h"
+#include "gocl-svm-buffer.h"
 
 G_BEGIN_DECLS
 